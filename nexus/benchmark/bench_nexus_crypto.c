@@ -0,0 +1,390 @@
+/** \file bench_nexus_crypto.c
+ * \brief Micro-benchmarks for Nexus cryptographic and integrity primitives
+ * \author Angaza
+ * \copyright 2021 Angaza, Inc.
+ * \license This file is released under the MIT license
+ *
+ * The above copyright notice and license shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * Measures the primitives that every keycode and Nexus Channel message
+ * depends on (Siphash 2-4, Nexus checks, CRC-CCITT, COSE MAC0 sign and
+ * verify) across a range of input sizes, and prints the results as JSON.
+ *
+ * Usage: `nexus_benchmark [output.json]` (prints to stdout if no output
+ * file is given). See `README.md` in this directory.
+ */
+
+#include "src/nexus_cose_mac0_common.h"
+#include "src/nexus_cose_mac0_sign.h"
+#include "src/nexus_cose_mac0_verify.h"
+#include "src/nexus_util.h"
+#include "utils/crc_ccitt.h"
+#include "utils/siphash_24.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+    #define BENCH_HAS_CYCLE_COUNTER 1
+#else
+    #define BENCH_HAS_CYCLE_COUNTER 0
+#endif
+
+/********************************************************
+ * DEFINITIONS
+ *******************************************************/
+
+// Each sample runs for at least this long, to amortize timer overhead
+#define BENCH_MIN_SAMPLE_NS 10000000ULL
+// Median of this many samples is reported
+#define BENCH_SAMPLE_COUNT 7
+#define BENCH_MAX_INPUT_SIZE 1024
+#define BENCH_MAX_RESULTS 64
+#define BENCH_MAX_NAME_LENGTH 64
+
+/********************************************************
+ * PRIVATE TYPES
+ *******************************************************/
+
+// Runs the operation under test `iterations` times
+typedef void (*bench_fn_t)(uint32_t iterations, size_t input_size);
+
+struct bench_result
+{
+    char name[BENCH_MAX_NAME_LENGTH];
+    size_t input_size;
+    uint32_t iterations;
+    double ns_per_op;
+    double cycles_per_op;
+};
+
+/********************************************************
+ * PRIVATE DATA
+ *******************************************************/
+
+static const struct nx_common_check_key BENCH_KEY = {{0xC4,
+                                                      0xB8,
+                                                      0x40,
+                                                      0x48,
+                                                      0xCF,
+                                                      0x04,
+                                                      0x24,
+                                                      0xA2,
+                                                      0x5D,
+                                                      0xC5,
+                                                      0xE9,
+                                                      0xD3,
+                                                      0xF0,
+                                                      0x67,
+                                                      0x40,
+                                                      0x36}};
+
+static uint8_t _input[BENCH_MAX_INPUT_SIZE];
+
+// Results of each operation are folded into this value, so that the
+// compiler cannot remove the operations under test
+static volatile uint64_t _sink;
+
+// secured message used by the COSE MAC0 verify benchmark
+static uint8_t _secured_message[NEXUS_COSE_MAC0_MAX_ENCODED_CBOR_OBJECT_SIZE];
+static size_t _secured_message_len;
+
+static struct bench_result _results[BENCH_MAX_RESULTS];
+static uint8_t _result_count;
+
+/********************************************************
+ * PRIVATE FUNCTIONS
+ *******************************************************/
+
+static uint64_t _bench_now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000ULL + (uint64_t) now.tv_nsec;
+}
+
+static uint64_t _bench_now_cycles(void)
+{
+#if BENCH_HAS_CYCLE_COUNTER
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static int _bench_compare_doubles(const void* a, const void* b)
+{
+    const double lhs = *(const double*) a;
+    const double rhs = *(const double*) b;
+    return (lhs > rhs) - (lhs < rhs);
+}
+
+static void _bench_siphash24_compute(uint32_t iterations, size_t input_size)
+{
+    uint8_t out[8];
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        siphash24_compute(out, _input, (uint32_t) input_size, BENCH_KEY.bytes);
+        _sink ^= out[0];
+    }
+}
+
+static void _bench_nexus_check_compute(uint32_t iterations, size_t input_size)
+{
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        const struct nexus_check_value value =
+            nexus_check_compute(&BENCH_KEY, _input, (uint16_t) input_size);
+        _sink ^= value.bytes[0];
+    }
+}
+
+static void _bench_nexus_check_compute_pseudorandom_bytes(uint32_t iterations,
+                                                          size_t input_size)
+{
+    uint8_t out[8];
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        nexus_check_compute_pseudorandom_bytes(
+            &BENCH_KEY, _input, (uint16_t) input_size, out, sizeof(out));
+        _sink ^= out[0];
+    }
+}
+
+static void _bench_compute_crc_ccitt(uint32_t iterations, size_t input_size)
+{
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        _sink ^= compute_crc_ccitt(_input, input_size);
+    }
+}
+
+static void _bench_cose_mac0_sign(uint32_t iterations, size_t input_size)
+{
+    const nexus_cose_mac0_common_macparams_t mac_params = {
+        &BENCH_KEY,
+        5,
+        {2, (uint8_t*) "/nx/pc", 6},
+        _input,
+        input_size,
+    };
+    uint8_t output[NEXUS_COSE_MAC0_MAX_ENCODED_CBOR_OBJECT_SIZE];
+    size_t encoded_len;
+
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        _sink ^= (uint64_t) nexus_cose_mac0_sign_encode_message(
+            &mac_params, output, sizeof(output), &encoded_len);
+        _sink ^= encoded_len;
+    }
+}
+
+static void _bench_cose_mac0_verify(uint32_t iterations, size_t input_size)
+{
+    (void) input_size;
+    const nexus_cose_mac0_verify_ctx_t verify_ctx = {
+        &BENCH_KEY,
+        {2, (uint8_t*) "/nx/pc", 6},
+        _secured_message,
+        _secured_message_len,
+    };
+    uint32_t nonce;
+    uint8_t* payload;
+    size_t payload_len;
+
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        _sink ^= (uint64_t) nexus_cose_mac0_verify_message(
+            &verify_ctx, &nonce, &payload, &payload_len);
+        _sink ^= payload_len;
+    }
+}
+
+// prepare `_secured_message` with a payload of `input_size` bytes
+static bool _bench_prepare_cose_mac0_verify(size_t input_size)
+{
+    const nexus_cose_mac0_common_macparams_t mac_params = {
+        &BENCH_KEY,
+        5,
+        {2, (uint8_t*) "/nx/pc", 6},
+        _input,
+        input_size,
+    };
+    return nexus_cose_mac0_sign_encode_message(&mac_params,
+                                               _secured_message,
+                                               sizeof(_secured_message),
+                                               &_secured_message_len) ==
+           NEXUS_COSE_ERROR_NONE;
+}
+
+static void _bench_run(const char* name, bench_fn_t fn, size_t input_size)
+{
+    if (_result_count >= BENCH_MAX_RESULTS)
+    {
+        fprintf(stderr, "Too many benchmarks, skipping %s\n", name);
+        return;
+    }
+
+    // warm up and find an iteration count long enough to time accurately
+    uint32_t iterations = 1;
+    for (;;)
+    {
+        const uint64_t start = _bench_now_ns();
+        fn(iterations, input_size);
+        const uint64_t elapsed = _bench_now_ns() - start;
+        if (elapsed >= BENCH_MIN_SAMPLE_NS || iterations >= (1UL << 30))
+        {
+            break;
+        }
+        iterations *= 2;
+    }
+
+    double ns_samples[BENCH_SAMPLE_COUNT];
+    double cycle_samples[BENCH_SAMPLE_COUNT];
+    for (uint8_t i = 0; i < BENCH_SAMPLE_COUNT; i++)
+    {
+        const uint64_t start_cycles = _bench_now_cycles();
+        const uint64_t start = _bench_now_ns();
+        fn(iterations, input_size);
+        const uint64_t elapsed = _bench_now_ns() - start;
+        const uint64_t elapsed_cycles = _bench_now_cycles() - start_cycles;
+        ns_samples[i] = (double) elapsed / iterations;
+        cycle_samples[i] = (double) elapsed_cycles / iterations;
+    }
+    qsort(ns_samples,
+          BENCH_SAMPLE_COUNT,
+          sizeof(double),
+          _bench_compare_doubles);
+    qsort(cycle_samples,
+          BENCH_SAMPLE_COUNT,
+          sizeof(double),
+          _bench_compare_doubles);
+
+    struct bench_result* result = &_results[_result_count++];
+    snprintf(result->name, sizeof(result->name), "%s/%zu", name, input_size);
+    result->input_size = input_size;
+    result->iterations = iterations;
+    result->ns_per_op = ns_samples[BENCH_SAMPLE_COUNT / 2];
+    result->cycles_per_op = cycle_samples[BENCH_SAMPLE_COUNT / 2];
+
+    fprintf(stderr,
+            "%-48s %10.1f ns/op %10.2f ns/byte\n",
+            result->name,
+            result->ns_per_op,
+            input_size > 0 ? result->ns_per_op / (double) input_size : 0.0);
+}
+
+static void _bench_print_json(FILE* out)
+{
+    fprintf(out, "{\n");
+    fprintf(out, "  \"compiler\": \"%s\",\n", __VERSION__);
+    fprintf(out,
+            "  \"cycle_counter\": %s,\n",
+            BENCH_HAS_CYCLE_COUNTER ? "\"tsc\"" : "null");
+    fprintf(out, "  \"benchmarks\": [\n");
+    for (uint8_t i = 0; i < _result_count; i++)
+    {
+        const struct bench_result* result = &_results[i];
+        fprintf(out, "    {\n");
+        fprintf(out, "      \"name\": \"%s\",\n", result->name);
+        fprintf(out, "      \"input_size\": %zu,\n", result->input_size);
+        fprintf(out, "      \"iterations\": %u,\n", result->iterations);
+        fprintf(out, "      \"ns_per_op\": %.3f,\n", result->ns_per_op);
+        if (result->input_size > 0)
+        {
+            fprintf(out,
+                    "      \"ns_per_byte\": %.4f,\n",
+                    result->ns_per_op / (double) result->input_size);
+        }
+        else
+        {
+            fprintf(out, "      \"ns_per_byte\": null,\n");
+        }
+        if (BENCH_HAS_CYCLE_COUNTER && result->input_size > 0)
+        {
+            fprintf(out,
+                    "      \"cycles_per_byte\": %.4f\n",
+                    result->cycles_per_op / (double) result->input_size);
+        }
+        else
+        {
+            fprintf(out, "      \"cycles_per_byte\": null\n");
+        }
+        fprintf(out, "    }%s\n", (i + 1 < _result_count) ? "," : "");
+    }
+    fprintf(out, "  ]\n");
+    fprintf(out, "}\n");
+}
+
+int main(int argc, char** argv)
+{
+    static const size_t hash_sizes[] = {8, 16, 32, 64, 128, 256, 1024};
+    static const size_t seed_sizes[] = {1, 4};
+    static const size_t cose_payload_sizes[] = {0, 16, 32, 64};
+
+    for (size_t i = 0; i < sizeof(_input); i++)
+    {
+        _input[i] = (uint8_t) (i * 31 + 7);
+    }
+
+    for (size_t i = 0; i < sizeof(hash_sizes) / sizeof(hash_sizes[0]); i++)
+    {
+        _bench_run(
+            "siphash24_compute", _bench_siphash24_compute, hash_sizes[i]);
+    }
+    for (size_t i = 0; i < sizeof(hash_sizes) / sizeof(hash_sizes[0]); i++)
+    {
+        _bench_run(
+            "nexus_check_compute", _bench_nexus_check_compute, hash_sizes[i]);
+    }
+    for (size_t i = 0; i < sizeof(seed_sizes) / sizeof(seed_sizes[0]); i++)
+    {
+        _bench_run("nexus_check_compute_pseudorandom_bytes",
+                   _bench_nexus_check_compute_pseudorandom_bytes,
+                   seed_sizes[i]);
+    }
+    for (size_t i = 0; i < sizeof(hash_sizes) / sizeof(hash_sizes[0]); i++)
+    {
+        _bench_run(
+            "compute_crc_ccitt", _bench_compute_crc_ccitt, hash_sizes[i]);
+    }
+    for (size_t i = 0;
+         i < sizeof(cose_payload_sizes) / sizeof(cose_payload_sizes[0]);
+         i++)
+    {
+        // also confirms that signing succeeds for this payload size
+        if (!_bench_prepare_cose_mac0_verify(cose_payload_sizes[i]))
+        {
+            fprintf(stderr, "Unable to sign COSE MAC0 benchmark payload\n");
+            return EXIT_FAILURE;
+        }
+        _bench_run(
+            "cose_mac0_sign", _bench_cose_mac0_sign, cose_payload_sizes[i]);
+        _bench_run(
+            "cose_mac0_verify", _bench_cose_mac0_verify, cose_payload_sizes[i]);
+    }
+
+    FILE* out = stdout;
+    if (argc > 1)
+    {
+        out = fopen(argv[1], "w");
+        if (out == NULL)
+        {
+            fprintf(stderr, "Unable to open %s\n", argv[1]);
+            return EXIT_FAILURE;
+        }
+    }
+    _bench_print_json(out);
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+
+    return EXIT_SUCCESS;
+}
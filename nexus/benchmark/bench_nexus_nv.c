@@ -0,0 +1,992 @@
+/** \file bench_nexus_nv.c
+ * \brief NV write amplification and flash endurance benchmark
+ * \author Angaza
+ * \copyright 2021 Angaza, Inc.
+ * \license This file is released under the MIT license
+ *
+ * The above copyright notice and license shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * Runs the complete Nexus library (as configured in `user_config.h`)
+ * through scripted workloads in simulated time, and counts every call to
+ * `nxp_common_nv_write`. Each workload reports writes per block ID, bytes
+ * written, and the projected erase cycles of the most-erased flash page
+ * for several page sizes, both for blocks stored in place (one erase of
+ * the containing page per write) and for blocks stored in `utils/nv_log`.
+ *
+ * Workloads:
+ *
+ * - `keycode_bursts`: bursts of valid (and one mistyped) keycodes
+ * - `payg_credit_sync`: a controller with linked accessories, sending only
+ *   the periodic PAYG credit updates generated by Nexus Channel
+ * - `channel_traffic`: as `payg_credit_sync`, with additional secured
+ *   requests sent to each accessory at a fixed interval
+ * - `mixed`: all of the above
+ *
+ * Linked accessories are simulated: every secured request sent to an
+ * accessory is answered, which advances the link nonce exactly as a valid
+ * secured response received by the security manager does.
+ *
+ * Usage: `nexus_nv_benchmark [options] [output.json]` (prints to stdout
+ * if no output file is given). See `README.md` in this directory.
+ */
+
+#include "include/nx_channel.h"
+#include "include/nx_common.h"
+#include "include/nx_keycode.h"
+#include "include/nxp_channel.h"
+#include "include/nxp_common.h"
+#include "include/nxp_keycode.h"
+#include "oc/include/oc_client_state.h"
+#include "oc/messaging/coap/transactions.h"
+#include "src/nexus_channel_res_lm.h"
+#include "src/nexus_keycode_pro.h"
+#include "src/nexus_nv.h"
+#include "utils/nv_log.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/********************************************************
+ * DEFINITIONS
+ *******************************************************/
+
+// Block IDs 0 to `BENCH_NV_MAX_BLOCKS - 1` are counted
+#if defined(CONFIG_NEXUS_CHANNEL_LINK_SECURITY_ENABLED) &&                     \
+    defined(CONFIG_NEXUS_CHANNEL_LARGE_LINK_TABLE_ENABLED)
+    // link pages have the highest block IDs
+    #define BENCH_NV_MAX_BLOCKS                                                \
+        (NX_COMMON_NV_LINK_PAGE_FIRST_BLOCK_ID + NX_COMMON_NV_LINK_PAGE_COUNT)
+#else
+    #define BENCH_NV_MAX_BLOCKS 64
+#endif
+#define BENCH_NV_MAX_PAGE_SIZES 8
+#define BENCH_NV_MAX_RESPONSES 64
+// Recent requests, to avoid answering a retransmission twice
+#define BENCH_NV_RECENT_REQUESTS 32
+// Longest simulated time between calls to `nx_common_process`
+#define BENCH_NV_MAX_STEP_SECONDS 10
+// Seconds between keycodes entered within a burst
+#define BENCH_NV_KEYCODE_ENTRY_SECONDS 30
+#define BENCH_NV_HOURS_PER_YEAR 8766.0
+#define BENCH_NV_MAX_OUTPUT_SIZE 8192
+
+/********************************************************
+ * PRIVATE TYPES
+ *******************************************************/
+
+struct bench_nv_workload
+{
+    const char* name;
+    bool links; // controller linked to `--links` accessories
+    bool keycodes; // keycode bursts every `--keycode-interval` hours
+    bool messages; // secured request every `--message-interval` seconds
+};
+
+struct bench_nv_options
+{
+    uint32_t hours;
+    uint32_t page_sizes[BENCH_NV_MAX_PAGE_SIZES];
+    uint8_t page_size_count;
+    uint8_t page_count;
+    uint32_t endurance;
+    uint8_t links;
+    uint32_t keycode_interval_hours;
+    uint8_t keycodes_per_burst;
+    uint32_t message_interval_seconds;
+    const char* only_workload;
+};
+
+// Flash emulated in RAM, storing one `nv_log` for one page size
+struct bench_nv_flash
+{
+    struct nv_log_flash flash;
+    struct nv_log log;
+    uint8_t* bytes;
+    uint32_t erase_count[NV_LOG_MAX_PAGES];
+    bool usable;
+};
+
+/********************************************************
+ * PRIVATE DATA
+ *******************************************************/
+
+static const struct bench_nv_workload BENCH_NV_WORKLOADS[] = {
+    {"keycode_bursts", false, true, false},
+    {"payg_credit_sync", true, false, false},
+    {"channel_traffic", true, false, true},
+    {"mixed", true, true, true},
+};
+
+static const struct nx_common_check_key BENCH_NV_SECRET_KEY = {
+    {0xC4, 0xB8, 0x40, 0x48, 0xCF, 0x04, 0x24, 0xA2,
+     0x5D, 0xC5, 0xE9, 0xD3, 0xF0, 0x67, 0x40, 0x36}};
+static const struct nx_common_check_key BENCH_NV_LINK_KEY = {
+    {0x0B, 0x1E, 0x3F, 0x7C, 0x51, 0x22, 0x9A, 0x6D,
+     0x83, 0x14, 0xE5, 0xC0, 0x2F, 0x96, 0x48, 0xB7}};
+static const struct nx_id BENCH_NV_CONTROLLER_ID = {0, 0x00ABCDEF};
+// accessory `n` has device ID `BENCH_NV_FIRST_ACCESSORY_DEVICE_ID + n`
+#define BENCH_NV_FIRST_ACCESSORY_DEVICE_ID 0x00100000
+
+static struct bench_nv_options _options;
+
+// Simulated product state
+static struct
+{
+    uint32_t uptime;
+    uint32_t credit;
+    bool processing_requested;
+    uint8_t nv[BENCH_NV_MAX_BLOCKS][NX_COMMON_NV_MAX_BLOCK_LENGTH];
+    bool nv_valid[BENCH_NV_MAX_BLOCKS];
+    // secured requests waiting for a response
+    struct
+    {
+        struct nx_id dest;
+        uint16_t message_id;
+    } responses[BENCH_NV_MAX_RESPONSES];
+    uint8_t response_count;
+    struct
+    {
+        struct nx_id dest;
+        uint16_t message_id;
+    } recent_requests[BENCH_NV_RECENT_REQUESTS];
+    uint8_t recent_request_next;
+    struct bench_nv_flash flashes[BENCH_NV_MAX_PAGE_SIZES];
+} _device;
+
+// Counted during the measured part of a workload
+static struct
+{
+    bool counting;
+    uint32_t writes[BENCH_NV_MAX_BLOCKS];
+    uint8_t block_length[BENCH_NV_MAX_BLOCKS];
+    uint64_t bytes_written;
+    uint32_t keycodes_entered;
+    uint32_t requests_sent;
+    // requests from the workload which could not be sent
+    uint32_t requests_refused;
+    uint32_t responses_received;
+} _stats;
+
+/********************************************************
+ * PRIVATE FUNCTIONS
+ *******************************************************/
+
+static bool _bench_nv_flash_read(void* context,
+                                 uint32_t address,
+                                 void* data,
+                                 uint16_t length)
+{
+    const struct bench_nv_flash* flash = (const struct bench_nv_flash*) context;
+    memcpy(data, flash->bytes + address, length);
+    return true;
+}
+
+static bool _bench_nv_flash_program(void* context,
+                                    uint32_t address,
+                                    const void* data,
+                                    uint16_t length)
+{
+    struct bench_nv_flash* flash = (struct bench_nv_flash*) context;
+    const uint8_t* new_bytes = (const uint8_t*) data;
+    for (uint16_t i = 0; i < length; i++)
+    {
+        // programming only clears bits
+        flash->bytes[address + i] &= new_bytes[i];
+    }
+    return true;
+}
+
+static bool _bench_nv_flash_erase_page(void* context, uint8_t page)
+{
+    struct bench_nv_flash* flash = (struct bench_nv_flash*) context;
+    memset(flash->bytes + (uint32_t) page * flash->flash.page_size,
+           0xFF,
+           flash->flash.page_size);
+    if (_stats.counting)
+    {
+        flash->erase_count[page]++;
+    }
+    return true;
+}
+
+static void _bench_nv_flash_open(struct bench_nv_flash* flash,
+                                 uint32_t page_size)
+{
+    memset(flash, 0x00, sizeof(*flash));
+    flash->flash.context = flash;
+    flash->flash.page_size = (uint16_t) page_size;
+    flash->flash.page_count = _options.page_count;
+    flash->flash.read = _bench_nv_flash_read;
+    flash->flash.program = _bench_nv_flash_program;
+    flash->flash.erase_page = _bench_nv_flash_erase_page;
+    flash->bytes = malloc((size_t) page_size * _options.page_count);
+    if (flash->bytes == NULL)
+    {
+        return;
+    }
+    memset(flash->bytes, 0xFF, (size_t) page_size * _options.page_count);
+    // fails if pages cannot hold one record of every block
+    flash->usable = nv_log_init(&flash->log, &flash->flash);
+}
+
+// Keycode entered by the user, with start and end keys
+static void _bench_nv_enter_keycode(const nexus_keycode_encoder_t* encoder,
+                                    uint32_t message_id,
+                                    bool mistyped)
+{
+    struct nexus_keycode_pro_full_message message;
+    memset(&message, 0x00, sizeof(message));
+    message.full_message_id = message_id;
+    message.type_code = NEXUS_KEYCODE_PRO_FULL_ACTIVATION_ADD_CREDIT;
+    message.body.add_set_credit.hours = 24;
+
+    struct nexus_keycode_frame frame;
+    if (nexus_keycode_encoder_full_encode_batch(encoder, &message, 1, &frame) !=
+        1)
+    {
+        return;
+    }
+    if (mistyped)
+    {
+        frame.keys[frame.length - 1] =
+            (nx_keycode_key)(frame.keys[frame.length - 1] == '0' ? '1' : '0');
+    }
+
+    nx_keycode_key keys[NEXUS_KEYCODE_MAX_MESSAGE_LENGTH + 2];
+    keys[0] = '*';
+    memcpy(&keys[1], frame.keys, frame.length);
+    keys[frame.length + 1] = '#';
+    struct nx_keycode_complete_code keycode = {
+        .keys = keys, .length = (uint8_t)(frame.length + 2)};
+    (void) nx_keycode_handle_complete_keycode(&keycode);
+    _stats.keycodes_entered++;
+}
+
+static void _bench_nv_response_handler(nx_channel_client_response_t* response)
+{
+    (void) response;
+}
+
+static struct nx_id _bench_nv_accessory_id(uint8_t index)
+{
+    struct nx_id id = {0, BENCH_NV_FIRST_ACCESSORY_DEVICE_ID + index};
+    return id;
+}
+
+// Answer each secured request sent since the last call
+static void _bench_nv_deliver_responses(void)
+{
+    for (uint8_t i = 0; i < _device.response_count; i++)
+    {
+        struct nexus_channel_link_security_mode0_data security_data;
+        const struct nx_id* accessory_id = &_device.responses[i].dest;
+        // as for a received response, complete the request transaction
+        // and client callback (without parsing a response payload)
+        coap_transaction_t* transaction =
+            coap_get_transaction_by_mid(_device.responses[i].message_id);
+        if (transaction != NULL)
+        {
+            coap_clear_transaction(transaction);
+        }
+        oc_ri_free_client_cbs_by_mid(_device.responses[i].message_id);
+        if (!nexus_channel_link_manager_security_data_from_nxid(
+                accessory_id, &security_data))
+        {
+            continue;
+        }
+        // the accessory responds with the nonce of the request, which
+        // is one more than the current nonce of the link (or the current
+        // nonce, if the request already used it up)
+        const uint32_t response_nonce =
+            NEXUS_CHANNEL_LINK_SECURITY_REPLAY_WINDOW_ENABLED ?
+                security_data.nonce :
+                security_data.nonce + 1;
+        (void) nexus_channel_link_manager_set_security_data_auth_nonce(
+            accessory_id, response_nonce);
+        (void) nexus_channel_link_manager_reset_link_secs_since_active(
+            accessory_id);
+        _stats.responses_received++;
+    }
+    _device.response_count = 0;
+}
+
+// Run `nx_common_process`, and return seconds until it must be run again
+static uint32_t _bench_nv_process(void)
+{
+    uint32_t sleep_seconds = 0;
+    // processing requested during processing is handled immediately
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        _device.processing_requested = false;
+        sleep_seconds = nx_common_process(_device.uptime);
+        _bench_nv_deliver_responses();
+        if (!_device.processing_requested)
+        {
+            break;
+        }
+    }
+    return sleep_seconds;
+}
+
+static void _bench_nv_print_json_years(FILE* out,
+                                       const char* name,
+                                       uint32_t erases)
+{
+    if (erases == 0)
+    {
+        fprintf(out, "\"%s\": null", name);
+        return;
+    }
+    const double erases_per_year =
+        (double) erases / _options.hours * BENCH_NV_HOURS_PER_YEAR;
+    fprintf(out, "\"%s\": %.2f", name, _options.endurance / erases_per_year);
+}
+
+/* Erases of the most-erased page if each page holds whole blocks (packed in
+ * block ID order), and every write of a block erases its page.
+ */
+static uint32_t _bench_nv_in_place_max_page_erases(uint32_t page_size)
+{
+    uint32_t max_erases = 0;
+    uint32_t page_erases = 0;
+    uint32_t page_used = 0;
+    for (uint16_t id = 0; id < BENCH_NV_MAX_BLOCKS; id++)
+    {
+        if (_stats.block_length[id] == 0)
+        {
+            continue;
+        }
+        if (page_used + _stats.block_length[id] > page_size)
+        {
+            page_erases = 0;
+            page_used = 0;
+        }
+        page_used += _stats.block_length[id];
+        page_erases += _stats.writes[id];
+        if (page_erases > max_erases)
+        {
+            max_erases = page_erases;
+        }
+    }
+    return max_erases;
+}
+
+static void _bench_nv_print_json(FILE* out,
+                                 const struct bench_nv_workload* workload)
+{
+    uint32_t total_writes = 0;
+    fprintf(out, "    {\n");
+    fprintf(out, "      \"name\": \"%s\",\n", workload->name);
+    fprintf(out, "      \"simulated_hours\": %u,\n", _options.hours);
+    fprintf(out,
+            "      \"links\": %u,\n",
+            workload->links ? _options.links : 0);
+    fprintf(out, "      \"keycodes_entered\": %u,\n", _stats.keycodes_entered);
+    fprintf(out,
+            "      \"secured_requests_sent\": %u,\n",
+            _stats.requests_sent);
+    fprintf(out,
+            "      \"secured_responses\": %u,\n",
+            _stats.responses_received);
+    fprintf(out,
+            "      \"workload_requests_refused\": %u,\n",
+            _stats.requests_refused);
+    fprintf(out, "      \"writes_per_block\": {");
+    bool first = true;
+    for (uint16_t id = 0; id < BENCH_NV_MAX_BLOCKS; id++)
+    {
+        if (_stats.writes[id] == 0)
+        {
+            continue;
+        }
+        fprintf(out, "%s\"%u\": %u", first ? "" : ", ", id, _stats.writes[id]);
+        total_writes += _stats.writes[id];
+        first = false;
+    }
+    fprintf(out, "},\n");
+    fprintf(out, "      \"writes\": %u,\n", total_writes);
+    fprintf(out, "      \"writes_per_hour\": %.2f,\n",
+            (double) total_writes / _options.hours);
+    fprintf(out,
+            "      \"bytes_written\": %llu,\n",
+            (unsigned long long) _stats.bytes_written);
+    fprintf(out, "      \"erase_projection\": [\n");
+    for (uint8_t i = 0; i < _options.page_size_count; i++)
+    {
+        const struct bench_nv_flash* flash = &_device.flashes[i];
+        const uint32_t in_place_erases =
+            _bench_nv_in_place_max_page_erases(_options.page_sizes[i]);
+        fprintf(out, "        {\"page_size\": %u, ", _options.page_sizes[i]);
+        fprintf(out, "\"in_place_max_page_erases\": %u, ", in_place_erases);
+        _bench_nv_print_json_years(
+            out, "in_place_years_to_endurance", in_place_erases);
+        if (flash->usable)
+        {
+            uint32_t log_erases = 0;
+            for (uint8_t page = 0; page < _options.page_count; page++)
+            {
+                if (flash->erase_count[page] > log_erases)
+                {
+                    log_erases = flash->erase_count[page];
+                }
+            }
+            fprintf(out, ", \"nv_log_max_page_erases\": %u, ", log_erases);
+            _bench_nv_print_json_years(
+                out, "nv_log_years_to_endurance", log_erases);
+        }
+        else
+        {
+            // page too small to hold every block
+            fprintf(out,
+                    ", \"nv_log_max_page_erases\": null, "
+                    "\"nv_log_years_to_endurance\": null");
+        }
+        fprintf(out,
+                "}%s\n",
+                i + 1 < _options.page_size_count ? "," : "");
+    }
+    fprintf(out, "      ]\n");
+    fprintf(out, "    }");
+
+    fprintf(stderr,
+            "%-18s %8u writes (%8.2f/h) %10llu bytes, %u keycodes, %u "
+            "secured requests\n",
+            workload->name,
+            total_writes,
+            (double) total_writes / _options.hours,
+            (unsigned long long) _stats.bytes_written,
+            _stats.keycodes_entered,
+            _stats.requests_sent);
+}
+
+static void _bench_nv_run_workload(const struct bench_nv_workload* workload,
+                                   FILE* out)
+{
+    memset(&_stats, 0x00, sizeof(_stats));
+    for (uint8_t i = 0; i < _options.page_size_count; i++)
+    {
+        _bench_nv_flash_open(&_device.flashes[i], _options.page_sizes[i]);
+    }
+
+    nexus_keycode_encoder_t encoder;
+    nexus_keycode_encoder_init(&encoder, &BENCH_NV_SECRET_KEY);
+
+    // Setup (initial NV writes, link creation) is not counted
+    nx_common_init(_device.uptime);
+    (void) _bench_nv_process();
+    if (workload->links)
+    {
+        for (uint8_t i = 0; i < _options.links; i++)
+        {
+            const struct nx_id accessory_id = _bench_nv_accessory_id(i);
+            union nexus_channel_link_security_data security_data;
+            memset(&security_data, 0x00, sizeof(security_data));
+            security_data.mode0.sym_key = BENCH_NV_LINK_KEY;
+            (void) nexus_channel_link_manager_create_link(
+                &accessory_id,
+                CHANNEL_LINK_OPERATING_MODE_CONTROLLER,
+                NEXUS_CHANNEL_LINK_SECURITY_MODE_KEY128SYM_COSE_MAC0_AUTH_SIPHASH24,
+                &security_data);
+            // one link is created per call
+            (void) _bench_nv_process();
+        }
+    }
+    _stats.counting = true;
+
+    const uint32_t start = _device.uptime;
+    const uint32_t end = start + _options.hours * 3600;
+    uint32_t next_keycode = UINT32_MAX;
+    uint32_t next_message = UINT32_MAX;
+    uint32_t message_step = 0;
+    uint8_t message_link = 0;
+    uint32_t keycode_message_id = 0;
+    uint8_t keycodes_left_in_burst = 0;
+    if (workload->keycodes && _options.keycodes_per_burst > 0)
+    {
+        next_keycode = start + 60;
+    }
+    if (workload->messages && _options.message_interval_seconds > 0 &&
+        _options.links > 0)
+    {
+        // requests to different accessories are spread over the interval
+        message_step = _options.message_interval_seconds / _options.links;
+        message_step = message_step > 0 ? message_step : 1;
+        next_message = start + message_step;
+    }
+
+    while (_device.uptime < end)
+    {
+        uint32_t sleep_seconds = _bench_nv_process();
+        if (sleep_seconds > BENCH_NV_MAX_STEP_SECONDS)
+        {
+            sleep_seconds = BENCH_NV_MAX_STEP_SECONDS;
+        }
+        uint32_t next =
+            _device.uptime + (sleep_seconds > 0 ? sleep_seconds : 1);
+        next = next_keycode < next ? next_keycode : next;
+        next = next_message < next ? next_message : next;
+        _device.uptime = next < end ? next : end;
+
+        if (_device.uptime >= next_keycode)
+        {
+            if (keycodes_left_in_burst == 0)
+            {
+                keycodes_left_in_burst = _options.keycodes_per_burst;
+            }
+            // last keycode of each burst is mistyped, and entered again
+            _bench_nv_enter_keycode(
+                &encoder, keycode_message_id, keycodes_left_in_burst == 1);
+            if (keycodes_left_in_burst == 1)
+            {
+                _bench_nv_enter_keycode(&encoder, keycode_message_id, false);
+            }
+            keycode_message_id++;
+            keycodes_left_in_burst--;
+            next_keycode =
+                _device.uptime +
+                (keycodes_left_in_burst > 0 ?
+                     BENCH_NV_KEYCODE_ENTRY_SECONDS :
+                     _options.keycode_interval_hours * 3600);
+        }
+        if (_device.uptime >= next_message)
+        {
+            const struct nx_id accessory_id =
+                _bench_nv_accessory_id(message_link);
+            const nx_channel_error result =
+                nx_channel_do_get_request_secured("nx/pc",
+                                                  &accessory_id,
+                                                  NULL,
+                                                  _bench_nv_response_handler,
+                                                  NULL);
+            if (result != NX_CHANNEL_ERROR_NONE)
+            {
+                _stats.requests_refused++;
+            }
+            message_link = (uint8_t)((message_link + 1) % _options.links);
+            next_message = _device.uptime + message_step;
+        }
+    }
+
+    // writes still pending in RAM (e.g. in the NV cache) are counted
+    nx_common_shutdown();
+    _bench_nv_print_json(out, workload);
+}
+
+/* Run a workload in a separate process, so that every workload starts from
+ * freshly initialized Nexus library state. Returns false on failure.
+ */
+static bool _bench_nv_run_isolated(const struct bench_nv_workload* workload,
+                                   FILE* out,
+                                   bool first)
+{
+    int fds[2];
+    if (pipe(fds) != 0)
+    {
+        return false;
+    }
+    const pid_t pid = fork();
+    if (pid < 0)
+    {
+        return false;
+    }
+    if (pid == 0)
+    {
+        close(fds[0]);
+        // discard library logging (`CONFIG_NEXUS_COMMON_OC_PRINT_LOG_ENABLED`)
+        if (freopen("/dev/null", "w", stdout) == NULL)
+        {
+            _exit(EXIT_FAILURE);
+        }
+        FILE* child_out = fdopen(fds[1], "w");
+        if (child_out == NULL)
+        {
+            _exit(EXIT_FAILURE);
+        }
+        _bench_nv_run_workload(workload, child_out);
+        fclose(child_out);
+        _exit(EXIT_SUCCESS);
+    }
+
+    close(fds[1]);
+    char buffer[BENCH_NV_MAX_OUTPUT_SIZE];
+    size_t length = 0;
+    ssize_t count;
+    while ((count = read(fds[0], buffer + length, sizeof(buffer) - length)) >
+           0)
+    {
+        length += (size_t) count;
+    }
+    close(fds[0]);
+
+    int status;
+    if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) ||
+        WEXITSTATUS(status) != EXIT_SUCCESS || length == sizeof(buffer))
+    {
+        fprintf(stderr, "Workload %s failed\n", workload->name);
+        return false;
+    }
+    fprintf(out, "%s%.*s", first ? "" : ",\n", (int) length, buffer);
+    return true;
+}
+
+static bool _bench_nv_parse_options(int argc, char** argv, const char** output)
+{
+    _options.hours = 24 * 7;
+    _options.page_count = 4;
+    _options.endurance = 10000;
+    _options.links = 4;
+    _options.keycode_interval_hours = 24;
+    _options.keycodes_per_burst = 3;
+    _options.message_interval_seconds = 60;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strncmp(argv[i], "--", 2) != 0)
+        {
+            *output = argv[i];
+            continue;
+        }
+        if (value == NULL)
+        {
+            return false;
+        }
+        i++;
+        if (strcmp(argv[i - 1], "--workload") == 0)
+        {
+            _options.only_workload = value;
+            continue;
+        }
+        const unsigned long number = strtoul(value, NULL, 10);
+        if (strcmp(argv[i - 1], "--hours") == 0 && number > 0)
+        {
+            _options.hours = (uint32_t) number;
+        }
+        else if (strcmp(argv[i - 1], "--page-size") == 0 &&
+                 _options.page_size_count < BENCH_NV_MAX_PAGE_SIZES &&
+                 number > 0 && number <= UINT16_MAX)
+        {
+            _options.page_sizes[_options.page_size_count++] = (uint32_t) number;
+        }
+        else if (strcmp(argv[i - 1], "--page-count") == 0 && number >= 2 &&
+                 number <= NV_LOG_MAX_PAGES)
+        {
+            _options.page_count = (uint8_t) number;
+        }
+        else if (strcmp(argv[i - 1], "--endurance") == 0 && number > 0)
+        {
+            _options.endurance = (uint32_t) number;
+        }
+        else if (strcmp(argv[i - 1], "--links") == 0 &&
+                 number <= NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS)
+        {
+            _options.links = (uint8_t) number;
+        }
+        else if (strcmp(argv[i - 1], "--keycode-interval") == 0 && number > 0)
+        {
+            _options.keycode_interval_hours = (uint32_t) number;
+        }
+        else if (strcmp(argv[i - 1], "--keycodes-per-burst") == 0 &&
+                 number <= UINT8_MAX)
+        {
+            _options.keycodes_per_burst = (uint8_t) number;
+        }
+        else if (strcmp(argv[i - 1], "--message-interval") == 0)
+        {
+            _options.message_interval_seconds = (uint32_t) number;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    if (_options.page_size_count == 0)
+    {
+        static const uint32_t default_page_sizes[] = {1024, 2048, 4096};
+        for (uint8_t i = 0; i < 3; i++)
+        {
+            _options.page_sizes[i] = default_page_sizes[i];
+        }
+        _options.page_size_count = 3;
+    }
+    return true;
+}
+
+/********************************************************
+ * PRODUCT INTERFACE
+ *******************************************************/
+
+void nxp_common_request_processing(void)
+{
+    _device.processing_requested = true;
+}
+
+bool nxp_common_nv_write(const struct nx_common_nv_block_meta block_meta,
+                         void* write_buffer)
+{
+    if (block_meta.block_id >= BENCH_NV_MAX_BLOCKS ||
+        block_meta.length > NX_COMMON_NV_MAX_BLOCK_LENGTH)
+    {
+        return false;
+    }
+    memcpy(_device.nv[block_meta.block_id], write_buffer, block_meta.length);
+    _device.nv_valid[block_meta.block_id] = true;
+
+    for (uint8_t i = 0; i < _options.page_size_count; i++)
+    {
+        if (_device.flashes[i].usable)
+        {
+            (void) nv_log_write(
+                &_device.flashes[i].log, block_meta, write_buffer);
+        }
+    }
+
+    if (_stats.counting)
+    {
+        _stats.writes[block_meta.block_id]++;
+        _stats.block_length[block_meta.block_id] = block_meta.length;
+        _stats.bytes_written += block_meta.length;
+    }
+    return true;
+}
+
+bool nxp_common_nv_write_v(const struct nx_common_nv_block_meta block_meta,
+                           const struct nx_common_nv_write_segment* segments,
+                           uint8_t segment_count)
+{
+    uint8_t block[NX_COMMON_NV_MAX_BLOCK_LENGTH];
+    uint16_t length = 0;
+    for (uint8_t i = 0; i < segment_count; i++)
+    {
+        if (length + segments[i].length > sizeof(block))
+        {
+            return false;
+        }
+        memcpy(block + length, segments[i].data, segments[i].length);
+        length = (uint16_t)(length + segments[i].length);
+    }
+    return length == block_meta.length &&
+           nxp_common_nv_write(block_meta, block);
+}
+
+bool nxp_common_nv_read(const struct nx_common_nv_block_meta block_meta,
+                        void* read_buffer)
+{
+    if (block_meta.block_id >= BENCH_NV_MAX_BLOCKS ||
+        !_device.nv_valid[block_meta.block_id])
+    {
+        return false;
+    }
+    memcpy(read_buffer, _device.nv[block_meta.block_id], block_meta.length);
+    return true;
+}
+
+enum nxp_common_payg_state nxp_common_payg_state_get_current(void)
+{
+    return _device.credit > 0 ? NXP_COMMON_PAYG_STATE_ENABLED :
+                                NXP_COMMON_PAYG_STATE_DISABLED;
+}
+
+uint32_t nxp_common_payg_credit_get_remaining(void)
+{
+    return _device.credit;
+}
+
+bool nxp_keycode_feedback_start(enum nxp_keycode_feedback_type feedback_type)
+{
+    (void) feedback_type;
+    return true;
+}
+
+bool nxp_keycode_payg_credit_add(uint32_t credit)
+{
+    _device.credit += credit;
+    return true;
+}
+
+bool nxp_keycode_payg_credit_set(uint32_t credit)
+{
+    _device.credit = credit;
+    return true;
+}
+
+bool nxp_keycode_payg_credit_unlock(void)
+{
+    _device.credit = UINT32_MAX;
+    return true;
+}
+
+struct nx_common_check_key nxp_keycode_get_secret_key(void)
+{
+    return BENCH_NV_SECRET_KEY;
+}
+
+uint32_t nxp_keycode_get_user_facing_id(void)
+{
+    return 12345678;
+}
+
+void nxp_keycode_notify_custom_flag_changed(enum nx_keycode_custom_flag flag,
+                                            bool value)
+{
+    (void) flag;
+    (void) value;
+}
+
+enum nxp_keycode_passthrough_error nxp_keycode_passthrough_keycode(
+    const struct nx_keycode_complete_code* passthrough_keycode)
+{
+    (void) passthrough_keycode;
+    return NXP_KEYCODE_PASSTHROUGH_ERROR_DATA_UNRECOGNIZED;
+}
+
+struct nx_common_check_key nxp_channel_symmetric_origin_key(void)
+{
+    return BENCH_NV_SECRET_KEY;
+}
+
+void nxp_channel_notify_event(enum nxp_channel_event_type event)
+{
+    (void) event;
+}
+
+nx_channel_error nxp_channel_network_send(const void* const bytes_to_send,
+                                          uint32_t bytes_count,
+                                          const struct nx_id* const source,
+                                          const struct nx_id* const dest,
+                                          bool is_multicast)
+{
+    (void) source;
+    const uint8_t* bytes = (const uint8_t*) bytes_to_send;
+    // CoAP header: version/type/token length, code, message ID
+    if (is_multicast || bytes_count < 4 || bytes[1] < 1 || bytes[1] > 4)
+    {
+        return NX_CHANNEL_ERROR_NONE;
+    }
+
+    // retransmissions of a request are only answered once
+    const uint16_t message_id = (uint16_t)((bytes[2] << 8) | bytes[3]);
+    for (uint8_t i = 0; i < BENCH_NV_RECENT_REQUESTS; i++)
+    {
+        if (_device.recent_requests[i].message_id == message_id &&
+            memcmp(&_device.recent_requests[i].dest, dest, sizeof(*dest)) == 0)
+        {
+            return NX_CHANNEL_ERROR_NONE;
+        }
+    }
+    _device.recent_requests[_device.recent_request_next].dest = *dest;
+    _device.recent_requests[_device.recent_request_next].message_id =
+        message_id;
+    _device.recent_request_next = (uint8_t)(
+        (_device.recent_request_next + 1) % BENCH_NV_RECENT_REQUESTS);
+
+    _stats.requests_sent++;
+    if (_device.response_count < BENCH_NV_MAX_RESPONSES)
+    {
+        _device.responses[_device.response_count].dest = *dest;
+        _device.responses[_device.response_count].message_id = message_id;
+        _device.response_count++;
+    }
+    return NX_CHANNEL_ERROR_NONE;
+}
+
+struct nx_id nxp_channel_get_nexus_id(void)
+{
+    return BENCH_NV_CONTROLLER_ID;
+}
+
+uint32_t nxp_channel_random_value(void)
+{
+    return (uint32_t) rand();
+}
+
+nx_channel_error nxp_channel_payg_credit_set(uint32_t remaining)
+{
+    _device.credit = remaining;
+    return NX_CHANNEL_ERROR_NONE;
+}
+
+nx_channel_error nxp_channel_payg_credit_unlock(void)
+{
+    _device.credit = UINT32_MAX;
+    return NX_CHANNEL_ERROR_NONE;
+}
+
+int main(int argc, char** argv)
+{
+    const char* output = NULL;
+    if (!_bench_nv_parse_options(argc, argv, &output))
+    {
+        fprintf(stderr,
+                "Usage: %s [--hours N] [--page-size BYTES]... "
+                "[--page-count N] [--endurance CYCLES] [--links N] "
+                "[--keycode-interval HOURS] [--keycodes-per-burst N] "
+                "[--message-interval SECONDS] [--workload NAME] "
+                "[output.json]\n",
+                argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // credit is available, so that PAYG credit is shared with accessories
+    _device.credit = 7 * 24 * 3600;
+    _device.uptime = 0;
+
+    FILE* out = stdout;
+    if (output != NULL)
+    {
+        out = fopen(output, "w");
+        if (out == NULL)
+        {
+            fprintf(stderr, "Unable to open %s\n", output);
+            return EXIT_FAILURE;
+        }
+    }
+
+    fprintf(out, "{\n");
+    fprintf(out,
+            "  \"nonce_nv_storage_interval\": %u,\n",
+            NEXUS_CHANNEL_LINK_SECURITY_NONCE_NV_STORAGE_INTERVAL_COUNT);
+    fprintf(out, "  \"nv_cache_enabled\": %s,\n",
+            NEXUS_NV_CACHE_ENABLED ? "true" : "false");
+    fprintf(out, "  \"nv_transactions_enabled\": %s,\n",
+            NEXUS_NV_TRANSACTIONS_ENABLED ? "true" : "false");
+    fprintf(out,
+            "  \"adaptive_nonce_reservation_enabled\": %s,\n",
+            NEXUS_CHANNEL_ADAPTIVE_NONCE_RESERVATION_ENABLED ? "true"
+                                                              : "false");
+    fprintf(out, "  \"nv_log_page_count\": %u,\n", _options.page_count);
+    fprintf(out, "  \"endurance_cycles\": %u,\n", _options.endurance);
+    fprintf(out, "  \"workloads\": [\n");
+
+    bool first = true;
+    bool success = true;
+    for (size_t i = 0;
+         i < sizeof(BENCH_NV_WORKLOADS) / sizeof(BENCH_NV_WORKLOADS[0]);
+         i++)
+    {
+        if (_options.only_workload != NULL &&
+            strcmp(_options.only_workload, BENCH_NV_WORKLOADS[i].name) != 0)
+        {
+            continue;
+        }
+        fflush(out);
+        success =
+            _bench_nv_run_isolated(&BENCH_NV_WORKLOADS[i], out, first) &&
+            success;
+        first = false;
+    }
+    fprintf(out, "\n  ]\n}\n");
+
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,105 @@
+#!/usr/bin/env python3
+"""Compare Nexus benchmark results against regression thresholds.
+
+Usage:
+    check_bench_thresholds.py RESULTS THRESHOLDS
+    check_bench_thresholds.py --update RESULTS THRESHOLDS
+
+RESULTS is the JSON output of `nexus_benchmark`. THRESHOLDS is a JSON file
+of the form:
+
+    {
+        "tolerance": 0.5,
+        "baseline_ns_per_op": {"siphash24_compute/64": 51.6, ...},
+        "tolerance_overrides": {"cose_mac0_verify/0": 1.0}
+    }
+
+A benchmark regresses if its `ns_per_op` exceeds its baseline by more than
+its tolerance (a fraction of the baseline). Benchmarks without a baseline
+are reported, but do not fail the check.
+
+With `--update`, the baselines in THRESHOLDS are replaced by RESULTS
+(tolerances are preserved) instead of checking.
+"""
+
+import argparse
+import json
+import sys
+
+DEFAULT_TOLERANCE = 0.5
+
+
+def load_json(path):
+    with open(path) as f:
+        return json.load(f)
+
+
+def update(results, thresholds_path):
+    try:
+        thresholds = load_json(thresholds_path)
+    except FileNotFoundError:
+        thresholds = {"tolerance": DEFAULT_TOLERANCE}
+
+    thresholds["baseline_ns_per_op"] = {
+        bench["name"]: round(bench["ns_per_op"], 1)
+        for bench in results["benchmarks"]
+    }
+    with open(thresholds_path, "w") as f:
+        json.dump(thresholds, f, indent=4, sort_keys=True)
+        f.write("\n")
+    print("Updated {} baselines in {}".format(
+        len(thresholds["baseline_ns_per_op"]), thresholds_path))
+    return 0
+
+
+def check(results, thresholds):
+    default_tolerance = thresholds.get("tolerance", DEFAULT_TOLERANCE)
+    baselines = thresholds.get("baseline_ns_per_op", {})
+    overrides = thresholds.get("tolerance_overrides", {})
+
+    regressions = 0
+    for bench in results["benchmarks"]:
+        name = bench["name"]
+        measured = bench["ns_per_op"]
+        if name not in baselines:
+            print("{:<48} {:>10.1f} ns/op  (no baseline)".format(
+                name, measured))
+            continue
+
+        baseline = baselines[name]
+        tolerance = overrides.get(name, default_tolerance)
+        limit = baseline * (1.0 + tolerance)
+        change = (measured - baseline) / baseline * 100.0
+        status = "ok"
+        if measured > limit:
+            status = "REGRESSION (limit {:.1f})".format(limit)
+            regressions += 1
+        print("{:<48} {:>10.1f} ns/op {:>+7.1f}%  {}".format(
+            name, measured, change, status))
+
+    if regressions:
+        print("{} benchmark(s) regressed beyond threshold".format(regressions))
+        return 1
+    print("All benchmarks within thresholds")
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("results", help="benchmark results JSON")
+    parser.add_argument("thresholds", help="regression thresholds JSON")
+    parser.add_argument(
+        "--update",
+        action="store_true",
+        help="replace baselines in THRESHOLDS with RESULTS",
+    )
+    args = parser.parse_args()
+
+    results = load_json(args.results)
+    if args.update:
+        return update(results, args.thresholds)
+    return check(results, load_json(args.thresholds))
+
+
+if __name__ == "__main__":
+    sys.exit(main())
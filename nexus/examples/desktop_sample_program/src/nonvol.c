@@ -9,19 +9,32 @@
  */
 
 #include "nonvol.h"
+#include "clock.h"
 #include "identity.h"
 #include "nx_keycode.h"
 #include "nxp_common.h"
 #include "payg_state.h"
-#include <assert.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 /**
  * NOTE: This implementation assumes a POSIX compliant file system. Embedded
  * applications will require a platform-specific implementation.
+ *
+ * Blocks are appended to a log file as records (sentinel, block ID, block
+ * length, block data). The file is memory-mapped, and an index in RAM holds
+ * the location of the latest record of each block, so reads do not scan the
+ * file. When the file is full and mostly holds outdated records, the latest
+ * records are copied to a new file which replaces it.
+ *
+ * The file is locked for as long as this program runs, since the index is
+ * only valid while no other process writes to the file.
  */
 
 #define BLOCK_SENTINEL_NX 'n' // indicates Nexus Keycode NV blocks
@@ -30,103 +43,325 @@
 #define PROD_PAYG_STATE_BLOCK_ID 0
 #define PROD_IDENTITY_BLOCK_ID 1
 
+// Sentinel (1 byte), block ID (2 bytes), block length (1 byte)
+#define NV_RECORD_HEADER_SIZE 4
+// Block IDs 0 to `NV_INDEX_MAX_BLOCK_ID - 1` may be stored
+#define NV_INDEX_MAX_BLOCK_ID 256
+#define NV_INDEX_NO_RECORD 0
+// The file is extended in multiples of this size; unused space at the end
+// of the file is zero-filled.
+#define NV_FILE_MIN_SIZE (64 * 1024)
+// Writes are synced to disk after this many writes, or when writing more
+// than this many seconds after the last sync
+#define NV_SYNC_WRITE_COUNT 32
+#define NV_SYNC_INTERVAL_SECONDS 2
+
 static struct
 {
     char nv_file_path[100];
+    int fd;
+    uint8_t* map;
+    size_t map_size; // size of the file and of `map`
+    size_t used; // bytes of `map` holding records
+    size_t live; // bytes of `map` holding the latest record of a block
+    // offset of the data of the latest record of each block (or
+    // `NV_INDEX_NO_RECORD`), for Nexus blocks ([0]) and product blocks ([1])
+    size_t index[2][NV_INDEX_MAX_BLOCK_ID];
+    uint32_t unsynced_writes;
+    uint32_t last_sync_seconds;
 } _this;
 
-bool nv_init(void)
+static size_t* _index_entry(char block_sentinel, uint16_t block_id)
 {
-    // Prompt for the location to read/write data to.
-    printf("Please enter the path to the NV file (if it does not exist, then "
-           "it will be created).\n");
+    if (block_id >= NV_INDEX_MAX_BLOCK_ID)
+    {
+        return NULL;
+    }
+    if (block_sentinel == BLOCK_SENTINEL_NX)
+    {
+        return &_this.index[0][block_id];
+    }
+    if (block_sentinel == BLOCK_SENTINEL_PROD)
+    {
+        return &_this.index[1][block_id];
+    }
+    return NULL;
+}
 
-    scanf("%s", &_this.nv_file_path[0]);
+static void _sync(void)
+{
+    if (_this.map != NULL && _this.unsynced_writes > 0)
+    {
+        (void) msync(_this.map, _this.map_size, MS_SYNC);
+    }
+    _this.unsynced_writes = 0;
+    _this.last_sync_seconds = clock_read_monotonic_time_seconds();
+}
 
-    // Ensure the file exists before first read.
-    FILE* fptr = NULL;
-    fptr = fopen(_this.nv_file_path, "ab");
-    if (fptr == NULL)
+// Map `size` bytes of the open file, extending the file if needed
+static bool _map(size_t size)
+{
+    if (_this.map != NULL)
+    {
+        munmap(_this.map, _this.map_size);
+        _this.map = NULL;
+    }
+    if (ftruncate(_this.fd, (off_t) size) != 0)
     {
-        // Unable to open the file; exit the program.
-        perror(
-            "Unable to find or create file at the specified path. Closing.\n");
         return false;
     }
+    void* map =
+        mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, _this.fd, 0);
+    if (map == MAP_FAILED)
+    {
+        return false;
+    }
+    _this.map = (uint8_t*) map;
+    _this.map_size = size;
+    return true;
+}
 
-    fclose(fptr);
+// Scan all records in the mapped file to build the index
+static void _load_index(void)
+{
+    memset(_this.index, 0x00, sizeof(_this.index));
+    _this.used = 0;
+    _this.live = 0;
 
-    return true;
+    while (_this.used + NV_RECORD_HEADER_SIZE <= _this.map_size)
+    {
+        const uint8_t* header = _this.map + _this.used;
+        uint16_t block_id;
+        memcpy(&block_id, &header[1], sizeof(uint16_t));
+        const uint8_t block_length = header[3];
+        const size_t data_offset = _this.used + NV_RECORD_HEADER_SIZE;
+        size_t* entry = _index_entry((char) header[0], block_id);
+
+        // unused (zero-filled) space, or a record interrupted by power loss
+        if (entry == NULL || data_offset + block_length > _this.map_size)
+        {
+            break;
+        }
+        if (*entry != NV_INDEX_NO_RECORD)
+        {
+            _this.live -= NV_RECORD_HEADER_SIZE + _this.map[*entry - 1];
+        }
+        *entry = data_offset;
+        _this.live += NV_RECORD_HEADER_SIZE + block_length;
+        _this.used = data_offset + block_length;
+    }
 }
 
-void _unlock_and_close_file(FILE* fptr)
+// Size of the file needed to hold `bytes` of records
+static size_t _file_size_for(size_t bytes)
 {
-    assert(flock(fileno(fptr), LOCK_UN) == 0);
-    fclose(fptr);
+    size_t size = NV_FILE_MIN_SIZE;
+    while (size < bytes)
+    {
+        size *= 2;
+    }
+    return size;
 }
 
-bool nv_write(char block_sentinel,
-              uint16_t block_id,
-              uint8_t block_length,
-              void* write_buffer)
+/* Replace the file with a new file holding only the latest record of each
+ * block, followed by space for at least `extra_bytes` of new records.
+ *
+ * The new file is written completely before it replaces the old file, so
+ * that no records are lost if this program exits during compaction.
+ */
+static bool _compact(size_t extra_bytes)
 {
-    // Append NV blocks to the end of the file. This way failed writes will not
-    // corrupt stable data.
-    FILE* fptr = NULL;
-    fptr = fopen(_this.nv_file_path, "ab");
+    char tmp_path[sizeof(_this.nv_file_path) + 4];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", _this.nv_file_path);
 
-    // Should always be able to open the file that was previously specified.
-    if (fptr == NULL)
+    const int fd = open(tmp_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
     {
         return false;
     }
-
-    // Place an exclusive lock on this file while writing; no other process
-    // should be reading or writing to it at this time.
-    if (flock(fileno(fptr), LOCK_EX) != 0)
+    const size_t new_size = _file_size_for(_this.live + extra_bytes);
+    bool success =
+        flock(fd, LOCK_EX) == 0 && ftruncate(fd, (off_t) new_size) == 0;
+
+    // copy the latest records, in their existing order
+    off_t write_offset = 0;
+    size_t offset = 0;
+    while (success && offset < _this.used)
+    {
+        const uint8_t* header = _this.map + offset;
+        uint16_t block_id;
+        memcpy(&block_id, &header[1], sizeof(uint16_t));
+        const size_t record_size = NV_RECORD_HEADER_SIZE + header[3];
+        const size_t* entry = _index_entry((char) header[0], block_id);
+        if (*entry == offset + NV_RECORD_HEADER_SIZE)
+        {
+            success = pwrite(fd, header, record_size, write_offset) ==
+                      (ssize_t) record_size;
+            write_offset += (off_t) record_size;
+        }
+        offset += record_size;
+    }
+    success = success && fsync(fd) == 0 &&
+              rename(tmp_path, _this.nv_file_path) == 0;
+    if (!success)
     {
-        _unlock_and_close_file(fptr);
+        close(fd);
+        (void) unlink(tmp_path);
         return false;
     }
 
-    // Write block sentinel.
-    if (fputc(block_sentinel, fptr) != block_sentinel)
+    // continue with the new file, which is already locked
+    munmap(_this.map, _this.map_size);
+    _this.map = NULL;
+    close(_this.fd);
+    _this.fd = fd;
+    _this.unsynced_writes = 0;
+    if (!_map(new_size))
     {
-        _unlock_and_close_file(fptr);
         return false;
     }
+    _load_index();
+    return true;
+}
+
+// Ensure that `bytes` more bytes of records fit in the mapped file
+static bool _reserve(size_t bytes)
+{
+    if (_this.used + bytes <= _this.map_size)
+    {
+        return true;
+    }
+    // if most records are outdated, compaction is enough to make space
+    if (_this.live < _this.used / 2)
+    {
+        return _compact(bytes);
+    }
+    _sync();
+    return _map(_file_size_for(_this.used + bytes));
+}
 
-    // Write block ID.
-    fwrite(&block_id, sizeof(uint16_t), 1, fptr);
-    if (ferror(fptr) != 0)
+bool nv_init(void)
+{
+    // Prompt for the location to read/write data to.
+    printf("Please enter the path to the NV file (if it does not exist, then "
+           "it will be created).\n");
+
+    scanf("%99s", &_this.nv_file_path[0]);
+
+    // Lock the file for as long as this program runs. Another process may
+    // have replaced the file (by compacting it) while we waited for the lock;
+    // if so, lock the new file instead.
+    while (true)
     {
-        _unlock_and_close_file(fptr);
-        return false;
+        _this.fd = open(_this.nv_file_path, O_RDWR | O_CREAT, 0644);
+        if (_this.fd < 0)
+        {
+            // Unable to open the file; exit the program.
+            perror("Unable to find or create file at the specified path. "
+                   "Closing.\n");
+            return false;
+        }
+        struct stat locked;
+        struct stat current;
+        if (flock(_this.fd, LOCK_EX) != 0 || fstat(_this.fd, &locked) != 0)
+        {
+            close(_this.fd);
+            return false;
+        }
+        if (stat(_this.nv_file_path, &current) == 0 &&
+            current.st_ino == locked.st_ino && current.st_dev == locked.st_dev)
+        {
+            break;
+        }
+        close(_this.fd);
     }
 
-    // Write block length.
-    fwrite(&block_length, sizeof(uint8_t), 1, fptr);
-    if (ferror(fptr) != 0)
+    struct stat file_stat;
+    if (fstat(_this.fd, &file_stat) != 0 ||
+        !_map(_file_size_for((size_t) file_stat.st_size)))
     {
-        _unlock_and_close_file(fptr);
+        perror("Unable to map the NV file. Closing.\n");
         return false;
     }
+    _load_index();
+    _this.unsynced_writes = 0;
+    _this.last_sync_seconds = clock_read_monotonic_time_seconds();
+
+    // write any unsynced data to disk when the program exits
+    atexit(_sync);
+
+    return true;
+}
 
-    // Write block data.
-    int write_count =
-        (int) fwrite(write_buffer, sizeof(uint8_t), block_length, fptr);
-    if (ferror(fptr) != 0 || write_count != block_length)
+// Write a block given as `segment_count` segments, which together are
+// `block_length` bytes long
+bool nv_write_v(char block_sentinel,
+                uint16_t block_id,
+                uint8_t block_length,
+                const struct nx_common_nv_write_segment* segments,
+                uint8_t segment_count)
+{
+    size_t* entry = _index_entry(block_sentinel, block_id);
+    if (entry == NULL || _this.map == NULL ||
+        !_reserve(NV_RECORD_HEADER_SIZE + (size_t) block_length))
     {
-        _unlock_and_close_file(fptr);
         return false;
     }
 
-    // asserts and will fail if unlock failed
-    _unlock_and_close_file(fptr);
+    // Append the record after all existing records. This way failed writes
+    // will not corrupt stable data.
+    uint8_t* record = _this.map + _this.used;
+    size_t data_length = 0;
+    for (uint8_t i = 0; i < segment_count; i++)
+    {
+        if (data_length + segments[i].length > block_length)
+        {
+            return false;
+        }
+        memcpy(record + NV_RECORD_HEADER_SIZE + data_length,
+               segments[i].data,
+               segments[i].length);
+        data_length += segments[i].length;
+    }
+    if (data_length != block_length)
+    {
+        return false;
+    }
+    // The sentinel is written last, so that `_load_index` only finds the
+    // record once it is complete.
+    record[3] = block_length;
+    memcpy(&record[1], &block_id, sizeof(uint16_t));
+    record[0] = (uint8_t) block_sentinel;
 
+    if (*entry != NV_INDEX_NO_RECORD)
+    {
+        _this.live -= NV_RECORD_HEADER_SIZE + _this.map[*entry - 1];
+    }
+    *entry = _this.used + NV_RECORD_HEADER_SIZE;
+    _this.live += NV_RECORD_HEADER_SIZE + block_length;
+    _this.used += NV_RECORD_HEADER_SIZE + block_length;
+
+    // Writes are synced to disk in batches
+    _this.unsynced_writes++;
+    if (_this.unsynced_writes >= NV_SYNC_WRITE_COUNT ||
+        clock_read_monotonic_time_seconds() - _this.last_sync_seconds >=
+            NV_SYNC_INTERVAL_SECONDS)
+    {
+        _sync();
+    }
     return true;
 }
 
+bool nv_write(char block_sentinel,
+              uint16_t block_id,
+              uint8_t block_length,
+              void* write_buffer)
+{
+    const struct nx_common_nv_write_segment segment = {
+        .data = write_buffer, .length = block_length};
+    return nv_write_v(block_sentinel, block_id, block_length, &segment, 1);
+}
+
 bool nxp_common_nv_write(const struct nx_common_nv_block_meta block_meta,
                          void* write_buffer)
 {
@@ -136,6 +371,17 @@ bool nxp_common_nv_write(const struct nx_common_nv_block_meta block_meta,
                     write_buffer);
 }
 
+bool nxp_common_nv_write_v(const struct nx_common_nv_block_meta block_meta,
+                           const struct nx_common_nv_write_segment* segments,
+                           uint8_t segment_count)
+{
+    return nv_write_v(BLOCK_SENTINEL_NX,
+                      block_meta.block_id,
+                      block_meta.length,
+                      segments,
+                      segment_count);
+}
+
 bool prod_nv_write_identity(uint8_t length, void* write_buffer)
 {
     return nv_write(
@@ -153,92 +399,19 @@ bool nv_read(char block_sentinel,
              uint8_t block_length,
              void* read_buffer)
 {
-    // Open the file containing NV information.
-    FILE* fptr = NULL;
-    fptr = fopen(_this.nv_file_path, "rb");
-
-    // Should always be able to open the file that was previously specified.
-    if (fptr == NULL)
-    {
-        return false;
-    }
-
-    // Place a shared lock on the file while reading; other processes may
-    // also place locks.
-    if (flock(fileno(fptr), LOCK_SH) != 0)
+    const size_t* entry = _index_entry(block_sentinel, block_id);
+    if (entry == NULL || *entry == NV_INDEX_NO_RECORD)
     {
-        fclose(fptr);
         return false;
     }
 
-    // Keep track of whether or not we found the block.
-    bool success = false;
-    while (feof(fptr) == 0)
-    {
-        uint16_t cur_block_id = 0;
-        uint8_t cur_block_length = 1;
-
-        // Read block sentinel.
-        int cur_block_sentinel = fgetc(fptr);
-        if (cur_block_sentinel == EOF)
-        {
-            break;
-        }
-
-        // Read block metadata.
-        if (fread(&cur_block_id, sizeof(uint16_t), 1, fptr) != 1)
-        {
-            break;
-        }
-
-        if (fread(&cur_block_length, sizeof(uint8_t), 1, fptr) != 1)
-        {
-            break;
-        }
-
-        // Note that `malloc` is not an option on many embedded platforms.
-        uint8_t* block = (uint8_t*) malloc(cur_block_length * sizeof(uint8_t));
-        if (block == NULL)
-        {
-            break;
-        }
-
-        // Read block data.
-        memset(block, 0, cur_block_length * sizeof(uint8_t));
-        if (fread(block, sizeof(uint8_t), cur_block_length, fptr) !=
-            cur_block_length)
-        {
-            break;
-        }
-
-        // Validate the block and check if the block ID is the one that was
-        // requested.
-        if ((char) cur_block_sentinel == block_sentinel &&
-            cur_block_id == block_id && cur_block_length == block_length)
-        {
-            // We continue if we found the requested block or not as there may
-            // be a more recent version of this block later in the file due to
-            // appending in `port_nv_write`.
-            success = true;
-            memcpy(read_buffer, block, cur_block_length);
-        }
-
-        if (block != NULL)
-        {
-            free(block);
-        }
-    }
-
-    // Safely close the file and release the lock.
-    if (flock(fileno(fptr), LOCK_UN) != 0)
+    // The latest record of the block must have the requested length
+    if (_this.map[*entry - 1] != block_length)
     {
-        fclose(fptr);
         return false;
     }
-
-    fclose(fptr);
-
-    return success;
+    memcpy(read_buffer, _this.map + *entry, block_length);
+    return true;
 }
 
 bool nxp_common_nv_read(const struct nx_common_nv_block_meta block_meta,
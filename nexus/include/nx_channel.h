@@ -313,6 +313,85 @@ nx_channel_error nx_channel_network_receive(const void* const bytes_received,
                                             uint32_t bytes_count,
                                             const struct nx_id* const source);
 
+/** Received Nexus Channel application data from one device.
+ *
+ * Used to pass several received packets to Nexus Channel at once, see
+ * `nx_channel_network_receive_batch`.
+ */
+struct nx_channel_network_frame
+{
+    const void* bytes_received; // received application data
+    uint32_t bytes_count; // number of bytes to read from `bytes_received`
+    struct nx_id source; // Nexus ID of sending device
+};
+
+/*! \brief Handle several incoming Nexus Channel application packets
+ *
+ * Equivalent to calling `nx_channel_network_receive` for each frame in
+ * `frames` in order, stopping at the first frame which is not accepted.
+ *
+ * Received packets wait for processing in `nx_common_process`, and only a
+ * limited number of packets may wait at once. `free_count` reports how many
+ * more packets may be received before `nx_common_process` is called, so
+ * that the link layer can delay further packets (or ask the sender to
+ * retry) instead of dropping them.
+ *
+ * If `CONFIG_NEXUS_CHANNEL_INGRESS_RING_ENABLED` is set, received packets
+ * are copied into a ring of `CONFIG_NEXUS_CHANNEL_INGRESS_RING_MESSAGE_COUNT`
+ * packets.
+ *
+ * \param frames received packets, oldest first
+ * \param frame_count number of packets in `frames`
+ * \param accepted_count set to the number of packets accepted, always the
+ * first `accepted_count` packets in `frames`
+ * \param free_count set to the number of further packets which may be
+ * accepted before `nx_common_process` is called
+ * \return `NX_CHANNEL_ERROR_NONE` if all packets were accepted, otherwise
+ * the error of the first packet not accepted
+ */
+nx_channel_error
+nx_channel_network_receive_batch(const struct nx_channel_network_frame* frames,
+                                 uint32_t frame_count,
+                                 uint32_t* accepted_count,
+                                 uint32_t* free_count);
+
+#ifdef CONFIG_NEXUS_CHANNEL_ZERO_COPY_RECEIVE_ENABLED
+/** Return a buffer lent by `nx_channel_network_receive_lent`.
+ *
+ * \param bytes_received buffer passed to `nx_channel_network_receive_lent`
+ */
+typedef void (*nx_channel_network_release_fn)(void* bytes_received);
+
+/*! \brief Handle an incoming Nexus Channel application packet in place
+ *
+ * Identical to `nx_channel_network_receive`, except that the packet is
+ * processed in `bytes_received` instead of being copied into Nexus Channel.
+ * This avoids a copy of each packet, and allows link layer drivers (for
+ * example, DMA driven UARTs) to receive directly into buffers which are
+ * then passed to Nexus Channel.
+ *
+ * If this function returns `NX_CHANNEL_ERROR_NONE`, `bytes_received` is
+ * lent to Nexus Channel, which may modify its contents. The platform must
+ * not reuse `bytes_received` until Nexus Channel calls
+ * `release(bytes_received)`, exactly once, after processing the packet.
+ * `release` is normally called from `nx_common_process`.
+ *
+ * Otherwise, `release` is not called, and `bytes_received` may be reused
+ * immediately.
+ *
+ * \param bytes_received pointer to received application data
+ * \param bytes_count number of bytes to read from `bytes_received`
+ * \param source Nexus ID of sending device
+ * \param release function to call once `bytes_received` is processed
+ * \return `nx_channel_error` indicating success or failure (and cause)
+ */
+nx_channel_error
+nx_channel_network_receive_lent(void* const bytes_received,
+                                uint32_t bytes_count,
+                                const struct nx_id* const source,
+                                nx_channel_network_release_fn release);
+#endif // #ifdef CONFIG_NEXUS_CHANNEL_ZERO_COPY_RECEIVE_ENABLED
+
 /*! \brief Return the number of current Channel Links
  *
  * Returns 0 if no links are established, returns > 1 representing the
@@ -51,43 +51,71 @@ extern "C" {
     // One block for each link present.
     // Always at least one present (block 4)
     #define NX_COMMON_NV_BLOCK_4_LENGTH 40 // 1 link
-    #if (CONFIG_NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS > 1) // 2 links
-        #define NX_COMMON_NV_BLOCK_5_LENGTH NX_COMMON_NV_BLOCK_4_LENGTH
+    #ifdef CONFIG_NEXUS_CHANNEL_LARGE_LINK_TABLE_ENABLED
+        // Links are stored in pages of `NX_COMMON_NV_LINK_PAGE_LINK_COUNT`
+        // links, one page per block. Page N is stored in block ID
+        // `NX_COMMON_NV_LINK_PAGE_FIRST_BLOCK_ID + N`, and blocks 4-13 are
+        // unused.
+        #define NX_COMMON_NV_LINK_PAGE_LINK_COUNT 4
+        #define NX_COMMON_NV_LINK_PAGE_FIRST_BLOCK_ID 64
+        #define NX_COMMON_NV_LINK_PAGE_COUNT                                   \
+            ((CONFIG_NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS +                    \
+              NX_COMMON_NV_LINK_PAGE_LINK_COUNT - 1) /                         \
+             NX_COMMON_NV_LINK_PAGE_LINK_COUNT)
+        // 4 bytes of block ID and CRC, followed by the links
+        #define NX_COMMON_NV_LINK_PAGE_BLOCK_LENGTH                            \
+            (4 + NX_COMMON_NV_LINK_PAGE_LINK_COUNT *                           \
+                     (NX_COMMON_NV_BLOCK_4_LENGTH - 4))
+        #define NX_COMMON_NV_MAX_BLOCK_LENGTH                                  \
+            NX_COMMON_NV_LINK_PAGE_BLOCK_LENGTH
+    #else
+        #if (CONFIG_NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS > 1) // 2 links
+            #define NX_COMMON_NV_BLOCK_5_LENGTH NX_COMMON_NV_BLOCK_4_LENGTH
+        #endif
+        #if (CONFIG_NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS > 2) // 3 links ... etc
+            #define NX_COMMON_NV_BLOCK_6_LENGTH NX_COMMON_NV_BLOCK_4_LENGTH
+        #endif
+        #if (CONFIG_NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS > 3)
+            #define NX_COMMON_NV_BLOCK_7_LENGTH NX_COMMON_NV_BLOCK_4_LENGTH
+        #endif
+        #if (CONFIG_NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS > 4)
+            #define NX_COMMON_NV_BLOCK_8_LENGTH NX_COMMON_NV_BLOCK_4_LENGTH
+        #endif
+        #if (CONFIG_NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS > 5)
+            #define NX_COMMON_NV_BLOCK_9_LENGTH NX_COMMON_NV_BLOCK_4_LENGTH
+        #endif
+        #if (CONFIG_NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS > 6)
+            #define NX_COMMON_NV_BLOCK_10_LENGTH NX_COMMON_NV_BLOCK_4_LENGTH
+        #endif
+        #if (CONFIG_NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS > 7)
+            #define NX_COMMON_NV_BLOCK_11_LENGTH NX_COMMON_NV_BLOCK_4_LENGTH
+        #endif
+        #if (CONFIG_NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS > 8)
+            #define NX_COMMON_NV_BLOCK_12_LENGTH NX_COMMON_NV_BLOCK_4_LENGTH
+        #endif
+        #if (CONFIG_NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS > 9) // 10 links
+            #define NX_COMMON_NV_BLOCK_13_LENGTH NX_COMMON_NV_BLOCK_4_LENGTH
+        #endif
+        #if (CONFIG_NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS > 10)
+            #error "More than 10 links requires additional NV configuration"
+        #endif
+
+        #define NX_COMMON_NV_MAX_BLOCK_LENGTH NX_COMMON_NV_BLOCK_4_LENGTH
     #endif
-    #if (CONFIG_NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS > 2) // 3 links ... etc
-        #define NX_COMMON_NV_BLOCK_6_LENGTH NX_COMMON_NV_BLOCK_4_LENGTH
-    #endif
-    #if (CONFIG_NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS > 3)
-        #define NX_COMMON_NV_BLOCK_7_LENGTH NX_COMMON_NV_BLOCK_4_LENGTH
-    #endif
-    #if (CONFIG_NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS > 4)
-        #define NX_COMMON_NV_BLOCK_8_LENGTH NX_COMMON_NV_BLOCK_4_LENGTH
-    #endif
-    #if (CONFIG_NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS > 5)
-        #define NX_COMMON_NV_BLOCK_9_LENGTH NX_COMMON_NV_BLOCK_4_LENGTH
-    #endif
-    #if (CONFIG_NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS > 6)
-        #define NX_COMMON_NV_BLOCK_10_LENGTH NX_COMMON_NV_BLOCK_4_LENGTH
-    #endif
-    #if (CONFIG_NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS > 7)
-        #define NX_COMMON_NV_BLOCK_11_LENGTH NX_COMMON_NV_BLOCK_4_LENGTH
-    #endif
-    #if (CONFIG_NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS > 8)
-        #define NX_COMMON_NV_BLOCK_12_LENGTH NX_COMMON_NV_BLOCK_4_LENGTH
-    #endif
-    #if (CONFIG_NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS > 9) // 10 links
-        #define NX_COMMON_NV_BLOCK_13_LENGTH NX_COMMON_NV_BLOCK_4_LENGTH
-    #endif
-    #if (CONFIG_NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS > 10)
-        #error "More than 10 links requires additional NV configuration"
-    #endif
-
-    #define NX_COMMON_NV_MAX_BLOCK_LENGTH NX_COMMON_NV_BLOCK_4_LENGTH
 #else
     // keycode only
     #define NX_COMMON_NV_MAX_BLOCK_LENGTH NX_COMMON_NV_BLOCK_1_LENGTH
 #endif /* ifdef CONFIG_NEXUS_CHANNEL_LINK_SECURITY_ENABLED */
 
+#ifdef CONFIG_NEXUS_COMMON_NV_TRANSACTIONS_ENABLED
+    // Atomic updates of multiple blocks require a second copy ('copy B') of
+    // each block above, with this value added to its block ID, and two
+    // commit blocks recording which copy of each block is current.
+    #define NX_COMMON_NV_BLOCK_COPY_B_ID_OFFSET 32
+    #define NX_COMMON_NV_BLOCK_21_LENGTH 12 // bytes
+    #define NX_COMMON_NV_BLOCK_22_LENGTH 12 // bytes
+#endif
+
 /** Nexus non-volatile data block metadata.
  *
  * Assumes uint16_t is 2 bytes wide, and uint8_t is 1 byte wide.
@@ -98,6 +126,17 @@ struct nx_common_nv_block_meta
     uint8_t length;
 };
 
+/** Part of a Nexus NV block.
+ *
+ * Used to write a block without first copying it into one buffer; see
+ * `nxp_common_nv_write_v`.
+ */
+struct nx_common_nv_write_segment
+{
+    const void* data;
+    uint8_t length;
+};
+
 /** Check whether or not a given Nexus NV block is valid.
  *
  * \param block_meta metadata about the block to verify
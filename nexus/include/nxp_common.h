@@ -115,6 +115,52 @@ void nxp_common_request_processing(void);
 bool nxp_common_nv_write(const struct nx_common_nv_block_meta block_meta,
                          void* write_buffer);
 
+/** Writes a new version of a Nexus NV block, given in separate segments.
+ *
+ * Only used if `CONFIG_NEXUS_COMMON_NV_WRITE_V_ENABLED` is defined, in
+ * which case it is called *instead of* `nxp_common_nv_write`, and products
+ * need not implement `nxp_common_nv_write`.
+ *
+ * The full block is the concatenation of `segment_count` segments, in
+ * order; the segment lengths add up to `block_meta.length`. Usually, the
+ * segments are the block ID, the inner data, and the CRC, so that Nexus
+ * does not need to copy the block into a separate buffer before writing
+ * it. Products which program NV in a stream (for example, flash programmed
+ * a word at a time) can write each segment directly.
+ *
+ * The same recommendations as for `nxp_common_nv_write` apply.
+ *
+ * \par Example Scenario:
+ * (For reference only.  Actual implementation will differ based on
+ * platform)
+ *     - @code
+ *       bool nxp_common_nv_write_v(
+ *           const struct nx_common_nv_block_meta block_meta,
+ *           const struct nx_common_nv_write_segment* segments,
+ *           uint8_t segment_count)
+ *       {
+ *           if (!flash_stream_begin(block_meta.block_id))
+ *           {
+ *               return false;
+ *           }
+ *           for (uint8_t i = 0; i < segment_count; i++)
+ *           {
+ *               flash_stream_write(segments[i].data, segments[i].length);
+ *           }
+ *           return flash_stream_end();
+ *       }
+ *       @endcode
+ *
+ * \note Never called at interrupt time.
+ * \param block_meta metadata for Nexus NV block to write
+ * \param segments parts of the full block to write, in order
+ * \param segment_count number of entries in `segments`
+ * \return true if data successfully written to NV, false otherwise
+ */
+bool nxp_common_nv_write_v(const struct nx_common_nv_block_meta block_meta,
+                           const struct nx_common_nv_write_segment* segments,
+                           uint8_t segment_count);
+
 /** Reads the most recent version of Nexus nonvolatile data.
  *
  * \par Example Scenario:
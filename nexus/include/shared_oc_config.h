@@ -55,6 +55,22 @@
     // (neither implemented currently)
     #define NEXUS_CHANNEL_USE_OC_OBSERVABILITY_AND_CONFIRMABLE_COAP_APIS 0
 
+    // Parse received payloads into an arena reset after each message
+    #ifdef CONFIG_NEXUS_CHANNEL_OC_REP_ARENA_ENABLED
+        #define NEXUS_CHANNEL_OC_REP_ARENA_ENABLED 1
+        #define NEXUS_CHANNEL_OC_REP_ARENA_SIZE                                \
+            CONFIG_NEXUS_CHANNEL_OC_REP_ARENA_SIZE
+    #else
+        #define NEXUS_CHANNEL_OC_REP_ARENA_ENABLED 0
+    #endif
+
+    // Keep pending event timers in a heap instead of a list
+    #ifdef CONFIG_NEXUS_CHANNEL_OC_ETIMER_HEAP_ENABLED
+        #define NEXUS_CHANNEL_OC_ETIMER_HEAP_ENABLED 1
+    #else
+        #define NEXUS_CHANNEL_OC_ETIMER_HEAP_ENABLED 0
+    #endif
+
     // Is int64/uint64 supported?
     #ifndef UINT64_MAX
         #error "Nexus Channel requires uint64_t support."
@@ -104,6 +120,8 @@
     #define NEXUS_CHANNEL_USE_OC_OBSERVABILITY_AND_CONFIRMABLE_COAP_APIS 0
     #define NEXUS_CHANNEL_OC_ENABLE_EMPTY_RESPONSES_ON_ERROR 0
     #define NEXUS_CHANNEL_OC_ENABLE_DUPLICATE_MESSAGE_ID_CHECK 0
+    #define NEXUS_CHANNEL_OC_REP_ARENA_ENABLED 0
+    #define NEXUS_CHANNEL_OC_ETIMER_HEAP_ENABLED 0
 
 #endif /* if NEXUS_CHANNEL_CORE_ENABLED */
 // 4 bytes for base CoAP header fields (Ver/T/OC/Code/TID)
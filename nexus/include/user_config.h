@@ -16,9 +16,20 @@ TO CHANGE THESE VALUES, RUN
 #define CONFIG_NEXUS_KEYCODE_PRO_FACTORY_QC_LONG_LIFETIME_MAX 5
 #define CONFIG_NEXUS_KEYCODE_PROTOCOL_ENTRY_TIMEOUT_SECONDS 16
 #define CONFIG_NEXUS_CHANNEL_CORE_ENABLED 1
+// #define CONFIG_NEXUS_CHANNEL_INGRESS_RING_ENABLED 1
+// #define CONFIG_NEXUS_CHANNEL_ZERO_COPY_RECEIVE_ENABLED 1
+// #define CONFIG_NEXUS_CHANNEL_OC_REP_ARENA_ENABLED 1
+// #define CONFIG_NEXUS_CHANNEL_OC_ETIMER_HEAP_ENABLED 1
 #define CONFIG_NEXUS_CHANNEL_LINK_SECURITY_ENABLED 1
 #define CONFIG_NEXUS_CHANNEL_PLATFORM_DUAL_MODE_SUPPORTED 1
 #define CONFIG_NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS 8
 #define CONFIG_NEXUS_CHANNEL_USE_PAYG_CREDIT_RESOURCE 1
+// #define CONFIG_NEXUS_CHANNEL_ADAPTIVE_NONCE_RESERVATION_ENABLED 1
+// #define CONFIG_NEXUS_CHANNEL_LINK_SECURITY_REPLAY_WINDOW_ENABLED 1
+// #define CONFIG_NEXUS_CHANNEL_LARGE_LINK_TABLE_ENABLED 1
+// #define CONFIG_NEXUS_COMMON_NV_CACHE_ENABLED 1
+// #define CONFIG_NEXUS_COMMON_NV_TRANSACTIONS_ENABLED 1
+// #define CONFIG_NEXUS_COMMON_NV_WRITE_V_ENABLED 1
+// #define CONFIG_NEXUS_COMMON_CRC_CCITT_SMALL_ROM_ENABLED 1
 #define CONFIG_NEXUS_COMMON_OC_PRINT_LOG_ENABLED 1
 // #define CONFIG_NEXUS_COMMON_OC_DEBUG_LOG_ENABLED 1
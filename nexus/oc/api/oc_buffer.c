@@ -24,6 +24,7 @@
 #include "util/oc_memb.h"
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 #include "oc_buffer.h"
 #include "oc_config.h"
 #include "oc_events.h"
@@ -44,18 +45,34 @@ int oc_buffer_outgoing_free_count(void)
     return oc_memb_numfree(&oc_outgoing_buffers);
 }
 
+void oc_buffer_incoming_get_stats(struct oc_memb_stats *stats)
+{
+    oc_memb_get_stats(&oc_incoming_buffers, stats);
+}
+
+void oc_buffer_outgoing_get_stats(struct oc_memb_stats *stats)
+{
+    oc_memb_get_stats(&oc_outgoing_buffers, stats);
+}
+
 static oc_message_t *
 allocate_message(struct oc_memb *pool)
 {
   //oc_network_event_handler_mutex_lock();
-  oc_message_t *message = (oc_message_t *)oc_memb_alloc(pool);
+  // `data` is written before it is read, so only the header is zeroed
+  oc_message_t *message = (oc_message_t *)oc_memb_alloc_uninit(pool);
   //oc_network_event_handler_mutex_unlock();
   if (message) {
     message->pool = pool;
     message->length = 0;
     message->next = 0;
     message->ref_count = 1;
+    memset(&message->endpoint, 0, sizeof(message->endpoint));
     message->endpoint.interface_index = -1;
+#ifdef CONFIG_NEXUS_CHANNEL_ZERO_COPY_RECEIVE_ENABLED
+    message->lent_data = NULL;
+    message->release = NULL;
+#endif
   }
   return message;
 }
@@ -103,6 +120,13 @@ oc_message_unref(oc_message_t *message)
 //#ifdef OC_DYNAMIC_ALLOCATION
       //free(message->data);
 //#endif // OC_DYNAMIC_ALLOCATION
+#ifdef CONFIG_NEXUS_CHANNEL_ZERO_COPY_RECEIVE_ENABLED
+      // return lent data to the platform
+      if (message->lent_data != NULL && message->release != NULL) {
+        message->release(message->lent_data);
+      }
+      message->lent_data = NULL;
+#endif
       struct oc_memb *pool = message->pool;
       oc_memb_free(pool, message);
 //#ifndef OC_DYNAMIC_ALLOCATION
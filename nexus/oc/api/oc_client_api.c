@@ -49,8 +49,8 @@ static bool _prepare_secured_coap_request(uint8_t* const transaction_payload, ui
   nexus_oc_wrapper_oc_endpoint_to_nx_id(&client_cb->endpoint, &nexus_id);
 
   // get security data for link to server
-  struct nexus_channel_link_security_mode0_data sec_data = {0};
-  sec_data_exists = nexus_channel_link_manager_security_data_from_nxid(
+  struct nexus_channel_link_security_handle sec_data = {0};
+  sec_data_exists = nexus_channel_link_manager_security_handle_from_nxid(
           &nexus_id, &sec_data);
 
   // if requested method is secured but we have no security data, return early
@@ -73,7 +73,8 @@ static bool _prepare_secured_coap_request(uint8_t* const transaction_payload, ui
   // populate COSE_MAC0 struct. Make every outbound request with the
   // *current* nonce of the link + 1
     nexus_cose_mac0_common_macparams_t mac_params = {
-        &sec_data.sym_key,
+        // link key (unused, `sec_data.key_state` is used)
+        NULL,
         sec_data.nonce + 1,
         // aad
         {
@@ -93,9 +94,9 @@ static bool _prepare_secured_coap_request(uint8_t* const transaction_payload, ui
     // will be populated with repacked COSE MAC0 data
     uint8_t coap_payload_buffer[NEXUS_CHANNEL_MAX_CBOR_PAYLOAD_SIZE];
 
-  // `nexus_oc_wrapper_repack_buffer_secured` internally copies the data from `mac_params->payload`
+  // `nexus_oc_wrapper_repack_buffer_secured_keyed` internally copies the data from `mac_params->payload`
   // into a local buffer before moving the final 'packed' result back into `coap_payload_buffer`.
-  *payload_size = (uint8_t) nexus_oc_wrapper_repack_buffer_secured(coap_payload_buffer, sizeof(coap_payload_buffer), &mac_params);
+  *payload_size = (uint8_t) nexus_oc_wrapper_repack_buffer_secured_keyed(coap_payload_buffer, sizeof(coap_payload_buffer), &mac_params, sec_data.key_state);
 
   NEXUS_ASSERT(*payload_size <= NEXUS_CHANNEL_MAX_CBOR_PAYLOAD_SIZE, "Secured payload size too large");
 
@@ -105,10 +106,12 @@ static bool _prepare_secured_coap_request(uint8_t* const transaction_payload, ui
     return false;
   }
 
-  // securely clear the Nexus Channel security data from the stack
-  nexus_secure_memclr(&sec_data,
-            sizeof(struct nexus_channel_link_security_mode0_data),
-            sizeof(struct nexus_channel_link_security_mode0_data));
+#if NEXUS_CHANNEL_LINK_SECURITY_REPLAY_WINDOW_ENABLED
+  // consume the nonce, so that each request in flight has its own nonce
+  // and the server accepts them in any order (within its replay window)
+  (void) nexus_channel_link_manager_set_security_data_auth_nonce(
+    &nexus_id, sec_data.nonce + 1);
+#endif
 
   coap_set_header_content_format(request, APPLICATION_COSE_MAC0);
   // copy secured message into outbound transaction payload buffer
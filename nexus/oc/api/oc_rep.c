@@ -29,8 +29,26 @@
 #include "util/oc_memb.h"
 
 #include <inttypes.h>
+#include <string.h>
 
 static struct oc_memb *rep_objects;
+#if NEXUS_CHANNEL_OC_REP_ARENA_ENABLED
+// Parsed reps, strings and arrays are allocated in order from the start of
+// the arena, and are all freed at once by `oc_rep_arena_reset`
+typedef union {
+  int64_t integer;
+  double double_p;
+  void *pointer;
+} oc_rep_arena_unit_t;
+
+#define OC_REP_ARENA_UNIT_COUNT                                                \
+  ((NEXUS_CHANNEL_OC_REP_ARENA_SIZE + sizeof(oc_rep_arena_unit_t) - 1) /       \
+   sizeof(oc_rep_arena_unit_t))
+
+static oc_rep_arena_unit_t rep_arena[OC_REP_ARENA_UNIT_COUNT];
+static size_t rep_arena_used;
+static size_t rep_arena_high_water;
+#endif
 static uint8_t *g_buf;
 CborEncoder g_encoder, root_map, links_array;
 int g_err;
@@ -74,13 +92,51 @@ oc_rep_get_encoded_payload_size(void)
   return (int)size;
 }
 
+#if NEXUS_CHANNEL_OC_REP_ARENA_ENABLED
+static void *
+_arena_alloc(size_t size)
+{
+  const size_t units = (size + sizeof(oc_rep_arena_unit_t) - 1) /
+                       sizeof(oc_rep_arena_unit_t);
+  if (units > OC_REP_ARENA_UNIT_COUNT - rep_arena_used) {
+    OC_WRN("rep arena exhausted");
+    return NULL;
+  }
+  void *ptr = &rep_arena[rep_arena_used];
+  rep_arena_used += units;
+  if (rep_arena_used > rep_arena_high_water) {
+    rep_arena_high_water = rep_arena_used;
+  }
+  return ptr;
+}
+
+void
+oc_rep_arena_reset(void)
+{
+  rep_arena_used = 0;
+}
+
+size_t
+oc_rep_arena_high_water(void)
+{
+  return rep_arena_high_water * sizeof(oc_rep_arena_unit_t);
+}
+#endif
+
 static oc_rep_t *
 _alloc_rep(void)
 {
+#if NEXUS_CHANNEL_OC_REP_ARENA_ENABLED
+  oc_rep_t *rep = (oc_rep_t *)_arena_alloc(sizeof(oc_rep_t));
+  if (rep != NULL) {
+    memset(rep, 0, sizeof(oc_rep_t));
+  }
+#else
   oc_rep_t *rep = (oc_rep_t*) oc_memb_alloc(rep_objects);
   if (rep != NULL) {
     rep->name.size = 0;
   }
+#endif
 #ifdef OC_DEBUG
 #include <assert.h>
   assert(rep != NULL);
@@ -89,15 +145,88 @@ _alloc_rep(void)
   return rep;
 }
 
+// Allocate a string of `size` bytes for a parsed rep
+static bool
+_alloc_rep_string(oc_string_t *ocstring, size_t size)
+{
+#if NEXUS_CHANNEL_OC_REP_ARENA_ENABLED
+  ocstring->next = NULL;
+  ocstring->ptr = _arena_alloc(size);
+  ocstring->size = size;
+#else
+  oc_alloc_string(ocstring, size);
+#endif
+  return oc_string(*ocstring) != NULL;
+}
+
+// Allocate an array of `size` items from `type` for a parsed rep
+static bool
+_new_rep_array(oc_array_t *ocarray, size_t size, oc_pool type)
+{
+#if NEXUS_CHANNEL_OC_REP_ARENA_ENABLED
+  size_t item_size = sizeof(uint8_t);
+  if (type == INT_POOL) {
+    item_size = sizeof(int64_t);
+  }
+#if NEXUS_CHANNEL_OC_SUPPORT_DOUBLES
+  else if (type == DOUBLE_POOL) {
+    item_size = sizeof(double);
+  }
+#endif
+  ocarray->next = NULL;
+  ocarray->ptr = _arena_alloc(size * item_size);
+  ocarray->size = size;
+#else
+  switch (type) {
+  case INT_POOL:
+    oc_new_int_array(ocarray, size);
+    break;
+#if NEXUS_CHANNEL_OC_SUPPORT_DOUBLES
+  case DOUBLE_POOL:
+    oc_new_double_array(ocarray, size);
+    break;
+#endif
+  default:
+    oc_new_bool_array(ocarray, size);
+    break;
+  }
+#endif
+  return ocarray->ptr != NULL;
+}
+
+// Allocate an array of `size` empty strings for a parsed rep
+static bool
+_new_rep_string_array(oc_string_array_t *ocstringarray, size_t size)
+{
+#if NEXUS_CHANNEL_OC_REP_ARENA_ENABLED
+  if (!_alloc_rep_string(ocstringarray, size * STRING_ARRAY_ITEM_MAX_LEN)) {
+    return false;
+  }
+  for (size_t i = 0; i < size; i++) {
+    oc_string(*ocstringarray)[i * STRING_ARRAY_ITEM_MAX_LEN] = '\0';
+  }
+  return true;
+#else
+  oc_new_string_array(ocstringarray, size);
+  return oc_string(*ocstringarray) != NULL;
+#endif
+}
+
+#if !NEXUS_CHANNEL_OC_REP_ARENA_ENABLED
 static void
 _free_rep(oc_rep_t *rep_value)
 {
   oc_memb_free(rep_objects, rep_value);
 }
+#endif
 
 void
 oc_free_rep(oc_rep_t *rep)
 {
+#if NEXUS_CHANNEL_OC_REP_ARENA_ENABLED
+  // freed with every other parsed rep by `oc_rep_arena_reset`
+  (void)rep;
+#else
   if (rep == 0)
     return;
   oc_free_rep(rep->next);
@@ -133,6 +262,7 @@ oc_free_rep(oc_rep_t *rep)
   if (rep->name.size > 0)
     oc_free_string(&rep->name);
   _free_rep(rep);
+#endif
 }
 /*
   An Object is a collection of key-value pairs.
@@ -176,7 +306,10 @@ oc_parse_rep_value(CborValue *value, oc_rep_t **rep, CborError *err)
     return;
   }
 
-  oc_alloc_string(&cur->name, len);
+  if (!_alloc_rep_string(&cur->name, len)) {
+    *err = CborErrorOutOfMemory;
+    return;
+  }
   *err = (CborError) (*err | cbor_value_copy_text_string(value, (char *)oc_string(cur->name), &len,
                                       NULL));
   if (*err != CborNoError)
@@ -215,7 +348,10 @@ get_tagged_value:
     len++;
     if (*err != CborNoError || len == 0)
       return;
-    oc_alloc_string(&cur->value.string, len);
+    if (!_alloc_rep_string(&cur->value.string, len)) {
+      *err = CborErrorOutOfMemory;
+      return;
+    }
     *err = (CborError) (*err | cbor_value_copy_byte_string(
       value, oc_cast(cur->value.string, uint8_t), &len, NULL));
     cur->type = OC_REP_BYTE_STRING;
@@ -225,7 +361,10 @@ get_tagged_value:
     len++;
     if (*err != CborNoError || len == 0)
       return;
-    oc_alloc_string(&cur->value.string, len);
+    if (!_alloc_rep_string(&cur->value.string, len)) {
+      *err = CborErrorOutOfMemory;
+      return;
+    }
     *err = (CborError) (*err | cbor_value_copy_text_string(value, oc_string(cur->value.string),
                                         &len, NULL));
     cur->type = OC_REP_STRING;
@@ -264,7 +403,10 @@ get_tagged_value:
       switch (array.type) {
       case CborIntegerType:
         if (k == 0) {
-          oc_new_int_array(&cur->value.array, len);
+          if (!_new_rep_array(&cur->value.array, len, INT_POOL)) {
+            *err = CborErrorOutOfMemory;
+            return;
+          }
           cur->type = (oc_rep_value_type_t) (OC_REP_INT | OC_REP_ARRAY);
         } else if ((cur->type & OC_REP_INT) != OC_REP_INT) {
           *err = (CborError) (*err | CborErrorIllegalType);
@@ -277,7 +419,10 @@ get_tagged_value:
 #if NEXUS_CHANNEL_OC_SUPPORT_DOUBLES
       case CborDoubleType:
         if (k == 0) {
-          oc_new_double_array(&cur->value.array, len);
+          if (!_new_rep_array(&cur->value.array, len, DOUBLE_POOL)) {
+            *err = CborErrorOutOfMemory;
+            return;
+          }
           cur->type = OC_REP_DOUBLE | OC_REP_ARRAY;
         } else if ((cur->type & OC_REP_DOUBLE) != OC_REP_DOUBLE) {
           *err |= CborErrorIllegalType;
@@ -290,7 +435,10 @@ get_tagged_value:
 #endif
       case CborBooleanType:
         if (k == 0) {
-          oc_new_bool_array(&cur->value.array, len);
+          if (!_new_rep_array(&cur->value.array, len, BYTE_POOL)) {
+            *err = CborErrorOutOfMemory;
+            return;
+          }
           cur->type = (oc_rep_value_type_t) (OC_REP_BOOL | OC_REP_ARRAY);
         } else if ((cur->type & OC_REP_BOOL) != OC_REP_BOOL) {
           *err = (CborError) (*err | CborErrorIllegalType);
@@ -302,7 +450,10 @@ get_tagged_value:
         break;
       case CborByteStringType: {
         if (k == 0) {
-          oc_new_byte_string_array(&cur->value.array, len);
+          if (!_new_rep_string_array(&cur->value.array, len)) {
+            *err = CborErrorOutOfMemory;
+            return;
+          }
           cur->type = (oc_rep_value_type_t) (OC_REP_BYTE_STRING | OC_REP_ARRAY);
         } else if ((cur->type & OC_REP_BYTE_STRING) != OC_REP_BYTE_STRING) {
           *err = (CborError) (*err | CborErrorIllegalType);
@@ -326,7 +477,10 @@ get_tagged_value:
       } break;
       case CborTextStringType:
         if (k == 0) {
-          oc_new_string_array(&cur->value.array, len);
+          if (!_new_rep_string_array(&cur->value.array, len)) {
+            *err = CborErrorOutOfMemory;
+            return;
+          }
           cur->type = (oc_rep_value_type_t) (OC_REP_STRING | OC_REP_ARRAY);
         } else if ((cur->type & OC_REP_STRING) != OC_REP_STRING) {
           *err = (CborError) (*err | CborErrorIllegalType);
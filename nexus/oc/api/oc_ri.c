@@ -712,6 +712,7 @@ oc_ri_invoke_coap_entity_handler(void *request, void *response, uint8_t *buffer,
   int payload_len = 0;
   payload_len = coap_get_payload(request, &payload);
 
+#if !NEXUS_CHANNEL_OC_REP_ARENA_ENABLED
 //#ifndef OC_DYNAMIC_ALLOCATION
   char rep_objects_alloc[OC_MAX_NUM_REP_OBJECTS];
   oc_rep_t rep_objects_pool[OC_MAX_NUM_REP_OBJECTS];
@@ -719,13 +720,14 @@ oc_ri_invoke_coap_entity_handler(void *request, void *response, uint8_t *buffer,
   memset(rep_objects_pool, 0, OC_MAX_NUM_REP_OBJECTS * sizeof(oc_rep_t));
   struct oc_memb rep_objects = { sizeof(oc_rep_t), OC_MAX_NUM_REP_OBJECTS,
                                  rep_objects_alloc, (void *)rep_objects_pool,
-                                 0 };
+                                 0, OC_MEMB_STATE_INIT };
 /*
 #else  // !OC_DYNAMIC_ALLOCATION
   struct oc_memb rep_objects = { sizeof(oc_rep_t), 0, 0, 0, 0 };
 #endif // OC_DYNAMIC_ALLOCATION
 */
   oc_rep_set_pool(&rep_objects);
+#endif
 
   if (payload_len > 0) {
     /* Attempt to parse request payload using tinyCBOR via oc_rep helper
@@ -1239,6 +1241,7 @@ oc_ri_invoke_client_cb(void *response, oc_client_cb_t *cb,
 
   payload_len = coap_get_payload(response, (const uint8_t **)&payload);
 
+#if !NEXUS_CHANNEL_OC_REP_ARENA_ENABLED
 // #ifndef OC_DYNAMIC_ALLOCATION
   char rep_objects_alloc[OC_MAX_NUM_REP_OBJECTS];
   oc_rep_t rep_objects_pool[OC_MAX_NUM_REP_OBJECTS];
@@ -1246,13 +1249,14 @@ oc_ri_invoke_client_cb(void *response, oc_client_cb_t *cb,
   memset(rep_objects_pool, 0, OC_MAX_NUM_REP_OBJECTS * sizeof(oc_rep_t));
   struct oc_memb rep_objects = { sizeof(oc_rep_t), OC_MAX_NUM_REP_OBJECTS,
                                  rep_objects_alloc, (void *)rep_objects_pool,
-                                 0 };
+                                 0, OC_MEMB_STATE_INIT };
 /*
 #else  // !OC_DYNAMIC_ALLOCATION
   struct oc_memb rep_objects = { sizeof(oc_rep_t), 0, 0, 0, 0 };
 #endif // OC_DYNAMIC_ALLOCATION
 */
   oc_rep_set_pool(&rep_objects);
+#endif
   if (payload_len) {
     if (cb->discovery) {
       /*
@@ -35,6 +35,8 @@ OC_PROCESS_NAME(message_buffer_handler);
 
 int oc_buffer_incoming_free_count(void);
 int oc_buffer_outgoing_free_count(void);
+void oc_buffer_incoming_get_stats(struct oc_memb_stats *stats);
+void oc_buffer_outgoing_get_stats(struct oc_memb_stats *stats);
 
 oc_message_t *oc_allocate_message(void);
 /*
@@ -992,6 +992,24 @@ int oc_parse_rep(const uint8_t *payload, int payload_size,
 
 void oc_free_rep(oc_rep_t *rep);
 
+#if NEXUS_CHANNEL_OC_REP_ARENA_ENABLED
+/**
+ * @brief Free every rep parsed since the previous reset
+ *
+ * With the rep arena, parsed reps (and their strings and arrays) are not
+ * freed individually by oc_free_rep. Called after each received message
+ * is processed.
+ */
+void oc_rep_arena_reset(void);
+
+/**
+ * @brief Largest number of arena bytes used to parse a single message
+ *
+ * @return bytes, never more than NEXUS_CHANNEL_OC_REP_ARENA_SIZE
+ */
+size_t oc_rep_arena_high_water(void);
+#endif
+
 
 /**
  * Read an integer from an `oc_rep_t`
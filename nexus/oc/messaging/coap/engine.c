@@ -185,8 +185,8 @@ coap_send_previous_request_with_repacked_security(uint16_t mid,
     struct nx_id nexus_id = {0};
     (void) nexus_oc_wrapper_oc_endpoint_to_nx_id(&request_message->endpoint,
                                                  &nexus_id);
-    struct nexus_channel_link_security_mode0_data sec_data = {0};
-    bool sec_data_exists = nexus_channel_link_manager_security_data_from_nxid(
+    struct nexus_channel_link_security_handle sec_data = {0};
+    bool sec_data_exists = nexus_channel_link_manager_security_handle_from_nxid(
         &nexus_id, &sec_data);
     if (!sec_data_exists)
     {
@@ -197,7 +197,8 @@ coap_send_previous_request_with_repacked_security(uint16_t mid,
 
     // repack the original payload with an updated nonce
     nexus_cose_mac0_common_macparams_t mac_params = {
-        &sec_data.sym_key,
+        // link key (unused, `sec_data.key_state` is used)
+        NULL,
         // nonce would have been updated before this re-request, but
         // we need to increment again because the server has already
         // updated its nonce to the same value and it expects to
@@ -213,20 +214,23 @@ coap_send_previous_request_with_repacked_security(uint16_t mid,
         extracted_params.payload_len,
     };
 
-    pkt->payload_len = nexus_oc_wrapper_repack_buffer_secured(
-        coap_payload_buffer, sizeof(coap_payload_buffer), &mac_params);
+    pkt->payload_len = nexus_oc_wrapper_repack_buffer_secured_keyed(
+        coap_payload_buffer,
+        sizeof(coap_payload_buffer),
+        &mac_params,
+        sec_data.key_state);
     pkt->payload = coap_payload_buffer;
 
+#if NEXUS_CHANNEL_LINK_SECURITY_REPLAY_WINDOW_ENABLED
+    // consume the nonce, as in `_prepare_secured_coap_request`
+    (void) nexus_channel_link_manager_set_security_data_auth_nonce(
+        &nexus_id, sec_data.nonce + 1);
+#endif
+
     // set the header content-format to indicate the payload is
     // secured
     coap_set_header_content_format(pkt, APPLICATION_COSE_MAC0);
 
-    // securely clear the Nexus Channel security data from the
-    // stack
-    nexus_secure_memclr(&sec_data,
-                        sizeof(struct nexus_channel_link_security_mode0_data),
-                        sizeof(struct nexus_channel_link_security_mode0_data));
-
     // transfer from coap packet to message->data
     size_t len = coap_serialize_message(pkt, request_message->data);
     if (len > 0)
@@ -261,10 +265,10 @@ static void coap_send_nonce_sync_response(uint16_t mid,
         }
         struct nx_id nexus_id = {0};
         (void) nexus_oc_wrapper_oc_endpoint_to_nx_id(endpoint, &nexus_id);
-        struct nexus_channel_link_security_mode0_data sec_data = {0};
+        struct nexus_channel_link_security_handle sec_data = {0};
         bool sec_data_exists =
-            nexus_channel_link_manager_security_data_from_nxid(&nexus_id,
-                                                               &sec_data);
+            nexus_channel_link_manager_security_handle_from_nxid(&nexus_id,
+                                                                 &sec_data);
         NEXUS_ASSERT(sec_data_exists,
                      "Unexpectedly attempting to nonce sync for missing "
                      "security link...");
@@ -281,7 +285,8 @@ static void coap_send_nonce_sync_response(uint16_t mid,
 
         // encode the outbound message as secured
         nexus_cose_mac0_common_macparams_t mac_params = {
-            &sec_data.sym_key,
+            // link key (unused, `sec_data.key_state` is used)
+            NULL,
             sync_nonce,
             // aad
             {
@@ -295,21 +300,17 @@ static void coap_send_nonce_sync_response(uint16_t mid,
             0,
         };
 
-        pkt->payload_len = nexus_oc_wrapper_repack_buffer_secured(
-            coap_payload_buffer, sizeof(coap_payload_buffer), &mac_params);
+        pkt->payload_len = nexus_oc_wrapper_repack_buffer_secured_keyed(
+            coap_payload_buffer,
+            sizeof(coap_payload_buffer),
+            &mac_params,
+            sec_data.key_state);
         pkt->payload = coap_payload_buffer;
 
         // set the header content-format to indicate the payload is
         // secured
         coap_set_header_content_format(pkt, APPLICATION_COSE_MAC0);
 
-        // securely clear the Nexus Channel security data from the
-        // stack
-        nexus_secure_memclr(
-            &sec_data,
-            sizeof(struct nexus_channel_link_security_mode0_data),
-            sizeof(struct nexus_channel_link_security_mode0_data));
-
         // transfer from coap packet to message->data
         size_t len = coap_serialize_message(pkt, message->data);
         if (len > 0)
@@ -456,7 +457,7 @@ int coap_receive(oc_message_t* msg)
 
     OC_DBG("CoAP Engine: received datalen=%u from", (unsigned int) msg->length);
     OC_LOGipaddr(msg->endpoint);
-    OC_LOGbytes(msg->data, msg->length);
+    OC_LOGbytes(OC_MESSAGE_RECEIVED_DATA(msg), msg->length);
 
     // static declaration reduces stack peaks and program code size
     static coap_packet_t parsed_coap_pkt[1]; // this way the packet can be
@@ -472,7 +473,7 @@ int coap_receive(oc_message_t* msg)
     bool rcvd_pkt_secured = false;
 
     coap_status_code = coap_udp_parse_message(
-        parsed_coap_pkt, msg->data, (uint16_t) msg->length);
+        parsed_coap_pkt, OC_MESSAGE_RECEIVED_DATA(msg), (uint16_t) msg->length);
 
 #if NEXUS_CHANNEL_LINK_SECURITY_ENABLED
     // Only attempt to unpack/authenticate COSE payload if the encapsulating
@@ -760,10 +761,10 @@ send_message:
                 &transaction->message->endpoint, &nexus_id);
 
             // get security data
-            struct nexus_channel_link_security_mode0_data sec_data = {0};
+            struct nexus_channel_link_security_handle sec_data = {0};
             sec_data_exists =
-                nexus_channel_link_manager_security_data_from_nxid(&nexus_id,
-                                                                   &sec_data);
+                nexus_channel_link_manager_security_handle_from_nxid(
+                    &nexus_id, &sec_data);
 
             // Clients may make secured or unsecured requests - we
             // only respond with a secured response if:
@@ -775,7 +776,8 @@ send_message:
             {
                 // encode the outbound message as secured
                 nexus_cose_mac0_common_macparams_t mac_params = {
-                    &sec_data.sym_key,
+                    // link key (unused, `sec_data.key_state` is used)
+                    NULL,
                     sec_data.nonce,
                     // aad
                     {
@@ -793,8 +795,11 @@ send_message:
                 uint8_t tmp_output[NEXUS_CHANNEL_MAX_CBOR_PAYLOAD_SIZE];
 
                 const size_t new_payload_size =
-                    nexus_oc_wrapper_repack_buffer_secured(
-                        tmp_output, sizeof(tmp_output), &mac_params);
+                    nexus_oc_wrapper_repack_buffer_secured_keyed(
+                        tmp_output,
+                        sizeof(tmp_output),
+                        &mac_params,
+                        sec_data.key_state);
                 response->payload_len = new_payload_size;
                 memcpy(response->payload, tmp_output, new_payload_size);
 
@@ -810,13 +815,6 @@ send_message:
                     OC_WRN("Secured server message cannot be packed");
                     coap_clear_transaction(transaction);
                 }
-
-                // securely clear the Nexus Channel security data from the
-                // stack
-                nexus_secure_memclr(
-                    &sec_data,
-                    sizeof(struct nexus_channel_link_security_mode0_data),
-                    sizeof(struct nexus_channel_link_security_mode0_data));
             }
 #else
             // only used if security is enabled
@@ -860,6 +858,10 @@ OC_PROCESS_THREAD(coap_engine, ev, data)
         {
             OC_DBG("Handling INBOUND_RI_EVENT\n");
             coap_receive((oc_message_t*) data);
+#if NEXUS_CHANNEL_OC_REP_ARENA_ENABLED
+            // no parsed reps outlive the message they were parsed from
+            oc_rep_arena_reset();
+#endif
             oc_message_unref((oc_message_t*) data);
         }
         else if (ev == OC_PROCESS_EVENT_TIMER)
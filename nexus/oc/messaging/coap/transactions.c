@@ -76,6 +76,11 @@ int coap_transactions_free_count(void)
     return oc_memb_numfree(&transactions_memb);
 }
 
+void coap_transactions_get_stats(struct oc_memb_stats* stats)
+{
+    oc_memb_get_stats(&transactions_memb, stats);
+}
+
 /*---------------------------------------------------------------------------*/
 /*- Internal API ------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
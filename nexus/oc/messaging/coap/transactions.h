@@ -52,6 +52,7 @@
 
 #include "coap.h"
 #include "util/oc_etimer.h"
+#include "util/oc_memb.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -91,6 +92,7 @@ typedef struct coap_transaction
 void coap_register_as_transaction_handler(void);
 
 int coap_transactions_free_count(void);
+void coap_transactions_get_stats(struct oc_memb_stats* stats);
 coap_transaction_t* coap_new_transaction(uint16_t mid,
                                          const oc_endpoint_t* endpoint);
 
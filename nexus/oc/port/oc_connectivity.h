@@ -43,8 +43,22 @@ struct oc_message_s
   size_t length;
   uint8_t ref_count;
   uint8_t data[NEXUS_CHANNEL_MAX_COAP_TOTAL_MESSAGE_SIZE];
+#ifdef CONFIG_NEXUS_CHANNEL_ZERO_COPY_RECEIVE_ENABLED
+  // If not NULL, received data lent by the platform, which is used instead
+  // of `data`. `release` is called with `lent_data` when the message is freed.
+  uint8_t *lent_data;
+  void (*release)(void *lent_data);
+#endif
 };
 
+// Received data of `message`, which may be lent by the platform
+#ifdef CONFIG_NEXUS_CHANNEL_ZERO_COPY_RECEIVE_ENABLED
+#define OC_MESSAGE_RECEIVED_DATA(message)                                      \
+  ((message)->lent_data != NULL ? (message)->lent_data : (message)->data)
+#else
+#define OC_MESSAGE_RECEIVED_DATA(message) ((message)->data)
+#endif
+
 
 int oc_send_buffer(oc_message_t *message);
 /*
@@ -41,15 +41,134 @@
 
 #include "oc_etimer.h"
 #include "oc_process.h"
+#include <stdbool.h>
 
+#if NEXUS_CHANNEL_OC_ETIMER_HEAP_ENABLED
+/* Pending timers are kept in a pairing heap, with the earliest expiring
+   timer at the root. Children of a timer are linked through `next`, and
+   never expire before their parent. */
+static struct oc_etimer *timerheap;
+#else
 static struct oc_etimer *timerlist;
+#endif
 static oc_clock_time_t next_expiration;
 
 OC_PROCESS(oc_etimer_process, "Event timer");
+#if NEXUS_CHANNEL_OC_ETIMER_HEAP_ENABLED
+/*---------------------------------------------------------------------------*/
+static bool
+expires_before(const struct oc_etimer *a, const struct oc_etimer *b)
+{
+  /* Compare the distance between expiration times due to wraps */
+  oc_clock_time_t diff = (a->timer.start + a->timer.interval) -
+                         (b->timer.start + b->timer.interval);
+  return diff > ((oc_clock_time_t)-1 >> 1);
+}
+/*---------------------------------------------------------------------------*/
+/* Combine two heaps, returning the root of the combined heap */
+static struct oc_etimer *
+heap_meld(struct oc_etimer *a, struct oc_etimer *b)
+{
+  struct oc_etimer *t;
+
+  if (a == NULL) {
+    return b;
+  } else if (b == NULL) {
+    return a;
+  }
+  if (expires_before(b, a)) {
+    t = a;
+    a = b;
+    b = t;
+  }
+  /* b becomes the first child of a */
+  b->prev = a;
+  b->next = a->child;
+  if (a->child != NULL) {
+    a->child->prev = b;
+  }
+  a->child = b;
+  return a;
+}
+/*---------------------------------------------------------------------------*/
+/* Combine a list of sibling heaps, returning the root of the combined heap */
+static struct oc_etimer *
+heap_merge_siblings(struct oc_etimer *first)
+{
+  struct oc_etimer *a, *b, *pairs = NULL, *root = NULL;
+
+  /* Meld pairs of siblings from first to last... */
+  while (first != NULL) {
+    a = first;
+    b = a->next;
+    first = (b != NULL) ? b->next : NULL;
+    a->prev = NULL;
+    a->next = NULL;
+    if (b != NULL) {
+      b->prev = NULL;
+      b->next = NULL;
+    }
+    a = heap_meld(a, b);
+    a->next = pairs;
+    pairs = a;
+  }
+  /* ...then meld each pair into the result, from last to first. */
+  while (pairs != NULL) {
+    a = pairs;
+    pairs = a->next;
+    a->next = NULL;
+    root = heap_meld(a, root);
+  }
+  return root;
+}
+/*---------------------------------------------------------------------------*/
+static bool
+heap_contains(struct oc_etimer *et)
+{
+  return et == timerheap || et->prev != NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+heap_insert(struct oc_etimer *et)
+{
+  et->child = NULL;
+  et->prev = NULL;
+  et->next = NULL;
+  timerheap = heap_meld(timerheap, et);
+}
+/*---------------------------------------------------------------------------*/
+static void
+heap_remove(struct oc_etimer *et)
+{
+  struct oc_etimer *children = et->child;
+
+  et->child = NULL;
+  if (et == timerheap) {
+    timerheap = heap_merge_siblings(children);
+  } else {
+    if (et->prev->child == et) {
+      et->prev->child = et->next;
+    } else {
+      et->prev->next = et->next;
+    }
+    if (et->next != NULL) {
+      et->next->prev = et->prev;
+    }
+    timerheap = heap_meld(timerheap, heap_merge_siblings(children));
+  }
+  et->prev = NULL;
+  et->next = NULL;
+}
+#endif /* NEXUS_CHANNEL_OC_ETIMER_HEAP_ENABLED */
 /*---------------------------------------------------------------------------*/
 static void
 update_time(void)
 {
+#if NEXUS_CHANNEL_OC_ETIMER_HEAP_ENABLED
+  next_expiration = (timerheap == NULL)
+                      ? 0
+                      : timerheap->timer.start + timerheap->timer.interval;
+#else
   oc_clock_time_t tdist;
   oc_clock_time_t now;
   struct oc_etimer *t;
@@ -68,6 +187,7 @@ update_time(void)
     }
     next_expiration = now + tdist;
   }
+#endif
 }
 /*---------------------------------------------------------------------------*/
 OC_PROCESS_THREAD(oc_etimer_process, ev, data)
@@ -76,6 +196,48 @@ OC_PROCESS_THREAD(oc_etimer_process, ev, data)
 
   OC_PROCESS_BEGIN();
 
+#if NEXUS_CHANNEL_OC_ETIMER_HEAP_ENABLED
+  timerheap = NULL;
+
+  while (1) {
+    OC_PROCESS_YIELD();
+
+    if (ev == OC_PROCESS_EVENT_EXITED) {
+      struct oc_process *p = (struct oc_process*) data;
+
+      /* Rebuild the heap without the timers of the exited process */
+      u = timerheap;
+      timerheap = NULL;
+      while (u != NULL) {
+        t = u;
+        u = heap_merge_siblings(t->child);
+        t->child = NULL;
+        if (t->p != p) {
+          heap_insert(t);
+        }
+      }
+      update_time();
+      continue;
+    } else if (ev != OC_PROCESS_EVENT_POLL) {
+      continue;
+    }
+
+    while (timerheap != NULL && oc_timer_expired(&timerheap->timer)) {
+      t = timerheap;
+      if (oc_process_post(t->p, OC_PROCESS_EVENT_TIMER, t) !=
+          OC_PROCESS_ERR_OK) {
+        oc_etimer_request_poll();
+        break;
+      }
+      /* Reset the process ID of the event timer, to signal that the
+         etimer has expired. This is later checked in the
+         oc_etimer_expired() function. */
+      t->p = OC_PROCESS_NONE;
+      heap_remove(t);
+      update_time();
+    }
+  }
+#else
   timerlist = NULL;
 
   while (1) {
@@ -130,6 +292,7 @@ OC_PROCESS_THREAD(oc_etimer_process, ev, data)
       u = t;
     }
   }
+#endif
 
   OC_PROCESS_END();
 }
@@ -144,10 +307,18 @@ oc_etimer_request_poll(void)
 static void
 add_timer(struct oc_etimer *timer)
 {
-  struct oc_etimer *t;
-
   oc_etimer_request_poll();
 
+#if NEXUS_CHANNEL_OC_ETIMER_HEAP_ENABLED
+  /* Expiration time may have changed, so reposition the timer */
+  if (heap_contains(timer)) {
+    heap_remove(timer);
+  }
+  timer->p = OC_PROCESS_CURRENT();
+  heap_insert(timer);
+#else
+  struct oc_etimer *t;
+
   if (timer->p != OC_PROCESS_NONE) {
     for (t = timerlist; t != NULL; t = t->next) {
       if (t == timer) {
@@ -163,6 +334,7 @@ add_timer(struct oc_etimer *timer)
   timer->p = OC_PROCESS_CURRENT();
   timer->next = timerlist;
   timerlist = timer;
+#endif
 
   update_time();
 }
@@ -200,7 +372,17 @@ oc_etimer_restart(struct oc_etimer *et)
 void
 oc_etimer_adjust(struct oc_etimer *et, int timediff)
 {
+#if NEXUS_CHANNEL_OC_ETIMER_HEAP_ENABLED
+  if (heap_contains(et)) {
+    heap_remove(et);
+    et->timer.start += timediff;
+    heap_insert(et);
+  } else {
+    et->timer.start += timediff;
+  }
+#else
   et->timer.start += timediff;
+#endif
   update_time();
 }
 /*---------------------------------------------------------------------------*/
@@ -225,7 +407,11 @@ oc_etimer_start_time(struct oc_etimer *et)
 int
 oc_etimer_pending(void)
 {
+#if NEXUS_CHANNEL_OC_ETIMER_HEAP_ENABLED
+  return timerheap != NULL;
+#else
   return timerlist != NULL;
+#endif
 }
 /*---------------------------------------------------------------------------*/
 oc_clock_time_t
@@ -237,6 +423,12 @@ oc_etimer_next_expiration_time(void)
 void
 oc_etimer_stop(struct oc_etimer *et)
 {
+#if NEXUS_CHANNEL_OC_ETIMER_HEAP_ENABLED
+  if (heap_contains(et)) {
+    heap_remove(et);
+    update_time();
+  }
+#else
   struct oc_etimer *t;
 
   /* First check if et is the first event timer on the list. */
@@ -261,6 +453,7 @@ oc_etimer_stop(struct oc_etimer *et)
 
   /* Remove the next pointer from the item to be removed. */
   et->next = NULL;
+#endif
   /* Set the timer as expired */
   et->p = OC_PROCESS_NONE;
 }
@@ -75,6 +75,12 @@ struct oc_etimer
   struct oc_timer timer;
   struct oc_etimer *next;
   struct oc_process *p;
+#if NEXUS_CHANNEL_OC_ETIMER_HEAP_ENABLED
+  /* In the timer heap, `next` is the next sibling, and `prev` is the
+     previous sibling, or the parent of a first child. */
+  struct oc_etimer *child;
+  struct oc_etimer *prev;
+#endif
 };
 
 /**
@@ -38,6 +38,7 @@
 
 #include "oc_memb.h"
 #include "port/oc_log.h"
+#include <limits.h>
 #include <string.h>
 /*
 #ifdef OC_MEMORY_TRACE
@@ -56,56 +57,58 @@ oc_memb_init(struct oc_memb *m)
     memset(m->mem, 0, (unsigned)m->num * sizeof(char *));
 #endif // OC_DYNAMIC_ALLOCATION*/
   }
+  memset(&m->state, 0, sizeof(m->state));
 }
 //---------------------------------------------------------------------------
-void *
-_oc_memb_alloc(
-#ifdef OC_MEMORY_TRACE
-  const char *func,
-#endif
-  struct oc_memb *m)
+// Take a free chunk from the block, or return NULL if none are free
+static void *
+oc_memb_take(struct oc_memb *m)
 {
   if (!m) {
     //OC_ERR("oc_memb is NULL");
     return NULL;
   }
 
-  //int i = m->num; scan-build: value stored during initialization never read
-  int i;
   void *ptr = NULL;
-  if (m->num > 0) {
-    for (i = 0; i < m->num; i++) {
-      if (m->count[i] == 0) {
-        /* If this block was unused, we increase the reference count to
-     indicate that it now is used and return a pointer to the
-     memory block. */
-        ++(m->count[i]);
-        break;
-      }
-    }
-
-    if (i < m->num) {
-/*#ifdef OC_DYNAMIC_ALLOCATION
-      ptr = calloc(1, m->size);
-      void *slot = (void *)((char *)m->mem + (i * sizeof(void *)));
-      memcpy(slot, &ptr, sizeof(void *));
-#else  /* OC_DYNAMIC_ALLOCATION */
-      ptr = (void *)((char *)m->mem + (i * m->size));
-      memset(ptr, 0, m->size);
-//#endif // !OC_DYNAMIC_ALLOCATION
-    }
-  }
-/*#ifdef OC_DYNAMIC_ALLOCATION
-  else {
-    ptr = calloc(1, m->size);
+  if (m->state.free_list != NULL) {
+    // first bytes of a free chunk point to the next free chunk
+    ptr = m->state.free_list;
+    memcpy(&m->state.free_list, ptr, sizeof(void *));
+  } else if (m->state.unused < m->num) {
+    ptr = (void *)((char *)m->mem + (m->state.unused * m->size));
+    ++(m->state.unused);
   }
-//#endif /* OC_DYNAMIC_ALLOCATION*/
 
   if (!ptr) {
     /* No free block was found, so we return NULL to indicate failure to
        allocate block. */
+    if (m->state.alloc_failures < USHRT_MAX) {
+      ++(m->state.alloc_failures);
+    }
+    return NULL;
+  }
+
+  /* Increase the reference count to indicate that the block is now used. */
+  ++(m->count[((char *)ptr - (char *)m->mem) / m->size]);
+  ++(m->state.used);
+  if (m->state.used > m->state.high_water) {
+    m->state.high_water = m->state.used;
+  }
+  return ptr;
+}
+//---------------------------------------------------------------------------
+void *
+_oc_memb_alloc(
+#ifdef OC_MEMORY_TRACE
+  const char *func,
+#endif
+  struct oc_memb *m)
+{
+  void *ptr = oc_memb_take(m);
+  if (!ptr) {
     return NULL;
   }
+  memset(ptr, 0, m->size);
 
 /*
 #ifdef OC_MEMORY_TRACE
@@ -116,6 +119,12 @@ _oc_memb_alloc(
   return ptr;
 }
 //---------------------------------------------------------------------------
+void *
+_oc_memb_alloc_uninit(struct oc_memb *m)
+{
+  return oc_memb_take(m);
+}
+//---------------------------------------------------------------------------
 
 char
 _oc_memb_free(
@@ -133,40 +142,23 @@ _oc_memb_free(
   oc_mem_trace_add_pace(func, m->size, MEM_TRACE_FREE, ptr);
 #endif
 
-  // int i = m->num; scan-build: value stored during initialization never read
-  int i;
-  char *ptr2 = NULL;
-  if (m->num > 0) {
-    /* Walk through the list of blocks and try to find the block to
-       which the pointer "ptr" points to. */
-    ptr2 = (char *)m->mem;
-    for (i = 0; i < m->num; ++i) {
-#ifdef OC_DYNAMIC_ALLOCATION
-      if (memcmp(ptr2, &ptr, sizeof(void *)) == 0) {
-#else  // OC_DYNAMIC_ALLOCATION
-      if (ptr2 == (char *)ptr) {
-#endif // !OC_DYNAMIC_ALLOCATION
-        /* We've found to block to which "ptr" points so we decrease the
-           reference count and return the new value of it. */
-        if (m->count[i] > 0) {
-          /* Make sure that we don't deallocate free memory. */
-          --(m->count[i]);
-        }
-        break;
-      }
-#ifdef OC_DYNAMIC_ALLOCATION
-      ptr2 += sizeof(void *);
-#else  // OC_DYNAMIC_ALLOCATION
-      ptr2 += m->size;
-#endif // !OC_DYNAMIC_ALLOCATION
-    }
+  /* Find the block to which the pointer "ptr" points. */
+  const char *first = (const char *)m->mem;
+  if ((const char *)ptr < first ||
+      (const char *)ptr >= first + (m->num * m->size) ||
+      ((const char *)ptr - first) % m->size != 0) {
+    return -1;
   }
-#ifdef OC_DYNAMIC_ALLOCATION
-  if (i < m->num) {
-    memset(&ptr2, 0, sizeof(void *));
+  const size_t i = (size_t)((const char *)ptr - first) / m->size;
+
+  if (m->count[i] > 0) {
+    /* Make sure that we don't deallocate free memory. */
+    --(m->count[i]);
+    --(m->state.used);
+    memcpy(ptr, &m->state.free_list, sizeof(void *));
+    m->state.free_list = ptr;
   }
-  free(ptr);
-#endif // OC_DYNAMIC_ALLOCATION
+
   if (m->buffers_avail_cb) {
     m->buffers_avail_cb(oc_memb_numfree(m));
   }
@@ -184,16 +176,16 @@ int oc_memb_inmemb(struct oc_memb * m, void *ptr)
 int
 oc_memb_numfree(struct oc_memb *m)
 {
-  int i;
-  int num_free = 0;
-
-  for (i = 0; i < m->num; ++i) {
-    if (m->count[i] == 0) {
-      ++num_free;
-    }
-  }
-
-  return num_free;
+  return m->num - m->state.used;
+}
+//---------------------------------------------------------------------------
+void
+oc_memb_get_stats(const struct oc_memb *m, struct oc_memb_stats *stats)
+{
+  stats->num = m->num;
+  stats->used = m->state.used;
+  stats->high_water = m->state.high_water;
+  stats->alloc_failures = m->state.alloc_failures;
 }
 /*
 //---------------------------------------------------------------------------
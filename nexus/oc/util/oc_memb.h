@@ -106,16 +106,49 @@ extern "C"
 #else // OC_DYNAMIC_ALLOCATION
 */
 #define OC_MEMB(name, structure, num)                                          \
+  typedef char CC_CONCAT(name, _memb_holds_free_list_link)                     \
+    [sizeof(structure) >= sizeof(void *) ? 1 : -1];                            \
   static char CC_CONCAT(name, _memb_count)[num];                               \
   static structure CC_CONCAT(name, _memb_mem)[num];                            \
-  static struct oc_memb name = { sizeof(structure), num,                       \
+  static struct oc_memb name = { sizeof(structure),                            \
+                                 num,                                          \
                                  CC_CONCAT(name, _memb_count),                 \
-                                 (void *)CC_CONCAT(name, _memb_mem), 0 }
+                                 (void *)CC_CONCAT(name, _memb_mem),           \
+                                 0,                                            \
+                                 OC_MEMB_STATE_INIT }
 /*
 #endif // !OC_DYNAMIC_ALLOCATION
 */
+
+/**
+ * Initial value of `struct oc_memb_state`, for memory blocks which are
+ * declared without MEMB().
+ */
+#define OC_MEMB_STATE_INIT                                                     \
+  {                                                                            \
+    0, 0, 0, 0, 0                                                              \
+  }
 typedef void (*oc_memb_buffers_avail_callback_t)(int);
 
+/**
+ * Allocation state of a memory block.
+ *
+ * Free chunks are kept in an intrusive list, so that allocating and
+ * deallocating a chunk takes constant time. Each chunk in `free_list` holds
+ * a pointer to the next free chunk in its first bytes, so chunks must be at
+ * least as large as a pointer. Chunks at or above index `unused` have never
+ * been allocated, and are not in `free_list`, so that a memory block is
+ * usable without initialization.
+ */
+struct oc_memb_state
+{
+  void *free_list;
+  unsigned short unused;
+  unsigned short used;
+  unsigned short high_water;
+  unsigned short alloc_failures;
+};
+
 struct oc_memb
 {
   unsigned short size;
@@ -123,6 +156,22 @@ struct oc_memb
   char *count;
   void *mem;
   oc_memb_buffers_avail_callback_t buffers_avail_cb;
+  struct oc_memb_state state;
+};
+
+/**
+ * Usage statistics of a memory block, see oc_memb_get_stats().
+ */
+struct oc_memb_stats
+{
+  /** Total number of memory chunks in the block */
+  unsigned short num;
+  /** Number of chunks currently allocated */
+  unsigned short used;
+  /** Largest number of chunks allocated at once since initialization */
+  unsigned short high_water;
+  /** Number of failed allocations since initialization */
+  unsigned short alloc_failures;
 };
 
 /**
@@ -143,6 +192,16 @@ void *_oc_memb_alloc(
 #endif
   struct oc_memb *m);
 
+/**
+ * Allocate a memory block from a block of memory declared with MEMB(),
+ * without zeroing it.
+ *
+ * Only use if the caller initializes every field of the allocated chunk.
+ *
+ * \param m A memory block previously declared with MEMB().
+ */
+void *_oc_memb_alloc_uninit(struct oc_memb *m);
+
 /**
  * Deallocate a memory block from a memory block previously declared
  * with MEMB().
@@ -169,6 +228,8 @@ char _oc_memb_free(
 */
 #define oc_memb_alloc(m) (void *)_oc_memb_alloc(m)
 
+#define oc_memb_alloc_uninit(m) (void *)_oc_memb_alloc_uninit(m)
+
 #define oc_memb_free(m, ptr) (char)_oc_memb_free(m, ptr)
 /*
 #endif
@@ -180,6 +241,15 @@ int oc_memb_inmemb(struct oc_memb *m, void *ptr);
 */
 int oc_memb_numfree(struct oc_memb *m);
 
+/**
+ * Get usage statistics of a memory block declared with MEMB().
+ *
+ * \param m A memory block previously declared with MEMB().
+ *
+ * \param stats Filled with the usage statistics of `m`.
+ */
+void oc_memb_get_stats(const struct oc_memb *m, struct oc_memb_stats *stats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -26,6 +26,22 @@
     #error "NEXUS_CHANNEL_LINK_SECURITY_ENABLED must be defined"
 #endif
 
+// Queue received messages until they are processed by `nx_common_process`
+#ifdef CONFIG_NEXUS_CHANNEL_INGRESS_RING_ENABLED
+    #define NEXUS_CHANNEL_INGRESS_RING_ENABLED 1
+    #define NEXUS_CHANNEL_INGRESS_RING_MESSAGE_COUNT                           \
+        CONFIG_NEXUS_CHANNEL_INGRESS_RING_MESSAGE_COUNT
+#else
+    #define NEXUS_CHANNEL_INGRESS_RING_ENABLED 0
+#endif
+
+// Parse received messages in buffers lent by the platform
+#ifdef CONFIG_NEXUS_CHANNEL_ZERO_COPY_RECEIVE_ENABLED
+    #define NEXUS_CHANNEL_ZERO_COPY_RECEIVE_ENABLED 1
+#else
+    #define NEXUS_CHANNEL_ZERO_COPY_RECEIVE_ENABLED 0
+#endif
+
 // Set up further configuration parameters
 #if NEXUS_CHANNEL_LINK_SECURITY_ENABLED
 
@@ -50,6 +66,29 @@ extern "C" {
     // from this system. 7776000 = 3 months
     #define NEXUS_CHANNEL_LINK_TIMEOUT_SECONDS 7776000
 
+    // Persist reservations of link nonces which grow with the message rate
+    // of each link, instead of persisting link nonces at a fixed interval.
+    #ifdef CONFIG_NEXUS_CHANNEL_ADAPTIVE_NONCE_RESERVATION_ENABLED
+        #define NEXUS_CHANNEL_ADAPTIVE_NONCE_RESERVATION_ENABLED 1
+    #else
+        #define NEXUS_CHANNEL_ADAPTIVE_NONCE_RESERVATION_ENABLED 0
+    #endif
+
+    // Accept secured requests with out-of-order nonces, if the nonce is
+    // recent and was not received before.
+    #ifdef CONFIG_NEXUS_CHANNEL_LINK_SECURITY_REPLAY_WINDOW_ENABLED
+        #define NEXUS_CHANNEL_LINK_SECURITY_REPLAY_WINDOW_ENABLED 1
+    #else
+        #define NEXUS_CHANNEL_LINK_SECURITY_REPLAY_WINDOW_ENABLED 0
+    #endif
+
+    // Index links by hash and persist several links per NV block
+    #ifdef CONFIG_NEXUS_CHANNEL_LARGE_LINK_TABLE_ENABLED
+        #define NEXUS_CHANNEL_LARGE_LINK_TABLE_ENABLED 1
+    #else
+        #define NEXUS_CHANNEL_LARGE_LINK_TABLE_ENABLED 0
+    #endif
+
 NEXUS_STATIC_ASSERT(
     NEXUS_CHANNEL_MAX_CBOR_PAYLOAD_SIZE <
         NEXUS_CHANNEL_MAX_COAP_TOTAL_MESSAGE_SIZE,
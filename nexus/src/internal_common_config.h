@@ -21,6 +21,26 @@
 #include "utils/crc_ccitt.h"
 #include "utils/siphash_24.h"
 
+#ifdef CONFIG_NEXUS_COMMON_NV_CACHE_ENABLED
+    #define NEXUS_NV_CACHE_ENABLED 1
+    #define NEXUS_NV_CACHE_FLUSH_DELAY_SECONDS                                 \
+        CONFIG_NEXUS_COMMON_NV_CACHE_FLUSH_DELAY_SECONDS
+#else
+    #define NEXUS_NV_CACHE_ENABLED 0
+#endif
+
+#ifdef CONFIG_NEXUS_COMMON_NV_TRANSACTIONS_ENABLED
+    #define NEXUS_NV_TRANSACTIONS_ENABLED 1
+#else
+    #define NEXUS_NV_TRANSACTIONS_ENABLED 0
+#endif
+
+#ifdef CONFIG_NEXUS_COMMON_NV_WRITE_V_ENABLED
+    #define NEXUS_NV_WRITE_V_ENABLED 1
+#else
+    #define NEXUS_NV_WRITE_V_ENABLED 0
+#endif
+
 // Macro to expose certain functions during unit tests
 #ifdef NEXUS_INTERNAL_IMPL_NON_STATIC
     #define NEXUS_IMPL_STATIC
@@ -46,6 +46,9 @@ bool nexus_channel_core_init(void)
 {
     // Initialize CoaP
     coap_init_engine();
+    #if NEXUS_CHANNEL_INGRESS_RING_ENABLED
+    nexus_oc_wrapper_ingress_ring_clear();
+    #endif
 
     /** Setup functions before calling `oc_main_init`; see docstring of
      * `oc_main_init` in `oc_api.h`.
@@ -101,6 +104,10 @@ bool nexus_channel_core_init(void)
 void nexus_channel_core_shutdown(void)
 {
     oc_main_shutdown();
+    #if NEXUS_CHANNEL_INGRESS_RING_ENABLED
+    // drop received messages not yet passed to IoTivity
+    nexus_oc_wrapper_ingress_ring_clear();
+    #endif
     #if NEXUS_CHANNEL_LINK_SECURITY_ENABLED
     nexus_channel_sm_free_all_nexus_resource_methods();
     #endif
@@ -116,6 +123,14 @@ void nexus_channel_core_shutdown(void)
 uint32_t nexus_channel_core_process(uint32_t seconds_elapsed)
 {
     uint32_t min_sleep = NEXUS_COMMON_IDLE_TIME_BETWEEN_PROCESS_CALL_SECONDS;
+    #if NEXUS_CHANNEL_INGRESS_RING_ENABLED
+    // Pass received messages to IoTivity as incoming message buffers become
+    // free, processing each group of messages before passing the next
+    while (nexus_oc_wrapper_ingress_ring_drain() > 0)
+    {
+        (void) oc_main_poll();
+    }
+    #endif
     // Execute any OC/IoTivity processes until completion
     // oc_clock_time_t is a typecast for uint64_t, but should not normally
     // be larger than a uint32_t
@@ -167,6 +182,13 @@ uint32_t nexus_channel_core_process(uint32_t seconds_elapsed)
     #else
     (void) seconds_elapsed;
     #endif // NEXUS_CHANNEL_LINK_SECURITY_ENABLED
+    #if NEXUS_CHANNEL_INGRESS_RING_ENABLED
+    if (nexus_oc_wrapper_ingress_ring_count() > 0)
+    {
+        // received messages are still waiting for free incoming buffers
+        min_sleep = 0;
+    }
+    #endif
     return min_sleep;
 }
 
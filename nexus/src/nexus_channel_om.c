@@ -12,6 +12,7 @@
 #include "include/nxp_channel.h"
 #include "src/nexus_channel_core.h"
 #include "src/nexus_nv.h"
+#include "src/nexus_security.h"
 #include "src/nexus_util.h"
 
 #if NEXUS_CHANNEL_LINK_SECURITY_ENABLED
@@ -37,6 +38,10 @@
         // Fixed number of digits (at end of origin command) for MAC
         #define NEXUS_CHANNEL_OM_FIXED_MAC_DIGIT_COUNT 6
 
+        // Authenticated bytes in controller action and create link commands
+        // (command ID, type code, 4 byte body)
+        #define NEXUS_CHANNEL_OM_FIXED_AUTH_BYTES_COUNT 9
+
 static NEXUS_PACKED_STRUCT
 {
     // center 'index' of window of received commands
@@ -263,17 +268,12 @@ NEXUS_IMPL_STATIC bool _nexus_channel_om_ascii_parse_message(
 }
 
 // internal
-static uint32_t _nexus_channel_om_ascii_auth_arbitrary_bytes(
-    const uint8_t* bytes,
-    uint8_t bytes_count,
-    const struct nx_common_check_key* key)
+static uint32_t _nexus_channel_om_ascii_truncate_check(
+    const struct nexus_check_value* check_val)
 {
-    const struct nexus_check_value check_val =
-        nexus_check_compute(key, bytes, bytes_count);
-
     // obtain lower 32 bits of check
     const uint32_t lower_check =
-        nexus_check_value_as_uint64(&check_val) & 0xffffffff;
+        nexus_check_value_as_uint64(check_val) & 0xffffffff;
 
     // obtain the 'decimal representation' of the lowest 6 decimal digits of
     // the check. Note that leading zeros are *ignored* as the check is now
@@ -282,20 +282,32 @@ static uint32_t _nexus_channel_om_ascii_auth_arbitrary_bytes(
     return lower_check % 1000000;
 }
 
-NEXUS_IMPL_STATIC bool _nexus_channel_om_ascii_message_infer_inner_compute_auth(
-    struct nexus_channel_om_command_message* message,
-    const struct nx_common_check_key* origin_key)
+// internal
+static uint32_t _nexus_channel_om_ascii_auth_arbitrary_bytes(
+    const uint8_t* bytes,
+    uint8_t bytes_count,
+    const struct nx_common_check_key* key)
 {
-    uint8_t compute_bytes[NEXUS_CHANNEL_OM_COMMAND_BEARER_MAX_BYTES_TO_AUTH] = {
-        0};
-    bool success = false;
-    uint32_t computed_check;
+    const struct nexus_check_value check_val =
+        nexus_check_compute(key, bytes, bytes_count);
 
+    return _nexus_channel_om_ascii_truncate_check(&check_val);
+}
+
+// internal
+// Populates `compute_bytes` with the authenticated bytes of `message` which
+// do not depend on any inferred field other than the command ID. For
+// accessory action messages, this is only the command ID and type code; the
+// accessory ID must be appended by the caller. Returns the number of bytes
+// populated.
+static uint8_t _nexus_channel_om_ascii_message_fixed_auth_bytes(
+    const struct nexus_channel_om_command_message* message,
+    uint8_t* compute_bytes)
+{
     // first 4 bytes are the command ID for all message types
-    //
     const uint32_t computed_command_id_le =
         nexus_endian_htole32(message->computed_command_id);
-    memcpy(&compute_bytes, &computed_command_id_le, 4);
+    memcpy(compute_bytes, &computed_command_id_le, 4);
 
     NEXUS_ASSERT(sizeof(message->computed_command_id) == 4,
                  "Invalid command ID size");
@@ -316,7 +328,44 @@ NEXUS_IMPL_STATIC bool _nexus_channel_om_ascii_message_infer_inner_compute_auth(
                        ->action_type) == 4,
             "Unexpected struct size for controller action body");
         bytes_count = (uint8_t)(bytes_count + 4);
+    }
+    else if (message->type ==
+             NEXUS_CHANNEL_OM_COMMAND_TYPE_CREATE_ACCESSORY_LINK_MODE_3)
+    {
+        const uint32_t accessory_challenge_le = nexus_endian_htole32(
+            message->body.create_link.accessory_challenge.six_int_digits);
+
+        memcpy(&compute_bytes[5], &accessory_challenge_le, 4);
+        NEXUS_STATIC_ASSERT(
+            sizeof(((union nexus_channel_om_auth_field*) 0)->six_int_digits) ==
+                4,
+            "Invalid size for six_int_digits field");
+        bytes_count = (uint8_t)(bytes_count + 4);
+
+        NEXUS_ASSERT(bytes_count == NEXUS_CHANNEL_OM_FIXED_AUTH_BYTES_COUNT,
+                     "Invalid number of bytes for MAC computation");
+    }
 
+    return bytes_count;
+}
+
+NEXUS_IMPL_STATIC bool _nexus_channel_om_ascii_message_infer_inner_compute_auth(
+    struct nexus_channel_om_command_message* message,
+    const struct nx_common_check_key* origin_key)
+{
+    uint8_t compute_bytes[NEXUS_CHANNEL_OM_COMMAND_BEARER_MAX_BYTES_TO_AUTH] = {
+        0};
+    bool success = false;
+    uint32_t computed_check;
+
+    uint8_t bytes_count = _nexus_channel_om_ascii_message_fixed_auth_bytes(
+        message, compute_bytes);
+
+    if (message->type ==
+            NEXUS_CHANNEL_OM_COMMAND_TYPE_GENERIC_CONTROLLER_ACTION ||
+        message->type ==
+            NEXUS_CHANNEL_OM_COMMAND_TYPE_CREATE_ACCESSORY_LINK_MODE_3)
+    {
         computed_check = _nexus_channel_om_ascii_auth_arbitrary_bytes(
             compute_bytes, bytes_count, origin_key);
 
@@ -424,36 +473,95 @@ NEXUS_IMPL_STATIC bool _nexus_channel_om_ascii_message_infer_inner_compute_auth(
             }
         }
     }
-    else if (message->type ==
-             NEXUS_CHANNEL_OM_COMMAND_TYPE_CREATE_ACCESSORY_LINK_MODE_3)
+    // sanity check for tests
+    NEXUS_ASSERT(bytes_count <=
+                     NEXUS_CHANNEL_OM_COMMAND_BEARER_MAX_BYTES_TO_AUTH,
+                 "too many bytes to auth!");
+
+    return success;
+}
+
+// internal
+// Search the window for the command ID of a message whose authenticated
+// bytes (other than the command ID) are fixed, computing checks for several
+// candidate command IDs at a time.
+static bool _nexus_channel_om_ascii_infer_command_id_batched(
+    struct nexus_channel_om_command_message* message,
+    const struct nexus_window* window,
+    const struct nx_common_check_key* origin_key)
+{
+    uint8_t template_bytes[NEXUS_CHANNEL_OM_COMMAND_BEARER_MAX_BYTES_TO_AUTH];
+    const uint8_t bytes_count =
+        _nexus_channel_om_ascii_message_fixed_auth_bytes(message,
+                                                         template_bytes);
+    NEXUS_ASSERT(bytes_count == NEXUS_CHANNEL_OM_FIXED_AUTH_BYTES_COUNT,
+                 "Unexpected number of bytes for batched MAC computation");
+    NEXUS_UNUSED(bytes_count);
+
+    struct nexus_check_keyed_state origin_key_state;
+    nexus_check_keyed_state_init(&origin_key_state, origin_key);
+
+    uint32_t candidate_ids[NEXUS_CHECK_BATCH_MAX_COUNT];
+    uint8_t candidate_bytes[NEXUS_CHECK_BATCH_MAX_COUNT]
+                           [NEXUS_CHANNEL_OM_FIXED_AUTH_BYTES_COUNT];
+    struct nexus_check_value checks[NEXUS_CHECK_BATCH_MAX_COUNT];
+    uint32_t candidate_id = message->computed_command_id;
+    bool validated = false;
+
+    while (!validated &&
+           nexus_util_window_id_within_window(window, candidate_id))
     {
-        const uint32_t accessory_challenge_le = nexus_endian_htole32(
-            message->body.create_link.accessory_challenge.six_int_digits);
+        uint8_t candidate_count = 0;
 
-        memcpy(&compute_bytes[5], &accessory_challenge_le, 4);
-        NEXUS_STATIC_ASSERT(
-            sizeof(((union nexus_channel_om_auth_field*) 0)->six_int_digits) ==
-                4,
-            "Invalid size for six_int_digits field");
-        bytes_count = (uint8_t)(bytes_count + 4);
+        while (candidate_count < NEXUS_CHECK_BATCH_MAX_COUNT &&
+               nexus_util_window_id_within_window(window, candidate_id))
+        {
+            // only examine IDs that aren't already set
+            candidate_id =
+                nexus_util_window_next_unset_id(window, candidate_id);
+            if (!nexus_util_window_id_within_window(window, candidate_id))
+            {
+                break;
+            }
 
-        NEXUS_ASSERT(bytes_count == 9,
-                     "Invalid number of bytes for MAC computation");
+            const uint32_t candidate_id_le = nexus_endian_htole32(candidate_id);
+            memcpy(candidate_bytes[candidate_count],
+                   template_bytes,
+                   sizeof(candidate_bytes[0]));
+            memcpy(candidate_bytes[candidate_count], &candidate_id_le, 4);
+            candidate_ids[candidate_count] = candidate_id;
+            candidate_count++;
+            candidate_id++;
+        }
 
-        computed_check = _nexus_channel_om_ascii_auth_arbitrary_bytes(
-            compute_bytes, bytes_count, origin_key);
+        if (candidate_count == 0)
+        {
+            break;
+        }
 
-        if (computed_check == message->auth.six_int_digits)
+        nexus_check_compute_batch(&origin_key_state,
+                                  true,
+                                  candidate_bytes,
+                                  sizeof(candidate_bytes[0]),
+                                  candidate_count,
+                                  checks);
+
+        for (uint8_t i = 0; i < candidate_count; i++)
         {
-            success = true;
+            if (_nexus_channel_om_ascii_truncate_check(&checks[i]) ==
+                message->auth.six_int_digits)
+            {
+                candidate_id = candidate_ids[i];
+                validated = true;
+                break;
+            }
         }
     }
-    // sanity check for tests
-    NEXUS_ASSERT(bytes_count <=
-                     NEXUS_CHANNEL_OM_COMMAND_BEARER_MAX_BYTES_TO_AUTH,
-                 "too many bytes to auth!");
 
-    return success;
+    nexus_secure_memclr(
+        &origin_key_state, sizeof(origin_key_state), sizeof(origin_key_state));
+    message->computed_command_id = candidate_id;
+    return validated;
 }
 
 // returns true and populates inferred command ID and MAC if valid, returns
@@ -475,15 +583,30 @@ NEXUS_IMPL_STATIC bool _nexus_channel_om_ascii_infer_fields_compute_auth(
                      window, message->computed_command_id),
                  "Bottom of window is outside of window - unexpected.");
 
+    if (message->type ==
+            NEXUS_CHANNEL_OM_COMMAND_TYPE_GENERIC_CONTROLLER_ACTION ||
+        message->type ==
+            NEXUS_CHANNEL_OM_COMMAND_TYPE_CREATE_ACCESSORY_LINK_MODE_3)
+    {
+        return _nexus_channel_om_ascii_infer_command_id_batched(
+            message, window, origin_key);
+    }
+
     // loop through all possible command IDs in the window
     while (nexus_util_window_id_within_window(window,
                                               message->computed_command_id))
     {
         // only examine IDs that aren't already set
-        if (!nexus_util_window_id_flag_already_set(
-                window, message->computed_command_id) &&
-            (_nexus_channel_om_ascii_message_infer_inner_compute_auth(
-                message, origin_key)))
+        message->computed_command_id = nexus_util_window_next_unset_id(
+            window, message->computed_command_id);
+        if (!nexus_util_window_id_within_window(window,
+                                                message->computed_command_id))
+        {
+            break;
+        }
+
+        if (_nexus_channel_om_ascii_message_infer_inner_compute_auth(
+                message, origin_key))
         {
             validated = true;
             // don't increment computed command ID any longer
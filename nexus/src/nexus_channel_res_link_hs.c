@@ -299,6 +299,26 @@ static struct nexus_check_value _res_link_hs_mode0_compute_inverted_salt_mac(
     return result;
 }
 
+// internal
+// Fill `material` (KEY_DERIVATION_MATERIAL_LENGTH_BYTES in length) with the
+// bytes used to derive a link key from a salt and challenge result.
+static void _res_link_hs_fill_key_derivation_material(uint8_t* material,
+                                                      uint32_t challenge_int,
+                                                      const uint8_t* salt_bytes,
+                                                      uint8_t salt_len)
+{
+    // Obtain challenge int in little endian (for consistent computation,
+    // always order its bytes in little endian)
+    const uint32_t little_end_challenge = nexus_endian_htole32(challenge_int);
+    // append bytes of the challenge result to the key derivation material
+
+    // Fill key derivation material as:
+    // [0..7] = Salt
+    // [8..11] = challenge integer (from origin)
+    memcpy(&material[0], salt_bytes, salt_len);
+    memcpy(&material[8], (const void*) &little_end_challenge, sizeof(uint32_t));
+}
+
 // internal, may branch into separate security manager
 // takes key derivation key and challenge data, returns derived link key
 NEXUS_IMPL_STATIC struct nx_common_check_key _res_link_hs_generate_link_key(
@@ -316,18 +336,8 @@ NEXUS_IMPL_STATIC struct nx_common_check_key _res_link_hs_generate_link_key(
     static uint8_t
         key_derivation_material[KEY_DERIVATION_MATERIAL_LENGTH_BYTES] = {0};
 
-    // Obtain challenge int in little endian (for consistent computation,
-    // always order its bytes in little endian)
-    const uint32_t little_end_challenge = nexus_endian_htole32(challenge_int);
-    // append bytes of the challenge result to the key derivation material
-
-    // Fill key derivation material as:
-    // [0..7] = Salt
-    // [8..11] = challenge integer (from origin)
-    memcpy(&key_derivation_material[0], salt_bytes, salt_len);
-    memcpy(&key_derivation_material[8],
-           (const void*) &little_end_challenge,
-           sizeof(uint32_t));
+    _res_link_hs_fill_key_derivation_material(
+        key_derivation_material, challenge_int, salt_bytes, salt_len);
 
     // Compute and return the link key using the key derivation key, done
     // by computing two separate Siphash 2-4 results and concatenating.
@@ -387,15 +397,35 @@ NEXUS_IMPL_STATIC bool _nexus_channel_res_link_hs_server_validate_challenge(
     // use the key which only the origin and this device know
     const struct nx_common_check_key origin_key =
         nxp_channel_symmetric_origin_key();
+    // same origin key is used for every index in the window, only set it up
+    // once for the entire search
+    struct nexus_check_keyed_state origin_key_state;
+    nexus_check_keyed_state_init(&origin_key_state, &origin_key);
+
+    // public key derivation keys are also shared by all candidates
+    struct nexus_check_keyed_state derivation_key_a_state;
+    struct nexus_check_keyed_state derivation_key_b_state;
+    nexus_check_keyed_state_init(&derivation_key_a_state,
+                                 &NEXUS_CHANNEL_PUBLIC_KEY_DERIVATION_KEY_1);
+    nexus_check_keyed_state_init(&derivation_key_b_state,
+                                 &NEXUS_CHANNEL_PUBLIC_KEY_DERIVATION_KEY_2);
 
     bool mac_valid = false;
 
-    // variables updated on each loop iteration
-    uint32_t count_le;
-    struct nexus_check_value challenge_hash;
-    uint32_t six_digit_int_challenge;
+    // Candidate handshake indices are validated several at a time. Each
+    // step below computes one check per candidate in a single batch.
+    uint32_t candidate_ids[NEXUS_CHECK_BATCH_MAX_COUNT];
+    uint32_t counts_le[NEXUS_CHECK_BATCH_MAX_COUNT];
+    struct nexus_check_value challenge_hashes[NEXUS_CHECK_BATCH_MAX_COUNT];
+    uint8_t key_derivation_material[NEXUS_CHECK_BATCH_MAX_COUNT]
+                                   [KEY_DERIVATION_MATERIAL_LENGTH_BYTES];
+    struct nexus_check_value key_parts_a[NEXUS_CHECK_BATCH_MAX_COUNT];
+    struct nexus_check_value key_parts_b[NEXUS_CHECK_BATCH_MAX_COUNT];
+    struct nexus_check_keyed_state link_key_states[NEXUS_CHECK_BATCH_MAX_COUNT];
+    uint8_t salts[NEXUS_CHECK_BATCH_MAX_COUNT]
+                 [CHALLENGE_MODE_3_SALT_LENGTH_BYTES];
+    struct nexus_check_value computed_macs[NEXUS_CHECK_BATCH_MAX_COUNT];
     struct nx_common_check_key computed_link_key;
-    struct nexus_check_value computed_mac;
 
     // should be true due if window is valid.
     NEXUS_ASSERT(window->center_index >= window->flags_below,
@@ -406,64 +436,138 @@ NEXUS_IMPL_STATIC bool _nexus_channel_res_link_hs_server_validate_challenge(
     const uint32_t start_index = window->center_index - window->flags_below;
     const uint32_t end_index = window->center_index + window->flags_above;
 
-    // each loop iteration involves a key derivation step
-    for (uint32_t i = start_index; i <= end_index; i++)
+    // the salt is authenticated under every candidate link key
+    for (uint8_t i = 0; i < NEXUS_CHECK_BATCH_MAX_COUNT; i++)
     {
-        NEXUS_ASSERT(nexus_util_window_id_within_window(window, i),
-                     "ID unexpectedly out of window.");
-        if (nexus_util_window_id_flag_already_set(window, i))
+        memcpy(salts[i], salt, CHALLENGE_MODE_3_SALT_LENGTH_BYTES);
+    }
+
+    uint32_t i = start_index;
+    while (!mac_valid && i <= end_index)
+    {
+        uint8_t candidate_count = 0;
+
+        for (; candidate_count < NEXUS_CHECK_BATCH_MAX_COUNT && i <= end_index;
+             i++)
         {
-            OC_DBG("Skipping already used ID %u", i);
-            continue;
+            NEXUS_ASSERT(nexus_util_window_id_within_window(window, i),
+                         "ID unexpectedly out of window.");
+            // skip over any already used IDs
+            i = nexus_util_window_next_unset_id(window, i);
+            if (i > end_index)
+            {
+                break;
+            }
+            // For consistency in computation ensure that the count is in
+            // little endian.
+            candidate_ids[candidate_count] = i;
+            counts_le[candidate_count] = nexus_endian_htole32(i);
+            candidate_count++;
         }
 
-        // first, calculate a possible 'challenge int' using the accessory
-        // link handshake 'count' and the origin key. For consistency in
-        // computation ensure that the count is in little endian.
-        count_le = nexus_endian_htole32(i);
-        challenge_hash =
-            nexus_check_compute(&origin_key, &count_le, sizeof(count_le));
-
-        // obtain lower 32 bits of check
-        six_digit_int_challenge =
-            nexus_check_value_as_uint64(&challenge_hash) & 0xffffffff;
-
-        // obtain the 'decimal representation' of the lowest 6 decimal digits
-        // of the check.  Note that leading zeros are *ignored* as the check is
-        // now
-        // computed over the numeric value represented by the 6 decimal check
-        // digits, not the individual digits themselves.
-        six_digit_int_challenge = six_digit_int_challenge % 1000000;
-
-        // Now, we can attempt to compute a key to use to check the MAC
-        computed_link_key = _res_link_hs_generate_link_key(
-            six_digit_int_challenge,
-            salt,
-            CHALLENGE_MODE_3_SALT_LENGTH_BYTES,
-            &NEXUS_CHANNEL_PUBLIC_KEY_DERIVATION_KEY_1,
-            &NEXUS_CHANNEL_PUBLIC_KEY_DERIVATION_KEY_2);
-
-        // use the computed key to check the MAC for the provided salt. We
-        // can then determine if this computed key (and thus this 'handshake
-        // index') is the right one to use.
-        computed_mac = nexus_check_compute(
-            &computed_link_key, salt, CHALLENGE_MODE_3_SALT_LENGTH_BYTES);
-        if (memcmp(&computed_mac, rcvd_mac, sizeof(struct nexus_check_value)) ==
-            0)
+        if (candidate_count == 0)
         {
-            // will be persisted later by caller
-            *matched_handshake_index = i;
-            mac_valid = true;
-            memcpy(derived_key,
-                   &computed_link_key,
-                   sizeof(struct nx_common_check_key));
-            nexus_secure_memclr(&computed_link_key,
-                                sizeof(struct nx_common_check_key),
-                                sizeof(struct nx_common_check_key));
             break;
         }
+
+        // first, calculate a possible 'challenge int' for each candidate
+        // using the accessory link handshake 'count' and the origin key.
+        nexus_check_compute_batch(&origin_key_state,
+                                  true,
+                                  counts_le,
+                                  sizeof(counts_le[0]),
+                                  candidate_count,
+                                  challenge_hashes);
+
+        for (uint8_t j = 0; j < candidate_count; j++)
+        {
+            // obtain lower 32 bits of check, then the 'decimal
+            // representation' of the lowest 6 decimal digits of the check.
+            // Note that leading zeros are *ignored* as the check is now
+            // computed over the numeric value represented by the 6 decimal
+            // check digits, not the individual digits themselves.
+            const uint32_t six_digit_int_challenge =
+                (uint32_t)(nexus_check_value_as_uint64(&challenge_hashes[j]) &
+                           0xffffffff) %
+                1000000;
+
+            _res_link_hs_fill_key_derivation_material(
+                key_derivation_material[j],
+                six_digit_int_challenge,
+                salt,
+                CHALLENGE_MODE_3_SALT_LENGTH_BYTES);
+        }
+
+        // Now, we can compute a possible link key for each candidate, done
+        // by computing two separate Siphash 2-4 results and concatenating
+        // (as in `_res_link_hs_generate_link_key`).
+        nexus_check_compute_batch(&derivation_key_a_state,
+                                  true,
+                                  key_derivation_material,
+                                  KEY_DERIVATION_MATERIAL_LENGTH_BYTES,
+                                  candidate_count,
+                                  key_parts_a);
+        nexus_check_compute_batch(&derivation_key_b_state,
+                                  true,
+                                  key_derivation_material,
+                                  KEY_DERIVATION_MATERIAL_LENGTH_BYTES,
+                                  candidate_count,
+                                  key_parts_b);
+
+        for (uint8_t j = 0; j < candidate_count; j++)
+        {
+            (void) memcpy(&computed_link_key.bytes[0],
+                          &key_parts_a[j],
+                          sizeof(struct nexus_check_value));
+            (void) memcpy(&computed_link_key.bytes[0] + 8,
+                          &key_parts_b[j],
+                          sizeof(struct nexus_check_value));
+            nexus_check_keyed_state_init(&link_key_states[j],
+                                         &computed_link_key);
+        }
+
+        // use each computed key to check the MAC for the provided salt. We
+        // can then determine if a computed key (and thus its 'handshake
+        // index') is the right one to use.
+        nexus_check_compute_batch(link_key_states,
+                                  false,
+                                  salts,
+                                  CHALLENGE_MODE_3_SALT_LENGTH_BYTES,
+                                  candidate_count,
+                                  computed_macs);
+
+        for (uint8_t j = 0; j < candidate_count; j++)
+        {
+            if (memcmp(&computed_macs[j],
+                       rcvd_mac,
+                       sizeof(struct nexus_check_value)) == 0)
+            {
+                // will be persisted later by caller
+                *matched_handshake_index = candidate_ids[j];
+                mac_valid = true;
+                memcpy(&derived_key->bytes[0],
+                       &key_parts_a[j],
+                       sizeof(struct nexus_check_value));
+                memcpy(&derived_key->bytes[0] + 8,
+                       &key_parts_b[j],
+                       sizeof(struct nexus_check_value));
+                break;
+            }
+        }
     }
 
+    // clear all intermediate key material
+    nexus_secure_memclr(&origin_key_state,
+                        sizeof(origin_key_state),
+                        sizeof(origin_key_state));
+    nexus_secure_memclr(&computed_link_key,
+                        sizeof(computed_link_key),
+                        sizeof(computed_link_key));
+    nexus_secure_memclr(key_parts_a, sizeof(key_parts_a), sizeof(key_parts_a));
+    nexus_secure_memclr(key_parts_b, sizeof(key_parts_b), sizeof(key_parts_b));
+    nexus_secure_memclr(
+        link_key_states, sizeof(link_key_states), sizeof(link_key_states));
+
     return mac_valid;
 }
 
@@ -28,6 +28,13 @@ const char* L_TIME_SINCE_INIT_SHORT_PROP_NAME = "tI";
 const char* L_TIME_SINCE_ACTIVITY_SHORT_PROP_NAME = "tA";
 const char* L_TIMEOUT_CONFIGURED_SHORT_PROP_NAME = "tT";
 
+    #if NEXUS_CHANNEL_LARGE_LINK_TABLE_ENABLED
+        // At most half of the index slots are in use, so that probe sequences
+        // are short and always end at an empty slot
+        #define NEXUS_CHANNEL_LINK_INDEX_SLOT_COUNT                            \
+            (2 * NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS)
+    #endif
+
 // forward declarations
 static void _nexus_channel_link_manager_clear_link_internal(uint8_t link_id);
 static void _nexus_channel_link_manager_clear_links_internal(void);
@@ -43,6 +50,30 @@ static NEXUS_PACKED_STRUCT
     uint8_t link_count;
     bool link_idx_in_use[NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS];
     bool link_idx_should_persist_nonce[NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS];
+    #if NEXUS_CHANNEL_ADAPTIVE_NONCE_RESERVATION_ENABLED
+    // Highest nonce persisted to NV for each link; nonces up to this value
+    // may be used without another NV write
+    uint32_t nonce_reserved[NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS];
+    // Number of nonces to reserve by the next NV write for each link
+    uint32_t nonce_reservation_size[NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS];
+    uint32_t seconds_since_nonce_reserved[NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS];
+    #endif
+    #if NEXUS_CHANNEL_LINK_SECURITY_REPLAY_WINDOW_ENABLED
+    // Received request nonces for each link, as `nexus_window` flags. Window
+    // IDs are request nonces plus the window size, so that the window never
+    // extends below 0.
+    uint8_t replay_window_flags[NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS]
+                               [NEXUS_CHANNEL_LINK_SECURITY_REPLAY_WINDOW_SIZE /
+                                8];
+    uint32_t replay_window_center[NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS];
+    #endif
+    #if NEXUS_CHANNEL_LARGE_LINK_TABLE_ENABLED
+    // Open addressing (linear probing) hash index of links by linked device
+    // ID. Each slot holds a link index plus one, or 0 if the slot is empty.
+    uint8_t link_index_slots[NEXUS_CHANNEL_LINK_INDEX_SLOT_COUNT];
+    // Link pages which must be written to NV
+    bool link_page_dirty[NX_COMMON_NV_LINK_PAGE_COUNT];
+    #endif
     bool pending_add_link;
     bool pending_clear_all_links;
 }
@@ -52,6 +83,112 @@ NEXUS_STATIC_ASSERT(sizeof(_this.stored) ==
                         36 * NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS,
                     "Invalid size of stored links struct");
 
+// Keyed state of each link key, used to compute and verify MACs without
+// copying the key or repeating key setup. Kept outside of (packed) `_this`
+// so that it is naturally aligned.
+static struct nexus_check_keyed_state
+    _link_key_states[NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS];
+
+    #if NEXUS_CHANNEL_LARGE_LINK_TABLE_ENABLED
+NEXUS_STATIC_ASSERT(NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS <= UINT8_MAX,
+                    "Link index slots cannot hold more than 255 links");
+NEXUS_STATIC_ASSERT(sizeof(nexus_channel_link_t) *
+                            NX_COMMON_NV_LINK_PAGE_LINK_COUNT ==
+                        NX_COMMON_NV_LINK_PAGE_BLOCK_LENGTH -
+                            NEXUS_NV_BLOCK_WRAPPER_SIZE_BYTES,
+                    "Invalid size of link page NV block");
+
+// Home index slot of a linked device ID
+static uint16_t
+_nexus_channel_link_manager_index_home_slot(const struct nx_id* id)
+{
+    // Fibonacci hashing; the upper bits of the product are well mixed
+    const uint32_t hash =
+        (id->device_id ^ ((uint32_t) id->authority_id << 16)) * 2654435761u;
+    return (uint16_t)((hash >> 16) % NEXUS_CHANNEL_LINK_INDEX_SLOT_COUNT);
+}
+
+// Find the index slot of the link to `id`, return false if there is none
+static bool _nexus_channel_link_manager_index_find(const struct nx_id* id,
+                                                   uint16_t* slot_ptr)
+{
+    uint16_t slot = _nexus_channel_link_manager_index_home_slot(id);
+    while (_this.link_index_slots[slot] != 0)
+    {
+        const struct nx_id* comp_id =
+            &_this.stored.links[_this.link_index_slots[slot] - 1]
+                 .linked_device_id;
+        if (comp_id->device_id == id->device_id &&
+            comp_id->authority_id == id->authority_id)
+        {
+            *slot_ptr = slot;
+            return true;
+        }
+        slot = (uint16_t)((slot + 1) % NEXUS_CHANNEL_LINK_INDEX_SLOT_COUNT);
+    }
+    return false;
+}
+
+// Add the (in use) link at `index` to the index
+static void _nexus_channel_link_manager_index_insert(uint8_t index)
+{
+    uint16_t slot = _nexus_channel_link_manager_index_home_slot(
+        &_this.stored.links[index].linked_device_id);
+    while (_this.link_index_slots[slot] != 0)
+    {
+        slot = (uint16_t)((slot + 1) % NEXUS_CHANNEL_LINK_INDEX_SLOT_COUNT);
+    }
+    _this.link_index_slots[slot] = (uint8_t)(index + 1);
+}
+
+/* Remove the link at `index` from the index.
+ *
+ * Must be called before the link is cleared. Links later in the same probe
+ * sequence are moved back into the removed slot (backward shift deletion),
+ * so that lookups never stop early at the removed slot.
+ */
+static void _nexus_channel_link_manager_index_remove(uint8_t index)
+{
+    const uint16_t slot_count = NEXUS_CHANNEL_LINK_INDEX_SLOT_COUNT;
+    uint16_t empty_slot = 0;
+    if (!_nexus_channel_link_manager_index_find(
+            &_this.stored.links[index].linked_device_id, &empty_slot))
+    {
+        NEXUS_ASSERT_FAIL_IN_DEBUG_ONLY(0, "Link not found in index");
+        return;
+    }
+    NEXUS_ASSERT(_this.link_index_slots[empty_slot] == index + 1,
+                 "Unexpected link in index");
+
+    uint16_t slot = (uint16_t)((empty_slot + 1) % slot_count);
+    while (_this.link_index_slots[slot] != 0)
+    {
+        const uint16_t home_slot = _nexus_channel_link_manager_index_home_slot(
+            &_this.stored.links[_this.link_index_slots[slot] - 1]
+                 .linked_device_id);
+        // The link may only move back if its home slot is not between the
+        // empty slot and its current slot
+        if ((slot + slot_count - home_slot) % slot_count >=
+            (slot + slot_count - empty_slot) % slot_count)
+        {
+            _this.link_index_slots[empty_slot] = _this.link_index_slots[slot];
+            empty_slot = slot;
+        }
+        slot = (uint16_t)((slot + 1) % slot_count);
+    }
+    _this.link_index_slots[empty_slot] = 0;
+}
+
+// NV block storing link page `page`
+static struct nx_common_nv_block_meta
+_nexus_channel_link_manager_page_to_nv_block(uint8_t page)
+{
+    const struct nx_common_nv_block_meta block_meta = {
+        .block_id = (uint16_t)(NX_COMMON_NV_LINK_PAGE_FIRST_BLOCK_ID + page),
+        .length = NX_COMMON_NV_LINK_PAGE_BLOCK_LENGTH};
+    return block_meta;
+}
+    #else
 // Look up an NV metadata block based on ID
 NEXUS_IMPL_STATIC bool _nexus_channel_link_manager_index_to_nv_block(
     uint8_t index, struct nx_common_nv_block_meta** dest_block_meta_ptr)
@@ -101,12 +238,243 @@ NEXUS_IMPL_STATIC bool _nexus_channel_link_manager_index_to_nv_block(
     }
     return success;
 }
+    #endif
+
+// Copy the link at `index` as it is stored in NV into `dest`. Links which
+// are not in use are stored as all 0x00.
+static void _nexus_channel_link_manager_nv_link(uint8_t index,
+                                                nexus_channel_link_t* dest)
+{
+    memcpy(dest, &_this.stored.links[index], sizeof(nexus_channel_link_t));
+    #if NEXUS_CHANNEL_ADAPTIVE_NONCE_RESERVATION_ENABLED
+    if (_this.link_idx_in_use[index])
+    {
+        // always store the end of the current reservation
+        dest->security_data.mode0.nonce = _this.nonce_reserved[index];
+    }
+    #endif
+}
+
+/* Write the link at `index` to NV.
+ *
+ * If links are stored in pages, the page holding the link is only marked
+ * for writing, and is written by `_nexus_channel_link_manager_flush_pages`.
+ */
+static void _nexus_channel_link_manager_persist_link(uint8_t index)
+{
+    #if NEXUS_CHANNEL_LARGE_LINK_TABLE_ENABLED
+    _this.link_page_dirty[index / NX_COMMON_NV_LINK_PAGE_LINK_COUNT] = true;
+    #else
+    struct nx_common_nv_block_meta* tmp_block_meta = 0;
+    (void) _nexus_channel_link_manager_index_to_nv_block(index,
+                                                         &tmp_block_meta);
+    NEXUS_ASSERT(tmp_block_meta != 0, "Block ID not found");
+
+    nexus_channel_link_t nv_link;
+    _nexus_channel_link_manager_nv_link(index, &nv_link);
+    nexus_nv_update(*tmp_block_meta, (uint8_t*) &nv_link);
+    nexus_secure_memclr(
+        &nv_link, sizeof(nexus_channel_link_t), sizeof(nexus_channel_link_t));
+    #endif
+}
+
+    #if NEXUS_CHANNEL_LARGE_LINK_TABLE_ENABLED
+// Write each link page containing a link changed since the last flush
+static void _nexus_channel_link_manager_flush_pages(void)
+{
+    nexus_channel_link_t page_links[NX_COMMON_NV_LINK_PAGE_LINK_COUNT];
+    for (uint8_t page = 0; page < NX_COMMON_NV_LINK_PAGE_COUNT; page++)
+    {
+        if (!_this.link_page_dirty[page])
+        {
+            continue;
+        }
+        for (uint8_t i = 0; i < NX_COMMON_NV_LINK_PAGE_LINK_COUNT; i++)
+        {
+            const uint16_t index =
+                (uint16_t)(page * NX_COMMON_NV_LINK_PAGE_LINK_COUNT + i);
+            if (index < NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS)
+            {
+                _nexus_channel_link_manager_nv_link((uint8_t) index,
+                                                    &page_links[i]);
+            }
+            else
+            {
+                // unused space at the end of the last page
+                memset(&page_links[i], 0x00, sizeof(nexus_channel_link_t));
+            }
+        }
+        nexus_nv_update(_nexus_channel_link_manager_page_to_nv_block(page),
+                        (uint8_t*) page_links);
+        _this.link_page_dirty[page] = false;
+    }
+    nexus_secure_memclr(page_links, sizeof(page_links), sizeof(page_links));
+}
+    #endif
+
+    #if NEXUS_CHANNEL_ADAPTIVE_NONCE_RESERVATION_ENABLED
+NEXUS_STATIC_ASSERT(
+    NEXUS_CHANNEL_LINK_SECURITY_NONCE_RESERVATION_MAX_COUNT >=
+        NEXUS_CHANNEL_LINK_SECURITY_NONCE_NV_STORAGE_INTERVAL_COUNT,
+    "Nonce reservations must be at least the nonce NV storage interval");
+
+// Start tracking nonce reservations for a link with nonce `nonce`, which is
+// already persisted to NV (or is a nonce which may be reused after a reset).
+static void _nexus_channel_link_manager_init_nonce_reservation(uint8_t index,
+                                                               uint32_t nonce)
+{
+    _this.nonce_reserved[index] = nonce;
+    _this.nonce_reservation_size[index] =
+        NEXUS_CHANNEL_LINK_SECURITY_NONCE_NV_STORAGE_INTERVAL_COUNT;
+    // neither grow nor shrink the first reservation
+    _this.seconds_since_nonce_reserved[index] =
+        NEXUS_CHANNEL_LINK_SECURITY_NONCE_RESERVATION_SECONDS;
+}
+
+/* Persist a new nonce reservation for the link at `index`.
+ *
+ * The nonce stored in NV for the link is the highest nonce reserved for
+ * it, so that no nonce used before a reset is reused after the reset.
+ * The size of the reservation depends on how quickly the previous
+ * reservation was used up.
+ */
+static void _nexus_channel_link_manager_persist_nonce_reservation(
+    uint8_t index)
+{
+    const uint32_t min_size =
+        NEXUS_CHANNEL_LINK_SECURITY_NONCE_NV_STORAGE_INTERVAL_COUNT;
+    const uint32_t target_seconds =
+        NEXUS_CHANNEL_LINK_SECURITY_NONCE_RESERVATION_SECONDS;
+    const uint32_t seconds = _this.seconds_since_nonce_reserved[index];
+    uint32_t size = _this.nonce_reservation_size[index];
+    if (seconds < target_seconds)
+    {
+        size = u32min(size * 2,
+                      NEXUS_CHANNEL_LINK_SECURITY_NONCE_RESERVATION_MAX_COUNT);
+    }
+    else if (seconds > 4 * target_seconds && size / 2 >= min_size)
+    {
+        size /= 2;
+    }
+    _this.nonce_reservation_size[index] = size;
+    _this.seconds_since_nonce_reserved[index] = 0;
+
+    // Reservations stop short of the largest nonces, so that the nonce
+    // increment on init never overflows.
+    const uint32_t nonce = _this.stored.links[index].security_data.mode0.nonce;
+    const uint32_t max_reserved = UINT32_MAX - min_size;
+    if (nonce >= max_reserved)
+    {
+        _this.nonce_reserved[index] = nonce;
+    }
+    else
+    {
+        _this.nonce_reserved[index] =
+            nonce + u32min(size, max_reserved - nonce);
+    }
+
+    _nexus_channel_link_manager_persist_link(index);
+}
+    #endif
+
+    #if NEXUS_CHANNEL_LINK_SECURITY_REPLAY_WINDOW_ENABLED
+NEXUS_STATIC_ASSERT(NEXUS_CHANNEL_LINK_SECURITY_REPLAY_WINDOW_SIZE % 8 == 0,
+                    "Replay window size must be a multiple of 8");
+NEXUS_STATIC_ASSERT(
+    NEXUS_CHANNEL_LINK_SECURITY_REPLAY_WINDOW_SIZE / 8 <=
+        NEXUS_UTIL_MAX_WINDOW_BITSET_SIZE_BYTES,
+    "Replay window size too large");
+// Nonces near UINT32_MAX force a nonce reset and are never in the window,
+// so that window IDs (and the top of the window) never overflow
+NEXUS_STATIC_ASSERT(
+    2 * NEXUS_CHANNEL_LINK_SECURITY_REPLAY_WINDOW_SIZE <=
+        NEXUS_CHANNEL_LINK_SECURITY_NONCE_NV_STORAGE_INTERVAL_COUNT,
+    "Replay window size must be at most half the nonce NV storage interval");
+
+// Treat every request nonce up to and including `nonce` as received
+static void _nexus_channel_link_manager_replay_window_reset(uint8_t index,
+                                                            uint32_t nonce)
+{
+    _this.replay_window_center[index] =
+        nonce + NEXUS_CHANNEL_LINK_SECURITY_REPLAY_WINDOW_SIZE;
+    memset(_this.replay_window_flags[index],
+           0xFF,
+           sizeof(_this.replay_window_flags[index]));
+}
+    #endif
+
+// Load the link at `index` from `nv_link`, as read from NV
+static void
+_nexus_channel_link_manager_load_link(uint8_t index,
+                                      const nexus_channel_link_t* nv_link)
+{
+    // check that link represents a valid device (skip '0' device IDs)
+    if (nv_link->linked_device_id.device_id == 0)
+    {
+        return;
+    }
+
+    // valid link - copy and increment link index/count
+    memcpy(&_this.stored.links[index], nv_link, sizeof(nexus_channel_link_t));
+    _this.link_count++;
+    _this.link_idx_in_use[index] = true;
+    nexus_check_keyed_state_init(
+        &_link_key_states[index],
+        &_this.stored.links[index].security_data.mode0.sym_key);
+    #if NEXUS_CHANNEL_LARGE_LINK_TABLE_ENABLED
+    _nexus_channel_link_manager_index_insert(index);
+    #endif
+
+    // existing links update nonce by
+    // NEXUS_CHANNEL_LINK_SECURITY_NONCE_NV_STORAGE_INTERVAL_COUNT
+    // on every re-init to protect against replay attacks
+    _this.stored.links[index].security_data.mode0.nonce +=
+        NEXUS_CHANNEL_LINK_SECURITY_NONCE_NV_STORAGE_INTERVAL_COUNT;
+    _this.link_idx_should_persist_nonce[index] = true;
+    #if NEXUS_CHANNEL_ADAPTIVE_NONCE_RESERVATION_ENABLED
+    // The stored nonce is the end of a reservation, which is already
+    // used up after the increment above
+    _nexus_channel_link_manager_init_nonce_reservation(
+        index, _this.stored.links[index].security_data.mode0.nonce);
+    #endif
+    #if NEXUS_CHANNEL_LINK_SECURITY_REPLAY_WINDOW_ENABLED
+    _nexus_channel_link_manager_replay_window_reset(
+        index, _this.stored.links[index].security_data.mode0.nonce);
+    #endif
+}
 
 bool nexus_channel_link_manager_init(void)
 {
     // assumes that all flags in `_this` are 'do nothing' if false/0
     memset(&_this, 0x00, sizeof(_this));
-
+    nexus_secure_memclr(&_link_key_states,
+                        sizeof(_link_key_states),
+                        sizeof(_link_key_states));
+
+    #if NEXUS_CHANNEL_LARGE_LINK_TABLE_ENABLED
+    nexus_channel_link_t page_links[NX_COMMON_NV_LINK_PAGE_LINK_COUNT];
+    // load data for each page of links from nonvolatile
+    for (uint8_t page = 0; page < NX_COMMON_NV_LINK_PAGE_COUNT; page++)
+    {
+        // note: packed struct
+        if (!nexus_nv_read(_nexus_channel_link_manager_page_to_nv_block(page),
+                           (uint8_t*) page_links))
+        {
+            continue;
+        }
+        for (uint8_t i = 0; i < NX_COMMON_NV_LINK_PAGE_LINK_COUNT; i++)
+        {
+            const uint16_t index =
+                (uint16_t)(page * NX_COMMON_NV_LINK_PAGE_LINK_COUNT + i);
+            if (index < NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS)
+            {
+                _nexus_channel_link_manager_load_link((uint8_t) index,
+                                                      &page_links[i]);
+            }
+        }
+    }
+    nexus_secure_memclr(page_links, sizeof(page_links), sizeof(page_links));
+    #else
     // Must initialize tmp_block_meta for CWE-457
     struct nx_common_nv_block_meta* tmp_block_meta = {0};
     nexus_channel_link_t tmp_link;
@@ -117,27 +485,10 @@ bool nexus_channel_link_manager_init(void)
         // note: packed struct
         if (nexus_nv_read(*tmp_block_meta, (uint8_t*) &tmp_link))
         {
-            // check that link represents a valid device (skip '0' device IDs)
-            if (tmp_link.linked_device_id.device_id == 0)
-            {
-                continue;
-            }
-
-            // valid link - copy and increment link index/count
-            memcpy(&_this.stored.links[i],
-                   &tmp_link,
-                   sizeof(nexus_channel_link_t));
-            _this.link_count++;
-            _this.link_idx_in_use[i] = true;
-
-            // existing links update nonce by
-            // NEXUS_CHANNEL_LINK_SECURITY_NONCE_NV_STORAGE_INTERVAL_COUNT
-            // on every re-init to protect against replay attacks
-            _this.stored.links[i].security_data.mode0.nonce +=
-                NEXUS_CHANNEL_LINK_SECURITY_NONCE_NV_STORAGE_INTERVAL_COUNT;
-            _this.link_idx_should_persist_nonce[i] = true;
+            _nexus_channel_link_manager_load_link(i, &tmp_link);
         }
     }
+    #endif
 
     const oc_interface_mask_t if_mask_arr[] = {OC_IF_RW, OC_IF_BASELINE};
     const struct nx_channel_resource_props lm_props = {
@@ -162,6 +513,9 @@ bool nexus_channel_link_manager_init(void)
 uint32_t nexus_channel_link_manager_process(uint32_t seconds_elapsed)
 {
     OC_DBG("res_lm: inside process\n");
+    // Links updated by the same call are stored together
+    nexus_nv_transaction_begin();
+
     // increment activity time for any active links, and delete any timed out
     // links
     struct nexus_channel_link_t* cur_link;
@@ -178,6 +532,13 @@ uint32_t nexus_channel_link_manager_process(uint32_t seconds_elapsed)
         // 'seconds since active' is incremented here, and reset to 0 when
         // the link is detected as 'used' by security manager.
         cur_link->seconds_since_active += seconds_elapsed;
+    #if NEXUS_CHANNEL_ADAPTIVE_NONCE_RESERVATION_ENABLED
+        if (_this.seconds_since_nonce_reserved[i] <=
+            UINT32_MAX - seconds_elapsed)
+        {
+            _this.seconds_since_nonce_reserved[i] += seconds_elapsed;
+        }
+    #endif
 
         if (cur_link->seconds_since_active > NEXUS_CHANNEL_LINK_TIMEOUT_SECONDS)
         {
@@ -193,14 +554,12 @@ uint32_t nexus_channel_link_manager_process(uint32_t seconds_elapsed)
         {
             if (_this.link_idx_should_persist_nonce[i])
             {
-                // Write the update to NV, clearing this link block. On the next
-                // read, if the block is all 0x00, it will be considered a
-                // meaningless link and ignored.
-                struct nx_common_nv_block_meta* tmp_block_meta = 0;
-                (void) _nexus_channel_link_manager_index_to_nv_block(
-                    i, &tmp_block_meta);
-                NEXUS_ASSERT(tmp_block_meta != 0, "Block ID not found");
-                nexus_nv_update(*tmp_block_meta, (uint8_t*) cur_link);
+                // Write the updated nonce to NV
+    #if NEXUS_CHANNEL_ADAPTIVE_NONCE_RESERVATION_ENABLED
+                _nexus_channel_link_manager_persist_nonce_reservation(i);
+    #else
+                _nexus_channel_link_manager_persist_link(i);
+    #endif
 
                 _this.link_idx_should_persist_nonce[i] = false;
             }
@@ -225,14 +584,24 @@ uint32_t nexus_channel_link_manager_process(uint32_t seconds_elapsed)
                 memcpy(new_link,
                        &_this.pending_link_to_create,
                        sizeof(nexus_channel_link_t));
+                nexus_check_keyed_state_init(
+                    &_link_key_states[i],
+                    &new_link->security_data.mode0.sym_key);
+    #if NEXUS_CHANNEL_LARGE_LINK_TABLE_ENABLED
+                _nexus_channel_link_manager_index_insert(i);
+    #endif
+    #if NEXUS_CHANNEL_ADAPTIVE_NONCE_RESERVATION_ENABLED
+                _nexus_channel_link_manager_init_nonce_reservation(
+                    i, new_link->security_data.mode0.nonce);
+    #endif
+    #if NEXUS_CHANNEL_LINK_SECURITY_REPLAY_WINDOW_ENABLED
+                _nexus_channel_link_manager_replay_window_reset(
+                    i, new_link->security_data.mode0.nonce);
+    #endif
                 // Write the update to NV
                 // The new link is at the *current* next link index, before we
                 // increment
-                struct nx_common_nv_block_meta* tmp_block_meta = 0;
-                (void) _nexus_channel_link_manager_index_to_nv_block(
-                    i, &tmp_block_meta);
-                NEXUS_ASSERT(tmp_block_meta != 0, "Block ID not found");
-                nexus_nv_update(*tmp_block_meta, (uint8_t*) new_link);
+                _nexus_channel_link_manager_persist_link(i);
 
                 PRINT("\nres_lm: New link persisted! Total link count %u\n",
                       _this.link_count);
@@ -277,6 +646,11 @@ uint32_t nexus_channel_link_manager_process(uint32_t seconds_elapsed)
               _this.link_count);
     }
 
+    #if NEXUS_CHANNEL_LARGE_LINK_TABLE_ENABLED
+    _nexus_channel_link_manager_flush_pages();
+    #endif
+    (void) nexus_nv_transaction_commit();
+
     // no urgent callbacks required
     return NEXUS_COMMON_IDLE_TIME_BETWEEN_PROCESS_CALL_SECONDS;
 }
@@ -286,6 +660,15 @@ static bool
 _nexus_channel_link_manager_link_index_from_nxid(const struct nx_id* id,
                                                  uint8_t* link_index)
 {
+    #if NEXUS_CHANNEL_LARGE_LINK_TABLE_ENABLED
+    uint16_t slot;
+    if (!_nexus_channel_link_manager_index_find(id, &slot))
+    {
+        return false;
+    }
+    *link_index = (uint8_t)(_this.link_index_slots[slot] - 1);
+    return true;
+    #else
     for (uint8_t i = 0; i < NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS; i++)
     {
         if (!_this.link_idx_in_use[i])
@@ -302,6 +685,7 @@ _nexus_channel_link_manager_link_index_from_nxid(const struct nx_id* id,
         }
     }
     return false;
+    #endif
 }
 
 bool nexus_channel_link_manager_link_from_nxid(
@@ -353,17 +737,19 @@ static void _nexus_channel_link_manager_clear_link_internal(uint8_t link_id)
         // skip already idle links
         return;
     }
+    #if NEXUS_CHANNEL_LARGE_LINK_TABLE_ENABLED
+    _nexus_channel_link_manager_index_remove(link_id);
+    #endif
     memset(&_this.stored.links[link_id], 0x00, sizeof(nexus_channel_link_t));
+    nexus_secure_memclr(&_link_key_states[link_id],
+                        sizeof(struct nexus_check_keyed_state),
+                        sizeof(struct nexus_check_keyed_state));
     _this.link_idx_in_use[link_id] = false;
 
     // Write the update to NV, clearing this link block. On the next
     // read, if the block is all 0x00, it will be considered a
     // meaningless link and ignored.
-    struct nx_common_nv_block_meta* tmp_block_meta = 0;
-    (void) _nexus_channel_link_manager_index_to_nv_block(link_id,
-                                                         &tmp_block_meta);
-    NEXUS_ASSERT(tmp_block_meta != 0, "Block ID not found");
-    nexus_nv_update(*tmp_block_meta, (uint8_t*) &_this.stored.links[link_id]);
+    _nexus_channel_link_manager_persist_link(link_id);
 
     _this.link_count--;
     nxp_channel_notify_event(NXP_CHANNEL_EVENT_LINK_DELETED);
@@ -437,6 +823,9 @@ bool nexus_channel_link_manager_create_link(
         // accessory.
         _nexus_channel_link_manager_clear_link_internal(idx_to_delete);
     }
+    #if NEXUS_CHANNEL_LARGE_LINK_TABLE_ENABLED
+    _nexus_channel_link_manager_flush_pages();
+    #endif
 
     PRINT("res_lm: Identified new link to persist\n");
     _this.pending_add_link = true;
@@ -558,6 +947,19 @@ bool nexus_channel_link_manager_security_data_from_nxid(
     return result;
 }
 
+bool nexus_channel_link_manager_security_handle_from_nxid(
+    const struct nx_id* id, struct nexus_channel_link_security_handle* handle)
+{
+    uint8_t link_index;
+    if (!_nexus_channel_link_manager_link_index_from_nxid(id, &link_index))
+    {
+        return false;
+    }
+    handle->key_state = &_link_key_states[link_index];
+    handle->nonce = _this.stored.links[link_index].security_data.mode0.nonce;
+    return true;
+}
+
 bool nexus_channel_link_manager_set_security_data_auth_nonce(
     const struct nx_id* id, uint32_t new_nonce)
 {
@@ -580,9 +982,26 @@ bool nexus_channel_link_manager_set_security_data_auth_nonce(
     // flag that we should persist the link data (including nonce) to NV.
     const uint32_t old_nonce = found_link->security_data.mode0.nonce;
     if (new_nonce == 0)
+    {
+        _this.link_idx_should_persist_nonce[link_index] = true;
+    #if NEXUS_CHANNEL_ADAPTIVE_NONCE_RESERVATION_ENABLED
+        // nonces are reused after a reset, start a new reservation
+        _nexus_channel_link_manager_init_nonce_reservation(link_index, 0);
+    #endif
+    #if NEXUS_CHANNEL_LINK_SECURITY_REPLAY_WINDOW_ENABLED
+        _nexus_channel_link_manager_replay_window_reset(link_index, 0);
+    #endif
+    }
+    #if NEXUS_CHANNEL_ADAPTIVE_NONCE_RESERVATION_ENABLED
+    // Persist a new reservation once the current reservation is used up.
+    // Nonces used before the new reservation is persisted are covered by
+    // the nonce increment on init.
+    else if (new_nonce > _this.nonce_reserved[link_index])
     {
         _this.link_idx_should_persist_nonce[link_index] = true;
     }
+    (void) old_nonce;
+    #else
     else if ((new_nonce > old_nonce) && (old_nonce > 0))
     {
         for (uint32_t i = old_nonce + 1; i <= new_nonce; i++)
@@ -597,6 +1016,7 @@ bool nexus_channel_link_manager_set_security_data_auth_nonce(
             }
         }
     }
+    #endif
 
     found_link->security_data.mode0.nonce = new_nonce;
     return true;
@@ -618,6 +1038,56 @@ bool nexus_channel_link_manager_reset_link_secs_since_active(
     return true;
 }
 
+    #if NEXUS_CHANNEL_LINK_SECURITY_REPLAY_WINDOW_ENABLED
+bool nexus_channel_link_manager_replay_window_accept_nonce(
+    const struct nx_id* id, uint32_t nonce)
+{
+    uint8_t link_index;
+    // if no link exists, or the nonce is large enough to force a nonce
+    // reset, return early
+    if (!_nexus_channel_link_manager_link_index_from_nxid(id, &link_index) ||
+        nonce > UINT32_MAX -
+                    NEXUS_CHANNEL_LINK_SECURITY_NONCE_NV_STORAGE_INTERVAL_COUNT)
+    {
+        return false;
+    }
+
+    const uint8_t flags_size =
+        (uint8_t)(NEXUS_CHANNEL_LINK_SECURITY_REPLAY_WINDOW_SIZE - 1);
+    const uint32_t window_id =
+        nonce + NEXUS_CHANNEL_LINK_SECURITY_REPLAY_WINDOW_SIZE;
+    uint32_t center = _this.replay_window_center[link_index];
+    if (window_id > center + flags_size)
+    {
+        // Too far above the window to move it there. Every nonce in a
+        // window centered on `nonce` is above the current window, so none
+        // were received.
+        center = window_id;
+        memset(_this.replay_window_flags[link_index],
+               0x00,
+               sizeof(_this.replay_window_flags[link_index]));
+    }
+
+    struct nexus_window window;
+    nexus_util_window_init(&window,
+                           _this.replay_window_flags[link_index],
+                           sizeof(_this.replay_window_flags[link_index]),
+                           center,
+                           flags_size,
+                           flags_size);
+
+    // nonces below the window are treated as received
+    if (!nexus_util_window_id_within_window(&window, window_id) ||
+        nexus_util_window_id_flag_already_set(&window, window_id))
+    {
+        return false;
+    }
+    (void) nexus_util_window_set_id_flag(&window, window_id);
+    _this.replay_window_center[link_index] = window.center_index;
+    return true;
+}
+    #endif
+
 uint8_t nx_channel_link_count(void)
 {
     // starts at '0'
@@ -662,11 +1132,12 @@ bool nexus_channel_link_manager_next_linked_accessory(
 
     // start checking at the next link index after previous_id, checking
     // all link slots *except* `prev_link_idx`
-    for (uint8_t i = prev_id_link_idx + 1;
+    for (uint16_t i = (uint16_t)(prev_id_link_idx + 1);
          i < (prev_id_link_idx + NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS);
          i++)
     {
-        const uint8_t link_idx = i % NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS;
+        const uint8_t link_idx =
+            (uint8_t)(i % NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS);
         if (!_this.link_idx_in_use[link_idx] ||
             (_this.stored.links[link_idx].operating_mode ==
              CHANNEL_LINK_OPERATING_MODE_ACCESSORY))
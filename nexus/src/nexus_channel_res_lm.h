@@ -16,6 +16,7 @@
 // between link manager and handshake manager.
 #include "src/internal_channel_config.h"
 #include "src/nexus_nv.h"
+#include "src/nexus_util.h"
 
 #if NEXUS_CHANNEL_LINK_SECURITY_ENABLED
 
@@ -39,7 +40,31 @@ extern const char* L_TIMEOUT_CONFIGURED_SHORT_PROP_NAME;
 
     // How many secured messages must be exchanged before the nonce is persisted
     // to nonvolatile storage
-    #define NEXUS_CHANNEL_LINK_SECURITY_NONCE_NV_STORAGE_INTERVAL_COUNT 64
+    #ifndef NEXUS_CHANNEL_LINK_SECURITY_NONCE_NV_STORAGE_INTERVAL_COUNT
+        #define NEXUS_CHANNEL_LINK_SECURITY_NONCE_NV_STORAGE_INTERVAL_COUNT 64
+    #endif
+
+    #if NEXUS_CHANNEL_ADAPTIVE_NONCE_RESERVATION_ENABLED
+        // Most nonces which may be reserved for a link by a single NV write
+        #ifndef NEXUS_CHANNEL_LINK_SECURITY_NONCE_RESERVATION_MAX_COUNT
+            #define NEXUS_CHANNEL_LINK_SECURITY_NONCE_RESERVATION_MAX_COUNT 4096
+        #endif
+        // A link whose nonce reservation is used up in less than this many
+        // seconds gets a larger next reservation. A link whose reservation
+        // lasts more than 4 times this long gets a smaller next reservation.
+        #ifndef NEXUS_CHANNEL_LINK_SECURITY_NONCE_RESERVATION_SECONDS
+            #define NEXUS_CHANNEL_LINK_SECURITY_NONCE_RESERVATION_SECONDS 3600
+        #endif
+    #endif
+
+    #if NEXUS_CHANNEL_LINK_SECURITY_REPLAY_WINDOW_ENABLED
+        // Number of request nonces, up to the highest nonce received in a
+        // request, which are tracked to accept out-of-order requests.
+        // Must be a multiple of 8.
+        #ifndef NEXUS_CHANNEL_LINK_SECURITY_REPLAY_WINDOW_SIZE
+            #define NEXUS_CHANNEL_LINK_SECURITY_REPLAY_WINDOW_SIZE 32
+        #endif
+    #endif
 
 /* Security data for link mode 0.
  *
@@ -90,6 +115,19 @@ NEXUS_STATIC_ASSERT(
         NX_COMMON_NV_BLOCK_4_LENGTH - NEXUS_NV_BLOCK_WRAPPER_SIZE_BYTES,
     "Unexpected size for `nexus_channel_link_t`, NV storage may fail");
 
+/* Handle to the security state of a mode 0 Nexus Channel link.
+ *
+ * `key_state` is computed from the link key when the link is loaded or
+ * created, and is owned by the link manager. It is cleared when the link
+ * is deleted (by `nexus_channel_link_manager_process`), so a handle must
+ * not be kept after the function which obtained it returns.
+ */
+struct nexus_channel_link_security_handle
+{
+    const struct nexus_check_keyed_state* key_state;
+    uint32_t nonce;
+};
+
 /* Initialize the Nexus Channel Link module.
  *
  * Called on startup by `nexus_channel_core_init()`.
@@ -245,6 +283,22 @@ bool nexus_channel_link_manager_security_data_from_nxid(
     const struct nx_id* id,
     struct nexus_channel_link_security_mode0_data* security_data);
 
+/* Get a handle to the security state of a given Channel Link.
+ *
+ * Preferred over `nexus_channel_link_manager_security_data_from_nxid`
+ * to compute or verify a MAC, as the link key is not copied and key setup
+ * is not repeated for each message.
+ *
+ * If there is no link found to the specified Nexus ID, this function will
+ * return false and `handle` will be unmodified.
+ *
+ * \param id Nexus ID of linked device to find
+ * \param handle Will be populated with the link security handle
+ * \return true if link exists and `handle` is populated, false otherwise
+ */
+bool nexus_channel_link_manager_security_handle_from_nxid(
+    const struct nx_id* id, struct nexus_channel_link_security_handle* handle);
+
 /* Set authentication nonce for a given Channel Link.
  *
  * Called when a link is used (typically when sending a request over the
@@ -272,6 +326,24 @@ bool nexus_channel_link_manager_set_security_data_auth_nonce(
 bool nexus_channel_link_manager_reset_link_secs_since_active(
     const struct nx_id* id);
 
+    #if NEXUS_CHANNEL_LINK_SECURITY_REPLAY_WINDOW_ENABLED
+/** Record the nonce of a secured request received on a Nexus Channel link.
+ *
+ * Each link tracks which of the most recent
+ * `NEXUS_CHANNEL_LINK_SECURITY_REPLAY_WINDOW_SIZE` request nonces (up to
+ * the highest nonce received in a request) were received. Nonces below
+ * this window are treated as received. Does not modify the link nonce.
+ *
+ * Not expected to be used outside of security manager.
+ *
+ * \param id Nexus ID of link the request was received on
+ * \param nonce nonce of the received request
+ * \return true if `nonce` was not received before, false otherwise
+ */
+bool nexus_channel_link_manager_replay_window_accept_nonce(
+    const struct nx_id* id, uint32_t nonce);
+    #endif
+
 /** Look up link details based on Nexus ID
  *
  * Can be used to verify whether a link exists or not by examining the
@@ -284,7 +356,8 @@ bool nexus_channel_link_manager_reset_link_secs_since_active(
 bool nexus_channel_link_manager_link_from_nxid(
     const struct nx_id* id, nexus_channel_link_t* retrieved_link);
 
-    #ifdef NEXUS_INTERNAL_IMPL_NON_STATIC
+    #if defined(NEXUS_INTERNAL_IMPL_NON_STATIC) &&                             \
+        !NEXUS_CHANNEL_LARGE_LINK_TABLE_ENABLED
 bool _nexus_channel_link_manager_index_to_nv_block(
     uint8_t index, struct nx_common_nv_block_meta** dest_block_meta_ptr);
     #endif // NEXUS_INTERNAL_IMPL_NON_STATIC
@@ -180,16 +180,16 @@ nexus_channel_authenticate_message(const oc_endpoint_t* const endpoint,
         }
 
         // get link security data
-        struct nexus_channel_link_security_mode0_data link_security_data;
-        if (!nexus_channel_link_manager_security_data_from_nxid(
+        struct nexus_channel_link_security_handle link_security_data;
+        if (!nexus_channel_link_manager_security_handle_from_nxid(
                 &nexus_id, &link_security_data))
         {
             return NEXUS_CHANNEL_SM_AUTH_MESSAGE_ERROR_SENDER_DEVICE_NOT_LINKED;
         }
 
         const nexus_cose_mac0_verify_ctx_t verify_ctx = {
-            // link key,
-            &link_security_data.sym_key,
+            // link key (unused, `link_security_data.key_state` is used)
+            NULL,
             // aad
             {
                 pkt->code, // request method
@@ -205,10 +205,11 @@ nexus_channel_authenticate_message(const oc_endpoint_t* const endpoint,
         // *not* check whether the nonce is too low or not.
         size_t unsecured_payload_len = 0;
         nexus_cose_error verify_result =
-            nexus_cose_mac0_verify_message(&verify_ctx,
-                                           &received_nonce,
-                                           &pkt->payload,
-                                           &unsecured_payload_len);
+            nexus_cose_mac0_verify_message_keyed(&verify_ctx,
+                                                 link_security_data.key_state,
+                                                 &received_nonce,
+                                                 &pkt->payload,
+                                                 &unsecured_payload_len);
         pkt->payload_len = (uint32_t) unsecured_payload_len;
 
         if (verify_result == NEXUS_COSE_ERROR_MAC_TAG_INVALID)
@@ -239,8 +240,16 @@ nexus_channel_authenticate_message(const oc_endpoint_t* const endpoint,
             // requests must have a nonce > the current nonce
             if (received_nonce < (link_security_data.nonce + 1))
             {
-                sm_auth_result =
-                    NEXUS_CHANNEL_SM_AUTH_MESSAGE_ERROR_REQUEST_RECEIVED_WITH_INVALID_NONCE;
+    #if NEXUS_CHANNEL_LINK_SECURITY_REPLAY_WINDOW_ENABLED
+                // ...unless they arrived out of order, and this nonce is
+                // within the replay window and not yet received
+                if (!nexus_channel_link_manager_replay_window_accept_nonce(
+                        &nexus_id, received_nonce))
+    #endif
+                {
+                    sm_auth_result =
+                        NEXUS_CHANNEL_SM_AUTH_MESSAGE_ERROR_REQUEST_RECEIVED_WITH_INVALID_NONCE;
+                }
             }
             else if (
                 received_nonce >
@@ -257,6 +266,15 @@ nexus_channel_authenticate_message(const oc_endpoint_t* const endpoint,
                 sm_auth_result =
                     NEXUS_CHANNEL_SM_AUTH_MESSAGE_ERROR_NONCE_APPROACHING_MAX_FORCED_RESET_REQUIRED;
             }
+    #if NEXUS_CHANNEL_LINK_SECURITY_REPLAY_WINDOW_ENABLED
+            else
+            {
+                // record the nonce, so that a replay of this request is
+                // rejected after later nonces are received
+                (void) nexus_channel_link_manager_replay_window_accept_nonce(
+                    &nexus_id, received_nonce);
+            }
+    #endif
         }
         // response messages (pkt->code >= CREATED_2_01)
         else
@@ -265,7 +283,16 @@ nexus_channel_authenticate_message(const oc_endpoint_t* const endpoint,
                          "Unexpectedly handling non-response message");
             // Any response message must have a nonce at least equal to the
             // current nonce on this device
-            if (received_nonce < link_security_data.nonce)
+            uint32_t min_response_nonce = link_security_data.nonce;
+    #if NEXUS_CHANNEL_LINK_SECURITY_REPLAY_WINDOW_ENABLED
+            // Each request in flight has its own nonce, so responses may
+            // arrive signed with a nonce below the current one. Replayed
+            // responses are dropped, as their token matches no transaction.
+            min_response_nonce -=
+                u32min(min_response_nonce,
+                       NEXUS_CHANNEL_LINK_SECURITY_REPLAY_WINDOW_SIZE);
+    #endif
+            if (received_nonce < min_response_nonce)
             {
                 sm_auth_result =
                     NEXUS_CHANNEL_SM_AUTH_MESSAGE_ERROR_REQUEST_RECEIVED_WITH_INVALID_NONCE;
@@ -282,6 +309,13 @@ nexus_channel_authenticate_message(const oc_endpoint_t* const endpoint,
                     // special case - reset local nonce to 0
                     nonce_to_sync = 0;
                 }
+    #if NEXUS_CHANNEL_LINK_SECURITY_REPLAY_WINDOW_ENABLED
+                else if (nonce_to_sync < link_security_data.nonce)
+                {
+                    // never move the local nonce backwards
+                    nonce_to_sync = link_security_data.nonce;
+                }
+    #endif
                 // update the local notion of the nonce
                 nexus_channel_link_manager_set_security_data_auth_nonce(
                     &nexus_id, nonce_to_sync);
@@ -290,11 +324,15 @@ nexus_channel_authenticate_message(const oc_endpoint_t* const endpoint,
             }
         }
 
-        // clear sensitive security info
-        nexus_secure_memclr(
-            &link_security_data,
-            sizeof(struct nexus_channel_link_security_mode0_data),
-            sizeof(struct nexus_channel_link_security_mode0_data));
+    #if NEXUS_CHANNEL_LINK_SECURITY_REPLAY_WINDOW_ENABLED
+        // out-of-order messages must not move the local nonce backwards
+        const uint32_t updated_nonce =
+            received_nonce > link_security_data.nonce ?
+                received_nonce :
+                link_security_data.nonce;
+    #else
+        const uint32_t updated_nonce = received_nonce;
+    #endif
 
         if (sm_auth_result != NEXUS_CHANNEL_SM_AUTH_MESSAGE_ERROR_NONE)
         {
@@ -305,7 +343,7 @@ nexus_channel_authenticate_message(const oc_endpoint_t* const endpoint,
         // nonce value and indicate that the link is active
         // if authenticated, update nonce value and indicate link is active
         nexus_channel_link_manager_set_security_data_auth_nonce(&nexus_id,
-                                                                received_nonce);
+                                                                updated_nonce);
         nexus_channel_link_manager_reset_link_secs_since_active(&nexus_id);
         // Overwrite the secured payload with the unsecured payload, which
         // we know must be equal or shorter in length from checks earlier
@@ -16,6 +16,7 @@
 #include "include/nxp_keycode.h"
 #include "src/nexus_channel_core.h"
 #include "src/nexus_keycode_core.h"
+#include "src/nexus_nv.h"
 #include "src/nexus_util.h"
 
 /** Internal struct of data persisted to NV.
@@ -37,6 +38,10 @@ void nx_common_init(uint32_t initial_uptime_s)
     _this.init_completed = false;
     _this.pending_init = true;
 
+#if NEXUS_NV_CACHE_ENABLED || NEXUS_NV_TRANSACTIONS_ENABLED
+    nexus_nv_init();
+#endif
+
 #if NEXUS_KEYCODE_ENABLED
     nexus_keycode_core_init();
 #endif
@@ -76,6 +81,11 @@ uint32_t nx_common_process(uint32_t uptime_seconds)
     min_sleep = u32min(min_sleep, nexus_channel_core_process(seconds_elapsed));
 #endif
 
+#if NEXUS_NV_CACHE_ENABLED
+    // after other modules, so that their updates are included
+    min_sleep = u32min(min_sleep, nexus_nv_cache_process());
+#endif
+
     // System is initialized after first 'process' run
     // `pending_init` enforces call order (must call `init` then `process`)
     if (_this.pending_init)
@@ -102,4 +112,8 @@ void nx_common_shutdown(void)
 #if NEXUS_CHANNEL_CORE_ENABLED
     nexus_channel_core_shutdown();
 #endif
+
+#if NEXUS_NV_CACHE_ENABLED
+    (void) nexus_nv_cache_flush();
+#endif
 }
@@ -10,6 +10,7 @@
 
 #include "src/nexus_cose_mac0_common.h"
 #include "oc/deps/tinycbor/src/cbor.h"
+#include "src/nexus_security.h"
 #include "src/nexus_util.h"
 
 #if NEXUS_CHANNEL_LINK_SECURITY_ENABLED
@@ -70,11 +71,16 @@ nexus_cose_mac0_encode_protected_header_map(uint32_t nonce,
     return (uint8_t) header_size;
 }
 
-nexus_cose_error nexus_cose_mac0_common_mac_params_to_mac_structure(
+// Encode every byte of the `MAC_structure` which precedes the payload
+// contents into `prefix_buf`: the array header, context string, protected
+// header, AAD, and the header of the payload bytestring.
+static nexus_cose_error _nexus_cose_mac0_common_encode_mac_structure_prefix(
     const nexus_cose_mac0_common_macparams_t* const mac_params,
-    struct nexus_cose_mac0_cbor_data_t* mac_struct)
+    uint8_t* prefix_buf,
+    size_t prefix_buf_size,
+    size_t* prefix_len)
 {
-    CborEncoder enc, inner_enc;
+    CborEncoder enc, inner_enc, payload_header_enc;
 
     // used internally to build components of the MAC struct array. Also
     // used to temporarily store the protected header for a different
@@ -95,7 +101,7 @@ nexus_cose_error nexus_cose_mac0_common_mac_params_to_mac_structure(
     }
 
     // Initialize CBOR encoder to encode a `MAC_structure` (Section 6.3)
-    cbor_encoder_init(&enc, mac_struct->buf, sizeof(mac_struct->buf), 0);
+    cbor_encoder_init(&enc, prefix_buf, prefix_buf_size, 0);
 
     // 4 item array (identity string 'MAC0', protected attributes, AAD, payload)
     if (cbor_encoder_create_array(
@@ -149,28 +155,107 @@ nexus_cose_error nexus_cose_mac0_common_mac_params_to_mac_structure(
         return NEXUS_COSE_ERROR_CBOR_ENCODER;
     }
 
-    // 6.3.4 payload
-    // XXX we might optimize here by not copying payload at this stage,
-    // computing the partial MAC without the payload, then computing the
-    // MAC over the payload without copying, and inserting it into the tag
-    // at the last step. We could do this by passing payload to the tag
-    // generation step, and reduce the size of
-    // `nexus_cose_mac0_cbor_data_t->buf`
-    if (cbor_encode_byte_string(&inner_enc,
-                                mac_params->payload,
-                                mac_params->payload_len) != CborNoError)
+    // 6.3.4 payload. Only the bytestring header is encoded here; the
+    // payload contents are appended (or hashed) directly by the caller.
+    // tinycbor cannot encode a bytestring header without its contents, but
+    // the header is identical to an unsigned integer header with the major
+    // type changed.
+    size_t encoded_len = cbor_encoder_get_buffer_size(&inner_enc, prefix_buf);
+    cbor_encoder_init(&payload_header_enc,
+                      &prefix_buf[encoded_len],
+                      prefix_buf_size - encoded_len,
+                      0);
+    if (cbor_encode_uint(&payload_header_enc, mac_params->payload_len) !=
+        CborNoError)
     {
         return NEXUS_COSE_ERROR_CBOR_ENCODER;
     }
+    prefix_buf[encoded_len] |= CborByteStringType;
+    encoded_len += cbor_encoder_get_buffer_size(&payload_header_enc,
+                                                &prefix_buf[encoded_len]);
 
-    // close array (checks that 4 elements are present, and that there
-    // is sufficient memory to close it).
-    if (cbor_encoder_close_container(&enc, &inner_enc) != CborNoError)
+    *prefix_len = encoded_len;
+    return NEXUS_COSE_ERROR_NONE;
+}
+
+nexus_cose_error nexus_cose_mac0_common_mac_params_to_mac_structure(
+    const nexus_cose_mac0_common_macparams_t* const mac_params,
+    struct nexus_cose_mac0_cbor_data_t* mac_struct)
+{
+    size_t prefix_len;
+    const nexus_cose_error result =
+        _nexus_cose_mac0_common_encode_mac_structure_prefix(
+            mac_params, mac_struct->buf, sizeof(mac_struct->buf), &prefix_len);
+    if (result != NEXUS_COSE_ERROR_NONE)
+    {
+        return result;
+    }
+
+    if (mac_params->payload_len > sizeof(mac_struct->buf) - prefix_len)
     {
         return NEXUS_COSE_ERROR_CBOR_ENCODER;
     }
-    mac_struct->len =
-        (uint8_t) cbor_encoder_get_buffer_size(&enc, mac_struct->buf);
+    // Skip 0-length payloads
+    if (mac_params->payload_len > 0)
+    {
+        memcpy(&mac_struct->buf[prefix_len],
+               mac_params->payload,
+               mac_params->payload_len);
+    }
+    mac_struct->len = (uint8_t) (prefix_len + mac_params->payload_len);
+
+    return NEXUS_COSE_ERROR_NONE;
+}
+
+nexus_cose_error nexus_cose_mac0_common_mac_params_compute_tag(
+    const nexus_cose_mac0_common_macparams_t* const mac_params,
+    struct nexus_check_value* tag)
+{
+    struct nexus_check_keyed_state key_state;
+    nexus_check_keyed_state_init(&key_state, mac_params->key);
+    const nexus_cose_error result =
+        nexus_cose_mac0_common_mac_params_compute_tag_keyed(
+            mac_params, &key_state, tag);
+    nexus_secure_memclr(&key_state,
+                        sizeof(struct nexus_check_keyed_state),
+                        sizeof(struct nexus_check_keyed_state));
+    return result;
+}
+
+nexus_cose_error nexus_cose_mac0_common_mac_params_compute_tag_keyed(
+    const nexus_cose_mac0_common_macparams_t* const mac_params,
+    const struct nexus_check_keyed_state* const key_state,
+    struct nexus_check_value* tag)
+{
+    uint8_t prefix_buf[NEXUS_COSE_MAC0_MAX_MAC_STRUCTURE_PREFIX_SIZE];
+    size_t prefix_len;
+
+    if (mac_params->payload_len > NEXUS_COSE_MAC0_MAX_ENCODED_CBOR_OBJECT_SIZE)
+    {
+        OC_WRN("Payload too long, cannot compute MAC");
+        return NEXUS_COSE_ERROR_INPUT_DATA_INVALID;
+    }
+
+    const nexus_cose_error result =
+        _nexus_cose_mac0_common_encode_mac_structure_prefix(
+            mac_params, prefix_buf, sizeof(prefix_buf), &prefix_len);
+    if (result != NEXUS_COSE_ERROR_NONE)
+    {
+        return result;
+    }
+
+    struct nexus_check_ctx check_ctx;
+    nexus_check_init(&check_ctx, key_state);
+
+    // MAC the framing bytes, then the payload in place
+    nexus_check_update(&check_ctx, prefix_buf, (uint16_t) prefix_len);
+    if (mac_params->payload_len > 0)
+    {
+        nexus_check_update(&check_ctx,
+                           mac_params->payload,
+                           (uint16_t) mac_params->payload_len);
+    }
+    *tag = nexus_check_final(&check_ctx);
 
     return NEXUS_COSE_ERROR_NONE;
 }
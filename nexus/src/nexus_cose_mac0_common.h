@@ -47,6 +47,16 @@ extern "C" {
 //   protected header as a bytestring and
 #define NEXUS_COSE_MAC0_MAX_PROTECTED_HEADER_BSTR_SIZE 7
 
+// Bytes of a `MAC_structure` preceding the payload contents
+// 1 byte for the 4 element array header
+// 5 bytes for the "MAC0" context text string
+// 1 byte bytestring header + protected header
+// AAD bytestring (AAD size above already includes its header)
+// 5 bytes max for the payload bytestring header
+#define NEXUS_COSE_MAC0_MAX_MAC_STRUCTURE_PREFIX_SIZE                          \
+    (1 + 5 + 1 + NEXUS_COSE_MAC0_MAX_PROTECTED_HEADER_BSTR_SIZE +              \
+     NEXUS_COSE_MAC0_MAX_AAD_SIZE + 5)
+
 /* Return codes specific to nexus_cose_mac0 functionality.
  *
  * Used for clearly diagnosing the cause of failure in encoding or decoding
@@ -153,6 +163,38 @@ nexus_cose_error nexus_cose_mac0_common_mac_params_to_mac_structure(
     const nexus_cose_mac0_common_macparams_t* const mac_params,
     struct nexus_cose_mac0_cbor_data_t* mac_struct);
 
+/* Compute the MAC0 MAC/tag for `mac_params` without a `MAC_structure`.
+ *
+ * Result is identical to calling
+ * `nexus_cose_mac0_common_mac_params_to_mac_structure` followed by
+ * `nexus_cose_mac0_common_compute_tag` with `mac_params->key`, but the
+ * CBOR framing bytes and the payload are fed directly into the MAC
+ * computation, so the payload is never copied.
+ *
+ * \param mac_params key, context, and payload to compute tag/MAC over
+ * \param tag populated with the computed tag if successful
+ * \return error if unable to compute a tag for `mac_params`
+ */
+nexus_cose_error nexus_cose_mac0_common_mac_params_compute_tag(
+    const nexus_cose_mac0_common_macparams_t* const mac_params,
+    struct nexus_check_value* tag);
+
+/* Compute the MAC0 MAC/tag for `mac_params` using a precomputed key state.
+ *
+ * Identical to `nexus_cose_mac0_common_mac_params_compute_tag`, but uses
+ * `key_state` instead of `mac_params->key` (which is ignored, and may be
+ * NULL), skipping key setup.
+ *
+ * \param mac_params context and payload to compute tag/MAC over
+ * \param key_state keyed state (see `nexus_check_keyed_state_init`)
+ * \param tag populated with the computed tag if successful
+ * \return error if unable to compute a tag for `mac_params`
+ */
+nexus_cose_error nexus_cose_mac0_common_mac_params_compute_tag_keyed(
+    const nexus_cose_mac0_common_macparams_t* const mac_params,
+    const struct nexus_check_keyed_state* const key_state,
+    struct nexus_check_value* tag);
+
 /* Given a nonce, generate a CBOR map representing the protected header.
  *
  * Does not use `nexus_cose_mac0_cbor_data_t` to save RAM (don't need
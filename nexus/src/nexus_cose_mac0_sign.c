@@ -10,6 +10,7 @@
 
 #include "src/nexus_cose_mac0_sign.h"
 #include "oc/deps/tinycbor/src/cbor.h"
+#include "src/nexus_security.h"
 
 #if NEXUS_CHANNEL_LINK_SECURITY_ENABLED
 
@@ -112,36 +113,40 @@ nexus_cose_error nexus_cose_mac0_sign_encode_message(
     size_t output_size,
     size_t* encoded_bytes_count)
 {
-    // temporary structures to hold message in processing
-    // mac_struct buffer should be equal to the exact size we define this
-    // structure as in `nexus_cose_mac0_common.h`
-    struct nexus_cose_mac0_cbor_data_t mac_struct;
-    NEXUS_STATIC_ASSERT(
-        sizeof(((struct nexus_cose_mac0_cbor_data_t*) 0)->buf) ==
-            4 + NEXUS_COSE_MAC0_MAX_PROTECTED_HEADER_BSTR_SIZE +
-                NEXUS_COSE_MAC0_MAX_AAD_SIZE +
-                NEXUS_COSE_MAC0_MAX_ENCODED_CBOR_OBJECT_SIZE,
-        "`mac_struct` not expected size for secured messages");
+    struct nexus_check_keyed_state key_state;
+    nexus_check_keyed_state_init(&key_state, mac_params->key);
+    const nexus_cose_error result = nexus_cose_mac0_sign_encode_message_keyed(
+        mac_params, &key_state, output, output_size, encoded_bytes_count);
+    nexus_secure_memclr(&key_state,
+                        sizeof(struct nexus_check_keyed_state),
+                        sizeof(struct nexus_check_keyed_state));
+    return result;
+}
 
+nexus_cose_error nexus_cose_mac0_sign_encode_message_keyed(
+    const nexus_cose_mac0_common_macparams_t* const mac_params,
+    const struct nexus_check_keyed_state* const key_state,
+    uint8_t* output,
+    size_t output_size,
+    size_t* encoded_bytes_count)
+{
     // output will simply be an unsecured payload
     if (output_size < NEXUS_COSE_MAC0_MAX_ENCODED_CBOR_OBJECT_SIZE)
     {
         return NEXUS_COSE_ERROR_BUFFER_TOO_SMALL;
     }
 
+    // Compute the tag directly over the payload (no `MAC_structure` copy)
+    struct nexus_check_value tag;
     nexus_cose_error result =
-        nexus_cose_mac0_common_mac_params_to_mac_structure(mac_params,
-                                                           &mac_struct);
+        nexus_cose_mac0_common_mac_params_compute_tag_keyed(
+            mac_params, key_state, &tag);
 
     if (result != NEXUS_COSE_ERROR_NONE)
     {
         return result;
     }
 
-    // Compute the tag (cannot fail)
-    const struct nexus_check_value tag =
-        nexus_cose_mac0_common_compute_tag(&mac_struct, mac_params->key);
-
     // Create the encoded COSE MAC0 output message and populate its size
     result = _nexus_cose_mac0_sign_input_and_tag_to_nexus_cose_mac0_message_t(
         mac_params, &tag, output, output_size, encoded_bytes_count);
@@ -59,6 +59,25 @@ nexus_cose_error nexus_cose_mac0_sign_encode_message(
     size_t output_size,
     size_t* encoded_bytes_count);
 
+/** Create a secured COSE MAC0 message using a precomputed key state.
+ *
+ * Identical to `nexus_cose_mac0_sign_encode_message`, but uses `key_state`
+ * instead of `mac_params->key` (which is ignored, and may be NULL).
+ *
+ * \param mac_params parameters used to create a secured payload
+ * \param key_state keyed state (see `nexus_check_keyed_state_init`)
+ * \param output buffer to write secured output payload
+ * \param output_size max number of bytes to write to `output`.
+ * \param encoded_bytes_count actual number of bytes written to `output`
+ * \return error if failed, otherwise no error
+ */
+nexus_cose_error nexus_cose_mac0_sign_encode_message_keyed(
+    const nexus_cose_mac0_common_macparams_t* const mac_params,
+    const struct nexus_check_keyed_state* const key_state,
+    uint8_t* output,
+    size_t output_size,
+    size_t* encoded_bytes_count);
+
 // Functions only exposed externally during unit testing
 #ifdef NEXUS_INTERNAL_IMPL_NON_STATIC
 
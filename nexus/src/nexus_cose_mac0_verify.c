@@ -10,6 +10,7 @@
 
 #include "src/nexus_cose_mac0_verify.h"
 #include "oc/deps/tinycbor/src/cbor.h"
+#include "src/nexus_security.h"
 
 #if NEXUS_CHANNEL_LINK_SECURITY_ENABLED
 
@@ -226,6 +227,30 @@ nexus_cose_error nexus_cose_mac0_verify_message(
     uint32_t* extracted_nonce,
     uint8_t** unsecured_payload,
     size_t* unsecured_payload_len)
+{
+    OC_LOG("Verifying with key: ");
+    OC_LOGbytes(verify_ctx->key->bytes, sizeof(struct nx_common_check_key));
+
+    struct nexus_check_keyed_state key_state;
+    nexus_check_keyed_state_init(&key_state, verify_ctx->key);
+    const nexus_cose_error result =
+        nexus_cose_mac0_verify_message_keyed(verify_ctx,
+                                             &key_state,
+                                             extracted_nonce,
+                                             unsecured_payload,
+                                             unsecured_payload_len);
+    nexus_secure_memclr(&key_state,
+                        sizeof(struct nexus_check_keyed_state),
+                        sizeof(struct nexus_check_keyed_state));
+    return result;
+}
+
+nexus_cose_error nexus_cose_mac0_verify_message_keyed(
+    const nexus_cose_mac0_verify_ctx_t* const verify_ctx,
+    const struct nexus_check_keyed_state* const key_state,
+    uint32_t* extracted_nonce,
+    uint8_t** unsecured_payload,
+    size_t* unsecured_payload_len)
 {
     // extract protected header map, payload, and tag
     nexus_cose_mac0_extracted_cose_params_t extracted_params;
@@ -244,14 +269,13 @@ nexus_cose_error nexus_cose_mac0_verify_message(
     memcpy((void*) &repacked_aad,
            &verify_ctx->aad,
            sizeof(nexus_cose_mac0_common_external_aad_t));
-    OC_LOG("Verifying AAD. URI len %d. Nonce %d. Payload len %d). Key: ",
+    OC_LOG("Verifying AAD. URI len %d. Nonce %d. Payload len %d)",
            repacked_aad.coap_uri_len,
            extracted_params.nonce,
            extracted_params.payload_len);
-    OC_LOGbytes(verify_ctx->key->bytes, sizeof(struct nx_common_check_key));
 
-    // used so we can reuse the same mac_params->mac_struct for both
-    // verify and sign functionality
+    // used so we can reuse the same tag computation for both verify and
+    // sign functionality
     nexus_cose_mac0_common_macparams_t repacked_mac_params = {
         verify_ctx->key,
         extracted_params.nonce,
@@ -260,20 +284,16 @@ nexus_cose_error nexus_cose_mac0_verify_message(
         extracted_params.payload_len,
     };
 
-    // convert repacked payload/context into MAC struct
-    struct nexus_cose_mac0_cbor_data_t repacked_mac_struct;
-    result = nexus_cose_mac0_common_mac_params_to_mac_structure(
-        &repacked_mac_params, &repacked_mac_struct);
+    // compute tag directly over the received payload
+    struct nexus_check_value computed_tag;
+    result = nexus_cose_mac0_common_mac_params_compute_tag_keyed(
+        &repacked_mac_params, key_state, &computed_tag);
     if (result != NEXUS_COSE_ERROR_NONE)
     {
-        OC_WRN("Error packing MAC parameters to MAC structure");
+        OC_WRN("Error computing tag from MAC parameters");
         return result;
     }
 
-    // compute tag
-    struct nexus_check_value computed_tag = nexus_cose_mac0_common_compute_tag(
-        &repacked_mac_struct, repacked_mac_params.key);
-
     if (memcmp((const void*) &computed_tag,
                (const void*) &extracted_params.tag,
                sizeof(struct nexus_check_value)) != 0)
@@ -85,6 +85,25 @@ nexus_cose_error nexus_cose_mac0_verify_message(
     uint8_t** unsecured_payload,
     size_t* unsecured_payload_len);
 
+/* Verify a secured payload using a precomputed key state.
+ *
+ * Identical to `nexus_cose_mac0_verify_message`, but uses `key_state`
+ * instead of `verify_ctx->key` (which is ignored, and may be NULL).
+ *
+ * \param verify_ctx input payload and context to examine
+ * \param key_state keyed state (see `nexus_check_keyed_state_init`)
+ * \param extracted_nonce nonce from received message
+ * \param unsecured_payload pointer which will be updated to point to encapsulated unsecured payload
+ * \param unsecured_payload_len length of payload beginning at `unsecured_payload`
+ * \return error if unable to verify message, no error otherwise
+ */
+nexus_cose_error nexus_cose_mac0_verify_message_keyed(
+    const nexus_cose_mac0_verify_ctx_t* const verify_ctx,
+    const struct nexus_check_keyed_state* const key_state,
+    uint32_t* extracted_nonce,
+    uint8_t** unsecured_payload,
+    size_t* unsecured_payload_len);
+
 #ifdef NEXUS_INTERNAL_IMPL_NON_STATIC
 nexus_cose_error _nexus_cose_mac0_verify_deserialize_protected_header(
     uint32_t* nonce,
@@ -18,13 +18,6 @@
     #include "src/nexus_keycode_core.h"
     #include "src/nexus_util.h"
 
-    //
-    // NON-ADJUSTABLE PROTOCOL CONSTANTS
-    //
-
-    // Internal identifier used in mapping message ID flags
-    #define NEXUS_KEYCODE_PRO_MAX_MESSAGE_ID_BYTE 3
-
 //
 // Common to both protocol variants
 //
@@ -80,6 +73,12 @@ const uint8_t NEXUS_KEYCODE_PRO_FULL_DEVICE_ID_MAX_CHARACTER_COUNT = 10;
     // activation messages are fixed at 14 digits in 'full' protocol
     #define NEXUS_KEYCODE_MESSAGE_LENGTH_ACTIVATION_MESSAGE_FULL 14
 
+    // check is computed over all message fields before the check itself
+    // (assumes message.check is uint32_t)
+    #define NEXUS_KEYCODE_PRO_FULL_CHECKED_BYTES                               \
+        (sizeof(struct nexus_keycode_pro_full_message) -                       \
+         sizeof(((struct nexus_keycode_pro_full_message*) 0)->check))
+
 //
 // CORE
 //
@@ -95,6 +94,10 @@ static struct
 static NEXUS_PACKED_STRUCT protocol
 {
     const char* alphabet;
+    // small protocol: 2-bit value of each key plus one, indexed by key
+    // character. Zero (the value after `memset`) marks keys outside the
+    // alphabet.
+    uint8_t small_symbol_values_plus_one[256];
 }
 _this_protocol;
 
@@ -138,6 +141,23 @@ NEXUS_STATIC_ASSERT(
          NEXUS_NV_BLOCK_CRC_WIDTH),
     "nexus_keycode_pro: _nexus_keycode_stored invalid size for NV block.");
 
+// Message ID receipt window, either of the stored keycode state of this
+// device or of a device being verified by a `nexus_keycode_verifier_t`.
+// The same receipt functions update both, so that keycodes are accepted or
+// rejected identically on the device and by the verifier.
+struct nexus_keycode_pro_receipt
+{
+    uint32_t pd_index;
+    uint8_t* received_flags; // NEXUS_KEYCODE_PRO_MAX_MESSAGE_ID_BYTE bytes
+};
+
+// Credit change requested by an applied full protocol message
+struct nexus_keycode_pro_credit
+{
+    enum nexus_keycode_verifier_credit_action action;
+    uint32_t seconds;
+};
+
 // FORWARD DECLARATIONS
 
 static void _update_keycode_pro_nv_blocks(void);
@@ -180,13 +200,6 @@ NEXUS_IMPL_STATIC uint32_t nexus_keycode_pro_full_compute_check(
     const struct nexus_keycode_pro_full_message* message,
     const struct nx_common_check_key* key);
 
-NEXUS_IMPL_STATIC bool
-nexus_keycode_pro_mask_idx_from_message_id(const uint16_t full_message_id,
-                                           uint8_t* mask_id_index);
-
-NEXUS_IMPL_STATIC bool
-nexus_keycode_pro_is_message_id_within_window(const uint16_t full_message_id);
-
 NEXUS_IMPL_STATIC bool
 nexus_keycode_pro_can_unit_accept_qc_code(const uint32_t qc_credit_seconds);
 
@@ -201,9 +214,54 @@ NEXUS_IMPL_STATIC void
 nexus_keycode_pro_increment_long_qc_test_message_count(void);
     #endif
 
-// INTERNAL declaration
+// INTERNAL declarations
 static uint16_t
 nexus_keycode_pro_small_get_add_credit_increment_days(uint8_t increment_id);
+static bool _nexus_keycode_pro_full_parse_activation_at_pd_index(
+    struct nexus_keycode_frame* frame,
+    struct nexus_keycode_pro_full_message* parsed,
+    const uint32_t pd_index,
+    const bool assert_on_unsupported_type);
+static enum nexus_keycode_pro_response
+_nexus_keycode_pro_full_activation_outcome(
+    const struct nexus_keycode_pro_full_message* message,
+    struct nexus_keycode_pro_receipt* receipt,
+    struct nexus_keycode_pro_credit* credit);
+static enum nexus_keycode_pro_response
+_nexus_keycode_pro_full_factory_outcome(
+    const struct nexus_keycode_pro_full_message* message,
+    uint32_t user_facing_id,
+    struct nexus_keycode_pro_credit* credit);
+static struct nexus_keycode_pro_receipt _nexus_keycode_pro_stored_receipt(void);
+static void _nexus_keycode_pro_store_receipt(
+    const struct nexus_keycode_pro_receipt* receipt);
+static bool _nexus_keycode_pro_receipt_id_within_window(
+    const struct nexus_keycode_pro_receipt* receipt,
+    const uint16_t full_message_id);
+static bool _nexus_keycode_pro_receipt_mask_idx(
+    const struct nexus_keycode_pro_receipt* receipt,
+    const uint16_t full_message_id,
+    uint8_t* mask_id_index);
+static bool _nexus_keycode_pro_receipt_get_flag(
+    const struct nexus_keycode_pro_receipt* receipt,
+    const uint16_t full_message_id);
+static void _nexus_keycode_pro_receipt_shift_right(
+    struct nexus_keycode_pro_receipt* receipt,
+    const uint32_t pd_increment);
+static bool _nexus_keycode_pro_receipt_update_window(
+    struct nexus_keycode_pro_receipt* receipt,
+    const uint16_t full_message_id,
+    uint8_t* mask_id_index);
+static bool
+_nexus_keycode_pro_receipt_set_flag(struct nexus_keycode_pro_receipt* receipt,
+                                    const uint16_t full_message_id);
+static bool
+_nexus_keycode_pro_receipt_mask_below(struct nexus_keycode_pro_receipt* receipt,
+                                      const uint16_t full_message_id);
+static void _nexus_keycode_pro_receipt_wipe_flags(
+    struct nexus_keycode_pro_receipt* receipt);
+static void
+_nexus_keycode_pro_receipt_reset(struct nexus_keycode_pro_receipt* receipt);
 
 void nexus_keycode_pro_init(nexus_keycode_pro_parse_and_apply parse_and_apply,
                             nexus_keycode_pro_protocol_init protocol_init,
@@ -318,6 +376,24 @@ void nexus_keycode_pro_small_init(const char* alphabet)
                  "unsupported keycode alphabet size");
     #endif
     _this_protocol.alphabet = alphabet;
+
+    // build the reverse alphabet lookup, so that keys are converted without
+    // searching the alphabet. If a key is repeated, its first position wins.
+    (void) memset(_this_protocol.small_symbol_values_plus_one,
+                  0x00,
+                  sizeof(_this_protocol.small_symbol_values_plus_one));
+    for (uint8_t i = 0; alphabet[i] != '\0' &&
+                        i < NEXUS_KEYCODE_PRO_SMALL_ALPHABET_LENGTH;
+         ++i)
+    {
+        uint8_t* symbol_value_plus_one =
+            &_this_protocol.small_symbol_values_plus_one[(uint8_t) alphabet[i]];
+
+        if (*symbol_value_plus_one == 0)
+        {
+            *symbol_value_plus_one = (uint8_t)(i + 1);
+        }
+    }
 }
 
 // Used as the last-step in parsing.
@@ -362,62 +438,6 @@ void nexus_keycode_pro_get_current_message_id_window(
                  "Center of window too small");
 }
 
-// Used to update "Pd" (window 'center') value
-// Does write NV after updating Pd.
-NEXUS_IMPL_STATIC void nexus_keycode_pro_increase_pd_and_shift_window_right(
-    const uint32_t pd_increment)
-{
-    // increased pd by more than lower window size, clear mask.
-    // Warning: pd_increment is assumed to be valid (not too large)
-    if (pd_increment > NEXUS_KEYCODE_PRO_RECEIVE_WINDOW_BEFORE_PD)
-    {
-        nexus_keycode_pro_wipe_message_ids_in_window();
-    }
-    else
-    {
-        // only use flags 0-23 inclusive.
-        uint8_t new_mask[NEXUS_KEYCODE_PRO_MAX_MESSAGE_ID_BYTE] = {0};
-
-        // temporary storage for new mask (starting from 0 offset)
-        struct nexus_bitset new_mask_bitset;
-        nexus_bitset_init(&new_mask_bitset, &new_mask[0], sizeof(new_mask));
-
-        struct nexus_bitset old_mask_bitset;
-        nexus_bitset_init(&old_mask_bitset,
-                          &_nexus_keycode_stored.flags_0_23.received_flags[0],
-                          sizeof(new_mask));
-
-        /* E.g. Pd=23, pd_increment = 2 (final Pd = 25)
-         * Entire window will shift to the right by 2.
-         *
-         * So, we want to copy all IDs in the lower portion of the window
-         * starting at the leftmost position in the current window + the
-         * pd_increment.  Everything to the left of this is 'lost' when we
-         * move the window, and so won't be in the new mask.
-         */
-        for (uint32_t i = pd_increment;
-             i <= (uint8_t) NEXUS_KEYCODE_PRO_RECEIVE_WINDOW_BEFORE_PD;
-             i++)
-        {
-            // copy values from the old mask into the new mask,
-            // offset by pd_inc
-            if (nexus_bitset_contains(&old_mask_bitset, (uint16_t) i))
-            {
-                nexus_bitset_add(&new_mask_bitset,
-                                 (uint16_t)(i - pd_increment));
-            }
-        }
-        // copy new mask back over the existing NV flags
-        (void) memcpy(&_nexus_keycode_stored.flags_0_23.received_flags,
-                      &new_mask,
-                      sizeof(new_mask));
-    }
-
-    // Update our current Pd after updating the window/mask.
-    _nexus_keycode_stored.code_counts.pd_index += pd_increment;
-    _update_keycode_pro_nv_blocks();
-}
-
 // Assumes `passthrough_bitstream` position is 0
 NEXUS_IMPL_STATIC enum nxp_keycode_passthrough_error
 nexus_keycode_pro_small_internal_bitstream_passthrough(
@@ -460,18 +480,30 @@ NEXUS_IMPL_STATIC void nexus_keycode_pro_small_reversibly_obfuscate(
     nexus_bitstream_set_bit_position(input_bitstream, 0);
     nexus_bitstream_set_bit_position(prng_bitstream, 0);
 
-    for (uint8_t i = 0; i < obfuscation_bit_count; ++i)
+    // XOR (up to) 32 bits at a time
+    while (input_bitstream->position < obfuscation_bit_count)
     {
-        const bool deobscured_bit = nexus_bitstream_pull_bit(input_bitstream) ^
-                                    nexus_bitstream_pull_bit(prng_bitstream);
-        nexus_bitstream_push_bit(output_bitstream, deobscured_bit);
+        const uint8_t chunk_bits = (uint8_t)(
+            obfuscation_bit_count - input_bitstream->position < 32 ?
+                obfuscation_bit_count - input_bitstream->position :
+                32);
+        const uint32_t deobscured_bits =
+            nexus_bitstream_pull_bits(input_bitstream, chunk_bits) ^
+            nexus_bitstream_pull_bits(prng_bitstream, chunk_bits);
+        nexus_bitstream_push_bits(
+            output_bitstream, deobscured_bits, chunk_bits);
     }
     // copy remaining input bits 'deobscured' into output bitstream
-    for (uint16_t i = input_bitstream->position; i < input_bitstream->length;
-         ++i)
+    while (input_bitstream->position < input_bitstream->length)
     {
-        nexus_bitstream_push_bit(output_bitstream,
-                                 nexus_bitstream_pull_bit(input_bitstream));
+        const uint8_t chunk_bits = (uint8_t)(
+            input_bitstream->length - input_bitstream->position < 32 ?
+                input_bitstream->length - input_bitstream->position :
+                32);
+        nexus_bitstream_push_bits(
+            output_bitstream,
+            nexus_bitstream_pull_bits(input_bitstream, chunk_bits),
+            chunk_bits);
     }
 
     // GCOVR_EXCL_START
@@ -499,22 +531,18 @@ _nexus_keycode_pro_small_internal_extract_passthrough_message(
     nexus_bitstream_set_bit_position(passthrough_bitstream, 0);
 
     // read bits 0-5 inclusive before type ID
-    for (uint8_t i = 0; i < 6; ++i)
-    {
-        nexus_bitstream_push_bit(
-            passthrough_bitstream,
-            nexus_bitstream_pull_bit(deobscured_bitstream));
-    }
+    nexus_bitstream_push_bits(
+        passthrough_bitstream,
+        nexus_bitstream_pull_bits(deobscured_bitstream, 6),
+        6);
 
     // skip over type ID bits (bits 6 and 7)
     nexus_bitstream_set_bit_position(deobscured_bitstream, 8);
     // read remaining 20 bits for a total of 26
-    for (uint8_t i = 0; i < 20; ++i)
-    {
-        nexus_bitstream_push_bit(
-            passthrough_bitstream,
-            nexus_bitstream_pull_bit(deobscured_bitstream));
-    }
+    nexus_bitstream_push_bits(
+        passthrough_bitstream,
+        nexus_bitstream_pull_bits(deobscured_bitstream, 20),
+        20);
 
     // GCOVR_EXCL_START
     NEXUS_ASSERT(deobscured_bitstream->position == 28,
@@ -541,28 +569,31 @@ nexus_keycode_pro_small_parse(const struct nexus_keycode_frame* frame,
     nexus_bitstream_init(
         &message_bitstream, message_bytes, sizeof(message_bytes) * 8, 0);
 
+    uint32_t message_bits = 0;
+
     for (uint8_t i = 0; i < NEXUS_KEYCODE_MESSAGE_LENGTH_MAX_DIGITS_SMALL; ++i)
     {
-        const nx_keycode_key key = frame->keys[i];
-
-        for (uint8_t j = 0; _this_protocol.alphabet[j] != '\0'; ++j)
-        {
-            if (key == _this_protocol.alphabet[j])
-            {
-                // the alphabet size is assumed to be four; two bits are pushed
-                nexus_bitstream_push_uint8(&message_bitstream, j, 2);
-                break;
-            }
-        }
+        const uint8_t symbol_value_plus_one =
+            _this_protocol
+                .small_symbol_values_plus_one[(uint8_t) frame->keys[i]];
 
         // was this symbol outside the alphabet?
-        if (nexus_bitstream_length_in_bits(&message_bitstream) != (i + 1) * 2)
+        if (symbol_value_plus_one == 0)
         {
             // then reject the message
             return false;
         }
+
+        // the alphabet size is assumed to be four; two bits per key
+        message_bits =
+            (message_bits << 2) | (uint32_t)(symbol_value_plus_one - 1);
     }
 
+    nexus_bitstream_push_bits(
+        &message_bitstream,
+        message_bits,
+        (uint8_t)(NEXUS_KEYCODE_MESSAGE_LENGTH_MAX_DIGITS_SMALL * 2));
+
     #ifdef NEXUS_USE_DEFAULT_ASSERT
     const uint32_t message_bits_length =
         nexus_bitstream_length_in_bits(&message_bitstream);
@@ -916,6 +947,15 @@ nexus_keycode_pro_small_parse_and_apply(const struct nexus_keycode_frame* frame)
     }
 }
 
+static uint16_t
+_nexus_keycode_pro_small_check_from_value(const struct nexus_check_value* value)
+{
+    // use the 12 MSBs of the 64-bit hash as our check value; note that the
+    // hash bytes are packed little-endian
+    return (uint16_t)(((uint16_t) value->bytes[7] << 4) |
+                      (value->bytes[6] >> 4));
+}
+
 NEXUS_IMPL_STATIC uint16_t nexus_keycode_pro_small_compute_check(
     const struct nexus_keycode_pro_small_message* message,
     const struct nx_common_check_key* key)
@@ -926,9 +966,7 @@ NEXUS_IMPL_STATIC uint16_t nexus_keycode_pro_small_compute_check(
     const struct nexus_check_value value = nexus_check_compute(
         key, &message_copy, sizeof(*message) - sizeof(message->check));
 
-    // use the 12 MSBs of the 64-bit hash as our check value; note that the
-    // hash bytes are packed little-endian
-    return (uint16_t)(((uint16_t) value.bytes[7] << 4) | (value.bytes[6] >> 4));
+    return _nexus_keycode_pro_small_check_from_value(&value);
 }
 
 uint16_t
@@ -1054,35 +1092,20 @@ bool nexus_keycode_pro_full_parse(struct nexus_keycode_frame* frame,
 NEXUS_IMPL_STATIC uint32_t nexus_keycode_pro_full_check_field_from_frame(
     const struct nexus_keycode_frame* frame)
 {
-    struct nexus_digits digits;
-    char digit_chars[NEXUS_KEYCODE_MESSAGE_LENGTH_MAX_DIGITS_FULL];
     NEXUS_ASSERT(frame->length <= NEXUS_KEYCODE_MESSAGE_LENGTH_MAX_DIGITS_FULL,
                  "Frame does not contain a valid keycode.");
-    memcpy(&digit_chars, frame->keys, frame->length);
-    nexus_digits_init(&digits, digit_chars, frame->length);
-
-    const int8_t non_check_char_count =
-        (int8_t)(frame->length - NEXUS_KEYCODE_PRO_FULL_CHECK_CHARACTER_COUNT);
 
-    if (non_check_char_count < 0)
+    if (frame->length < NEXUS_KEYCODE_PRO_FULL_CHECK_CHARACTER_COUNT)
     {
         // return 0; which will be essentially an 'invalid' check
         return 0;
     }
-    else
-    {
-        // skim through and ignore the non-check digits
-        for (uint8_t i = 0; i < non_check_char_count; ++i)
-        {
-            (void) nexus_digits_pull_uint8(&digits, 1);
-        }
-    }
-
-    // extract the 6-digit MAC
-    const uint32_t check_as_int = nexus_digits_pull_uint32(
-        &digits, NEXUS_KEYCODE_PRO_FULL_CHECK_CHARACTER_COUNT);
 
-    return check_as_int;
+    // extract the 6-digit MAC, in place, from the end of the frame
+    return nexus_digits_chars_to_uint32(
+        &frame->keys[frame->length -
+                     NEXUS_KEYCODE_PRO_FULL_CHECK_CHARACTER_COUNT],
+        NEXUS_KEYCODE_PRO_FULL_CHECK_CHARACTER_COUNT);
 }
 
 /** Parse an activation message packed in a *normalized* frame.
@@ -1090,6 +1113,23 @@ NEXUS_IMPL_STATIC uint32_t nexus_keycode_pro_full_check_field_from_frame(
 NEXUS_IMPL_STATIC bool nexus_keycode_pro_full_parse_activation(
     struct nexus_keycode_frame* frame,
     struct nexus_keycode_pro_full_message* parsed)
+{
+    return _nexus_keycode_pro_full_parse_activation_at_pd_index(
+        frame, parsed, _nexus_keycode_stored.code_counts.pd_index, true);
+}
+
+/* Parse an activation message, inferring its full message ID from the
+ * receipt window centered at `pd_index`.
+ *
+ * Unsupported message types are rejected; if `assert_on_unsupported_type`
+ * is false, they are rejected without asserting (mistyped keycodes checked
+ * by the verifier are ordinary input).
+ */
+static bool _nexus_keycode_pro_full_parse_activation_at_pd_index(
+    struct nexus_keycode_frame* frame,
+    struct nexus_keycode_pro_full_message* parsed,
+    const uint32_t pd_index,
+    const bool assert_on_unsupported_type)
 {
     // it's an activation message
     NEXUS_ASSERT(frame->length ==
@@ -1104,12 +1144,6 @@ NEXUS_IMPL_STATIC bool nexus_keycode_pro_full_parse_activation(
     // (note that we're changing the caller's message frame here!)
     nexus_keycode_pro_full_deinterleave(frame, parsed->check);
 
-    // prepare to access the *de-interleaved* frame as a digit stream
-    struct nexus_digits digits;
-    char digit_chars[NEXUS_KEYCODE_MESSAGE_LENGTH_ACTIVATION_MESSAGE_FULL];
-    memcpy(&digit_chars, frame->keys, frame->length);
-    nexus_digits_init(&digits, digit_chars, frame->length);
-
     // per the protocol spec, *compressed* activation messages have the
     // following structure:
     //
@@ -1122,11 +1156,16 @@ NEXUS_IMPL_STATIC bool nexus_keycode_pro_full_parse_activation(
     // * 1-digit message type
     // * 2-digit message id
     //
+    // the header and body are converted, in place, as one 8-digit value and
+    // then split into fields
+    const uint32_t header_and_body = nexus_digits_chars_to_uint32(
+        frame->keys, NEXUS_KEYCODE_PRO_FULL_ACTIVATION_BODY_CHARACTER_COUNT);
 
-    parsed->type_code = nexus_digits_pull_uint8(&digits, 1);
+    parsed->type_code = (uint8_t)(header_and_body / 10000000);
 
     // extract the 2-digit *compressed* message id
-    const uint8_t received_message_id = nexus_digits_pull_uint8(&digits, 2);
+    const uint8_t received_message_id =
+        (uint8_t)((header_and_body / 100000) % 100);
 
     if (received_message_id > NEXUS_KEYCODE_PRO_RECEIVE_WINDOW_AFTER_PD +
                                   NEXUS_KEYCODE_PRO_RECEIVE_WINDOW_BEFORE_PD)
@@ -1138,11 +1177,13 @@ NEXUS_IMPL_STATIC bool nexus_keycode_pro_full_parse_activation(
     // 'activation' message ID is used during application of message, not check
     parsed->full_message_id = nexus_keycode_pro_infer_full_message_id(
         received_message_id,
-        _nexus_keycode_stored.code_counts.pd_index,
+        pd_index,
         NEXUS_KEYCODE_PRO_RECEIVE_WINDOW_BEFORE_PD,
         NEXUS_KEYCODE_PRO_RECEIVE_WINDOW_AFTER_PD);
 
-    // extract the 8-digit body
+    // extract the 5-digit body
+    const uint32_t body = header_and_body % 100000;
+
     switch (parsed->type_code)
     {
         case NEXUS_KEYCODE_PRO_FULL_ACTIVATION_ADD_CREDIT:
@@ -1153,10 +1194,7 @@ NEXUS_IMPL_STATIC bool nexus_keycode_pro_full_parse_activation(
             // ADD/SET_CREDIT messages have the following body structure:
             //
             // * Hours [5 digits]
-            //
-            // so, start by extracting the 5-digit hours count
-            parsed->body.add_set_credit.hours =
-                nexus_digits_pull_uint32(&digits, 5);
+            parsed->body.add_set_credit.hours = body;
 
             break;
 
@@ -1166,45 +1204,33 @@ NEXUS_IMPL_STATIC bool nexus_keycode_pro_full_parse_activation(
             // * Reserved [4 digits]
             // * Target Flags [1 digits]
             //
-            // so, start by discarding the reserved digits and
-            // extracting the 1-digit target number
-            (void) nexus_digits_pull_uint32(&digits, 4);
-            parsed->body.wipe_state.target =
-                nexus_digits_pull_uint8(&digits, 1);
+            // so, discard the reserved digits and keep the 1-digit target
+            parsed->body.wipe_state.target = (uint8_t)(body % 10);
 
             break;
 
         default:
-            NEXUS_ASSERT(false, "Unsupported ACTIVATION type received!");
+            (void) assert_on_unsupported_type; // unused if asserts disabled
+            NEXUS_ASSERT(!assert_on_unsupported_type,
+                         "Unsupported ACTIVATION type received!");
             // unrecognized message type; not a valid message
             return false;
     }
 
-    // 'consume' / throw away the 6 check digits at the end of the frame
-    (void) nexus_digits_pull_uint32(
-        &digits, NEXUS_KEYCODE_PRO_FULL_CHECK_CHARACTER_COUNT);
-
-    // we should now have consumed every digit
-    return nexus_digits_length_in_digits(&digits) ==
-           nexus_digits_position(&digits);
+    // the 6 check digits at the end of the frame were parsed above
+    return true;
 }
 
 NEXUS_IMPL_STATIC bool nexus_keycode_pro_full_parse_factory_and_passthrough(
     const struct nexus_keycode_frame* frame,
     struct nexus_keycode_pro_full_message* parsed)
 {
-    // prepare to access the message as a digit stream
-    struct nexus_digits digits;
-    char digit_chars[NEXUS_KEYCODE_MESSAGE_LENGTH_MAX_DIGITS_FULL];
-
-    if (frame->length > NEXUS_KEYCODE_MESSAGE_LENGTH_MAX_DIGITS_FULL)
+    if (frame->length == 0 ||
+        frame->length > NEXUS_KEYCODE_MESSAGE_LENGTH_MAX_DIGITS_FULL)
     {
         return false;
     }
 
-    memcpy(&digit_chars, frame->keys, frame->length);
-    nexus_digits_init(&digits, digit_chars, frame->length);
-
     // per the protocol spec, factory messages have the following structure:
     //
     // * 1-digit header
@@ -1215,14 +1241,13 @@ NEXUS_IMPL_STATIC bool nexus_keycode_pro_full_parse_factory_and_passthrough(
     //
     // * 1-digit message type
     //
-    // so, start by extracting the 1-digit message type
-    bool underrun = false;
-
-    const uint32_t type_code_u32 =
-        nexus_digits_try_pull_uint32(&digits, 1, &underrun);
+    // so, start by extracting the 1-digit message type. All fields are read
+    // in place from the frame keys.
+    parsed->type_code = (uint8_t) nexus_digits_chars_to_uint32(frame->keys, 1);
 
-    NEXUS_ASSERT(type_code_u32 <= UINT8_MAX, "Invalid type code digit!");
-    parsed->type_code = (uint8_t) type_code_u32;
+    // digits following the message type
+    const char* body_chars = &frame->keys[1];
+    const uint8_t body_length = (uint8_t)(frame->length - 1);
 
     /* Only supported factory messages are ALLOW_TEST, QC_TEST,
      DEVICE_ID_DISPLAY, and NOMAC_DEVICE_ID_CONFIRMATION */
@@ -1233,24 +1258,38 @@ NEXUS_IMPL_STATIC bool nexus_keycode_pro_full_parse_factory_and_passthrough(
     if (parsed->type_code <
         (uint8_t) NEXUS_KEYCODE_PRO_FULL_FACTORY_NOMAC_DEVICE_ID_CONFIRMATION)
     {
-        if (parsed->type_code ==
-            (uint8_t) NEXUS_KEYCODE_PRO_FULL_FACTORY_QC_TEST)
+        const bool is_qc_test =
+            parsed->type_code ==
+            (uint8_t) NEXUS_KEYCODE_PRO_FULL_FACTORY_QC_TEST;
+
+        // QC TEST codes have the following body structure:
+        // * Reserved [3 digits]
+        // * QC Variant [2 digits]
+        // (3 reserved digits provide flexibility to allow for future test
+        // keycodes without additional changes to QC code and maintaining
+        // existing message type code structure.)
+        // Other factory messages have no body. Either is followed by the
+        // 6-digit MAC, and every digit must be consumed.
+        const uint8_t expected_body_length =
+            (uint8_t)((is_qc_test ? 5 : 0) +
+                      NEXUS_KEYCODE_PRO_FULL_CHECK_CHARACTER_COUNT);
+
+        if (body_length != expected_body_length)
+        {
+            return false;
+        }
+
+        if (is_qc_test)
         {
-            // QC TEST codes have the following body structure:
-            // * Reserved [3 digits]
-            // * QC Variant [2 digits]
-            // (3 reserved digits provide flexibility to allow for future test
-            // keycodes without additional changes to QC code and maintaining
-            // existing message type code structure.)
             // Discarding the reserved digits and extracting the 2-digit
             // variant number:
-            (void) nexus_digits_pull_uint32(&digits, 3);
             parsed->body.qc_variant.minutes =
-                nexus_digits_pull_uint8(&digits, 2);
+                (uint8_t) nexus_digits_chars_to_uint32(&body_chars[3], 2);
         }
+
         // extract the 6-digit MAC
-        parsed->check = nexus_digits_try_pull_uint32(
-            &digits, NEXUS_KEYCODE_PRO_FULL_CHECK_CHARACTER_COUNT, &underrun);
+        parsed->check = nexus_keycode_pro_full_check_field_from_frame(frame);
+        return true;
     }
     else if (parsed->type_code ==
              (uint8_t)
@@ -1259,23 +1298,14 @@ NEXUS_IMPL_STATIC bool nexus_keycode_pro_full_parse_factory_and_passthrough(
         /* this path is for the NOMAC Device ID confirmation keycode & extracts
            the 8 to 10-digit Device ID */
 
-        // Message body consists of the Device ID being confirmed.
-        // The message frame consists of the body and the single character
-        // message ID.
-        // To find length of the Device ID confirmed, the frame length is pulled
-        // and one is subtracted.
-        // Device ID length used in nexus_digits_try_pull_uint32 to guarantee
-        // the
-        // function includes all digits in the keycode when setting
-        // body.nexus_device_id.device_id
-        uint8_t serial_id_length = (uint8_t)(frame->length - 1);
-        // Ensures serial_id_length is greater than
-        // NEXUS_KEYCODE_PRO_FULL_DEVICE_ID_MIN_CHARACTER_COUNT and less than
+        // Message body consists of the Device ID being confirmed, so every
+        // digit following the message type is part of the Device ID.
+        // Ensures the Device ID length is at least
+        // NEXUS_KEYCODE_PRO_FULL_DEVICE_ID_MIN_CHARACTER_COUNT and at most
         // NEXUS_KEYCODE_PRO_FULL_DEVICE_ID_MAX_CHARACTER_COUNT.
-        if (serial_id_length <
+        if (body_length <
                 NEXUS_KEYCODE_PRO_FULL_DEVICE_ID_MIN_CHARACTER_COUNT ||
-            serial_id_length >
-                NEXUS_KEYCODE_PRO_FULL_DEVICE_ID_MAX_CHARACTER_COUNT)
+            body_length > NEXUS_KEYCODE_PRO_FULL_DEVICE_ID_MAX_CHARACTER_COUNT)
         {
             return false;
         }
@@ -1284,7 +1314,8 @@ NEXUS_IMPL_STATIC bool nexus_keycode_pro_full_parse_factory_and_passthrough(
         // which will not match the internal device ID, and will produce
         // appropriate feedback (not 'matching').
         parsed->body.nexus_device_id.device_id =
-            nexus_digits_try_pull_uint32(&digits, serial_id_length, &underrun);
+            nexus_digits_chars_to_uint32(body_chars, body_length);
+        return true;
     }
     else if (parsed->type_code ==
              (uint8_t) NEXUS_KEYCODE_PRO_FULL_PASSTHROUGH_COMMAND)
@@ -1296,23 +1327,18 @@ NEXUS_IMPL_STATIC bool nexus_keycode_pro_full_parse_factory_and_passthrough(
         // a passthrough command, the next digit is a 'subtype ID' identifying
         // the type of passthrough data, and the following digits are the
         // passthrough data body.
-        if (digits.length > 2 &&
-            digits.length !=
+        if (frame->length > 2 &&
+            frame->length !=
                 NEXUS_KEYCODE_MESSAGE_LENGTH_ACTIVATION_MESSAGE_FULL)
         {
-            NEXUS_ASSERT(
-                digits.position == 1,
-                "More than one digit pulled from Passthrough Command message.");
             // Pass the body digits, skipping the type_code digit
             struct nx_keycode_complete_code passthrough_code;
             memset(&passthrough_code,
                    0x00,
                    sizeof(struct nx_keycode_complete_code));
 
-            passthrough_code.keys =
-                (nx_keycode_key*) &digits.chars[digits.position];
-            passthrough_code.length =
-                (uint8_t)(digits.length - digits.position);
+            passthrough_code.keys = (nx_keycode_key*) body_chars;
+            passthrough_code.length = body_length;
 
             const enum nxp_keycode_passthrough_error result =
                 nxp_keycode_passthrough_keycode(&passthrough_code);
@@ -1322,14 +1348,13 @@ NEXUS_IMPL_STATIC bool nexus_keycode_pro_full_parse_factory_and_passthrough(
                 command_valid = true;
             }
         }
-        // all nexus_digits aren't consumed in the usual fashion, instead, we
+        // digits aren't parsed in the usual fashion, instead, we
         // pass the raw ASCII digits to the product code.
         return command_valid;
     }
 
-    // we should now have consumed exactly every digit
-    return !underrun && nexus_digits_length_in_digits(&digits) ==
-                            nexus_digits_position(&digits);
+    // unsupported message type
+    return false;
 }
 
 NEXUS_IMPL_STATIC enum nexus_keycode_pro_response nexus_keycode_pro_full_apply(
@@ -1369,15 +1394,28 @@ NEXUS_IMPL_STATIC enum nexus_keycode_pro_response nexus_keycode_pro_full_apply(
     return response;
 }
 
-NEXUS_IMPL_STATIC enum nexus_keycode_pro_response
-nexus_keycode_pro_full_apply_activation(
-    const struct nexus_keycode_pro_full_message* message)
+/* Determine the outcome of an authenticated activation message.
+ *
+ * Updates `receipt` as the message requires and populates `credit` with the
+ * credit change requested by the message. `receipt` is unchanged if the
+ * message is a duplicate or invalid.
+ *
+ * Used both when applying messages on this device and by the verifier.
+ */
+static enum nexus_keycode_pro_response
+_nexus_keycode_pro_full_activation_outcome(
+    const struct nexus_keycode_pro_full_message* message,
+    struct nexus_keycode_pro_receipt* receipt,
+    struct nexus_keycode_pro_credit* credit)
 {
+    credit->action = NEXUS_KEYCODE_VERIFIER_CREDIT_ACTION_NONE;
+    credit->seconds = 0;
+
     // certain version of clang misinterpret this section
     #ifndef __clang_analyzer__
     // reject any activation message if its already been applied.
-    if (nexus_keycode_pro_get_full_message_id_flag(
-            (uint16_t) message->full_message_id))
+    if (_nexus_keycode_pro_receipt_get_flag(
+            receipt, (uint16_t) message->full_message_id))
     {
         return NEXUS_KEYCODE_PRO_RESPONSE_VALID_DUPLICATE;
     }
@@ -1389,168 +1427,211 @@ nexus_keycode_pro_full_apply_activation(
     const uint32_t credit_increment_seconds =
         message->body.add_set_credit.hours * NEXUS_KEYCODE_PRO_SECONDS_IN_HOUR;
 
+    // Invalidate receipt of any messages <= this message ID
+    const uint16_t mask_below_message_id =
+        (uint16_t)(message->full_message_id + 1);
+
     // apply the message according to its specific semantics
     switch (message->type_code)
     {
         case NEXUS_KEYCODE_PRO_FULL_ACTIVATION_ADD_CREDIT:
             // set only this message ID
-            nexus_keycode_pro_set_full_message_id_flag(
-                (uint16_t) message->full_message_id);
-
-            if (nxp_common_payg_state_get_current() !=
-                NXP_COMMON_PAYG_STATE_UNLOCKED)
-            {
-                nxp_keycode_payg_credit_add(credit_increment_seconds);
-            }
-            else
-            {
-                // already unlocked? return duplicate feedback
-                return NEXUS_KEYCODE_PRO_RESPONSE_VALID_DUPLICATE;
-            }
+            (void) _nexus_keycode_pro_receipt_set_flag(
+                receipt, (uint16_t) message->full_message_id);
+            credit->action = NEXUS_KEYCODE_VERIFIER_CREDIT_ACTION_ADD;
+            credit->seconds = credit_increment_seconds;
             break;
 
         case NEXUS_KEYCODE_PRO_FULL_ACTIVATION_DEMO_CODE:
             /* Intended for specially designated 'demo' units
              * Note: Demo codes *can* be reused (no message ID is set)
+             *
+             * The body of the demo code overrides 'hours' to convey
+             * 'minutes', so we only need to multiply by 60 here to get
+             * the conveyed amount.
              */
-            if (nxp_common_payg_state_get_current() !=
-                NXP_COMMON_PAYG_STATE_UNLOCKED)
-            {
-                // The body of the demo code overrides 'hours' to convey
-                // 'minutes', so we only need to multiply by 60 here to get
-                // the conveyed amount.
-                const uint32_t credit_increment_seconds_demo =
-                    message->body.add_set_credit.hours * 60;
-
-                nxp_keycode_payg_credit_add(credit_increment_seconds_demo);
-            }
+            credit->action = NEXUS_KEYCODE_VERIFIER_CREDIT_ACTION_ADD;
+            credit->seconds = message->body.add_set_credit.hours * 60;
             break;
 
         case NEXUS_KEYCODE_PRO_FULL_ACTIVATION_SET_CREDIT:
-            // Invalidate receipt of any messages <= this message ID
-            nexus_keycode_pro_mask_below_message_id(
-                (uint16_t)(message->full_message_id + 1));
+            (void) _nexus_keycode_pro_receipt_mask_below(receipt,
+                                                         mask_below_message_id);
 
             // unlock the unit
             if (message->body.add_set_credit.hours ==
                 NEXUS_KEYCODE_PRO_FULL_UNLOCK_INCREMENT)
             {
-                nxp_keycode_payg_credit_unlock();
+                credit->action = NEXUS_KEYCODE_VERIFIER_CREDIT_ACTION_UNLOCK;
             }
             else
             {
-                nxp_keycode_payg_credit_set(credit_increment_seconds);
+                credit->action = NEXUS_KEYCODE_VERIFIER_CREDIT_ACTION_SET;
+                credit->seconds = credit_increment_seconds;
             }
             break;
 
         case NEXUS_KEYCODE_PRO_FULL_ACTIVATION_WIPE_STATE:
-            // Invalidate receipt of any messages <= this message ID
-            nexus_keycode_pro_mask_below_message_id(
-                (uint16_t)(message->full_message_id + 1));
-
             switch (message->body.wipe_state.target)
             {
                 case NEXUS_KEYCODE_PRO_FULL_WIPE_STATE_TARGET_CREDIT_AND_MASK:
-                    nexus_keycode_pro_reset_pd_index();
-                    nexus_keycode_pro_reset_test_code_count();
-                    nexus_keycode_pro_wipe_message_ids_in_window();
-                    // intentional fallthrough
+                    (void) _nexus_keycode_pro_receipt_mask_below(
+                        receipt, mask_below_message_id);
+                    _nexus_keycode_pro_receipt_reset(receipt);
+                    credit->action = NEXUS_KEYCODE_VERIFIER_CREDIT_ACTION_SET;
+                    break;
 
                 case NEXUS_KEYCODE_PRO_FULL_WIPE_STATE_TARGET_CREDIT:
-                    // wipe all state data
-                    // We explicitly cast to indicate that we mean to treat
-                    // these enum types as integer values
-                    nxp_keycode_payg_credit_set(0);
+                    (void) _nexus_keycode_pro_receipt_mask_below(
+                        receipt, mask_below_message_id);
+                    credit->action = NEXUS_KEYCODE_VERIFIER_CREDIT_ACTION_SET;
                     break;
 
                 case NEXUS_KEYCODE_PRO_FULL_WIPE_STATE_TARGET_MASK_ONLY:
-                    nexus_keycode_pro_reset_pd_index();
-                    nexus_keycode_pro_reset_test_code_count();
-                    nexus_keycode_pro_wipe_message_ids_in_window();
+                    (void) _nexus_keycode_pro_receipt_mask_below(
+                        receipt, mask_below_message_id);
+                    _nexus_keycode_pro_receipt_reset(receipt);
                     break;
 
                 case NEXUS_KEYCODE_PRO_FULL_WIPE_CUSTOM_FLAG_RESTRICTED:
-                    // does not modify credit or message IDs
-                    nexus_keycode_pro_reset_custom_flag(
-                        NX_KEYCODE_CUSTOM_FLAG_RESTRICTED);
+                    // does not modify credit; custom flag is product state
+                    (void) _nexus_keycode_pro_receipt_mask_below(
+                        receipt, mask_below_message_id);
                     break;
 
                 default:
-                    NEXUS_ASSERT(false, "Invalid wipe state flag received!");
                     return NEXUS_KEYCODE_PRO_RESPONSE_INVALID;
             }
             break;
 
         default:
-            NEXUS_ASSERT(false, "Invalid activation message type received!");
             return NEXUS_KEYCODE_PRO_RESPONSE_INVALID;
     }
     return NEXUS_KEYCODE_PRO_RESPONSE_VALID_APPLIED;
 }
 
-/*@ requires \valid(message);
-    assigns \nothing;
-
-    behavior qc_codes_above_limit:
-        assumes _nexus_keycode_stored.code_counts.qc_test_codes_received >
-            10;
-        assumes message->type_code == NEXUS_KEYCODE_PRO_FULL_FACTORY_ALLOW_TEST;
-        ensures \result == NEXUS_KEYCODE_PRO_RESPONSE_VALID_DUPLICATE;
-*/
 NEXUS_IMPL_STATIC enum nexus_keycode_pro_response
-nexus_keycode_pro_full_apply_factory(
+nexus_keycode_pro_full_apply_activation(
     const struct nexus_keycode_pro_full_message* message)
 {
-    bool test_applied = false;
+    // read latest message IDs from NV
+    (void) nexus_nv_read(NX_NV_BLOCK_KEYCODE_PRO,
+                         (uint8_t*) &_nexus_keycode_stored);
 
-    // no body included in an 'allow_test' factory message
-    switch (message->type_code)
+    struct nexus_keycode_pro_receipt receipt =
+        _nexus_keycode_pro_stored_receipt();
+    struct nexus_keycode_pro_credit credit;
+    const enum nexus_keycode_pro_response response =
+        _nexus_keycode_pro_full_activation_outcome(message, &receipt, &credit);
+
+    if (response == NEXUS_KEYCODE_PRO_RESPONSE_INVALID)
     {
-        case NEXUS_KEYCODE_PRO_FULL_FACTORY_ALLOW_TEST:
-            // only apply if we are disabled and haven't hit the limit.
-            if (nxp_common_payg_state_get_current() ==
-                NXP_COMMON_PAYG_STATE_DISABLED)
+        NEXUS_ASSERT(false, "Invalid activation message received!");
+        return response;
+    }
+    else if (response != NEXUS_KEYCODE_PRO_RESPONSE_VALID_APPLIED)
+    {
+        return response;
+    }
+
+    // persist the updated receipt window (and any flags it wipes) in one
+    // update, committed before changing credit so that a keycode interrupted
+    // by power loss cannot be applied again
+    nexus_nv_transaction_begin();
+    _nexus_keycode_pro_store_receipt(&receipt);
+    if (message->type_code ==
+            (uint8_t) NEXUS_KEYCODE_PRO_FULL_ACTIVATION_WIPE_STATE &&
+        (message->body.wipe_state.target ==
+             NEXUS_KEYCODE_PRO_FULL_WIPE_STATE_TARGET_CREDIT_AND_MASK ||
+         message->body.wipe_state.target ==
+             NEXUS_KEYCODE_PRO_FULL_WIPE_STATE_TARGET_MASK_ONLY))
+    {
+        nexus_keycode_pro_reset_test_code_count();
+    }
+    _update_keycode_pro_nv_blocks();
+
+    if (message->type_code ==
+            (uint8_t) NEXUS_KEYCODE_PRO_FULL_ACTIVATION_WIPE_STATE &&
+        message->body.wipe_state.target ==
+            NEXUS_KEYCODE_PRO_FULL_WIPE_CUSTOM_FLAG_RESTRICTED)
+    {
+        nexus_keycode_pro_reset_custom_flag(NX_KEYCODE_CUSTOM_FLAG_RESTRICTED);
+    }
+    (void) nexus_nv_transaction_commit();
+
+    switch (credit.action)
+    {
+        case NEXUS_KEYCODE_VERIFIER_CREDIT_ACTION_ADD:
+            if (nxp_common_payg_state_get_current() !=
+                NXP_COMMON_PAYG_STATE_UNLOCKED)
             {
-                test_applied = true;
-                nxp_keycode_payg_credit_add(
-                    NEXUS_KEYCODE_PRO_UNIVERSAL_SHORT_TEST_SECONDS);
+                nxp_keycode_payg_credit_add(credit.seconds);
             }
-            break;
-
-        case NEXUS_KEYCODE_PRO_FULL_FACTORY_QC_TEST:
-        {
-            const uint32_t qc_credit_seconds =
-                message->body.qc_variant.minutes * 60;
-            test_applied =
-                nexus_keycode_pro_can_unit_accept_qc_code(qc_credit_seconds);
-            if (test_applied)
+            else if (message->type_code ==
+                     (uint8_t) NEXUS_KEYCODE_PRO_FULL_ACTIVATION_ADD_CREDIT)
             {
-                nxp_keycode_payg_credit_add(qc_credit_seconds);
-                if (qc_credit_seconds <=
-                    NEXUS_KEYCODE_PRO_QC_SHORT_TEST_MESSAGE_SECONDS)
-                {
-                    nexus_keycode_pro_increment_short_qc_test_message_count();
-                }
-                else
-                {
-                    nexus_keycode_pro_increment_long_qc_test_message_count();
-                }
+                // already unlocked? return duplicate feedback
+                return NEXUS_KEYCODE_PRO_RESPONSE_VALID_DUPLICATE;
             }
             break;
-        }
+
+        case NEXUS_KEYCODE_VERIFIER_CREDIT_ACTION_SET:
+            nxp_keycode_payg_credit_set(credit.seconds);
+            break;
+
+        case NEXUS_KEYCODE_VERIFIER_CREDIT_ACTION_UNLOCK:
+            nxp_keycode_payg_credit_unlock();
+            break;
+
+        case NEXUS_KEYCODE_VERIFIER_CREDIT_ACTION_NONE:
+        // intentional fallthrough
+        default:
+            break;
+    }
+    return NEXUS_KEYCODE_PRO_RESPONSE_VALID_APPLIED;
+}
+
+/* Determine the outcome of an authenticated factory message.
+ *
+ * Test messages are reported as applied with the credit they request.
+ * Whether this device accepts a test message depends on its PAYG state and
+ * test message counts, which are checked by the caller.
+ *
+ * Used both when applying messages on this device and by the verifier.
+ */
+static enum nexus_keycode_pro_response
+_nexus_keycode_pro_full_factory_outcome(
+    const struct nexus_keycode_pro_full_message* message,
+    uint32_t user_facing_id,
+    struct nexus_keycode_pro_credit* credit)
+{
+    credit->action = NEXUS_KEYCODE_VERIFIER_CREDIT_ACTION_NONE;
+    credit->seconds = 0;
+
+    // no body included in an 'allow_test' factory message
+    switch (message->type_code)
+    {
+        case NEXUS_KEYCODE_PRO_FULL_FACTORY_ALLOW_TEST:
+            credit->action = NEXUS_KEYCODE_VERIFIER_CREDIT_ACTION_ADD;
+            credit->seconds = NEXUS_KEYCODE_PRO_UNIVERSAL_SHORT_TEST_SECONDS;
+            return NEXUS_KEYCODE_PRO_RESPONSE_VALID_APPLIED;
+
+        case NEXUS_KEYCODE_PRO_FULL_FACTORY_QC_TEST:
+            credit->action = NEXUS_KEYCODE_VERIFIER_CREDIT_ACTION_ADD;
+            credit->seconds = message->body.qc_variant.minutes * 60;
+            return NEXUS_KEYCODE_PRO_RESPONSE_VALID_APPLIED;
 
         case NEXUS_KEYCODE_PRO_FULL_FACTORY_DEVICE_ID_DISPLAY:
             // No credit or state change occurs as a result of this message.
-            break;
+            return NEXUS_KEYCODE_PRO_RESPONSE_DISPLAY_DEVICE_ID;
 
         case NEXUS_KEYCODE_PRO_FULL_FACTORY_NOMAC_DEVICE_ID_CONFIRMATION:
-            if (message->body.nexus_device_id.device_id ==
-                nxp_keycode_get_user_facing_id())
+            // Signal 'applied' if the ID matches, 'duplicate' if not.
+            if (message->body.nexus_device_id.device_id == user_facing_id)
             {
-                // Signal 'applied' if the ID matches, 'invalid' if not.
-                test_applied = true;
+                return NEXUS_KEYCODE_PRO_RESPONSE_VALID_APPLIED;
             }
-            break;
+            return NEXUS_KEYCODE_PRO_RESPONSE_VALID_DUPLICATE;
 
         case NEXUS_KEYCODE_PRO_FULL_PASSTHROUGH_COMMAND:
             // Should not reach here, as passthrough commands are handled
@@ -1558,37 +1639,94 @@ nexus_keycode_pro_full_apply_factory(
             // intentional fallthrough
 
         default:
-            NEXUS_ASSERT(false, "should not be reached");
             return NEXUS_KEYCODE_PRO_RESPONSE_INVALID;
     }
+}
+
+/*@ requires \valid(message);
+    assigns \nothing;
 
-    if (test_applied)
+    behavior qc_codes_above_limit:
+        assumes _nexus_keycode_stored.code_counts.qc_test_codes_received >
+            10;
+        assumes message->type_code == NEXUS_KEYCODE_PRO_FULL_FACTORY_ALLOW_TEST;
+        ensures \result == NEXUS_KEYCODE_PRO_RESPONSE_VALID_DUPLICATE;
+*/
+NEXUS_IMPL_STATIC enum nexus_keycode_pro_response
+nexus_keycode_pro_full_apply_factory(
+    const struct nexus_keycode_pro_full_message* message)
+{
+    // only requested from the product when it is compared
+    uint32_t user_facing_id = 0;
+    if (message->type_code ==
+        (uint8_t) NEXUS_KEYCODE_PRO_FULL_FACTORY_NOMAC_DEVICE_ID_CONFIRMATION)
     {
-        return NEXUS_KEYCODE_PRO_RESPONSE_VALID_APPLIED;
+        user_facing_id = nxp_keycode_get_user_facing_id();
     }
-    else if (message->type_code ==
-             (uint8_t) NEXUS_KEYCODE_PRO_FULL_FACTORY_DEVICE_ID_DISPLAY)
+
+    struct nexus_keycode_pro_credit credit;
+    const enum nexus_keycode_pro_response response =
+        _nexus_keycode_pro_full_factory_outcome(
+            message, user_facing_id, &credit);
+
+    if (response == NEXUS_KEYCODE_PRO_RESPONSE_INVALID)
     {
-        return NEXUS_KEYCODE_PRO_RESPONSE_DISPLAY_DEVICE_ID;
+        NEXUS_ASSERT(false, "should not be reached");
+        return response;
     }
-    // if the above two are untrue, return the duplicate feedback response
-    else
+
+    if (credit.action == NEXUS_KEYCODE_VERIFIER_CREDIT_ACTION_ADD)
     {
-        return NEXUS_KEYCODE_PRO_RESPONSE_VALID_DUPLICATE;
-    }
-}
+        // only apply test messages if we are disabled and haven't hit the
+        // limit.
+        bool test_applied;
+        if (message->type_code ==
+            (uint8_t) NEXUS_KEYCODE_PRO_FULL_FACTORY_ALLOW_TEST)
+        {
+            test_applied = nxp_common_payg_state_get_current() ==
+                           NXP_COMMON_PAYG_STATE_DISABLED;
+        }
+        else
+        {
+            test_applied =
+                nexus_keycode_pro_can_unit_accept_qc_code(credit.seconds);
+        }
 
-// Note: Only "Activation" messages are interleaved.
-NEXUS_IMPL_STATIC void
-nexus_keycode_pro_full_deinterleave(struct nexus_keycode_frame* frame,
-                                    const uint32_t check_value)
-{
-    // compute pseudorandom bytes for deinterleaving
-    uint8_t prng_bytes[NEXUS_KEYCODE_PRO_FULL_ACTIVATION_BODY_CHARACTER_COUNT];
+        if (!test_applied)
+        {
+            return NEXUS_KEYCODE_PRO_RESPONSE_VALID_DUPLICATE;
+        }
 
-    // only activation messages are de-interleavable.
-    NEXUS_ASSERT(frame->length ==
-                     NEXUS_KEYCODE_PRO_FULL_ACTIVATION_BODY_CHARACTER_COUNT +
+        // count QC codes before adding credit, as for activation receipts
+        if (message->type_code ==
+            (uint8_t) NEXUS_KEYCODE_PRO_FULL_FACTORY_QC_TEST)
+        {
+            if (credit.seconds <=
+                NEXUS_KEYCODE_PRO_QC_SHORT_TEST_MESSAGE_SECONDS)
+            {
+                nexus_keycode_pro_increment_short_qc_test_message_count();
+            }
+            else
+            {
+                nexus_keycode_pro_increment_long_qc_test_message_count();
+            }
+        }
+        nxp_keycode_payg_credit_add(credit.seconds);
+    }
+    return response;
+}
+
+// Note: Only "Activation" messages are interleaved.
+NEXUS_IMPL_STATIC void
+nexus_keycode_pro_full_deinterleave(struct nexus_keycode_frame* frame,
+                                    const uint32_t check_value)
+{
+    // compute pseudorandom bytes for deinterleaving
+    uint8_t prng_bytes[NEXUS_KEYCODE_PRO_FULL_ACTIVATION_BODY_CHARACTER_COUNT];
+
+    // only activation messages are de-interleavable.
+    NEXUS_ASSERT(frame->length ==
+                     NEXUS_KEYCODE_PRO_FULL_ACTIVATION_BODY_CHARACTER_COUNT +
                          NEXUS_KEYCODE_PRO_FULL_CHECK_CHARACTER_COUNT,
                  "frame to deinterleave has wrong length");
 
@@ -1616,6 +1754,20 @@ nexus_keycode_pro_full_deinterleave(struct nexus_keycode_frame* frame,
     }
 }
 
+static uint32_t
+_nexus_keycode_pro_full_check_from_value(const struct nexus_check_value* value)
+{
+    // obtain lower 32 bits of check
+    const uint32_t lower_check =
+        nexus_check_value_as_uint64(value) & 0xffffffff;
+
+    // obtain the 'decimal representation' of the lowest 6 decimal digits
+    // of the check.  Note that leading zeros are *ignored* as the check is now
+    // computed over the numeric value represented by the 6 decimal check
+    // digits, not the individual digits themselves.
+    return lower_check % 1000000;
+}
+
 /**
  * \param message full protocol message to for computing MAC
  * \param key nx_check_key to use in MAC computation
@@ -1630,21 +1782,508 @@ NEXUS_IMPL_STATIC uint32_t nexus_keycode_pro_full_compute_check(
     // 1 = type_id (uint8_t)
     // 4 = contents of body (full message body always 4 bytes))
     const struct nexus_check_value check_val = nexus_check_compute(
-        key,
+        key, message, NEXUS_KEYCODE_PRO_FULL_CHECKED_BYTES);
+
+    return _nexus_keycode_pro_full_check_from_value(&check_val);
+}
+
+void nexus_keycode_verifier_init(nexus_keycode_verifier_t* verifier,
+                                 const struct nx_common_check_key* secret_key,
+                                 uint32_t user_facing_id,
+                                 uint32_t pd_index,
+                                 const uint8_t* received_flags)
+{
+    NEXUS_ASSERT(pd_index >= NEXUS_KEYCODE_PRO_RECEIVE_WINDOW_BEFORE_PD,
+                 "Center of window too small");
+    verifier->secret_key = *secret_key;
+    verifier->user_facing_id = user_facing_id;
+    verifier->pd_index = pd_index;
+    (void) memcpy(verifier->received_flags,
+                  received_flags,
+                  sizeof(verifier->received_flags));
+}
+
+enum nexus_keycode_pro_response
+nexus_keycode_verifier_verify(const nexus_keycode_verifier_t* verifier,
+                              const struct nexus_keycode_frame* frame,
+                              nexus_keycode_verifier_result_t* result)
+{
+    (void) memset(result, 0x00, sizeof(nexus_keycode_verifier_result_t));
+    result->response = NEXUS_KEYCODE_PRO_RESPONSE_INVALID;
+    result->pd_index = verifier->pd_index;
+    (void) memcpy(result->received_flags,
+                  verifier->received_flags,
+                  sizeof(result->received_flags));
+
+    // parsing expects digits only, as filtered by the MAS on the device
+    if (frame->length == 0 ||
+        frame->length > NEXUS_KEYCODE_MESSAGE_LENGTH_MAX_DIGITS_FULL)
+    {
+        return result->response;
+    }
+    for (uint8_t i = 0; i < frame->length; ++i)
+    {
+        if (frame->keys[i] < '0' || frame->keys[i] > '9')
+        {
+            return result->response;
+        }
+    }
+
+    // parsing deinterleaves activation messages in place
+    struct nexus_keycode_frame normalized = *frame;
+    bool parsed = false;
+
+    if (normalized.length ==
+        NEXUS_KEYCODE_MESSAGE_LENGTH_ACTIVATION_MESSAGE_FULL)
+    {
+        parsed = _nexus_keycode_pro_full_parse_activation_at_pd_index(
+            &normalized, &result->message, verifier->pd_index, false);
+    }
+    else if (normalized.keys[0] - '0' ==
+             NEXUS_KEYCODE_PRO_FULL_PASSTHROUGH_COMMAND)
+    {
+        // passthrough commands are handled by product code, not verified
+        result->message.type_code =
+            (uint8_t) NEXUS_KEYCODE_PRO_FULL_PASSTHROUGH_COMMAND;
+        result->response = NEXUS_KEYCODE_PRO_RESPONSE_NONE;
+        return result->response;
+    }
+    else if (normalized.keys[0] - '0' <
+             NEXUS_KEYCODE_PRO_FULL_PASSTHROUGH_COMMAND)
+    {
+        parsed = nexus_keycode_pro_full_parse_factory_and_passthrough(
+            &normalized, &result->message);
+    }
+
+    if (!parsed)
+    {
+        return result->response;
+    }
+
+    // validate the message, as in `nexus_keycode_pro_full_apply`
+    const struct nexus_keycode_pro_full_message* message = &result->message;
+    const bool is_activation =
+        message->type_code <
+        (uint8_t) NEXUS_KEYCODE_PRO_FULL_FACTORY_ALLOW_TEST;
+    const uint32_t check_expected = nexus_keycode_pro_full_compute_check(
         message,
-        // assumes message.check is uint32_t
-        sizeof(struct nexus_keycode_pro_full_message) -
-            sizeof(((struct nexus_keycode_pro_full_message*) 0)->check));
+        is_activation ? &verifier->secret_key :
+                        &NEXUS_INTEGRITY_CHECK_FIXED_00_KEY);
 
-    // obtain lower 32 bits of check
-    const uint32_t lower_check =
-        nexus_check_value_as_uint64(&check_val) & 0xffffffff;
+    if (message->check != check_expected &&
+        message->type_code <
+            (uint8_t)
+                NEXUS_KEYCODE_PRO_FULL_FACTORY_NOMAC_DEVICE_ID_CONFIRMATION)
+    {
+        return result->response;
+    }
 
-    // obtain the 'decimal representation' of the lowest 6 decimal digits
-    // of the check.  Note that leading zeros are *ignored* as the check is now
-    // computed over the numeric value represented by the 6 decimal check
-    // digits, not the individual digits themselves.
-    return lower_check % 1000000;
+    // determine the outcome as `nexus_keycode_pro_full_apply` does, on the
+    // receipt window in `result` instead of the stored keycode state
+    struct nexus_keycode_pro_credit credit;
+    if (is_activation)
+    {
+        struct nexus_keycode_pro_receipt receipt = {result->pd_index,
+                                                    result->received_flags};
+        result->response = _nexus_keycode_pro_full_activation_outcome(
+            message, &receipt, &credit);
+        result->pd_index = receipt.pd_index;
+    }
+    else
+    {
+        result->response = _nexus_keycode_pro_full_factory_outcome(
+            message, verifier->user_facing_id, &credit);
+    }
+
+    if (result->response != NEXUS_KEYCODE_PRO_RESPONSE_INVALID)
+    {
+        result->credit_action = credit.action;
+        result->credit_seconds = credit.seconds;
+    }
+    return result->response;
+}
+
+void nexus_keycode_encoder_init(nexus_keycode_encoder_t* encoder,
+                                const struct nx_common_check_key* secret_key)
+{
+    nexus_check_keyed_state_init(&encoder->secret_key_state, secret_key);
+    nexus_check_keyed_state_init(&encoder->fixed_00_key_state,
+                                 &NEXUS_INTEGRITY_CHECK_FIXED_00_KEY);
+    nexus_check_keyed_state_init(&encoder->fixed_ff_key_state,
+                                 &NEXUS_INTEGRITY_CHECK_FIXED_FF_KEY);
+}
+
+// Write `value` as `count` decimal digits, zero-padded on the left
+static void _nexus_keycode_encoder_write_digits(nx_keycode_key* keys,
+                                                uint32_t value,
+                                                const uint8_t count)
+{
+    for (uint8_t i = count; i > 0; --i)
+    {
+        keys[i - 1] = (nx_keycode_key)('0' + value % 10);
+        value /= 10;
+    }
+}
+
+/* Copy the fields of `message` which are transmitted in a full protocol
+ * keycode into `normalized`, as `nexus_keycode_pro_full_parse` would
+ * populate them.
+ *
+ * \return false if `message` cannot be encoded
+ */
+static bool _nexus_keycode_encoder_full_normalize(
+    const struct nexus_keycode_pro_full_message* message,
+    struct nexus_keycode_pro_full_message* normalized)
+{
+    (void) memset(normalized, 0x00, sizeof(*normalized));
+    normalized->type_code = message->type_code;
+
+    switch (message->type_code)
+    {
+        case NEXUS_KEYCODE_PRO_FULL_ACTIVATION_ADD_CREDIT:
+        // intentional fallthrough
+        case NEXUS_KEYCODE_PRO_FULL_ACTIVATION_SET_CREDIT:
+        // intentional fallthrough
+        case NEXUS_KEYCODE_PRO_FULL_ACTIVATION_DEMO_CODE:
+            // 5-digit hours
+            normalized->full_message_id = message->full_message_id;
+            normalized->body.add_set_credit.hours =
+                message->body.add_set_credit.hours;
+            return message->body.add_set_credit.hours <= 99999;
+
+        case NEXUS_KEYCODE_PRO_FULL_ACTIVATION_WIPE_STATE:
+            // 1-digit target
+            normalized->full_message_id = message->full_message_id;
+            normalized->body.wipe_state.target =
+                message->body.wipe_state.target;
+            return message->body.wipe_state.target <= 9;
+
+        case NEXUS_KEYCODE_PRO_FULL_FACTORY_ALLOW_TEST:
+        // intentional fallthrough
+        case NEXUS_KEYCODE_PRO_FULL_FACTORY_DEVICE_ID_DISPLAY:
+            return true;
+
+        case NEXUS_KEYCODE_PRO_FULL_FACTORY_QC_TEST:
+            // 2-digit minutes
+            normalized->body.qc_variant.minutes =
+                message->body.qc_variant.minutes;
+            return message->body.qc_variant.minutes <= 99;
+
+        case NEXUS_KEYCODE_PRO_FULL_FACTORY_NOMAC_DEVICE_ID_CONFIRMATION:
+            normalized->body.nexus_device_id.device_id =
+                message->body.nexus_device_id.device_id;
+            return true;
+
+        default:
+            // passthrough commands and reserved types
+            return false;
+    }
+}
+
+/* Write the keys of a normalized full protocol message into `frame`.
+ *
+ * `prng_bytes` are the pseudorandom bytes derived from the message check,
+ * used to interleave activation messages (reverses
+ * `nexus_keycode_pro_full_deinterleave`).
+ */
+static void _nexus_keycode_encoder_full_write_frame(
+    const struct nexus_keycode_pro_full_message* message,
+    const uint8_t* prng_bytes,
+    struct nexus_keycode_frame* frame)
+{
+    nx_keycode_key* keys = frame->keys;
+
+    _nexus_keycode_encoder_write_digits(keys, message->type_code, 1);
+
+    switch (message->type_code)
+    {
+        case NEXUS_KEYCODE_PRO_FULL_ACTIVATION_ADD_CREDIT:
+        // intentional fallthrough
+        case NEXUS_KEYCODE_PRO_FULL_ACTIVATION_SET_CREDIT:
+        // intentional fallthrough
+        case NEXUS_KEYCODE_PRO_FULL_ACTIVATION_DEMO_CODE:
+        // intentional fallthrough
+        case NEXUS_KEYCODE_PRO_FULL_ACTIVATION_WIPE_STATE:
+            // 2-digit compressed message ID, then 5-digit body (hours, or
+            // 4 reserved digits and a 1-digit wipe target)
+            _nexus_keycode_encoder_write_digits(
+                &keys[1], message->full_message_id & 0x3F, 2);
+            _nexus_keycode_encoder_write_digits(
+                &keys[3], message->body.add_set_credit.hours, 5);
+            _nexus_keycode_encoder_write_digits(
+                &keys[NEXUS_KEYCODE_PRO_FULL_ACTIVATION_BODY_CHARACTER_COUNT],
+                message->check,
+                NEXUS_KEYCODE_PRO_FULL_CHECK_CHARACTER_COUNT);
+            frame->length =
+                NEXUS_KEYCODE_MESSAGE_LENGTH_ACTIVATION_MESSAGE_FULL;
+
+            for (uint8_t i = 0;
+                 i < NEXUS_KEYCODE_PRO_FULL_ACTIVATION_BODY_CHARACTER_COUNT;
+                 ++i)
+            {
+                const uint8_t digit = (uint8_t)(keys[i] - '0');
+                keys[i] = (nx_keycode_key)('0' + (digit + prng_bytes[i]) % 10);
+            }
+            break;
+
+        case NEXUS_KEYCODE_PRO_FULL_FACTORY_QC_TEST:
+            // 3 reserved digits, 2-digit minutes, then check
+            _nexus_keycode_encoder_write_digits(
+                &keys[1], message->body.qc_variant.minutes, 5);
+            _nexus_keycode_encoder_write_digits(
+                &keys[6],
+                message->check,
+                NEXUS_KEYCODE_PRO_FULL_CHECK_CHARACTER_COUNT);
+            frame->length =
+                (uint8_t)(6 + NEXUS_KEYCODE_PRO_FULL_CHECK_CHARACTER_COUNT);
+            break;
+
+        case NEXUS_KEYCODE_PRO_FULL_FACTORY_NOMAC_DEVICE_ID_CONFIRMATION:
+        {
+            // device ID (no check), at least 8 digits
+            uint8_t id_length =
+                NEXUS_KEYCODE_PRO_FULL_DEVICE_ID_MIN_CHARACTER_COUNT;
+            for (uint32_t remaining = message->body.nexus_device_id.device_id /
+                                      100000000;
+                 remaining > 0;
+                 remaining /= 10)
+            {
+                ++id_length;
+            }
+            _nexus_keycode_encoder_write_digits(
+                &keys[1], message->body.nexus_device_id.device_id, id_length);
+            frame->length = (uint8_t)(1 + id_length);
+            break;
+        }
+
+        default:
+            // ALLOW_TEST and DEVICE_ID_DISPLAY have no body
+            _nexus_keycode_encoder_write_digits(
+                &keys[1],
+                message->check,
+                NEXUS_KEYCODE_PRO_FULL_CHECK_CHARACTER_COUNT);
+            frame->length =
+                (uint8_t)(1 + NEXUS_KEYCODE_PRO_FULL_CHECK_CHARACTER_COUNT);
+            break;
+    }
+}
+
+uint32_t nexus_keycode_encoder_full_encode_batch(
+    const nexus_keycode_encoder_t* encoder,
+    const struct nexus_keycode_pro_full_message* messages,
+    uint32_t count,
+    struct nexus_keycode_frame* frames)
+{
+    struct nexus_keycode_pro_full_message
+        normalized[NEXUS_CHECK_BATCH_MAX_COUNT];
+    bool encodable[NEXUS_CHECK_BATCH_MAX_COUNT];
+    struct nexus_check_keyed_state states[NEXUS_CHECK_BATCH_MAX_COUNT];
+    uint8_t checked_bytes[NEXUS_CHECK_BATCH_MAX_COUNT]
+                         [NEXUS_KEYCODE_PRO_FULL_CHECKED_BYTES];
+    // seeded as in `nexus_check_compute_pseudorandom_bytes`
+    uint8_t prng_seeds[NEXUS_CHECK_BATCH_MAX_COUNT][1 + sizeof(uint32_t)];
+    struct nexus_check_value values[NEXUS_CHECK_BATCH_MAX_COUNT];
+    uint32_t encoded_count = 0;
+
+    for (uint32_t start = 0; start < count;
+         start += NEXUS_CHECK_BATCH_MAX_COUNT)
+    {
+        const uint8_t batch_count =
+            (uint8_t)(count - start < NEXUS_CHECK_BATCH_MAX_COUNT ?
+                          count - start :
+                          NEXUS_CHECK_BATCH_MAX_COUNT);
+
+        for (uint8_t i = 0; i < batch_count; ++i)
+        {
+            encodable[i] = _nexus_keycode_encoder_full_normalize(
+                &messages[start + i], &normalized[i]);
+            // same keys as `nexus_keycode_pro_full_apply`
+            states[i] = normalized[i].type_code <
+                                (uint8_t)
+                                    NEXUS_KEYCODE_PRO_FULL_FACTORY_ALLOW_TEST ?
+                            encoder->secret_key_state :
+                            encoder->fixed_00_key_state;
+            (void) memcpy(
+                checked_bytes[i], &normalized[i], sizeof(checked_bytes[i]));
+        }
+
+        nexus_check_compute_batch(states,
+                                  false,
+                                  checked_bytes,
+                                  sizeof(checked_bytes[0]),
+                                  batch_count,
+                                  values);
+
+        for (uint8_t i = 0; i < batch_count; ++i)
+        {
+            const uint32_t check =
+                _nexus_keycode_pro_full_check_from_value(&values[i]);
+            normalized[i].check = check;
+            prng_seeds[i][0] = 0x00;
+            (void) memcpy(&prng_seeds[i][1], &check, sizeof(check));
+        }
+
+        // pseudorandom bytes to interleave activation messages
+        nexus_check_compute_batch(&encoder->fixed_00_key_state,
+                                  true,
+                                  prng_seeds,
+                                  sizeof(prng_seeds[0]),
+                                  batch_count,
+                                  values);
+
+        for (uint8_t i = 0; i < batch_count; ++i)
+        {
+            struct nexus_keycode_frame* frame = &frames[start + i];
+            (void) memset(frame, 0x00, sizeof(*frame));
+            if (encodable[i])
+            {
+                _nexus_keycode_encoder_full_write_frame(
+                    &normalized[i], values[i].bytes, frame);
+                ++encoded_count;
+            }
+        }
+    }
+    return encoded_count;
+}
+
+/* Copy the fields of `message` which are transmitted in a small protocol
+ * keycode into `normalized`, as `nexus_keycode_pro_small_parse` would
+ * populate them.
+ *
+ * \return false if `message` cannot be encoded
+ */
+static bool _nexus_keycode_encoder_small_normalize(
+    const struct nexus_keycode_pro_small_message* message,
+    struct nexus_keycode_pro_small_message* normalized)
+{
+    (void) memset(normalized, 0x00, sizeof(*normalized));
+    normalized->type_code = message->type_code;
+    normalized->body = message->body;
+
+    switch (message->type_code)
+    {
+        case NEXUS_KEYCODE_PRO_SMALL_ACTIVATION_ADD_CREDIT_TYPE:
+        // intentional fallthrough
+        case NEXUS_KEYCODE_PRO_SMALL_ACTIVATION_SET_CREDIT_TYPE:
+            normalized->full_message_id = message->full_message_id;
+            return true;
+
+        case NEXUS_KEYCODE_PRO_SMALL_MAINTENANCE_OR_TEST_TYPE:
+            // full message ID is not inferred for maintenance and test
+            normalized->full_message_id = message->full_message_id & 0x3F;
+            return true;
+
+        default:
+            // passthrough
+            return false;
+    }
+}
+
+uint32_t nexus_keycode_encoder_small_encode_batch(
+    const nexus_keycode_encoder_t* encoder,
+    const char* alphabet,
+    const struct nexus_keycode_pro_small_message* messages,
+    uint32_t count,
+    struct nexus_keycode_frame* frames)
+{
+    struct nexus_keycode_pro_small_message
+        normalized[NEXUS_CHECK_BATCH_MAX_COUNT];
+    bool encodable[NEXUS_CHECK_BATCH_MAX_COUNT];
+    struct nexus_check_keyed_state states[NEXUS_CHECK_BATCH_MAX_COUNT];
+    uint8_t checked_bytes[NEXUS_CHECK_BATCH_MAX_COUNT]
+                         [sizeof(struct nexus_keycode_pro_small_message) -
+                          sizeof(uint16_t)];
+    // seeded as in `nexus_check_compute_pseudorandom_bytes`
+    uint8_t prng_seeds[NEXUS_CHECK_BATCH_MAX_COUNT][1 + sizeof(uint16_t)];
+    struct nexus_check_value values[NEXUS_CHECK_BATCH_MAX_COUNT];
+    uint32_t encoded_count = 0;
+
+    for (uint32_t start = 0; start < count;
+         start += NEXUS_CHECK_BATCH_MAX_COUNT)
+    {
+        const uint8_t batch_count =
+            (uint8_t)(count - start < NEXUS_CHECK_BATCH_MAX_COUNT ?
+                          count - start :
+                          NEXUS_CHECK_BATCH_MAX_COUNT);
+
+        for (uint8_t i = 0; i < batch_count; ++i)
+        {
+            encodable[i] = _nexus_keycode_encoder_small_normalize(
+                &messages[start + i], &normalized[i]);
+            // same keys as `nexus_keycode_pro_small_apply`
+            const bool is_test =
+                normalized[i].type_code ==
+                    (uint8_t)
+                        NEXUS_KEYCODE_PRO_SMALL_MAINTENANCE_OR_TEST_TYPE &&
+                normalized[i].body.maintenance_test.function_id <=
+                    NEXUS_KEYCODE_PRO_SMALL_MAX_TEST_FUNCTION_ID;
+            states[i] = is_test ? encoder->fixed_ff_key_state :
+                                  encoder->secret_key_state;
+            (void) memcpy(
+                checked_bytes[i], &normalized[i], sizeof(checked_bytes[i]));
+        }
+
+        nexus_check_compute_batch(states,
+                                  false,
+                                  checked_bytes,
+                                  sizeof(checked_bytes[0]),
+                                  batch_count,
+                                  values);
+
+        for (uint8_t i = 0; i < batch_count; ++i)
+        {
+            normalized[i].check =
+                _nexus_keycode_pro_small_check_from_value(&values[i]);
+            // check is big-endian in the PRNG seed
+            prng_seeds[i][0] = 0x00;
+            prng_seeds[i][1] = (uint8_t)(normalized[i].check >> 8);
+            prng_seeds[i][2] = (uint8_t)(normalized[i].check & 0xFF);
+        }
+
+        // pseudorandom bytes to obfuscate the message (not check) bits
+        nexus_check_compute_batch(&encoder->fixed_00_key_state,
+                                  true,
+                                  prng_seeds,
+                                  sizeof(prng_seeds[0]),
+                                  batch_count,
+                                  values);
+
+        for (uint8_t i = 0; i < batch_count; ++i)
+        {
+            struct nexus_keycode_frame* frame = &frames[start + i];
+            (void) memset(frame, 0x00, sizeof(*frame));
+            if (!encodable[i])
+            {
+                continue;
+            }
+
+            // 6-bit message ID, 2-bit type and 8-bit body, obfuscated,
+            // followed by the 12-bit check
+            const uint8_t header =
+                (uint8_t)(((normalized[i].full_message_id & 0x3F) << 2) |
+                          (normalized[i].type_code & 0x03));
+            const uint32_t bits =
+                ((uint32_t)(header ^ values[i].bytes[0]) << 20) |
+                ((uint32_t)(normalized[i].body.activation.increment_id ^
+                            values[i].bytes[1])
+                 << 12) |
+                normalized[i].check;
+
+            // each key conveys 2 bits, most significant first
+            for (uint8_t j = 0;
+                 j < NEXUS_KEYCODE_MESSAGE_LENGTH_MAX_DIGITS_SMALL;
+                 ++j)
+            {
+                const uint8_t keys_after =
+                    (uint8_t)(NEXUS_KEYCODE_MESSAGE_LENGTH_MAX_DIGITS_SMALL -
+                              1 - j);
+                frame->keys[j] = alphabet[(bits >> (2 * keys_after)) & 0x03];
+            }
+            frame->length = NEXUS_KEYCODE_MESSAGE_LENGTH_MAX_DIGITS_SMALL;
+            ++encoded_count;
+        }
+    }
+    return encoded_count;
 }
 
 uint32_t nexus_keycode_pro_get_current_pd_index(void)
@@ -1652,10 +2291,30 @@ uint32_t nexus_keycode_pro_get_current_pd_index(void)
     return _nexus_keycode_stored.code_counts.pd_index;
 }
 
-NEXUS_IMPL_STATIC bool
-nexus_keycode_pro_is_message_id_within_window(const uint16_t full_message_id)
+// Receipt window of the stored keycode state of this device
+static struct nexus_keycode_pro_receipt _nexus_keycode_pro_stored_receipt(void)
+{
+    struct nexus_keycode_pro_receipt receipt = {
+        _nexus_keycode_stored.code_counts.pd_index,
+        _nexus_keycode_stored.flags_0_23.received_flags};
+    return receipt;
+}
+
+// Write `receipt` back to the stored keycode state (does not write NV)
+static void _nexus_keycode_pro_store_receipt(
+    const struct nexus_keycode_pro_receipt* receipt)
+{
+    NEXUS_ASSERT(receipt->received_flags ==
+                     _nexus_keycode_stored.flags_0_23.received_flags,
+                 "Receipt window is not the stored window");
+    _nexus_keycode_stored.code_counts.pd_index = receipt->pd_index;
+}
+
+static bool _nexus_keycode_pro_receipt_id_within_window(
+    const struct nexus_keycode_pro_receipt* receipt,
+    const uint16_t full_message_id)
 {
-    const uint32_t cur_pd = nexus_keycode_pro_get_current_pd_index();
+    const uint32_t cur_pd = receipt->pd_index;
 
     const bool in_window =
         ((cur_pd - NEXUS_KEYCODE_PRO_RECEIVE_WINDOW_BEFORE_PD <=
@@ -1666,20 +2325,22 @@ nexus_keycode_pro_is_message_id_within_window(const uint16_t full_message_id)
     return in_window;
 }
 
-NEXUS_IMPL_STATIC bool
-nexus_keycode_pro_mask_idx_from_message_id(const uint16_t full_message_id,
-                                           uint8_t* mask_id_index)
+static bool _nexus_keycode_pro_receipt_mask_idx(
+    const struct nexus_keycode_pro_receipt* receipt,
+    const uint16_t full_message_id,
+    uint8_t* mask_id_index)
 {
     // if a message ID is outside the window; we know nothing about it.
     // We assume it is 'not set'.
-    if (!nexus_keycode_pro_is_message_id_within_window(full_message_id))
+    if (!_nexus_keycode_pro_receipt_id_within_window(receipt,
+                                                     full_message_id))
     {
         return false;
     }
     // otherwise, value is in the current window.
     else
     {
-        const uint32_t cur_pd = nexus_keycode_pro_get_current_pd_index();
+        const uint32_t cur_pd = receipt->pd_index;
 
         if (cur_pd >= full_message_id)
         {
@@ -1698,14 +2359,70 @@ nexus_keycode_pro_mask_idx_from_message_id(const uint16_t full_message_id,
     }
 }
 
-// If in the future any other method updates PAYG credit in a manner that
-// should 'invalidate' certain message IDs (preventing previously generated
-// keycodes from being entered), this function should be called to update
-// the window and mask as well.
-NEXUS_IMPL_STATIC bool nexus_keycode_pro_update_window_and_message_mask_id(
-    const uint16_t full_message_id, uint8_t* mask_id_index)
+static bool _nexus_keycode_pro_receipt_get_flag(
+    const struct nexus_keycode_pro_receipt* receipt,
+    const uint16_t full_message_id)
+{
+    uint8_t mask_id_index = 0; // should never apply this default value.
+
+    if (full_message_id > receipt->pd_index)
+    {
+        return false;
+    }
+
+    // based on the current Pd value; determine if this is set
+    if (!_nexus_keycode_pro_receipt_mask_idx(
+            receipt, full_message_id, &mask_id_index))
+    {
+        return false;
+    }
+
+    struct nexus_bitset received_ids;
+    nexus_bitset_init(&received_ids,
+                      receipt->received_flags,
+                      NEXUS_KEYCODE_PRO_MAX_MESSAGE_ID_BYTE);
+    return nexus_bitset_contains(&received_ids, mask_id_index);
+}
+
+static void _nexus_keycode_pro_receipt_shift_right(
+    struct nexus_keycode_pro_receipt* receipt,
+    const uint32_t pd_increment)
+{
+    // increased pd by more than lower window size, clear mask.
+    // Warning: pd_increment is assumed to be valid (not too large)
+    if (pd_increment > NEXUS_KEYCODE_PRO_RECEIVE_WINDOW_BEFORE_PD)
+    {
+        _nexus_keycode_pro_receipt_wipe_flags(receipt);
+    }
+    else
+    {
+        // only use flags 0-23 inclusive.
+        struct nexus_bitset received_ids;
+        nexus_bitset_init(&received_ids,
+                          receipt->received_flags,
+                          NEXUS_KEYCODE_PRO_MAX_MESSAGE_ID_BYTE);
+
+        /* E.g. Pd=23, pd_increment = 2 (final Pd = 25)
+         * Entire window will shift to the right by 2.
+         *
+         * So, we want to keep all IDs in the lower portion of the window
+         * starting at the leftmost position in the current window + the
+         * pd_increment, moved down by pd_increment. Everything to the left
+         * of this is 'lost' when we move the window.
+         */
+        nexus_bitset_shift_down(&received_ids, (uint16_t) pd_increment);
+    }
+
+    // Update our current Pd after updating the window/mask.
+    receipt->pd_index += pd_increment;
+}
+
+static bool _nexus_keycode_pro_receipt_update_window(
+    struct nexus_keycode_pro_receipt* receipt,
+    const uint16_t full_message_id,
+    uint8_t* mask_id_index)
 {
-    const uint32_t cur_pd = nexus_keycode_pro_get_current_pd_index();
+    const uint32_t cur_pd = receipt->pd_index;
     bool pd_increased = false;
 
     /* RECEIVE_WINDOW_BEFORE_PD is also the index value of 'Pd' in the window.
@@ -1723,7 +2440,7 @@ NEXUS_IMPL_STATIC bool nexus_keycode_pro_update_window_and_message_mask_id(
         const uint32_t pd_increment = full_message_id - cur_pd;
         pd_increased = true;
 
-        nexus_keycode_pro_increase_pd_and_shift_window_right(pd_increment);
+        _nexus_keycode_pro_receipt_shift_right(receipt, pd_increment);
     }
     // full message is below PD but in the window; return its index.
     else if (full_message_id >=
@@ -1750,85 +2467,39 @@ NEXUS_IMPL_STATIC bool nexus_keycode_pro_update_window_and_message_mask_id(
     return pd_increased;
 }
 
-/**
- * \param full_message_id integer value of message id to check
- * IFF message_id is valid, returns value of message_id bit in the bitmask
- */
-bool nexus_keycode_pro_get_full_message_id_flag(const uint16_t full_message_id)
+// Returns true if the flag was not already set
+static bool
+_nexus_keycode_pro_receipt_set_flag(struct nexus_keycode_pro_receipt* receipt,
+                                    const uint16_t full_message_id)
 {
-    (void) nexus_nv_read(NX_NV_BLOCK_KEYCODE_PRO,
-                         (uint8_t*) &_nexus_keycode_stored);
-
-    uint8_t mask_id_index = 0; // should never apply this default value.
-    struct nexus_bitset received_ids;
-    bool return_val = false;
-
-    if (full_message_id > nexus_keycode_pro_get_current_pd_index())
+    if (_nexus_keycode_pro_receipt_get_flag(receipt, full_message_id))
     {
         return false;
     }
 
-    // based on the current Pd value; determine if this is set
-    else
-    {
-        const bool mask_id_valid = nexus_keycode_pro_mask_idx_from_message_id(
-            full_message_id, &mask_id_index);
-        if (mask_id_valid)
-        {
-            nexus_bitset_init(&received_ids,
-                              _nexus_keycode_stored.flags_0_23.received_flags,
-                              sizeof(_nexus_keycode_stored));
-
-            return_val = nexus_bitset_contains(&received_ids, mask_id_index);
-        }
-    }
-    return return_val;
-}
-
-/* INTERNAL */
-static void _update_keycode_pro_nv_blocks(void)
-{
-    (void) nexus_nv_update(NX_NV_BLOCK_KEYCODE_PRO,
-                           (uint8_t*) &_nexus_keycode_stored);
-}
-
-/**
- * \param full_message_id integer value of message id to set
- */
-void nexus_keycode_pro_set_full_message_id_flag(const uint16_t full_message_id)
-{
-    // return if the bit is already set (don't waste an NVWrite)
-    // also implicitly reads latest message_ids from NVRAM
-    if (!nexus_keycode_pro_get_full_message_id_flag(full_message_id))
-    {
-        // this should always be overwritten.
-        uint8_t mask_id_index = 0;
-
-        struct nexus_bitset received_ids;
-        nexus_bitset_init(&received_ids,
-                          _nexus_keycode_stored.flags_0_23.received_flags,
-                          NEXUS_KEYCODE_PRO_MAX_MESSAGE_ID_BYTE);
-
-        (void) nexus_keycode_pro_update_window_and_message_mask_id(
-            full_message_id, &mask_id_index);
+    // this should always be overwritten.
+    uint8_t mask_id_index = 0;
+    (void) _nexus_keycode_pro_receipt_update_window(
+        receipt, full_message_id, &mask_id_index);
 
-        // mark the message as now applied
-        nexus_bitset_add(&received_ids, mask_id_index);
-        // nexus_bitset_remove(&received_ids, message_id);
-
-        _update_keycode_pro_nv_blocks();
-    }
+    // mark the message as now applied
+    struct nexus_bitset received_ids;
+    nexus_bitset_init(&received_ids,
+                      receipt->received_flags,
+                      NEXUS_KEYCODE_PRO_MAX_MESSAGE_ID_BYTE);
+    nexus_bitset_add(&received_ids, mask_id_index);
+    return true;
 }
 
-/**
- * \param full_message_id id below which all received flags will be set.
- */
-void nexus_keycode_pro_mask_below_message_id(const uint16_t full_message_id)
+// Returns true if any flags below `full_message_id` were masked
+static bool
+_nexus_keycode_pro_receipt_mask_below(struct nexus_keycode_pro_receipt* receipt,
+                                      const uint16_t full_message_id)
 {
     // do not attempt to mask below full message ID 0.
     if (full_message_id == 0)
     {
-        return;
+        return false;
     }
 
     const uint16_t max_full_id_to_mask = (uint16_t)(full_message_id - 1);
@@ -1840,43 +2511,35 @@ void nexus_keycode_pro_mask_below_message_id(const uint16_t full_message_id)
         "NEXUS_KEYCODE_PRO_RECEIVE_WINDOW_BEFORE_PD too large!");
 
     // don't mask anything -- full_message_id is invalid/below window.
-    if (full_message_id < nexus_keycode_pro_get_current_pd_index() -
-                              NEXUS_KEYCODE_PRO_RECEIVE_WINDOW_BEFORE_PD)
+    if (full_message_id <
+        receipt->pd_index - NEXUS_KEYCODE_PRO_RECEIVE_WINDOW_BEFORE_PD)
     {
-        return;
+        return false;
     }
 
     // update the window to ensure that Pd is >= the max ID to mask
-    (void) nexus_keycode_pro_update_window_and_message_mask_id(
-        max_full_id_to_mask, &mask_id_index);
+    (void) _nexus_keycode_pro_receipt_update_window(
+        receipt, max_full_id_to_mask, &mask_id_index);
 
     // otherwise, mask all masks up to and including the 'max_full_id_to_mask'.
     struct nexus_bitset received_ids;
     nexus_bitset_init(&received_ids,
-                      _nexus_keycode_stored.flags_0_23.received_flags,
+                      receipt->received_flags,
                       NEXUS_KEYCODE_PRO_MAX_MESSAGE_ID_BYTE);
 
     for (uint8_t i = 0; i <= mask_id_index; i++)
     {
         nexus_bitset_add(&received_ids, i);
     }
-
-    _update_keycode_pro_nv_blocks();
-}
-
-void nexus_keycode_pro_reset_pd_index(void)
-{
-    // reset PD back to initial value.
-    _nexus_keycode_stored.code_counts.pd_index =
-        NEXUS_KEYCODE_PRO_RECEIVE_WINDOW_BEFORE_PD;
+    return true;
 }
 
-// Wrapper to wipe all message IDs (zero'd)
-void nexus_keycode_pro_wipe_message_ids_in_window(void)
+static void _nexus_keycode_pro_receipt_wipe_flags(
+    struct nexus_keycode_pro_receipt* receipt)
 {
     struct nexus_bitset received_ids;
     nexus_bitset_init(&received_ids,
-                      _nexus_keycode_stored.flags_0_23.received_flags,
+                      receipt->received_flags,
                       NEXUS_KEYCODE_PRO_MAX_MESSAGE_ID_BYTE);
     nexus_bitset_clear(&received_ids);
 
@@ -1884,7 +2547,125 @@ void nexus_keycode_pro_wipe_message_ids_in_window(void)
                             NEXUS_KEYCODE_PRO_RECEIVE_WINDOW_BEFORE_PD + 1,
                         "NEXUS_KEYCODE_PRO_MAX_MESSAGE_ID_BYTE does not align "
                         "with WINDOW_BEFORE_PD!");
+}
+
+// Reset the receipt window to its factory default position and flags
+static void
+_nexus_keycode_pro_receipt_reset(struct nexus_keycode_pro_receipt* receipt)
+{
+    receipt->pd_index = NEXUS_KEYCODE_PRO_RECEIVE_WINDOW_BEFORE_PD;
+    _nexus_keycode_pro_receipt_wipe_flags(receipt);
+}
+
+    #ifdef NEXUS_INTERNAL_IMPL_NON_STATIC
+// only used in unit tests
+NEXUS_IMPL_STATIC bool
+nexus_keycode_pro_is_message_id_within_window(const uint16_t full_message_id)
+{
+    const struct nexus_keycode_pro_receipt receipt =
+        _nexus_keycode_pro_stored_receipt();
+    return _nexus_keycode_pro_receipt_id_within_window(&receipt,
+                                                       full_message_id);
+}
+
+// only used in unit tests
+NEXUS_IMPL_STATIC bool
+nexus_keycode_pro_mask_idx_from_message_id(const uint16_t full_message_id,
+                                           uint8_t* mask_id_index)
+{
+    const struct nexus_keycode_pro_receipt receipt =
+        _nexus_keycode_pro_stored_receipt();
+    return _nexus_keycode_pro_receipt_mask_idx(
+        &receipt, full_message_id, mask_id_index);
+}
+
+// If in the future any other method updates PAYG credit in a manner that
+// should 'invalidate' certain message IDs (preventing previously generated
+// keycodes from being entered), this function should be called to update
+// the window and mask as well.
+NEXUS_IMPL_STATIC bool nexus_keycode_pro_update_window_and_message_mask_id(
+    const uint16_t full_message_id, uint8_t* mask_id_index)
+{
+    struct nexus_keycode_pro_receipt receipt =
+        _nexus_keycode_pro_stored_receipt();
+    const bool pd_increased = _nexus_keycode_pro_receipt_update_window(
+        &receipt, full_message_id, mask_id_index);
+    if (pd_increased)
+    {
+        _nexus_keycode_pro_store_receipt(&receipt);
+        _update_keycode_pro_nv_blocks();
+    }
+    return pd_increased;
+}
+    #endif /* NEXUS_INTERNAL_IMPL_NON_STATIC */
 
+/**
+ * \param full_message_id integer value of message id to check
+ * IFF message_id is valid, returns value of message_id bit in the bitmask
+ */
+bool nexus_keycode_pro_get_full_message_id_flag(const uint16_t full_message_id)
+{
+    (void) nexus_nv_read(NX_NV_BLOCK_KEYCODE_PRO,
+                         (uint8_t*) &_nexus_keycode_stored);
+
+    const struct nexus_keycode_pro_receipt receipt =
+        _nexus_keycode_pro_stored_receipt();
+    return _nexus_keycode_pro_receipt_get_flag(&receipt, full_message_id);
+}
+
+/* INTERNAL */
+static void _update_keycode_pro_nv_blocks(void)
+{
+    (void) nexus_nv_update(NX_NV_BLOCK_KEYCODE_PRO,
+                           (uint8_t*) &_nexus_keycode_stored);
+}
+
+/**
+ * \param full_message_id integer value of message id to set
+ */
+void nexus_keycode_pro_set_full_message_id_flag(const uint16_t full_message_id)
+{
+    // also reads latest message_ids from NVRAM
+    (void) nexus_nv_read(NX_NV_BLOCK_KEYCODE_PRO,
+                         (uint8_t*) &_nexus_keycode_stored);
+
+    struct nexus_keycode_pro_receipt receipt =
+        _nexus_keycode_pro_stored_receipt();
+    // don't waste an NV write if the bit is already set
+    if (_nexus_keycode_pro_receipt_set_flag(&receipt, full_message_id))
+    {
+        _nexus_keycode_pro_store_receipt(&receipt);
+        _update_keycode_pro_nv_blocks();
+    }
+}
+
+/**
+ * \param full_message_id id below which all received flags will be set.
+ */
+void nexus_keycode_pro_mask_below_message_id(const uint16_t full_message_id)
+{
+    struct nexus_keycode_pro_receipt receipt =
+        _nexus_keycode_pro_stored_receipt();
+    if (_nexus_keycode_pro_receipt_mask_below(&receipt, full_message_id))
+    {
+        _nexus_keycode_pro_store_receipt(&receipt);
+        _update_keycode_pro_nv_blocks();
+    }
+}
+
+void nexus_keycode_pro_reset_pd_index(void)
+{
+    // reset PD back to initial value.
+    _nexus_keycode_stored.code_counts.pd_index =
+        NEXUS_KEYCODE_PRO_RECEIVE_WINDOW_BEFORE_PD;
+}
+
+// Wrapper to wipe all message IDs (zero'd)
+void nexus_keycode_pro_wipe_message_ids_in_window(void)
+{
+    struct nexus_keycode_pro_receipt receipt =
+        _nexus_keycode_pro_stored_receipt();
+    _nexus_keycode_pro_receipt_wipe_flags(&receipt);
     _update_keycode_pro_nv_blocks();
 }
 
@@ -33,6 +33,9 @@ extern "C" {
     #define NEXUS_KEYCODE_PRO_RECEIVE_WINDOW_BEFORE_PD 23
     #define NEXUS_KEYCODE_PRO_RECEIVE_WINDOW_AFTER_PD 40
 
+    // Bytes of received message ID flags (Pd and the IDs before it)
+    #define NEXUS_KEYCODE_PRO_MAX_MESSAGE_ID_BYTE 3
+
 //
 // Common to both protocol variants
 //
@@ -162,9 +165,6 @@ nexus_keycode_pro_infer_full_message_id(const uint8_t compressed_message_id,
                                         const uint8_t valid_id_count_below,
                                         const uint8_t valid_id_count_above);
 
-void nexus_keycode_pro_increase_pd_and_shift_window_right(
-    const uint32_t pd_increment);
-
 enum nexus_keycode_pro_response nexus_keycode_pro_small_apply(
     const struct nexus_keycode_pro_small_message* message);
 
@@ -279,6 +279,168 @@ bool nexus_keycode_pro_full_parse(
  */
 uint32_t nexus_keycode_pro_get_current_pd_index(void);
 
+//
+// FULL-KEYPAD PROTOCOL VERIFIER
+//
+
+// Credit change requested of the product by an applied keycode
+enum nexus_keycode_verifier_credit_action
+{
+    NEXUS_KEYCODE_VERIFIER_CREDIT_ACTION_NONE = 0,
+    NEXUS_KEYCODE_VERIFIER_CREDIT_ACTION_ADD = 1,
+    NEXUS_KEYCODE_VERIFIER_CREDIT_ACTION_SET = 2,
+    NEXUS_KEYCODE_VERIFIER_CREDIT_ACTION_UNLOCK = 3,
+};
+
+/* Keycode receipt state of a single device.
+ *
+ * Holds everything required to verify a full protocol keycode for one
+ * device, so that keycodes may be verified outside of the device (for
+ * example, by a server checking keycodes for many devices concurrently).
+ *
+ * Verifiers are independent of each other and of the keycode state of this
+ * module; no `nxp_*` functions are called while verifying.
+ */
+typedef struct nexus_keycode_verifier_t
+{
+    struct nx_common_check_key secret_key;
+    uint32_t user_facing_id;
+    uint32_t pd_index;
+    uint8_t received_flags[NEXUS_KEYCODE_PRO_MAX_MESSAGE_ID_BYTE];
+} nexus_keycode_verifier_t;
+
+/* Outcome of verifying a keycode against a `nexus_keycode_verifier_t`.
+ *
+ * `pd_index` and `received_flags` hold the receipt window of the device
+ * after the keycode is applied (unchanged if the keycode is invalid or a
+ * duplicate).
+ */
+typedef struct nexus_keycode_verifier_result_t
+{
+    enum nexus_keycode_pro_response response;
+    struct nexus_keycode_pro_full_message message;
+    enum nexus_keycode_verifier_credit_action credit_action;
+    uint32_t credit_seconds;
+    uint32_t pd_index;
+    uint8_t received_flags[NEXUS_KEYCODE_PRO_MAX_MESSAGE_ID_BYTE];
+} nexus_keycode_verifier_result_t;
+
+/* Initialize a verifier with the keycode state of a device.
+ *
+ * `pd_index` and `received_flags` are the receipt window of the device, as
+ * returned in a previous `nexus_keycode_verifier_result_t` (or
+ * `NEXUS_KEYCODE_PRO_RECEIVE_WINDOW_BEFORE_PD` and all-zero flags for a
+ * device which has not received any keycodes).
+ *
+ * \param verifier verifier to initialize
+ * \param secret_key secret key of the device
+ * \param user_facing_id user facing ID of the device
+ * \param pd_index current "Pd" index of the device
+ * \param received_flags `NEXUS_KEYCODE_PRO_MAX_MESSAGE_ID_BYTE` flag bytes
+ */
+void nexus_keycode_verifier_init(nexus_keycode_verifier_t* verifier,
+                                 const struct nx_common_check_key* secret_key,
+                                 uint32_t user_facing_id,
+                                 uint32_t pd_index,
+                                 const uint8_t* received_flags);
+
+/* Verify a full protocol keycode without applying it.
+ *
+ * Parses `frame`, infers its full message ID from the verifier receipt
+ * window, checks its MAC and determines the response and state change that
+ * `nexus_keycode_pro_full_parse_and_apply` would produce on the device.
+ *
+ * Outcomes which depend on the PAYG state of the device (credit added to an
+ * unlocked unit, test codes on an enabled unit, QC code limits) are not
+ * known to the verifier; `credit_action` is reported as requested by the
+ * keycode, and the caller applies its own PAYG state. Passthrough commands
+ * are not interpreted, and result in `NEXUS_KEYCODE_PRO_RESPONSE_NONE`.
+ *
+ * Only reads `verifier`, so a single verifier may be used from multiple
+ * threads at once.
+ *
+ * \param verifier keycode state of the device entering the keycode
+ * \param frame keycode digits, excluding start and end characters
+ * \param result outcome of applying the keycode
+ * \return response the device would display for this keycode
+ */
+enum nexus_keycode_pro_response
+nexus_keycode_verifier_verify(const nexus_keycode_verifier_t* verifier,
+                              const struct nexus_keycode_frame* frame,
+                              nexus_keycode_verifier_result_t* result);
+
+//
+// KEYCODE ENCODER
+//
+
+/* Keyed state used to generate keycodes for a single device.
+ *
+ * Key setup for the device secret key and the fixed keys used by both
+ * protocols is performed once in `nexus_keycode_encoder_init`, and reused
+ * for every keycode generated. An encoder is never modified after
+ * initialization, so it may be shared across threads.
+ *
+ * Derived from secret key material; clear it when no longer needed.
+ */
+typedef struct nexus_keycode_encoder_t
+{
+    struct nexus_check_keyed_state secret_key_state;
+    struct nexus_check_keyed_state fixed_00_key_state;
+    struct nexus_check_keyed_state fixed_ff_key_state;
+} nexus_keycode_encoder_t;
+
+/* Initialize an encoder for the device with secret key `secret_key`.
+ *
+ * \param encoder encoder to initialize
+ * \param secret_key secret key of the device
+ */
+void nexus_keycode_encoder_init(nexus_keycode_encoder_t* encoder,
+                                const struct nx_common_check_key* secret_key);
+
+/* Generate full protocol keycodes.
+ *
+ * Each message is encoded to the keys (excluding start and end
+ * characters) which `nexus_keycode_pro_full_parse` parses back to the same
+ * message. The `check` field of each message is ignored and computed by
+ * the encoder, as are fields which are not part of the keycode for the
+ * message type (such as the message ID of factory messages). Only the 6
+ * least significant bits of the message ID are transmitted in activation
+ * keycodes, so the ID must be within the receipt window of the device.
+ *
+ * Messages which cannot be encoded (passthrough or reserved type codes, or
+ * bodies too large for their digits) produce a zero-length frame.
+ *
+ * \param encoder encoder initialized with the device key
+ * \param messages `count` messages to encode
+ * \param count number of messages to encode
+ * \param frames `count` frames to populate with the keycode for each message
+ * \return number of messages successfully encoded
+ */
+uint32_t nexus_keycode_encoder_full_encode_batch(
+    const nexus_keycode_encoder_t* encoder,
+    const struct nexus_keycode_pro_full_message* messages,
+    uint32_t count,
+    struct nexus_keycode_frame* frames);
+
+/* Generate small protocol keycodes.
+ *
+ * As `nexus_keycode_encoder_full_encode_batch`, for messages parsed by
+ * `nexus_keycode_pro_small_parse`. Passthrough messages cannot be encoded.
+ *
+ * \param encoder encoder initialized with the device key
+ * \param alphabet 4-character keycode alphabet of the device
+ * \param messages `count` messages to encode
+ * \param count number of messages to encode
+ * \param frames `count` frames to populate with the keycode for each message
+ * \return number of messages successfully encoded
+ */
+uint32_t nexus_keycode_encoder_small_encode_batch(
+    const nexus_keycode_encoder_t* encoder,
+    const char* alphabet,
+    const struct nexus_keycode_pro_small_message* messages,
+    uint32_t count,
+    struct nexus_keycode_frame* frames);
+
     #ifdef NEXUS_INTERNAL_IMPL_NON_STATIC
 uint32_t nexus_keycode_pro_full_check_field_from_frame(
     const struct nexus_keycode_frame* frame);
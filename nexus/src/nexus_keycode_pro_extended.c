@@ -13,8 +13,10 @@
 #if NEXUS_KEYCODE_ENABLED
     #include "include/nxp_keycode.h"
     #include "src/nexus_keycode_pro.h"
+    #include "src/nexus_security.h"
 
-    #define NEXUS_KEYCODE_EXTENDED_COMPUTE_BYTES_MAX_SIZE 10
+    // message ID (4), type code (1), increment ID (1), truncated ID (1)
+    #define NEXUS_KEYCODE_EXTENDED_SET_CREDIT_AUTH_BYTES 7
 
 bool nexus_keycode_pro_extended_small_parse(
     struct nexus_bitstream* command_bitstream,
@@ -62,34 +64,31 @@ bool nexus_keycode_pro_extended_small_parse(
     return true;
 }
 
-static uint16_t _nexus_keycode_pro_extended_small_auth_arbitrary_bytes(
-    const uint8_t* bytes,
-    uint8_t bytes_count,
-    const struct nx_common_check_key* key)
+// obtain upper 12 bits of check
+static uint16_t _nexus_keycode_pro_extended_small_truncate_check(
+    const struct nexus_check_value* check_val)
 {
-    const struct nexus_check_value check_val =
-        nexus_check_compute(key, bytes, bytes_count);
-
-    // obtain upper 12 bits of check
-    const uint16_t upper_check =
-        (uint16_t)(nexus_check_value_as_uint64(&check_val) >> 52);
-
-    return upper_check;
+    return (uint16_t)(nexus_check_value_as_uint64(check_val) >> 52);
 }
 
-NEXUS_IMPL_STATIC bool
-_nexus_keycode_pro_extended_small_message_infer_inner_compute_auth(
+// Populates `compute_bytes` with the bytes authenticated for `message`,
+// using `message->inferred_message_id` as the message ID. Returns the number
+// of bytes populated, or 0 if the message type is not supported.
+static uint8_t _nexus_keycode_pro_extended_small_message_auth_bytes(
     const struct nexus_keycode_pro_extended_small_message* const message,
-    const struct nx_common_check_key* const secret_key)
+    uint8_t* compute_bytes)
 {
-    uint8_t compute_bytes[NEXUS_KEYCODE_EXTENDED_COMPUTE_BYTES_MAX_SIZE] = {0};
-    bool success = false;
-    uint16_t computed_check;
+    // no other types are currently handled - just set credit + wipe flag
+    if (message->type_code !=
+        NEXUS_KEYCODE_PRO_EXTENDED_SMALL_TYPE_SET_CREDIT_AND_WIPE_FLAG)
+    {
+        return 0;
+    }
 
     // first 4 bytes are the command ID for all message types
     const uint32_t inferred_message_id =
         nexus_endian_htole32(message->inferred_message_id);
-    memcpy(&compute_bytes, &inferred_message_id, 4);
+    memcpy(compute_bytes, &inferred_message_id, 4);
 
     NEXUS_ASSERT(sizeof(message->inferred_message_id) == 4,
                  "Invalid command ID size");
@@ -97,47 +96,26 @@ _nexus_keycode_pro_extended_small_message_infer_inner_compute_auth(
     // 5th byte is just the type code
     compute_bytes[4] = (uint8_t) message->type_code;
 
-    uint8_t bytes_count = 5;
-
-    // no other types are currently handled - just set credit + wipe flag
-    if (message->type_code ==
-        NEXUS_KEYCODE_PRO_EXTENDED_SMALL_TYPE_SET_CREDIT_AND_WIPE_FLAG)
-    {
-        // 10 bits packed as little-endian at encoder.
-        // 8 leftmost bits = increment ID
-        // remaining 8 bits = 'truncated message ID' (6 bits are always 0 here)
-        compute_bytes[5] = message->body.set_credit_wipe_flag.increment_id;
-        compute_bytes[6] =
-            message->body.set_credit_wipe_flag.truncated_message_id;
-
-        NEXUS_STATIC_ASSERT(
-            sizeof(
-                ((struct
-                  nexus_keycode_pro_extended_small_message_body_set_credit_wipe_flag*) 0)
-                    ->truncated_message_id) == 1,
-            "Unexpected struct size for truncated_message_id");
-        NEXUS_STATIC_ASSERT(
-            sizeof(
-                ((struct
-                  nexus_keycode_pro_extended_small_message_body_set_credit_wipe_flag*) 0)
-                    ->increment_id) == 1,
-            "Unexpected struct size for increment_id");
-
-        bytes_count = bytes_count + 2;
-
-        computed_check = _nexus_keycode_pro_extended_small_auth_arbitrary_bytes(
-            compute_bytes, bytes_count, secret_key);
-
-        if (computed_check == message->check)
-        {
-            success = true;
-        }
-    }
-    // sanity check for tests
-    NEXUS_ASSERT(bytes_count <= NEXUS_KEYCODE_EXTENDED_COMPUTE_BYTES_MAX_SIZE,
-                 "too many bytes to auth!");
-
-    return success;
+    // 10 bits packed as little-endian at encoder.
+    // 8 leftmost bits = increment ID
+    // remaining 8 bits = 'truncated message ID' (6 bits are always 0 here)
+    compute_bytes[5] = message->body.set_credit_wipe_flag.increment_id;
+    compute_bytes[6] = message->body.set_credit_wipe_flag.truncated_message_id;
+
+    NEXUS_STATIC_ASSERT(
+        sizeof(
+            ((struct
+              nexus_keycode_pro_extended_small_message_body_set_credit_wipe_flag*) 0)
+                ->truncated_message_id) == 1,
+        "Unexpected struct size for truncated_message_id");
+    NEXUS_STATIC_ASSERT(
+        sizeof(
+            ((struct
+              nexus_keycode_pro_extended_small_message_body_set_credit_wipe_flag*) 0)
+                ->increment_id) == 1,
+        "Unexpected struct size for increment_id");
+
+    return NEXUS_KEYCODE_EXTENDED_SET_CREDIT_AUTH_BYTES;
 }
 
 NEXUS_IMPL_STATIC bool
@@ -149,12 +127,11 @@ nexus_keycode_pro_extended_small_infer_windowed_message_id(
     NEXUS_ASSERT(window->center_index - window->flags_below <=
                      window->center_index + window->flags_above,
                  "No IDs to check/validate against");
-    bool validated = false;
 
     // start counting from lowest possible message ID in the window
-    message->inferred_message_id = window->center_index - window->flags_below;
-    NEXUS_ASSERT(nexus_util_window_id_within_window(
-                     window, message->inferred_message_id),
+    uint32_t candidate_id = window->center_index - window->flags_below;
+    message->inferred_message_id = candidate_id;
+    NEXUS_ASSERT(nexus_util_window_id_within_window(window, candidate_id),
                  "Bottom of window is outside of window - unexpected.");
 
     if (message->type_code !=
@@ -165,34 +142,85 @@ nexus_keycode_pro_extended_small_infer_windowed_message_id(
         return false;
     }
 
+    // All candidates share the same key and differ only in message ID, so
+    // compute the authentication bytes once and then compute checks for
+    // several candidate IDs at a time.
+    uint8_t template_bytes[NEXUS_KEYCODE_EXTENDED_SET_CREDIT_AUTH_BYTES];
+    (void) _nexus_keycode_pro_extended_small_message_auth_bytes(
+        message, template_bytes);
+
+    struct nexus_check_keyed_state key_state;
+    nexus_check_keyed_state_init(&key_state, secret_key);
+
+    uint32_t candidate_ids[NEXUS_CHECK_BATCH_MAX_COUNT];
+    uint8_t candidate_bytes[NEXUS_CHECK_BATCH_MAX_COUNT]
+                           [NEXUS_KEYCODE_EXTENDED_SET_CREDIT_AUTH_BYTES];
+    struct nexus_check_value checks[NEXUS_CHECK_BATCH_MAX_COUNT];
+
     // loop through all possible command IDs in the window
-    while (nexus_util_window_id_within_window(window,
-                                              message->inferred_message_id))
+    while (nexus_util_window_id_within_window(window, candidate_id))
     {
-        // only compare IDs where the least significant 2 bits match the
-        // received truncated message ID
-        if ((message->inferred_message_id & 0x03) ==
-            message->body.set_credit_wipe_flag.truncated_message_id)
+        uint8_t candidate_count = 0;
+
+        while (candidate_count < NEXUS_CHECK_BATCH_MAX_COUNT &&
+               nexus_util_window_id_within_window(window, candidate_id))
         {
+            // skip straight over IDs which are already set
+            candidate_id =
+                nexus_util_window_next_unset_id(window, candidate_id);
+            if (!nexus_util_window_id_within_window(window, candidate_id))
+            {
+                break;
+            }
 
-            // only examine IDs that aren't already set
+            // only compare IDs where the least significant 2 bits match the
+            // received truncated message ID.
             // Note: We can't disambiguate easily between 'duplicate' and
             // 'valid' keycodes in this approach, unlike regular set credit
             // keycodes.
-            if (!nexus_util_window_id_flag_already_set(
-                    window, message->inferred_message_id) &&
-                (_nexus_keycode_pro_extended_small_message_infer_inner_compute_auth(
-                    message, secret_key)))
+            if ((candidate_id & 0x03) ==
+                message->body.set_credit_wipe_flag.truncated_message_id)
             {
-                validated = true;
-                // don't increment computed command ID any longer
-                break;
+                const uint32_t candidate_id_le =
+                    nexus_endian_htole32(candidate_id);
+                memcpy(candidate_bytes[candidate_count],
+                       template_bytes,
+                       sizeof(template_bytes));
+                memcpy(candidate_bytes[candidate_count], &candidate_id_le, 4);
+                candidate_ids[candidate_count] = candidate_id;
+                candidate_count++;
+            }
+            candidate_id++;
+        }
+
+        if (candidate_count == 0)
+        {
+            break;
+        }
+
+        nexus_check_compute_batch(&key_state,
+                                  true,
+                                  candidate_bytes,
+                                  sizeof(candidate_bytes[0]),
+                                  candidate_count,
+                                  checks);
+
+        for (uint8_t i = 0; i < candidate_count; i++)
+        {
+            if (_nexus_keycode_pro_extended_small_truncate_check(&checks[i]) ==
+                message->check)
+            {
+                message->inferred_message_id = candidate_ids[i];
+                nexus_secure_memclr(
+                    &key_state, sizeof(key_state), sizeof(key_state));
+                return true;
             }
         }
-        message->inferred_message_id++;
     }
 
-    return validated;
+    nexus_secure_memclr(&key_state, sizeof(key_state), sizeof(key_state));
+    message->inferred_message_id = candidate_id;
+    return false;
 }
 
 enum nexus_keycode_pro_response nexus_keycode_pro_extended_small_apply(
@@ -106,10 +106,6 @@ bool nexus_keycode_pro_extended_small_infer_windowed_message_id(
     struct nexus_keycode_pro_extended_small_message* message,
     const struct nexus_window* window,
     const struct nx_common_check_key* secret_key);
-
-bool _nexus_keycode_pro_extended_small_message_infer_inner_compute_auth(
-    const struct nexus_keycode_pro_extended_small_message* const message,
-    const struct nx_common_check_key* const secret_key);
     #endif // NEXUS_INTERNAL_IMPL_NON_STATIC
 
 #endif /* NEXUS_KEYCODE_ENABLED */
@@ -13,6 +13,11 @@
 #include "src/internal_keycode_config.h"
 #include "utils/crc_ccitt.h"
 
+#if NEXUS_NV_CACHE_ENABLED
+    #include "src/nexus_common_internal.h"
+    #include "src/nexus_util.h"
+#endif
+
 #include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
@@ -49,17 +54,94 @@ struct nx_common_nv_block_meta NX_NV_BLOCK_CHANNEL_LM_LINK_10 = {
 #endif /* if NEXUS_CHANNEL_LINK_SECURITY_ENABLED */
 // blocks 4-20 reserved for link related NV
 
+#if NEXUS_NV_CACHE_ENABLED || NEXUS_NV_TRANSACTIONS_ENABLED
+    #if NEXUS_CHANNEL_LINK_SECURITY_ENABLED &&                                 \
+        defined(CONFIG_NEXUS_CHANNEL_LARGE_LINK_TABLE_ENABLED)
+        // blocks 0-3. Link pages are not cached and are not part of
+        // transactions.
+        #define NEXUS_NV_BLOCK_COUNT 4
+    #elif NEXUS_CHANNEL_LINK_SECURITY_ENABLED
+        // blocks 0-3, followed by one block per link
+        #define NEXUS_NV_BLOCK_COUNT                                           \
+            (4 + CONFIG_NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS)
+    #else
+        #define NEXUS_NV_BLOCK_COUNT 2
+    #endif
+#endif
+
+#if NEXUS_NV_CACHE_ENABLED
+enum nexus_nv_cache_state
+{
+    // block has not been read from NV yet
+    NEXUS_NV_CACHE_STATE_UNKNOWN = 0,
+    // NV does not contain a valid copy of the block
+    NEXUS_NV_CACHE_STATE_ABSENT,
+    // cached block is identical to the block in NV
+    NEXUS_NV_CACHE_STATE_CLEAN,
+    // cached block has been updated, but not yet written to NV
+    NEXUS_NV_CACHE_STATE_DIRTY,
+};
+
+// RAM copy of a full block, including block ID and CRC
+struct nexus_nv_cache_slot
+{
+    uint8_t block[NX_COMMON_NV_MAX_BLOCK_LENGTH];
+    uint32_t dirty_since; // uptime of the oldest update not yet written
+    uint8_t length;
+    uint8_t state; // `enum nexus_nv_cache_state`
+};
+
+// One slot per block ID
+static struct
+{
+    struct nexus_nv_cache_slot slots[NEXUS_NV_BLOCK_COUNT];
+} _this_cache;
+#endif /* if NEXUS_NV_CACHE_ENABLED */
+
+#if NEXUS_NV_TRANSACTIONS_ENABLED
+// Commit blocks are written alternately, so that the previous commit block
+// remains valid if writing the next one is interrupted
+static const struct nx_common_nv_block_meta _NEXUS_NV_COMMIT_BLOCKS[2] = {
+    {.block_id = 21, .length = NX_COMMON_NV_BLOCK_21_LENGTH},
+    {.block_id = 22, .length = NX_COMMON_NV_BLOCK_22_LENGTH},
+};
+
+// Inner data of a commit block
+struct nexus_nv_commit_record
+{
+    uint32_t generation; // incremented by each commit
+    uint32_t copy_b_mask; // bit `n` is set if copy B of block `n` is current
+};
+
+static struct
+{
+    struct nexus_nv_commit_record commit; // latest commit in NV
+    bool commit_loaded;
+    uint8_t depth; // number of open (nested) transactions
+    uint32_t staged_mask; // bit `n` is set if block `n` has a staged update
+    uint8_t staged_length[NEXUS_NV_BLOCK_COUNT];
+    uint8_t staged[NEXUS_NV_BLOCK_COUNT][NX_COMMON_NV_MAX_BLOCK_LENGTH];
+} _this_transaction;
+
+NEXUS_STATIC_ASSERT(NEXUS_NV_BLOCK_COUNT <= 21,
+                    "Nexus NV blocks overlap commit blocks");
+NEXUS_STATIC_ASSERT(NX_COMMON_NV_BLOCK_COPY_B_ID_OFFSET > 22,
+                    "Copy B of Nexus NV blocks overlaps commit blocks");
+NEXUS_STATIC_ASSERT(sizeof(struct nexus_nv_commit_record) ==
+                        NX_COMMON_NV_BLOCK_21_LENGTH -
+                            NEXUS_NV_BLOCK_WRAPPER_SIZE_BYTES,
+                    "Commit record does not match commit block length");
+#endif /* if NEXUS_NV_TRANSACTIONS_ENABLED */
+
 // Used internally to compute CRC given a pointer to start of a full block
 uint16_t nexus_nv_compute_crc(const struct nx_common_nv_block_meta block_meta,
                               uint8_t* const full_block_data)
 {
     NEXUS_ASSERT(block_meta.length > NEXUS_NV_BLOCK_CRC_WIDTH,
                  "Invalid NV block length");
-    NEXUS_ASSERT(block_meta.length - NEXUS_NV_BLOCK_CRC_WIDTH < UINT8_MAX,
-                 "Cannot compute CRC longer over more than 255 bytes");
     return compute_crc_ccitt(
         full_block_data,
-        (uint8_t)(block_meta.length - NEXUS_NV_BLOCK_CRC_WIDTH));
+        (size_t)(block_meta.length - NEXUS_NV_BLOCK_CRC_WIDTH));
 }
 
 bool nx_common_nv_block_valid(const struct nx_common_nv_block_meta block_meta,
@@ -89,64 +171,606 @@ bool nx_common_nv_block_valid(const struct nx_common_nv_block_meta block_meta,
     return true;
 }
 
+// Compute the CRC of a block from its block ID and inner data, which need
+// not be contiguous
+static uint16_t
+_nexus_nv_block_crc(const struct nx_common_nv_block_meta block_meta,
+                    const uint8_t* inner_data)
+{
+    uint16_t crc = crc_ccitt_begin();
+    crc = crc_ccitt_update(
+        crc, &block_meta.block_id, (size_t) NEXUS_NV_BLOCK_ID_WIDTH);
+    crc = crc_ccitt_update(
+        crc,
+        inner_data,
+        (size_t)(block_meta.length - NEXUS_NV_BLOCK_WRAPPER_SIZE_BYTES));
+    return crc_ccitt_finish(crc);
+}
+
+#if NEXUS_NV_CACHE_ENABLED || !NEXUS_NV_WRITE_V_ENABLED
+// Build a full block (block ID, inner data, CRC) into `block`
+static void
+_nexus_nv_build_block(const struct nx_common_nv_block_meta block_meta,
+                      const uint8_t* inner_data,
+                      uint8_t* block)
+{
+    const uint32_t inner_data_size =
+        (uint32_t)(block_meta.length - NEXUS_NV_BLOCK_WRAPPER_SIZE_BYTES);
+    NEXUS_ASSERT(inner_data_size < NX_COMMON_NV_MAX_BLOCK_LENGTH,
+                 "Invalid new block inner data size!");
+
+    memcpy(block, &block_meta.block_id, NEXUS_NV_BLOCK_ID_WIDTH);
+    memcpy(block + NEXUS_NV_BLOCK_ID_WIDTH, inner_data, inner_data_size);
+
+    // append the CRC, over the contents of the block ID and inner data
+    const uint16_t new_crc = _nexus_nv_block_crc(block_meta, inner_data);
+
+    memcpy(block + NEXUS_NV_BLOCK_ID_WIDTH + inner_data_size,
+           &new_crc,
+           NEXUS_NV_BLOCK_CRC_WIDTH);
+}
+#endif
+
+// Read the inner data of a block stored in NV under `stored_meta`
+static bool
+_nexus_nv_read_stored(const struct nx_common_nv_block_meta stored_meta,
+                      uint8_t* inner_data)
+{
+    uint8_t block[NX_COMMON_NV_MAX_BLOCK_LENGTH] = {0};
+
+    nxp_common_nv_read(stored_meta, block);
+    if (nx_common_nv_block_valid(stored_meta, block))
+    {
+        // Copy only the 'inner data', skip the CRC and block ID
+        memcpy(
+            inner_data,
+            block + NEXUS_NV_BLOCK_ID_WIDTH,
+            (uint8_t)(stored_meta.length - NEXUS_NV_BLOCK_WRAPPER_SIZE_BYTES));
+        return true;
+    }
+    return false;
+}
+
+// Write a new block to NV under `stored_meta`
+static bool
+_nexus_nv_write_stored(const struct nx_common_nv_block_meta stored_meta,
+                       const uint8_t* inner_data)
+{
+#if NEXUS_NV_WRITE_V_ENABLED
+    // write the block ID, inner data, and CRC of the new "NX NV Block"
+    // directly, without copying them into a full block
+    const uint16_t new_crc = _nexus_nv_block_crc(stored_meta, inner_data);
+    const struct nx_common_nv_write_segment segments[3] = {
+        {.data = &stored_meta.block_id, .length = NEXUS_NV_BLOCK_ID_WIDTH},
+        {.data = inner_data,
+         .length = (uint8_t)(stored_meta.length -
+                             NEXUS_NV_BLOCK_WRAPPER_SIZE_BYTES)},
+        {.data = &new_crc, .length = NEXUS_NV_BLOCK_CRC_WIDTH},
+    };
+    return nxp_common_nv_write_v(stored_meta, segments, 3);
+#else
+    // compute a new valid "NX NV Block"
+    uint8_t new_block[NX_COMMON_NV_MAX_BLOCK_LENGTH] = {0};
+    _nexus_nv_build_block(stored_meta, inner_data, new_block);
+
+    return nxp_common_nv_write(stored_meta, new_block);
+#endif
+}
+
+#if NEXUS_NV_TRANSACTIONS_ENABLED
+// Read the latest valid commit block from NV, unless already read
+static void _nexus_nv_commit_load(void)
+{
+    if (_this_transaction.commit_loaded)
+    {
+        return;
+    }
+
+    // Without any valid commit block, copy A of every block is current
+    // (as it is for NV written before transactions were enabled)
+    memset(&_this_transaction.commit, 0x00, sizeof(_this_transaction.commit));
+    for (uint8_t i = 0; i < 2; i++)
+    {
+        struct nexus_nv_commit_record record;
+        if (_nexus_nv_read_stored(_NEXUS_NV_COMMIT_BLOCKS[i],
+                                  (uint8_t*) &record) &&
+            record.generation > _this_transaction.commit.generation)
+        {
+            _this_transaction.commit = record;
+        }
+    }
+    _this_transaction.commit_loaded = true;
+}
+#endif /* if NEXUS_NV_TRANSACTIONS_ENABLED */
+
+// Return the metadata under which the current data of a block is stored
+static struct nx_common_nv_block_meta
+_nexus_nv_current_copy(struct nx_common_nv_block_meta block_meta)
+{
+#if NEXUS_NV_TRANSACTIONS_ENABLED
+    _nexus_nv_commit_load();
+    if (block_meta.block_id < NEXUS_NV_BLOCK_COUNT &&
+        ((_this_transaction.commit.copy_b_mask >> block_meta.block_id) & 1u))
+    {
+        block_meta.block_id = (uint16_t)(block_meta.block_id +
+                                         NX_COMMON_NV_BLOCK_COPY_B_ID_OFFSET);
+    }
+#endif
+    return block_meta;
+}
+
+#if NEXUS_NV_TRANSACTIONS_ENABLED
+/* Write new inner data for each block in `block_mask`, such that after a
+ * power loss either all or none of these blocks are updated in NV.
+ *
+ * New data is written to the copy of each block which is *not* current,
+ * and a new commit block then makes those copies current. A single block
+ * is written in place, as it would be outside of a transaction.
+ */
+static bool _nexus_nv_write_atomic(uint32_t block_mask,
+                                   const uint8_t* const inner_data[],
+                                   const uint8_t lengths[])
+{
+    if (block_mask == 0)
+    {
+        return true;
+    }
+
+    _nexus_nv_commit_load();
+    struct nexus_nv_commit_record next = _this_transaction.commit;
+    next.generation++;
+    const bool single_block = (block_mask & (block_mask - 1)) == 0;
+
+    for (uint16_t i = 0; i < NEXUS_NV_BLOCK_COUNT; i++)
+    {
+        if (((block_mask >> i) & 1u) == 0)
+        {
+            continue;
+        }
+        const struct nx_common_nv_block_meta block_meta = {.block_id = i,
+                                                           .length =
+                                                               lengths[i]};
+        if (single_block)
+        {
+            return _nexus_nv_write_stored(_nexus_nv_current_copy(block_meta),
+                                          inner_data[i]);
+        }
+
+        struct nx_common_nv_block_meta target = block_meta;
+        if (((next.copy_b_mask >> i) & 1u) == 0)
+        {
+            target.block_id =
+                (uint16_t)(i + NX_COMMON_NV_BLOCK_COPY_B_ID_OFFSET);
+        }
+        if (!_nexus_nv_write_stored(target, inner_data[i]))
+        {
+            // current copies are untouched
+            return false;
+        }
+        next.copy_b_mask ^= (uint32_t)(1u << i);
+    }
+
+    // Writing the commit block is the only step which changes the current
+    // copy of any block, so an interrupted commit leaves all blocks unchanged
+    if (!_nexus_nv_write_stored(_NEXUS_NV_COMMIT_BLOCKS[next.generation % 2],
+                                (const uint8_t*) &next))
+    {
+        // NV may or may not contain the new commit block; read it again
+        _this_transaction.commit_loaded = false;
+        return false;
+    }
+    _this_transaction.commit = next;
+    return true;
+}
+#endif /* if NEXUS_NV_TRANSACTIONS_ENABLED */
+
+#if NEXUS_NV_CACHE_ENABLED
+/* Return the cache slot for `block_meta`, reading the block from NV if this
+ * is the first time it is accessed. Returns NULL for blocks which are not
+ * cached.
+ */
+static struct nexus_nv_cache_slot*
+_nexus_nv_cache_slot(const struct nx_common_nv_block_meta block_meta)
+{
+    if (block_meta.block_id >= NEXUS_NV_BLOCK_COUNT ||
+        block_meta.length > NX_COMMON_NV_MAX_BLOCK_LENGTH)
+    {
+        return NULL;
+    }
+
+    struct nexus_nv_cache_slot* slot = &_this_cache.slots[block_meta.block_id];
+    if (slot->state == NEXUS_NV_CACHE_STATE_UNKNOWN)
+    {
+        const struct nx_common_nv_block_meta stored_meta =
+            _nexus_nv_current_copy(block_meta);
+        memset(slot->block, 0x00, sizeof(slot->block));
+        slot->length = block_meta.length;
+        (void) nxp_common_nv_read(stored_meta, slot->block);
+        if (nx_common_nv_block_valid(stored_meta, slot->block))
+        {
+            slot->state = NEXUS_NV_CACHE_STATE_CLEAN;
+        }
+        else
+        {
+            slot->state = NEXUS_NV_CACHE_STATE_ABSENT;
+        }
+    }
+    return slot;
+}
+
+/* Return true if updates to `block_id` must be written to NV immediately.
+ *
+ * Message ID receipt flags (keycode, origin command and link handshake) and
+ * Nexus Channel link nonces must never be lost on power loss, or a received
+ * keycode or command could be accepted again, or a link nonce reused. Only
+ * the keycode rate limiting state (MAS block) may be written later.
+ */
+static bool _nexus_nv_cache_write_through(uint16_t block_id)
+{
+    return block_id != NX_NV_BLOCK_KEYCODE_MAS.block_id;
+}
+
+// Update the cached copy of a block, to be written to NV later
+static void
+_nexus_nv_cache_update(struct nexus_nv_cache_slot* slot,
+                       const struct nx_common_nv_block_meta block_meta,
+                       const uint8_t* inner_data)
+{
+    if (slot->state != NEXUS_NV_CACHE_STATE_ABSENT &&
+        memcmp(slot->block + NEXUS_NV_BLOCK_ID_WIDTH,
+               inner_data,
+               (uint8_t)(block_meta.length -
+                         NEXUS_NV_BLOCK_WRAPPER_SIZE_BYTES)) == 0)
+    {
+        // cached block is already up to date
+        return;
+    }
+
+    _nexus_nv_build_block(block_meta, inner_data, slot->block);
+    slot->length = block_meta.length;
+    if (slot->state != NEXUS_NV_CACHE_STATE_DIRTY)
+    {
+        // Later updates within the flush delay are written together
+        slot->state = NEXUS_NV_CACHE_STATE_DIRTY;
+        slot->dirty_since = nexus_common_uptime();
+        nxp_common_request_processing();
+    }
+}
+
+    #if !NEXUS_NV_TRANSACTIONS_ENABLED
+// Write a dirty slot to NV; it remains dirty if the write fails
+static bool _nexus_nv_cache_write_slot(uint16_t block_id,
+                                       struct nexus_nv_cache_slot* slot)
+{
+    const struct nx_common_nv_block_meta block_meta = {
+        .block_id = block_id, .length = slot->length};
+        #if NEXUS_NV_WRITE_V_ENABLED
+    const struct nx_common_nv_write_segment segment = {
+        .data = slot->block, .length = slot->length};
+    if (nxp_common_nv_write_v(block_meta, &segment, 1))
+        #else
+    if (nxp_common_nv_write(block_meta, slot->block))
+        #endif
+    {
+        slot->state = NEXUS_NV_CACHE_STATE_CLEAN;
+        return true;
+    }
+    return false;
+}
+    #endif
+
+// Write all dirty slots to NV; slots which fail to write remain dirty
+static bool _nexus_nv_cache_write_dirty(void)
+{
+    #if NEXUS_NV_TRANSACTIONS_ENABLED
+    // Blocks updated by the same transaction may be dirty together, so all
+    // dirty blocks are written as one atomic update
+    uint32_t block_mask = 0;
+    const uint8_t* inner_data[NEXUS_NV_BLOCK_COUNT];
+    uint8_t lengths[NEXUS_NV_BLOCK_COUNT];
+    for (uint16_t i = 0; i < NEXUS_NV_BLOCK_COUNT; i++)
+    {
+        struct nexus_nv_cache_slot* slot = &_this_cache.slots[i];
+        inner_data[i] = slot->block + NEXUS_NV_BLOCK_ID_WIDTH;
+        lengths[i] = slot->length;
+        if (slot->state == NEXUS_NV_CACHE_STATE_DIRTY)
+        {
+            block_mask |= (uint32_t)(1u << i);
+        }
+    }
+    if (!_nexus_nv_write_atomic(block_mask, inner_data, lengths))
+    {
+        return false;
+    }
+    for (uint16_t i = 0; i < NEXUS_NV_BLOCK_COUNT; i++)
+    {
+        if ((block_mask >> i) & 1u)
+        {
+            _this_cache.slots[i].state = NEXUS_NV_CACHE_STATE_CLEAN;
+        }
+    }
+    return true;
+    #else
+    bool all_written = true;
+    for (uint16_t i = 0; i < NEXUS_NV_BLOCK_COUNT; i++)
+    {
+        struct nexus_nv_cache_slot* slot = &_this_cache.slots[i];
+        if (slot->state == NEXUS_NV_CACHE_STATE_DIRTY &&
+            !_nexus_nv_cache_write_slot(i, slot))
+        {
+            all_written = false;
+        }
+    }
+    return all_written;
+    #endif
+}
+
+uint32_t nexus_nv_cache_process(void)
+{
+    const uint32_t now = nexus_common_uptime();
+    uint32_t min_sleep = UINT32_MAX;
+    bool retry = false;
+
+    #if NEXUS_NV_TRANSACTIONS_ENABLED
+    // All dirty blocks are written together, once any of them is due
+    bool due = false;
+    for (uint16_t i = 0; i < NEXUS_NV_BLOCK_COUNT; i++)
+    {
+        const struct nexus_nv_cache_slot* slot = &_this_cache.slots[i];
+        if (slot->state != NEXUS_NV_CACHE_STATE_DIRTY)
+        {
+            continue;
+        }
+
+        const uint32_t dirty_seconds = now - slot->dirty_since;
+        if (dirty_seconds < NEXUS_NV_CACHE_FLUSH_DELAY_SECONDS)
+        {
+            min_sleep = u32min(
+                min_sleep, NEXUS_NV_CACHE_FLUSH_DELAY_SECONDS - dirty_seconds);
+        }
+        else
+        {
+            due = true;
+        }
+    }
+    if (due)
+    {
+        min_sleep = UINT32_MAX;
+        if (!_nexus_nv_cache_write_dirty())
+        {
+            for (uint16_t i = 0; i < NEXUS_NV_BLOCK_COUNT; i++)
+            {
+                _this_cache.slots[i].dirty_since = now;
+            }
+            retry = true;
+        }
+    }
+    #else
+    for (uint16_t i = 0; i < NEXUS_NV_BLOCK_COUNT; i++)
+    {
+        struct nexus_nv_cache_slot* slot = &_this_cache.slots[i];
+        if (slot->state != NEXUS_NV_CACHE_STATE_DIRTY)
+        {
+            continue;
+        }
+
+        const uint32_t dirty_seconds = now - slot->dirty_since;
+        if (dirty_seconds < NEXUS_NV_CACHE_FLUSH_DELAY_SECONDS)
+        {
+            min_sleep = u32min(
+                min_sleep, NEXUS_NV_CACHE_FLUSH_DELAY_SECONDS - dirty_seconds);
+        }
+        else if (!_nexus_nv_cache_write_slot(i, slot))
+        {
+            slot->dirty_since = now;
+            retry = true;
+        }
+    }
+    #endif
+
+    if (retry)
+    {
+        // try again after another delay, but never immediately
+        min_sleep = u32min(min_sleep,
+                           NEXUS_NV_CACHE_FLUSH_DELAY_SECONDS > 0 ?
+                               NEXUS_NV_CACHE_FLUSH_DELAY_SECONDS :
+                               1);
+    }
+    return min_sleep;
+}
+
+bool nexus_nv_cache_flush(void)
+{
+    return _nexus_nv_cache_write_dirty();
+}
+#endif /* if NEXUS_NV_CACHE_ENABLED */
+
+#if NEXUS_NV_CACHE_ENABLED || NEXUS_NV_TRANSACTIONS_ENABLED
+void nexus_nv_init(void)
+{
+    #if NEXUS_NV_CACHE_ENABLED
+    memset(&_this_cache, 0x00, sizeof(_this_cache));
+    #endif
+    #if NEXUS_NV_TRANSACTIONS_ENABLED
+    memset(&_this_transaction, 0x00, sizeof(_this_transaction));
+    #endif
+}
+#endif
+
+#if NEXUS_NV_TRANSACTIONS_ENABLED
+void nexus_nv_transaction_begin(void)
+{
+    NEXUS_ASSERT(_this_transaction.depth < UINT8_MAX,
+                 "Too many nested NV transactions");
+    _this_transaction.depth++;
+}
+
+bool nexus_nv_transaction_commit(void)
+{
+    NEXUS_ASSERT(_this_transaction.depth > 0, "No NV transaction to commit");
+    if (_this_transaction.depth == 0)
+    {
+        return false;
+    }
+    _this_transaction.depth--;
+    if (_this_transaction.depth > 0)
+    {
+        // updates are committed by the outermost transaction
+        return true;
+    }
+
+    const uint32_t staged_mask = _this_transaction.staged_mask;
+    _this_transaction.staged_mask = 0;
+
+    #if NEXUS_NV_CACHE_ENABLED
+    // staged blocks become dirty together, and are written together
+    bool write_through = false;
+    for (uint16_t i = 0; i < NEXUS_NV_BLOCK_COUNT; i++)
+    {
+        if ((staged_mask >> i) & 1u)
+        {
+            const struct nx_common_nv_block_meta block_meta = {
+                .block_id = i, .length = _this_transaction.staged_length[i]};
+            struct nexus_nv_cache_slot* slot =
+                _nexus_nv_cache_slot(block_meta);
+            _nexus_nv_cache_update(
+                slot, block_meta, _this_transaction.staged[i]);
+            if (slot->state == NEXUS_NV_CACHE_STATE_DIRTY &&
+                _nexus_nv_cache_write_through(i))
+            {
+                write_through = true;
+            }
+        }
+    }
+    if (write_through)
+    {
+        // write the transaction (and any other dirty blocks) atomically now
+        return _nexus_nv_cache_write_dirty();
+    }
+    return true;
+    #else
+    // only write blocks which differ from NV
+    uint32_t changed_mask = 0;
+    const uint8_t* inner_data[NEXUS_NV_BLOCK_COUNT];
+    for (uint16_t i = 0; i < NEXUS_NV_BLOCK_COUNT; i++)
+    {
+        inner_data[i] = _this_transaction.staged[i];
+        if (((staged_mask >> i) & 1u) == 0)
+        {
+            continue;
+        }
+
+        const struct nx_common_nv_block_meta block_meta = {
+            .block_id = i, .length = _this_transaction.staged_length[i]};
+        uint8_t existing[NX_COMMON_NV_MAX_BLOCK_LENGTH];
+        if (!_nexus_nv_read_stored(_nexus_nv_current_copy(block_meta),
+                                   existing) ||
+            memcmp(existing,
+                   _this_transaction.staged[i],
+                   (uint8_t)(block_meta.length -
+                             NEXUS_NV_BLOCK_WRAPPER_SIZE_BYTES)) != 0)
+        {
+            changed_mask |= (uint32_t)(1u << i);
+        }
+    }
+    return _nexus_nv_write_atomic(
+        changed_mask, inner_data, _this_transaction.staged_length);
+    #endif
+}
+#endif /* if NEXUS_NV_TRANSACTIONS_ENABLED */
+
 bool nexus_nv_update(const struct nx_common_nv_block_meta block_meta,
                      uint8_t* inner_data)
 {
+    const uint8_t inner_data_size =
+        (uint8_t)(block_meta.length - NEXUS_NV_BLOCK_WRAPPER_SIZE_BYTES);
+
+#if NEXUS_NV_TRANSACTIONS_ENABLED
+    if (_this_transaction.depth > 0 &&
+        block_meta.block_id < NEXUS_NV_BLOCK_COUNT)
+    {
+        // written by `nexus_nv_transaction_commit`, with any other updates
+        memcpy(_this_transaction.staged[block_meta.block_id],
+               inner_data,
+               inner_data_size);
+        _this_transaction.staged_length[block_meta.block_id] =
+            (uint8_t) block_meta.length;
+        _this_transaction.staged_mask |= (uint32_t)(1u << block_meta.block_id);
+        return true;
+    }
+#endif
+
+#if NEXUS_NV_CACHE_ENABLED
+    struct nexus_nv_cache_slot* slot = _nexus_nv_cache_slot(block_meta);
+    if (slot != NULL)
+    {
+        _nexus_nv_cache_update(slot, block_meta, inner_data);
+        if (slot->state == NEXUS_NV_CACHE_STATE_DIRTY &&
+            _nexus_nv_cache_write_through(block_meta.block_id))
+        {
+            // failed writes remain dirty, and are retried later
+            return _nexus_nv_cache_write_dirty();
+        }
+        return true;
+    }
+#endif
+
+    const struct nx_common_nv_block_meta stored_meta =
+        _nexus_nv_current_copy(block_meta);
+
     // read existing block from NV
     uint8_t existing_block[NX_COMMON_NV_MAX_BLOCK_LENGTH] = {0};
-    if (nxp_common_nv_read(block_meta, existing_block))
+    if (nxp_common_nv_read(stored_meta, existing_block))
     {
         const uint8_t* old_inner_data =
             existing_block + NEXUS_NV_BLOCK_ID_WIDTH;
-        if (memcmp(old_inner_data,
-                   inner_data,
-                   (uint8_t)(block_meta.length -
-                             NEXUS_NV_BLOCK_WRAPPER_SIZE_BYTES)) == 0)
+        if (memcmp(old_inner_data, inner_data, inner_data_size) == 0)
         {
             // do not write if the existing NV block is identical
             return true;
         }
     }
 
-    const uint32_t inner_data_size =
-        (uint32_t)(block_meta.length - NEXUS_NV_BLOCK_WRAPPER_SIZE_BYTES);
-    NEXUS_ASSERT(inner_data_size < NX_COMMON_NV_MAX_BLOCK_LENGTH,
-                 "Invalid new block inner data size!");
-
-    // compute a new valid "NX NV Block"
-    uint8_t new_block[NX_COMMON_NV_MAX_BLOCK_LENGTH] = {0};
-    memcpy(new_block, &block_meta.block_id, NEXUS_NV_BLOCK_ID_WIDTH);
-    memcpy(new_block + NEXUS_NV_BLOCK_ID_WIDTH, inner_data, inner_data_size);
-
-    // compute and append the CRC, over the contents of the block ID and
-    // inner data
-    const uint16_t new_crc = compute_crc_ccitt(
-        new_block, (uint8_t)(block_meta.length - NEXUS_NV_BLOCK_CRC_WIDTH));
-
-    memcpy(new_block + NEXUS_NV_BLOCK_ID_WIDTH + inner_data_size,
-           &new_crc,
-           NEXUS_NV_BLOCK_CRC_WIDTH);
-
     // overwrite if the new block is valid and distinct
-    return nxp_common_nv_write(block_meta, new_block);
+    return _nexus_nv_write_stored(stored_meta, inner_data);
 }
 
 bool nexus_nv_read(const struct nx_common_nv_block_meta block_meta,
                    uint8_t* inner_data)
 {
-    uint8_t block[NX_COMMON_NV_MAX_BLOCK_LENGTH] = {0};
+#if NEXUS_NV_CACHE_ENABLED || NEXUS_NV_TRANSACTIONS_ENABLED
+    const uint8_t inner_data_size =
+        (uint8_t)(block_meta.length - NEXUS_NV_BLOCK_WRAPPER_SIZE_BYTES);
+#endif
 
-    nxp_common_nv_read(block_meta, block);
-    if (nx_common_nv_block_valid(block_meta, block))
+#if NEXUS_NV_TRANSACTIONS_ENABLED
+    if (block_meta.block_id < NEXUS_NV_BLOCK_COUNT &&
+        ((_this_transaction.staged_mask >> block_meta.block_id) & 1u))
     {
-        // Copy only the 'inner data', skip the CRC and block ID
+        // updated by the open transaction
+        memcpy(inner_data,
+               _this_transaction.staged[block_meta.block_id],
+               inner_data_size);
+        return true;
+    }
+#endif
+
+#if NEXUS_NV_CACHE_ENABLED
+    const struct nexus_nv_cache_slot* slot = _nexus_nv_cache_slot(block_meta);
+    if (slot != NULL)
+    {
+        if (slot->state == NEXUS_NV_CACHE_STATE_ABSENT)
+        {
+            return false;
+        }
         memcpy(
-            inner_data,
-            block + NEXUS_NV_BLOCK_ID_WIDTH,
-            (uint8_t)(block_meta.length - NEXUS_NV_BLOCK_WRAPPER_SIZE_BYTES));
+            inner_data, slot->block + NEXUS_NV_BLOCK_ID_WIDTH, inner_data_size);
         return true;
     }
-    return false;
+#endif
+
+    return _nexus_nv_read_stored(_nexus_nv_current_copy(block_meta),
+                                 inner_data);
 }
 
 // Internally, memory comparison to uint16_t values are performed, assuming that
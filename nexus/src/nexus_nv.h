@@ -11,6 +11,8 @@
 #ifndef NEXUS__SRC__NEXUS_NV_INTERNAL_H_
 #define NEXUS__SRC__NEXUS_NV_INTERNAL_H_
 
+#include "src/internal_common_config.h"
+
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -48,6 +50,15 @@ extern struct nx_common_nv_block_meta NX_NV_BLOCK_CHANNEL_LM_LINK_10;
  * nexus_nv_update will not trigger a write if the block to be written
  * is identical to what is already stored in NV.
  *
+ * If `NEXUS_NV_CACHE_ENABLED`, an updated keycode rate limiting (MAS) block
+ * is only stored in RAM, and written to NV later by `nexus_nv_cache_process`.
+ * In that case, a return value of true means the update was accepted by the
+ * cache. All other blocks hold message ID receipts or link nonces, and are
+ * still written before this function returns.
+ *
+ * If a transaction is open (`nexus_nv_transaction_begin`), the updated
+ * block is only staged in RAM until the transaction is committed.
+ *
  * **Note**: `inner_data` is *not* a pointer to a valid Nexus NV block! The
  * block ID and CRC are not included.
  *
@@ -76,6 +87,75 @@ bool nexus_nv_update(const struct nx_common_nv_block_meta block_meta,
 bool nexus_nv_read(const struct nx_common_nv_block_meta block_meta,
                    uint8_t* inner_data);
 
+#if NEXUS_NV_CACHE_ENABLED || NEXUS_NV_TRANSACTIONS_ENABLED
+/** (Internal) Discard all NV state held in RAM.
+ *
+ * Discards cached NV blocks and any open transaction. Subsequent reads and
+ * updates of each block will first read that block from NV. Called on
+ * `nx_common_init`, before any other Nexus module accesses NV.
+ */
+void nexus_nv_init(void);
+#endif
+
+#if NEXUS_NV_TRANSACTIONS_ENABLED
+/** (Internal) Begin a group of NV updates which must be stored atomically.
+ *
+ * Until the matching `nexus_nv_transaction_commit`, `nexus_nv_update` only
+ * stages each updated block in RAM, and `nexus_nv_read` returns staged
+ * blocks. Repeated updates of the same block are staged (and written)
+ * once.
+ *
+ * Transactions may be nested; staged blocks are written when the
+ * outermost transaction is committed.
+ */
+void nexus_nv_transaction_begin(void);
+
+/** (Internal) Store all blocks updated since `nexus_nv_transaction_begin`.
+ *
+ * Blocks identical to the data already in NV are not written. If more than
+ * one block changed, each is written to its non-current copy (A or B), and
+ * then a new commit block (with the next generation number) makes all of
+ * those copies current at once. After a power loss, either all or none
+ * of the blocks are updated.
+ *
+ * If `NEXUS_NV_CACHE_ENABLED`, the blocks are instead updated in the cache,
+ * which later writes all of its updated blocks in the same way.
+ *
+ * \return true if the updates are stored (or cached), false otherwise
+ */
+bool nexus_nv_transaction_commit(void);
+#else
+static inline void nexus_nv_transaction_begin(void)
+{
+}
+
+static inline bool nexus_nv_transaction_commit(void)
+{
+    return true;
+}
+#endif /* if NEXUS_NV_TRANSACTIONS_ENABLED */
+
+#if NEXUS_NV_CACHE_ENABLED
+
+/** (Internal) Write cached NV blocks which have been updated for long enough.
+ *
+ * A block is written once `NEXUS_NV_CACHE_FLUSH_DELAY_SECONDS` have passed
+ * since its first unwritten update. Blocks which fail to write (including
+ * blocks which failed to write immediately in `nexus_nv_update`) are retried
+ * after another delay.
+ *
+ * \return seconds until the next cached block is due to be written, or
+ * UINT32_MAX if no blocks are waiting to be written
+ */
+uint32_t nexus_nv_cache_process(void);
+
+/** (Internal) Immediately write all updated cached NV blocks.
+ *
+ * \return true if all updated blocks were written, false otherwise
+ */
+bool nexus_nv_cache_flush(void);
+#endif /* if NEXUS_NV_CACHE_ENABLED */
+
 #ifdef __cplusplus
 }
 #endif
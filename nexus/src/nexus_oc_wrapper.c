@@ -21,6 +21,7 @@
 
     #include "src/nexus_cose_mac0_sign.h"
     #include "src/nexus_cose_mac0_verify.h"
+    #include "src/nexus_security.h"
 
 // common define for the multicast OCF address
 // broadcast endpoint, not dynamically allocated
@@ -138,20 +139,12 @@ unsigned int oc_random_value(void)
     return nxp_channel_random_value();
 }
 
-nx_channel_error nx_channel_network_receive(const void* const bytes_received,
-                                            uint32_t bytes_count,
-                                            const struct nx_id* const source)
+// Allocate an incoming IoTivity message received from `source`, or return
+// NULL if no incoming message is free
+static oc_message_t*
+_nexus_oc_wrapper_allocate_received(uint32_t bytes_count,
+                                    const struct nx_id* const source)
 {
-    // return early on null or invalid bytes
-    if (bytes_received == 0 || bytes_count == 0)
-    {
-        return NX_CHANNEL_ERROR_UNSPECIFIED;
-    }
-    else if (bytes_count > NEXUS_CHANNEL_MAX_COAP_TOTAL_MESSAGE_SIZE)
-    {
-        return NX_CHANNEL_ERROR_MESSAGE_TOO_LARGE;
-    }
-
     // will be deallocated in calls initiated by `oc_network_event`
     // Note: Is *not* dynamic memory allocation. `oc_allocate_message`
     // pulls from an immutable set of bytes defined at compile time,
@@ -163,27 +156,325 @@ nx_channel_error nx_channel_network_receive(const void* const bytes_received,
     // each call.
     if (message == NULL)
     {
-        return NX_CHANNEL_ERROR_UNSPECIFIED;
+        return NULL;
     }
 
-    PRINT("nx_channel_network: Receiving %u byte message: ", bytes_count);
-    PRINTbytes(((uint8_t*) bytes_received), bytes_count);
     message->length = bytes_count;
-    memcpy(message->data, bytes_received, bytes_count);
 
     // Convert into oc_endpoint form expected by IoTivity
     oc_endpoint_t source_endpoint;
     memset(&source_endpoint, 0x00, sizeof(oc_endpoint_t));
     nexus_oc_wrapper_nx_id_to_oc_endpoint(source, &source_endpoint);
     oc_endpoint_copy(&message->endpoint, &source_endpoint);
+    return message;
+}
+
+// Copy a received message into IoTivity, to be processed and deallocated
+// during the main event loop
+static nx_channel_error
+_nexus_oc_wrapper_message_to_oc(const void* const bytes_received,
+                                uint32_t bytes_count,
+                                const struct nx_id* const source)
+{
+    oc_message_t* message =
+        _nexus_oc_wrapper_allocate_received(bytes_count, source);
+    if (message == NULL)
+    {
+        return NX_CHANNEL_ERROR_UNSPECIFIED;
+    }
+    memcpy(message->data, bytes_received, bytes_count);
 
     // Message will be processed and deallocated during main event loop
     oc_network_event(message);
+    return NX_CHANNEL_ERROR_NONE;
+}
+
+    #if NEXUS_CHANNEL_ZERO_COPY_RECEIVE_ENABLED
+// Lend a received message to IoTivity, to be processed in place. `release`
+// is called when IoTivity deallocates the message.
+static nx_channel_error
+_nexus_oc_wrapper_lent_message_to_oc(void* const bytes_received,
+                                     uint32_t bytes_count,
+                                     const struct nx_id* const source,
+                                     nx_channel_network_release_fn release)
+{
+    oc_message_t* message =
+        _nexus_oc_wrapper_allocate_received(bytes_count, source);
+    if (message == NULL)
+    {
+        return NX_CHANNEL_ERROR_UNSPECIFIED;
+    }
+    message->lent_data = (uint8_t*) bytes_received;
+    message->release = release;
+
+    // Message will be processed and deallocated during main event loop
+    oc_network_event(message);
+    return NX_CHANNEL_ERROR_NONE;
+}
+    #endif /* NEXUS_CHANNEL_ZERO_COPY_RECEIVE_ENABLED */
+
+    #if NEXUS_CHANNEL_INGRESS_RING_ENABLED
+NEXUS_STATIC_ASSERT(NEXUS_CHANNEL_MAX_COAP_TOTAL_MESSAGE_SIZE <= UINT8_MAX,
+                    "Ingress ring message length does not fit in uint8_t");
+NEXUS_STATIC_ASSERT(NEXUS_CHANNEL_INGRESS_RING_MESSAGE_COUNT <= UINT8_MAX,
+                    "Ingress ring message count does not fit in uint8_t");
+
+struct nexus_oc_wrapper_ingress_message
+{
+    struct nx_id source;
+    uint8_t length;
+    uint8_t data[NEXUS_CHANNEL_MAX_COAP_TOTAL_MESSAGE_SIZE];
+        #if NEXUS_CHANNEL_ZERO_COPY_RECEIVE_ENABLED
+    // If not NULL, the message is lent by the platform, and is not copied
+    // into `data`
+    void* lent_data;
+    nx_channel_network_release_fn release;
+        #endif
+};
+
+// Received messages not yet passed to IoTivity, oldest first
+static struct
+{
+    struct nexus_oc_wrapper_ingress_message
+        messages[NEXUS_CHANNEL_INGRESS_RING_MESSAGE_COUNT];
+    uint8_t head; // index of the oldest message
+    uint8_t count;
+} _ingress_ring;
+
+void nexus_oc_wrapper_ingress_ring_clear(void)
+{
+        #if NEXUS_CHANNEL_ZERO_COPY_RECEIVE_ENABLED
+    // return any lent messages to the platform
+    for (uint8_t i = 0; i < _ingress_ring.count; i++)
+    {
+        struct nexus_oc_wrapper_ingress_message* message =
+            &_ingress_ring.messages[(_ingress_ring.head + i) %
+                                    NEXUS_CHANNEL_INGRESS_RING_MESSAGE_COUNT];
+        if (message->lent_data != NULL)
+        {
+            message->release(message->lent_data);
+            message->lent_data = NULL;
+        }
+    }
+        #endif
+    _ingress_ring.head = 0;
+    _ingress_ring.count = 0;
+}
+
+uint8_t nexus_oc_wrapper_ingress_ring_drain(void)
+{
+    uint8_t passed_count = 0;
+    while (_ingress_ring.count > 0 && oc_buffer_incoming_free_count() > 0)
+    {
+        struct nexus_oc_wrapper_ingress_message* message =
+            &_ingress_ring.messages[_ingress_ring.head];
+        nx_channel_error result;
+        #if NEXUS_CHANNEL_ZERO_COPY_RECEIVE_ENABLED
+        if (message->lent_data != NULL)
+        {
+            result = _nexus_oc_wrapper_lent_message_to_oc(message->lent_data,
+                                                          message->length,
+                                                          &message->source,
+                                                          message->release);
+            if (result == NX_CHANNEL_ERROR_NONE)
+            {
+                // now owned by IoTivity, which releases it after processing
+                message->lent_data = NULL;
+            }
+        }
+        else
+        #endif
+        {
+            result = _nexus_oc_wrapper_message_to_oc(
+                message->data, message->length, &message->source);
+        }
+        if (result != NX_CHANNEL_ERROR_NONE)
+        {
+            break;
+        }
+        _ingress_ring.head =
+            (uint8_t)((_ingress_ring.head + 1) %
+                      NEXUS_CHANNEL_INGRESS_RING_MESSAGE_COUNT);
+        _ingress_ring.count--;
+        passed_count++;
+    }
+    return passed_count;
+}
+
+uint8_t nexus_oc_wrapper_ingress_ring_count(void)
+{
+    return _ingress_ring.count;
+}
+
+// Add a received message to the end of the ring, which must not be full
+static struct nexus_oc_wrapper_ingress_message*
+_nexus_oc_wrapper_ingress_ring_push(uint32_t bytes_count,
+                                    const struct nx_id* const source)
+{
+    NEXUS_ASSERT(_ingress_ring.count < NEXUS_CHANNEL_INGRESS_RING_MESSAGE_COUNT,
+                 "Ingress ring is full");
+    struct nexus_oc_wrapper_ingress_message* message =
+        &_ingress_ring.messages[(_ingress_ring.head + _ingress_ring.count) %
+                                NEXUS_CHANNEL_INGRESS_RING_MESSAGE_COUNT];
+    message->source = *source;
+    message->length = (uint8_t) bytes_count;
+        #if NEXUS_CHANNEL_ZERO_COPY_RECEIVE_ENABLED
+    message->lent_data = NULL;
+        #endif
+    _ingress_ring.count++;
+    return message;
+}
+    #endif /* NEXUS_CHANNEL_INGRESS_RING_ENABLED */
+
+// Check that a received message is valid, and that there is room for it
+static nx_channel_error
+_nexus_oc_wrapper_check_received(const void* const bytes_received,
+                                 uint32_t bytes_count)
+{
+    // return early on null or invalid bytes
+    if (bytes_received == 0 || bytes_count == 0)
+    {
+        return NX_CHANNEL_ERROR_UNSPECIFIED;
+    }
+    else if (bytes_count > NEXUS_CHANNEL_MAX_COAP_TOTAL_MESSAGE_SIZE)
+    {
+        return NX_CHANNEL_ERROR_MESSAGE_TOO_LARGE;
+    }
+
+    #if NEXUS_CHANNEL_INGRESS_RING_ENABLED
+    // Message will be passed to IoTivity by `nexus_channel_core_process`
+    if (_ingress_ring.count == NEXUS_CHANNEL_INGRESS_RING_MESSAGE_COUNT)
+    #else
+    // might happen if messages are received without calling
+    // `nx_common_process` between each message
+    if (oc_buffer_incoming_free_count() == 0)
+    #endif
+    {
+        return NX_CHANNEL_ERROR_UNSPECIFIED;
+    }
+
+    PRINT("nx_channel_network: Receiving %u byte message: ", bytes_count);
+    PRINTbytes(((uint8_t*) bytes_received), bytes_count);
+    return NX_CHANNEL_ERROR_NONE;
+}
+
+// Accept a single received message, without requesting processing
+static nx_channel_error
+_nexus_oc_wrapper_network_receive(const void* const bytes_received,
+                                  uint32_t bytes_count,
+                                  const struct nx_id* const source)
+{
+    const nx_channel_error result =
+        _nexus_oc_wrapper_check_received(bytes_received, bytes_count);
+    if (result != NX_CHANNEL_ERROR_NONE)
+    {
+        return result;
+    }
+
+    #if NEXUS_CHANNEL_INGRESS_RING_ENABLED
+    struct nexus_oc_wrapper_ingress_message* message =
+        _nexus_oc_wrapper_ingress_ring_push(bytes_count, source);
+    memcpy(message->data, bytes_received, bytes_count);
+    return NX_CHANNEL_ERROR_NONE;
+    #else
+    return _nexus_oc_wrapper_message_to_oc(bytes_received, bytes_count, source);
+    #endif
+}
+
+nx_channel_error nx_channel_network_receive(const void* const bytes_received,
+                                            uint32_t bytes_count,
+                                            const struct nx_id* const source)
+{
+    const nx_channel_error result =
+        _nexus_oc_wrapper_network_receive(bytes_received, bytes_count, source);
+    if (result == NX_CHANNEL_ERROR_NONE)
+    {
+        // trigger processing so that IoTivity core can receive the message
+        nxp_common_request_processing();
+    }
+    return result;
+}
+
+    #if NEXUS_CHANNEL_ZERO_COPY_RECEIVE_ENABLED
+nx_channel_error
+nx_channel_network_receive_lent(void* const bytes_received,
+                                uint32_t bytes_count,
+                                const struct nx_id* const source,
+                                nx_channel_network_release_fn release)
+{
+    if (release == NULL)
+    {
+        return NX_CHANNEL_ERROR_UNSPECIFIED;
+    }
+    nx_channel_error result =
+        _nexus_oc_wrapper_check_received(bytes_received, bytes_count);
+    if (result != NX_CHANNEL_ERROR_NONE)
+    {
+        return result;
+    }
+
+        #if NEXUS_CHANNEL_INGRESS_RING_ENABLED
+    struct nexus_oc_wrapper_ingress_message* message =
+        _nexus_oc_wrapper_ingress_ring_push(bytes_count, source);
+    message->lent_data = bytes_received;
+    message->release = release;
+        #else
+    result = _nexus_oc_wrapper_lent_message_to_oc(
+        bytes_received, bytes_count, source, release);
+    if (result != NX_CHANNEL_ERROR_NONE)
+    {
+        return result;
+    }
+        #endif
 
     // trigger processing so that IoTivity core can receive the message
     nxp_common_request_processing();
     return NX_CHANNEL_ERROR_NONE;
 }
+    #endif /* NEXUS_CHANNEL_ZERO_COPY_RECEIVE_ENABLED */
+
+nx_channel_error
+nx_channel_network_receive_batch(const struct nx_channel_network_frame* frames,
+                                 uint32_t frame_count,
+                                 uint32_t* accepted_count,
+                                 uint32_t* free_count)
+{
+    nx_channel_error result = NX_CHANNEL_ERROR_NONE;
+    uint32_t accepted = 0;
+    if (frames == NULL && frame_count > 0)
+    {
+        result = NX_CHANNEL_ERROR_UNSPECIFIED;
+    }
+    else
+    {
+        while (accepted < frame_count)
+        {
+            const struct nx_channel_network_frame* frame = &frames[accepted];
+            result = _nexus_oc_wrapper_network_receive(
+                frame->bytes_received, frame->bytes_count, &frame->source);
+            if (result != NX_CHANNEL_ERROR_NONE)
+            {
+                break;
+            }
+            accepted++;
+        }
+    }
+
+    *accepted_count = accepted;
+    #if NEXUS_CHANNEL_INGRESS_RING_ENABLED
+    *free_count = (uint32_t)(NEXUS_CHANNEL_INGRESS_RING_MESSAGE_COUNT -
+                             _ingress_ring.count);
+    #else
+    *free_count = (uint32_t) oc_buffer_incoming_free_count();
+    #endif
+
+    if (accepted > 0)
+    {
+        // trigger processing so that IoTivity core can receive the messages
+        nxp_common_request_processing();
+    }
+    return result;
+}
 
 void nexus_oc_wrapper_oc_endpoint_to_nx_id(const oc_endpoint_t* const input_ep,
                                            struct nx_id* output_id)
@@ -542,6 +833,22 @@ size_t nexus_oc_wrapper_repack_buffer_secured(
     uint8_t* secured_output,
     size_t secured_output_size,
     nexus_cose_mac0_common_macparams_t* mac_params)
+{
+    struct nexus_check_keyed_state key_state;
+    nexus_check_keyed_state_init(&key_state, mac_params->key);
+    const size_t bytes_encoded = nexus_oc_wrapper_repack_buffer_secured_keyed(
+        secured_output, secured_output_size, mac_params, &key_state);
+    nexus_secure_memclr(&key_state,
+                        sizeof(struct nexus_check_keyed_state),
+                        sizeof(struct nexus_check_keyed_state));
+    return bytes_encoded;
+}
+
+size_t nexus_oc_wrapper_repack_buffer_secured_keyed(
+    uint8_t* secured_output,
+    size_t secured_output_size,
+    nexus_cose_mac0_common_macparams_t* mac_params,
+    const struct nexus_check_keyed_state* key_state)
 {
     // if buffer not large enough to hold maximum payload size, then return
     // early
@@ -552,8 +859,12 @@ size_t nexus_oc_wrapper_repack_buffer_secured(
 
     size_t bytes_encoded;
 
-    const nexus_cose_error encode_result = nexus_cose_mac0_sign_encode_message(
-        mac_params, secured_output, secured_output_size, &bytes_encoded);
+    const nexus_cose_error encode_result =
+        nexus_cose_mac0_sign_encode_message_keyed(mac_params,
+                                                  key_state,
+                                                  secured_output,
+                                                  secured_output_size,
+                                                  &bytes_encoded);
 
     if (encode_result == NEXUS_COSE_ERROR_NONE)
     {
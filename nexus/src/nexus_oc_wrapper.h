@@ -107,6 +107,30 @@ void nexus_oc_wrapper_nx_id_to_oc_endpoint(const struct nx_id* id,
 void nexus_oc_wrapper_oc_endpoint_to_nx_id(
     const oc_endpoint_t* const source_endpoint, struct nx_id* dest_nx_id);
 
+    #if NEXUS_CHANNEL_INGRESS_RING_ENABLED
+/** Discard all received messages waiting in the ingress ring.
+ *
+ * Called when Nexus Channel is initialized.
+ */
+void nexus_oc_wrapper_ingress_ring_clear(void);
+
+/** Pass received messages from the ingress ring to IoTivity.
+ *
+ * Messages are passed oldest first, until the ring is empty or IoTivity
+ * has no free incoming message buffers. IoTivity frees incoming message
+ * buffers once it has processed the messages (in `oc_main_poll`).
+ *
+ * \return number of messages passed to IoTivity
+ */
+uint8_t nexus_oc_wrapper_ingress_ring_drain(void);
+
+/** Number of received messages waiting in the ingress ring.
+ *
+ * \return number of messages not yet passed to IoTivity
+ */
+uint8_t nexus_oc_wrapper_ingress_ring_count(void);
+    #endif /* NEXUS_CHANNEL_INGRESS_RING_ENABLED */
+
     #if NEXUS_CHANNEL_LINK_SECURITY_ENABLED
 /** Repack a CBOR-encoded payload with Nexus Channel security.
  *
@@ -121,6 +145,26 @@ size_t nexus_oc_wrapper_repack_buffer_secured(
     size_t secured_output_size,
     nexus_cose_mac0_common_macparams_t* cose_mac0);
 
+/** Repack a CBOR-encoded payload with Nexus Channel link security.
+ *
+ * Identical to `nexus_oc_wrapper_repack_buffer_secured`, but uses the
+ * precomputed key state of a link (see
+ * `nexus_channel_link_manager_security_handle_from_nxid`) instead of
+ * `cose_mac0->key` (which is ignored, and may be NULL).
+ *
+ * \param secured_output secured message will be placed here
+ * \param secured_output_size max number of bytes to copy into `secured_output`
+ * \param cose_mac0 pointer to MAC0 params to use in creating the
+ * security primitives (including the unsecured payload)
+ * \param key_state keyed state of the link key
+ * \return number of bytes packed into `secured_output`
+ */
+size_t nexus_oc_wrapper_repack_buffer_secured_keyed(
+    uint8_t* secured_output,
+    size_t secured_output_size,
+    nexus_cose_mac0_common_macparams_t* cose_mac0,
+    const struct nexus_check_keyed_state* key_state);
+
     #endif /* NEXUS_CHANNEL_LINK_SECURITY_ENABLED */
 
     #ifdef __cplusplus
@@ -39,6 +39,16 @@ extern const struct nx_common_check_key
 extern const struct nx_common_check_key
     NEXUS_CHANNEL_PUBLIC_KEY_DERIVATION_KEY_2;
 
+    #ifdef __cplusplus
+}
+    #endif
+
+#endif // NEXUS_CHANNEL_LINK_SECURITY_ENABLED
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /* Securely erase a section of memory (RAM).
  *
  * Ensures that the compiler will not optimize away a call to clear memory.
@@ -59,10 +69,8 @@ void* nexus_secure_memclr(void* pointer,
                           size_t size_data,
                           size_t size_to_erase);
 
-    #ifdef __cplusplus
+#ifdef __cplusplus
 }
-    #endif
-
-#endif // NEXUS_CHANNEL_LINK_SECURITY_ENABLED
+#endif
 
 #endif /* ifndef NEXUS__SRC__NEXUS_SECURITY_H_ */
@@ -9,6 +9,7 @@
  */
 #include "src/nexus_util.h"
 #include "src/internal_common_config.h" // to get siphash/crc
+#include "src/nexus_security.h"
 
 const struct nx_common_check_key NEXUS_INTEGRITY_CHECK_FIXED_00_KEY = {{0x00,
                                                                         0x00,
@@ -46,15 +47,81 @@ const struct nx_common_check_key NEXUS_INTEGRITY_CHECK_FIXED_FF_KEY = {{0xFF,
 
 struct nexus_check_value nexus_check_compute(
     const struct nx_common_check_key* key, const void* data, uint16_t data_size)
+{
+    struct nexus_check_keyed_state state;
+
+    nexus_check_keyed_state_init(&state, key);
+    const struct nexus_check_value value =
+        nexus_check_compute_keyed(&state, data, data_size);
+
+    // state is derived from the secret key
+    (void) nexus_secure_memclr(&state, sizeof(state), sizeof(state));
+    return value;
+}
+
+void nexus_check_keyed_state_init(struct nexus_check_keyed_state* state,
+                                  const struct nx_common_check_key* key)
+{
+    siphash24_keyed_state_init(&state->siphash, key->bytes);
+}
+
+struct nexus_check_value
+nexus_check_compute_keyed(const struct nexus_check_keyed_state* state,
+                          const void* data,
+                          uint16_t data_size)
+{
+    struct nexus_check_value value;
+
+    siphash24_compute_keyed(
+        value.bytes, (const uint8_t*) data, data_size, &state->siphash);
+
+    return value;
+}
+
+void nexus_check_init(struct nexus_check_ctx* ctx,
+                      const struct nexus_check_keyed_state* state)
+{
+    siphash24_init(&ctx->siphash, &state->siphash);
+}
+
+void nexus_check_update(struct nexus_check_ctx* ctx,
+                        const void* data,
+                        uint16_t data_size)
+{
+    siphash24_update(&ctx->siphash, (const uint8_t*) data, data_size);
+}
+
+struct nexus_check_value nexus_check_final(struct nexus_check_ctx* ctx)
 {
     struct nexus_check_value value;
 
-    siphash24_compute(
-        value.bytes, (const uint8_t*) data, data_size, key->bytes);
+    siphash24_final(&ctx->siphash, value.bytes);
 
     return value;
 }
 
+// Batch computation passes arrays of these structs directly to Siphash
+NEXUS_STATIC_ASSERT(sizeof(struct nexus_check_keyed_state) ==
+                        sizeof(struct siphash24_keyed_state),
+                    "Keyed state array stride does not match Siphash state");
+NEXUS_STATIC_ASSERT(sizeof(struct nexus_check_value) == 8,
+                    "Check value array stride is not 8 bytes");
+
+void nexus_check_compute_batch(const struct nexus_check_keyed_state* states,
+                               bool shared_state,
+                               const void* data,
+                               uint16_t data_size,
+                               uint8_t count,
+                               struct nexus_check_value* results)
+{
+    siphash24_compute_batch(results[0].bytes,
+                            (const uint8_t*) data,
+                            data_size,
+                            count,
+                            &states[0].siphash,
+                            shared_state);
+}
+
 void nexus_check_compute_pseudorandom_bytes(
     const struct nx_common_check_key* key,
     const void* seed,
@@ -122,22 +189,53 @@ void nexus_bitstream_push_bit(struct nexus_bitstream* stream, bool pushed)
     }
 }
 
+void nexus_bitstream_push_bits(struct nexus_bitstream* stream,
+                               uint32_t pushed,
+                               uint8_t bits)
+{
+    NEXUS_ASSERT(bits <= 32, "more than 32 bits pushed from uint32");
+    NEXUS_ASSERT(stream->position + bits <= stream->capacity,
+                 "attempt to overflow bitstream");
+
+    uint8_t remaining = bits;
+
+    // write as many bits as fit in the current byte on each step; as with
+    // `nexus_bitstream_push_bit`, less significant bits of the last byte
+    // written are cleared
+    while (remaining > 0)
+    {
+        const uint16_t byte_position = stream->position >> 3; // divide by 8
+        const uint8_t bit_offset = (uint8_t)(stream->position & 0x07);
+        const uint8_t free_bits = (uint8_t)(8 - bit_offset);
+        const uint8_t chunk_bits =
+            (uint8_t)(remaining < free_bits ? remaining : free_bits);
+
+        remaining = (uint8_t)(remaining - chunk_bits);
+        const uint8_t chunk =
+            (uint8_t)((pushed >> remaining) & (0xFFu >> (8 - chunk_bits)));
+        const uint8_t kept = (uint8_t)(stream->data[byte_position] &
+                                       (uint8_t) ~(0xFFu >> bit_offset));
+
+        stream->data[byte_position] =
+            (uint8_t)(kept | (chunk << (free_bits - chunk_bits)));
+
+        // Avoid += here to avoid false positive with GCC conversion warning.
+        stream->position = (uint16_t)(stream->position + chunk_bits);
+    }
+
+    if (stream->position > stream->length)
+    {
+        stream->length = stream->position;
+    }
+}
+
 void nexus_bitstream_push_uint8(struct nexus_bitstream* stream,
                                 uint8_t pushed,
                                 uint8_t bits)
 {
     NEXUS_ASSERT(bits <= 8, "more than 8 bits pushed from uint8");
 
-    for (uint8_t i = 0; i < bits; ++i)
-    {
-        const uint8_t bit = (pushed >> (bits - 1)) & 0x01;
-
-        nexus_bitstream_push_bit(stream, bit);
-
-        // Avoid <<= here to avoid false positive with GCC conversion warning.
-        const uint8_t pushed_lshift = (uint8_t)(pushed << 1);
-        pushed = pushed_lshift;
-    }
+    nexus_bitstream_push_bits(stream, pushed, bits);
 }
 
 bool nexus_bitstream_pull_bit(struct nexus_bitstream* stream)
@@ -155,55 +253,126 @@ bool nexus_bitstream_pull_bit(struct nexus_bitstream* stream)
     return (byte >> shift) & 0x01;
 }
 
-uint8_t nexus_bitstream_pull_uint8(struct nexus_bitstream* stream, uint8_t bits)
+uint32_t nexus_bitstream_pull_bits(struct nexus_bitstream* stream,
+                                   uint8_t bits)
 {
-    NEXUS_ASSERT(bits <= 8, "more than 8 bits pulled from uint8");
+    NEXUS_ASSERT(bits <= 32, "more than 32 bits pulled from uint32");
+    NEXUS_ASSERT(stream->position + bits <= stream->length,
+                 "attempt to overflow bitstream");
 
-    uint8_t pulled = 0x00;
+    uint32_t pulled = 0;
+    uint8_t remaining = bits;
 
-    for (uint8_t i = 0; i < bits; ++i)
+    // read as many bits as remain in the current byte on each step
+    while (remaining > 0)
     {
-        pulled = (uint8_t)((pulled << 1) |
-                           (uint8_t) nexus_bitstream_pull_bit(stream));
+        const uint16_t byte_position = stream->position >> 3; // divide by 8
+        const uint8_t bit_offset = (uint8_t)(stream->position & 0x07);
+        const uint8_t available_bits = (uint8_t)(8 - bit_offset);
+        const uint8_t chunk_bits =
+            (uint8_t)(remaining < available_bits ? remaining : available_bits);
+
+        const uint8_t chunk =
+            (uint8_t)((stream->data[byte_position] >>
+                       (available_bits - chunk_bits)) &
+                      (0xFFu >> (8 - chunk_bits)));
+
+        pulled = (pulled << chunk_bits) | chunk;
+
+        remaining = (uint8_t)(remaining - chunk_bits);
+        // Avoid += here to avoid false positive with GCC conversion warning.
+        stream->position = (uint16_t)(stream->position + chunk_bits);
     }
 
     return pulled;
 }
 
+uint8_t nexus_bitstream_pull_uint8(struct nexus_bitstream* stream, uint8_t bits)
+{
+    NEXUS_ASSERT(bits <= 8, "more than 8 bits pulled from uint8");
+
+    return (uint8_t) nexus_bitstream_pull_bits(stream, bits);
+}
+
 uint16_t nexus_bitstream_pull_uint16_be(struct nexus_bitstream* stream,
                                         uint16_t bits)
 {
     NEXUS_ASSERT(bits <= 16, "more than 8 bits pushed from uint8");
 
-    uint8_t msbyte_bits = (uint8_t)(bits > 8 ? 8 : bits);
-    uint8_t lsbyte_bits = (uint8_t)(bits > 8 ? bits - 8 : 0);
-    uint16_t pulled = 0x0000;
-
-    pulled = nexus_bitstream_pull_uint8(stream, msbyte_bits);
-
-    // Avoid <<= here to avoid false positive with GCC conversion warning.
-    const uint16_t pulled_lshift = (uint16_t)(pulled << lsbyte_bits);
-    pulled = pulled_lshift;
-    pulled |= (uint16_t) nexus_bitstream_pull_uint8(stream, lsbyte_bits);
-
-    return pulled;
+    return (uint16_t) nexus_bitstream_pull_bits(stream, (uint8_t) bits);
 }
 
 //
 // DIGIT STREAM
 //
 
-static uint32_t _chars_to_uint32(const char* chars, const uint8_t count)
+// Lanes of a SWAR (SIMD within a register) decimal digit chunk, one digit
+// value per byte, first (most significant) digit in the lowest byte.
+#define NEXUS_DIGITS_SWAR_CHUNK_DIGITS 8
+#define NEXUS_DIGITS_SWAR_ASCII_ZEROS 0x3030303030303030ULL
+
+// Combine the 8 digit values in `lanes` into one integer (0 to 99999999).
+// Adjacent lanes are merged pairwise, halving the lane count each step.
+static uint32_t _digits_swar_chunk_value(uint64_t lanes)
 {
-    // interpret characters as ASCII digits
-    uint32_t value = 0;
+    lanes = (lanes * 10 + (lanes >> 8)) & 0x00FF00FF00FF00FFULL;
+    lanes = (lanes * 100 + (lanes >> 16)) & 0x0000FFFF0000FFFFULL;
+    lanes = (lanes * 10000 + (lanes >> 32)) & 0x00000000FFFFFFFFULL;
+    return (uint32_t) lanes;
+}
+
+// Load up to 8 ASCII digits as SWAR lanes. Fewer than 8 digits are placed in
+// the highest lanes, i.e. left-padded with zero digits.
+static uint64_t _digits_swar_chunk_load(const char* chars, const uint8_t count)
+{
+    NEXUS_ASSERT(count <= NEXUS_DIGITS_SWAR_CHUNK_DIGITS,
+                 "too many digits in chunk");
+
+    uint64_t lanes = NEXUS_DIGITS_SWAR_ASCII_ZEROS;
+    const uint8_t first_lane =
+        (uint8_t)(NEXUS_DIGITS_SWAR_CHUNK_DIGITS - count);
 
     for (uint8_t i = 0; i < count; ++i)
     {
-        NEXUS_ASSERT('0' <= chars[i] && chars[i] <= '9',
-                     "char not an ASCII digit");
+        const uint8_t shift = (uint8_t)(8 * (first_lane + i));
+        lanes &= ~((uint64_t) 0xFF << shift);
+        lanes |= (uint64_t)(uint8_t) chars[i] << shift;
+    }
+
+    // every lane must hold an ASCII digit, '0' (0x30) to '9' (0x39)
+    NEXUS_ASSERT((((lanes + 0x4646464646464646ULL) |
+                   (lanes - NEXUS_DIGITS_SWAR_ASCII_ZEROS)) &
+                  0x8080808080808080ULL) == 0,
+                 "char not an ASCII digit");
+
+    return lanes - NEXUS_DIGITS_SWAR_ASCII_ZEROS;
+}
+
+uint32_t nexus_digits_chars_to_uint32(const char* chars, uint8_t count)
+{
+    // leading partial chunk, so that every later chunk is a full one
+    uint8_t chunk_digits = (uint8_t)(count % NEXUS_DIGITS_SWAR_CHUNK_DIGITS);
+    if (chunk_digits == 0 && count > 0)
+    {
+        chunk_digits = NEXUS_DIGITS_SWAR_CHUNK_DIGITS;
+    }
 
-        value = value * 10 + (uint32_t)(chars[i] - '0');
+    uint32_t value = 0;
+    while (count > 0)
+    {
+        const uint64_t lanes = _digits_swar_chunk_load(chars, chunk_digits);
+        const uint32_t chunk_value = _digits_swar_chunk_value(lanes);
+
+        // 10^8 shift for every full chunk; wraps modulo 2^32 like the
+        // digit-at-a-time conversion would
+        value = (chunk_digits == NEXUS_DIGITS_SWAR_CHUNK_DIGITS ?
+                     value * 100000000u :
+                     0) +
+                chunk_value;
+
+        chars += chunk_digits;
+        count = (uint8_t)(count - chunk_digits);
+        chunk_digits = NEXUS_DIGITS_SWAR_CHUNK_DIGITS;
     }
 
     return value;
@@ -225,7 +394,7 @@ uint32_t nexus_digits_pull_uint32(struct nexus_digits* digits,
                  "too many digits pulled");
 
     const uint32_t value =
-        _chars_to_uint32(digits->chars + digits->position, count);
+        nexus_digits_chars_to_uint32(digits->chars + digits->position, count);
 
     // Avoid += here to avoid false positive with GCC conversion warning.
     digits->position = (uint16_t)(count + digits->position);
@@ -341,6 +510,154 @@ bool nexus_bitset_contains(const struct nexus_bitset* bitset, uint16_t element)
     return bitset->bytes[indices.byte_index] & (0x01 << indices.bit_index);
 }
 
+// Bitsets are processed in 32-bit words, assembled from bytes least
+// significant first, so that the stored byte layout does not depend on
+// platform endianness or alignment. Bytes past the end of the bitset read
+// as zero, and are not written.
+#define NEXUS_BITSET_WORD_BITS 32
+#define NEXUS_BITSET_WORD_BYTES 4
+
+static uint16_t _bitset_word_count(const struct nexus_bitset* bitset)
+{
+    return (uint16_t)((bitset->bytes_count + NEXUS_BITSET_WORD_BYTES - 1) /
+                      NEXUS_BITSET_WORD_BYTES);
+}
+
+static uint32_t _bitset_load_word(const struct nexus_bitset* bitset,
+                                  uint16_t word_index)
+{
+    const uint16_t first_byte =
+        (uint16_t)(word_index * NEXUS_BITSET_WORD_BYTES);
+    uint32_t word = 0;
+
+    for (uint8_t i = 0; i < NEXUS_BITSET_WORD_BYTES &&
+                        first_byte + i < bitset->bytes_count;
+         ++i)
+    {
+        word |= (uint32_t) bitset->bytes[first_byte + i] << (8 * i);
+    }
+
+    return word;
+}
+
+static void _bitset_store_word(struct nexus_bitset* bitset,
+                               uint16_t word_index,
+                               uint32_t word)
+{
+    const uint16_t first_byte =
+        (uint16_t)(word_index * NEXUS_BITSET_WORD_BYTES);
+
+    for (uint8_t i = 0; i < NEXUS_BITSET_WORD_BYTES &&
+                        first_byte + i < bitset->bytes_count;
+         ++i)
+    {
+        bitset->bytes[first_byte + i] = (uint8_t)(word >> (8 * i));
+    }
+}
+
+// Index of the least significant set bit; `word` must not be 0
+static uint8_t _bitset_count_trailing_zeros(uint32_t word)
+{
+    NEXUS_ASSERT(word != 0, "no set bits to count");
+#if defined(__GNUC__) || defined(__clang__)
+    return (uint8_t) __builtin_ctz(word);
+#else
+    uint8_t count = 0;
+    while ((word & 0x01) == 0)
+    {
+        word >>= 1;
+        ++count;
+    }
+    return count;
+#endif
+}
+
+static uint8_t _bitset_popcount(uint32_t word)
+{
+    word = word - ((word >> 1) & 0x55555555u);
+    word = (word & 0x33333333u) + ((word >> 2) & 0x33333333u);
+    word = (word + (word >> 4)) & 0x0F0F0F0Fu;
+    return (uint8_t)((word * 0x01010101u) >> 24);
+}
+
+void nexus_bitset_shift_down(struct nexus_bitset* bitset, uint16_t count)
+{
+    const uint16_t word_count = _bitset_word_count(bitset);
+    const uint16_t word_shift = (uint16_t)(count / NEXUS_BITSET_WORD_BITS);
+    const uint8_t bit_shift = (uint8_t)(count % NEXUS_BITSET_WORD_BITS);
+
+    // words are only read at or above the word being written, so the shift
+    // can be done in place
+    for (uint16_t i = 0; i < word_count; ++i)
+    {
+        uint32_t word = 0;
+        const uint32_t source_index = (uint32_t) i + word_shift;
+
+        if (source_index < word_count)
+        {
+            word = _bitset_load_word(bitset, (uint16_t) source_index) >>
+                   bit_shift;
+
+            if (bit_shift != 0 && source_index + 1 < word_count)
+            {
+                word |= _bitset_load_word(bitset,
+                                          (uint16_t)(source_index + 1))
+                        << (NEXUS_BITSET_WORD_BITS - bit_shift);
+            }
+        }
+
+        _bitset_store_word(bitset, i, word);
+    }
+}
+
+uint16_t nexus_bitset_find_next_unset(const struct nexus_bitset* bitset,
+                                      uint16_t start)
+{
+    const uint16_t element_count = (uint16_t)(bitset->bytes_count * 8);
+
+    if (start >= element_count)
+    {
+        return element_count;
+    }
+
+    const uint16_t word_count = _bitset_word_count(bitset);
+    uint16_t word_index = (uint16_t)(start / NEXUS_BITSET_WORD_BITS);
+
+    // ignore elements below `start` in its word
+    uint32_t unset = ~_bitset_load_word(bitset, word_index) &
+                     (UINT32_MAX << (start % NEXUS_BITSET_WORD_BITS));
+
+    while (unset == 0)
+    {
+        ++word_index;
+        if (word_index >= word_count)
+        {
+            return element_count;
+        }
+        unset = ~_bitset_load_word(bitset, word_index);
+    }
+
+    const uint32_t element = (uint32_t) word_index * NEXUS_BITSET_WORD_BITS +
+                             _bitset_count_trailing_zeros(unset);
+
+    // padding past the last byte reads as unset
+    return element < element_count ? (uint16_t) element : element_count;
+}
+
+uint16_t nexus_bitset_count(const struct nexus_bitset* bitset)
+{
+    const uint16_t word_count = _bitset_word_count(bitset);
+    uint16_t count = 0;
+
+    for (uint16_t i = 0; i < word_count; ++i)
+    {
+        const uint32_t word = _bitset_load_word(bitset, i);
+        count = (uint16_t)(count + _bitset_popcount(word));
+    }
+
+    return count;
+}
+
 void nexus_util_window_init(struct nexus_window* window,
                             uint8_t* flag_array, // first element
                             const uint8_t flag_array_bytes,
@@ -429,6 +746,25 @@ bool nexus_util_window_id_flag_already_set(const struct nexus_window* window,
            nexus_bitset_contains(&window->flags, mask_id_index);
 }
 
+uint32_t nexus_util_window_next_unset_id(const struct nexus_window* window,
+                                         const uint32_t id)
+{
+    uint8_t mask_id_index = 0;
+
+    // IDs above the center or outside the window are never set
+    if (id > window->center_index ||
+        !_nexus_util_window_mask_idx_from_id(window, id, &mask_id_index))
+    {
+        return id;
+    }
+
+    const uint16_t unset_index =
+        nexus_bitset_find_next_unset(&window->flags, mask_id_index);
+
+    // at most one past the center, if every flag from `id` up is set
+    return id + (uint32_t)(unset_index - mask_id_index);
+}
+
 bool nexus_util_window_set_id_flag(struct nexus_window* window,
                                    const uint32_t id)
 {
@@ -473,32 +809,12 @@ bool nexus_util_window_set_id_flag(struct nexus_window* window,
     }
     else
     {
-        // mask array here may be larger than actual window flags byte array
-        uint8_t new_mask[NEXUS_UTIL_MAX_WINDOW_BITSET_SIZE_BYTES];
-        memset(&new_mask, 0x00, sizeof(new_mask));
-
-        // temporary storage for the new mask while we calculate it
-        struct nexus_bitset new_mask_bitset;
-        nexus_bitset_init(&new_mask_bitset, &new_mask[0], sizeof(new_mask));
-        // <= window->flags below to 'set' the center index value as well -
-        // the total number of flags in the window is window->flags_below + 1
-        // (1 for the center index)
-        for (uint32_t i = center_increment; i <= window->flags_below; i++)
-        {
-            // copy values from the old mask into the new mask, offset
-            // by the change in the center index value
-            if (nexus_bitset_contains(&window->flags, (uint16_t) i))
-            {
-                nexus_bitset_add(&new_mask_bitset,
-                                 (uint16_t)(i - center_increment));
-            }
-        }
         NEXUS_ASSERT(window->flags.bytes_count * 8 == window->flags_below + 1,
                      "flag bytes count does not match number of flag bits");
 
-        // copy 'moved' window values
-        (void) memcpy(
-            window->flags.bytes, &new_mask, window->flags.bytes_count);
+        // move flags down by the change in the center index value; flags
+        // shifted below the window are dropped
+        nexus_bitset_shift_down(&window->flags, (uint16_t) center_increment);
     }
 
     // finally, update the window center index value to the new ID.
@@ -36,7 +36,17 @@ extern "C" {
      ((uint64_t)((p)[4]) << 32) | ((uint64_t)((p)[5]) << 40) |                 \
      ((uint64_t)((p)[6]) << 48) | ((uint64_t)((p)[7]) << 56))
 
-#define NEXUS_UTIL_MAX_WINDOW_BITSET_SIZE_BYTES 5
+// Largest window flag array supported; `flags_below` (one less than the
+// number of flags) is a `uint8_t`, so windows hold at most 256 flags.
+#define NEXUS_UTIL_MAX_WINDOW_BITSET_SIZE_BYTES 32
+
+// Maximum number of candidate messages authenticated per call to
+// `nexus_check_compute_batch` by internal window searches. Larger values use
+// more stack, but allow more candidates to be computed in parallel on
+// SIMD-capable hosts.
+#ifndef NEXUS_CHECK_BATCH_MAX_COUNT
+    #define NEXUS_CHECK_BATCH_MAX_COUNT 4
+#endif
 
 /** Used for internal integrity checks.
  */
@@ -58,6 +68,109 @@ nexus_check_compute(const struct nx_common_check_key* key,
                     const void* data,
                     uint16_t data_size);
 
+/** Key setup for an internal authentication check, computed once per key.
+ *
+ * Callers which compute many checks under the same key (such as a link
+ * key or the origin key) may initialize this once and then use
+ * `nexus_check_compute_keyed`, skipping key setup on each computation.
+ * A keyed state is never modified after initialization, so it is safe to
+ * share across threads.
+ *
+ * Derived from secret key material; clear it when no longer needed.
+ */
+struct nexus_check_keyed_state
+{
+    struct siphash24_keyed_state siphash;
+};
+
+/** Precompute the keyed state for `key`.
+ *
+ * \param state keyed state to initialize
+ * \param key secret key the state is derived from
+ */
+void nexus_check_keyed_state_init(struct nexus_check_keyed_state* state,
+                                  const struct nx_common_check_key* key);
+
+/** Compute an internal authentication check with a precomputed keyed state.
+ *
+ * Result is identical to `nexus_check_compute` using the key that `state`
+ * was initialized from.
+ *
+ * \param state keyed state (see `nexus_check_keyed_state_init`)
+ * \param data pointer to data to compute the check over
+ * \param data_size number of bytes at `data`
+ * \return computed check value
+ */
+struct nexus_check_value
+nexus_check_compute_keyed(const struct nexus_check_keyed_state* state,
+                          const void* data,
+                          uint16_t data_size);
+
+/** Incremental internal authentication check computation.
+ *
+ * Used to compute a check over data which is not contiguous in memory
+ * (for example, framing bytes followed by a separately stored payload)
+ * without first copying it into a single buffer.
+ */
+struct nexus_check_ctx
+{
+    struct siphash24_ctx siphash;
+};
+
+/** Begin an incremental check computation.
+ *
+ * \param ctx context to initialize
+ * \param state keyed state (see `nexus_check_keyed_state_init`)
+ */
+void nexus_check_init(struct nexus_check_ctx* ctx,
+                      const struct nexus_check_keyed_state* state);
+
+/** Add more data to an incremental check computation.
+ *
+ * \param ctx context previously initialized with `nexus_check_init`
+ * \param data pointer to data to add to the check
+ * \param data_size number of bytes at `data`
+ */
+void nexus_check_update(struct nexus_check_ctx* ctx,
+                        const void* data,
+                        uint16_t data_size);
+
+/** Complete an incremental check computation.
+ *
+ * Result is identical to `nexus_check_compute_keyed` over all data passed
+ * to `nexus_check_update`, in order. `ctx` is cleared.
+ *
+ * \param ctx context previously initialized with `nexus_check_init`
+ * \return computed check value
+ */
+struct nexus_check_value nexus_check_final(struct nexus_check_ctx* ctx);
+
+/** Compute several independent internal authentication checks at once.
+ *
+ * Computes `count` checks over `count` equal-length messages stored
+ * back-to-back at `data` (message `i` begins at `data + i * data_size`).
+ * `results[i]` is identical to `nexus_check_compute_keyed` over message `i`.
+ *
+ * Each message may use its own keyed state (`states[i]`), or all messages
+ * may share `states[0]` if `shared_state` is true.
+ *
+ * On hosts with SIMD support, several checks are computed in parallel; see
+ * `siphash24_compute_batch`.
+ *
+ * \param states keyed states, one per message (or one if `shared_state`)
+ * \param shared_state if true, use `states[0]` for all messages
+ * \param data pointer to `count` messages of `data_size` bytes each
+ * \param data_size number of bytes in each message
+ * \param count number of messages
+ * \param results pointer to `count` check values to populate
+ */
+void nexus_check_compute_batch(const struct nexus_check_keyed_state* states,
+                               bool shared_state,
+                               const void* data,
+                               uint16_t data_size,
+                               uint8_t count,
+                               struct nexus_check_value* results);
+
 /** Compute pseudorandom bytes based on a seed and secret key.
  *
  * Warning: This implementation only supports seeds of 4 bytes or fewer
@@ -177,11 +290,36 @@ void nexus_bitstream_push_uint8(struct nexus_bitstream* bitstream,
                                 uint8_t data,
                                 uint8_t bits);
 
+/* Push the `bits` least significant bits of `data`, most significant first.
+ *
+ * Equivalent to pushing each bit with `nexus_bitstream_push_bit`, but
+ * writes up to a byte at a time.
+ *
+ * \param bitstream stream to push to
+ * \param data value holding the bits to push
+ * \param bits number of bits to push, 0 to 32
+ */
+void nexus_bitstream_push_bits(struct nexus_bitstream* bitstream,
+                               uint32_t data,
+                               uint8_t bits);
+
 bool nexus_bitstream_pull_bit(struct nexus_bitstream* stream);
 
 uint8_t nexus_bitstream_pull_uint8(struct nexus_bitstream* bitstream,
                                    uint8_t bits);
 
+/* Pull `bits` bits, most significant first, into the low bits of the result.
+ *
+ * Equivalent to pulling each bit with `nexus_bitstream_pull_bit`, but reads
+ * up to a byte at a time.
+ *
+ * \param bitstream stream to pull from
+ * \param bits number of bits to pull, 0 to 32
+ * \return pulled bits
+ */
+uint32_t nexus_bitstream_pull_bits(struct nexus_bitstream* bitstream,
+                                   uint8_t bits);
+
 uint16_t nexus_bitstream_pull_uint16_be(struct nexus_bitstream* bitstream,
                                         uint16_t bits);
 
@@ -216,6 +354,21 @@ static inline uint16_t nexus_digits_remaining(const struct nexus_digits* digits)
     return (uint16_t)(digits->length - digits->position);
 }
 
+/* Interpret `count` ASCII decimal digits as an unsigned integer.
+ *
+ * The first digit is the most significant. Converts 8 digits per step
+ * (SWAR), rather than one at a time; values of more than 9 digits wrap
+ * modulo 2^32. All `count` characters must be ASCII digits.
+ *
+ * Does not require a `nexus_digits` stream, so frames can be decoded in
+ * place without copying their digits.
+ *
+ * \param chars digits to convert
+ * \param count number of digits in `chars` to convert
+ * \return integer value of the digits (0 if `count` is 0)
+ */
+uint32_t nexus_digits_chars_to_uint32(const char* chars, uint8_t count);
+
 uint32_t nexus_digits_pull_uint32(struct nexus_digits* digits, uint8_t count);
 uint32_t nexus_digits_try_pull_uint32(struct nexus_digits* digits,
                                       uint8_t count,
@@ -242,6 +395,24 @@ void nexus_bitset_add(struct nexus_bitset* bitset, uint16_t element);
 void nexus_bitset_remove(struct nexus_bitset* bitset, uint16_t element);
 bool nexus_bitset_contains(const struct nexus_bitset* bitset, uint16_t element);
 
+/* Move every element down by `count` (element `i + count` becomes `i`).
+ *
+ * Elements below `count` are dropped, and the top `count` elements are
+ * cleared. Operates on 32-bit words, in place.
+ */
+void nexus_bitset_shift_down(struct nexus_bitset* bitset, uint16_t count);
+
+/* Return the smallest element at or above `start` not in the bitset.
+ *
+ * Returns the bitset size in bits (one past the last element) if every
+ * element from `start` up is set.
+ */
+uint16_t nexus_bitset_find_next_unset(const struct nexus_bitset* bitset,
+                                      uint16_t start);
+
+// Return the number of elements in the bitset
+uint16_t nexus_bitset_count(const struct nexus_bitset* bitset);
+
 // Used for manipulating bitset 'windows with a center', as used by
 // `nexus_keycode_pro` and `nexus_channel_om`.
 
@@ -312,6 +483,20 @@ bool nexus_util_window_id_within_window(const struct nexus_window* window,
 bool nexus_util_window_id_flag_already_set(const struct nexus_window* window,
                                            const uint32_t id);
 
+/*! \brief Find the first ID at or above `id` that is not already set.
+ *
+ * Skips over runs of set flags a word at a time, so that searches through a
+ * window only visit unset IDs. The returned ID may be outside the window;
+ * callers should check it with `nexus_util_window_id_within_window`.
+ *
+ * \param window window to search
+ * \param id first ID to consider
+ * \return `id`, or the next ID above it, for which
+ * `nexus_util_window_id_flag_already_set` is false
+ */
+uint32_t nexus_util_window_next_unset_id(const struct nexus_window* window,
+                                         const uint32_t id);
+
 /*! \brief Set the appropriate ID flag within a Nexus ID window.
  *
  *  ID must actually be a valid ID within the window; or this function
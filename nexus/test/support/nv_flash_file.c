@@ -0,0 +1,191 @@
+/* \file nv_flash_file.c
+ * \brief File-backed flash page emulator
+ * \author Angaza
+ * \copyright 2021 Angaza, Inc.
+ * \license This file is released under the MIT license
+ */
+
+#include "nv_flash_file.h"
+
+#include <string.h>
+
+#define NV_FLASH_FILE_ERASED_BYTE 0xFF
+
+static bool _nv_flash_file_in_range(const struct nv_flash_file* flash,
+                                    uint32_t address,
+                                    uint16_t length)
+{
+    const uint32_t size =
+        (uint32_t) flash->flash.page_size * flash->flash.page_count;
+    return address <= size && length <= size - address;
+}
+
+/* Reduce `length` to the bytes which may be written before a simulated
+ * power loss. Returns false if power is lost during this operation.
+ */
+static bool _nv_flash_file_consume_power(struct nv_flash_file* flash,
+                                         uint16_t* length)
+{
+    if (flash->bytes_until_power_loss < 0)
+    {
+        return true;
+    }
+    if ((int32_t) *length <= flash->bytes_until_power_loss)
+    {
+        flash->bytes_until_power_loss -= *length;
+        return true;
+    }
+    *length = (uint16_t) flash->bytes_until_power_loss;
+    flash->bytes_until_power_loss = 0;
+    flash->powered_off = true;
+    return false;
+}
+
+static bool _nv_flash_file_read_bytes(struct nv_flash_file* flash,
+                                      uint32_t address,
+                                      void* data,
+                                      uint16_t length)
+{
+    return fseek(flash->file, (long) address, SEEK_SET) == 0 &&
+           fread(data, 1, length, flash->file) == length;
+}
+
+static bool _nv_flash_file_write_bytes(struct nv_flash_file* flash,
+                                       uint32_t address,
+                                       const void* data,
+                                       uint16_t length)
+{
+    return fseek(flash->file, (long) address, SEEK_SET) == 0 &&
+           fwrite(data, 1, length, flash->file) == length &&
+           fflush(flash->file) == 0;
+}
+
+static bool _nv_flash_file_read(void* context,
+                                uint32_t address,
+                                void* data,
+                                uint16_t length)
+{
+    struct nv_flash_file* flash = (struct nv_flash_file*) context;
+    if (flash->powered_off || !_nv_flash_file_in_range(flash, address, length))
+    {
+        return false;
+    }
+    return _nv_flash_file_read_bytes(flash, address, data, length);
+}
+
+static bool _nv_flash_file_program(void* context,
+                                   uint32_t address,
+                                   const void* data,
+                                   uint16_t length)
+{
+    struct nv_flash_file* flash = (struct nv_flash_file*) context;
+    uint8_t existing[256];
+    if (flash->powered_off || length > sizeof(existing) ||
+        !_nv_flash_file_in_range(flash, address, length) ||
+        !_nv_flash_file_read_bytes(flash, address, existing, length))
+    {
+        return false;
+    }
+
+    // NOR flash programming only clears bits
+    const uint8_t* new_bytes = (const uint8_t*) data;
+    for (uint16_t i = 0; i < length; i++)
+    {
+        existing[i] &= new_bytes[i];
+    }
+
+    const bool powered = _nv_flash_file_consume_power(flash, &length);
+    flash->bytes_programmed += length;
+    return _nv_flash_file_write_bytes(flash, address, existing, length) &&
+           powered;
+}
+
+static bool _nv_flash_file_erase_page(void* context, uint8_t page)
+{
+    struct nv_flash_file* flash = (struct nv_flash_file*) context;
+    if (flash->powered_off || page >= flash->flash.page_count)
+    {
+        return false;
+    }
+
+    uint8_t erased[256];
+    memset(erased, NV_FLASH_FILE_ERASED_BYTE, sizeof(erased));
+    uint16_t length = flash->flash.page_size;
+    const bool powered = _nv_flash_file_consume_power(flash, &length);
+    flash->erase_count[page]++;
+
+    const uint32_t page_address = (uint32_t) page * flash->flash.page_size;
+    for (uint16_t offset = 0; offset < length;
+         offset = (uint16_t)(offset + sizeof(erased)))
+    {
+        uint16_t chunk = (uint16_t)(length - offset);
+        if (chunk > sizeof(erased))
+        {
+            chunk = sizeof(erased);
+        }
+        if (!_nv_flash_file_write_bytes(
+                flash, page_address + offset, erased, chunk))
+        {
+            return false;
+        }
+    }
+    return powered;
+}
+
+bool nv_flash_file_open(struct nv_flash_file* flash,
+                        const char* path,
+                        uint16_t page_size,
+                        uint8_t page_count)
+{
+    memset(flash, 0x00, sizeof(*flash));
+    flash->bytes_until_power_loss = -1;
+    flash->flash.context = flash;
+    flash->flash.page_size = page_size;
+    flash->flash.page_count = page_count;
+    flash->flash.read = _nv_flash_file_read;
+    flash->flash.program = _nv_flash_file_program;
+    flash->flash.erase_page = _nv_flash_file_erase_page;
+
+    flash->file = fopen(path, "r+b");
+    if (flash->file != NULL)
+    {
+        return true;
+    }
+
+    // New file, fill with erased bytes
+    flash->file = fopen(path, "w+b");
+    if (flash->file == NULL)
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < (uint32_t) page_size * page_count; i++)
+    {
+        if (fputc(NV_FLASH_FILE_ERASED_BYTE, flash->file) == EOF)
+        {
+            nv_flash_file_close(flash);
+            return false;
+        }
+    }
+    return fflush(flash->file) == 0;
+}
+
+void nv_flash_file_close(struct nv_flash_file* flash)
+{
+    if (flash->file != NULL)
+    {
+        fclose(flash->file);
+        flash->file = NULL;
+    }
+}
+
+void nv_flash_file_power_loss_after(struct nv_flash_file* flash,
+                                    int32_t bytes)
+{
+    flash->bytes_until_power_loss = bytes;
+}
+
+void nv_flash_file_power_on(struct nv_flash_file* flash)
+{
+    flash->bytes_until_power_loss = -1;
+    flash->powered_off = false;
+}
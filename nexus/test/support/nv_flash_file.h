@@ -0,0 +1,77 @@
+/** \file nv_flash_file.h
+ * \brief File-backed flash page emulator, for testing `utils/nv_log.h`.
+ * \author Angaza
+ * \copyright 2021 Angaza, Inc.
+ * \license This file is released under the MIT license
+ *
+ * The above copyright notice and license shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * Emulates page-erasable NOR flash in a file on the host: erased bytes are
+ * 0xFF, programming may only clear bits, and only whole pages are erased.
+ * Erases and programmed bytes are counted per page, and a power loss may be
+ * simulated partway through a program or erase operation.
+ */
+
+#ifndef __NEXUS__TEST__SUPPORT__NV_FLASH_FILE_H_
+#define __NEXUS__TEST__SUPPORT__NV_FLASH_FILE_H_
+
+#include "utils/nv_log.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct nv_flash_file
+{
+    FILE* file;
+    struct nv_log_flash flash; // interface to pass to `nv_log_init`
+    uint32_t erase_count[NV_LOG_MAX_PAGES];
+    uint32_t bytes_programmed;
+    // Bytes which may be programmed before a simulated power loss;
+    // negative if power loss is not simulated
+    int32_t bytes_until_power_loss;
+    bool powered_off;
+};
+
+/** Open (creating if required) a flash file.
+ *
+ * A newly created file is blank (all bytes 0xFF).
+ *
+ * \param flash emulator state to initialize
+ * \param path path of the file storing flash contents
+ * \param page_size bytes per page
+ * \param page_count number of pages
+ * \return true if the file was opened, false otherwise
+ */
+bool nv_flash_file_open(struct nv_flash_file* flash,
+                        const char* path,
+                        uint16_t page_size,
+                        uint8_t page_count);
+
+/** Close a flash file opened with `nv_flash_file_open`.
+ */
+void nv_flash_file_close(struct nv_flash_file* flash);
+
+/** Simulate a power loss after `bytes` more bytes are programmed.
+ *
+ * The program operation during which power is lost writes only part of
+ * its data, and an erase during power loss leaves the page partly erased.
+ * All operations fail until `nv_flash_file_power_on` is called.
+ */
+void nv_flash_file_power_loss_after(struct nv_flash_file* flash,
+                                    int32_t bytes);
+
+/** Restore power after a simulated power loss.
+ */
+void nv_flash_file_power_on(struct nv_flash_file* flash);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -3,6 +3,7 @@
 #include "include/nx_common.h"
 #include "src/nexus_channel_om.h"
 #include "src/nexus_nv.h"
+#include "src/nexus_security.h"
 #include "src/nexus_util.h"
 #include "unity.h"
 #include "utils/crc_ccitt.h"
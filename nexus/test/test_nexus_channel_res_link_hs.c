@@ -223,6 +223,7 @@ void _initialize_oc_rep_pool(void)
     rep_objects.count = rep_objects_alloc;
     rep_objects.mem = (void*) rep_objects_pool;
     rep_objects.buffers_avail_cb = 0;
+    oc_memb_init(&rep_objects);
 
     oc_rep_set_pool(&rep_objects);
 }
@@ -109,6 +109,7 @@ void _initialize_oc_rep_pool(void)
     rep_objects.count = rep_objects_alloc;
     rep_objects.mem = (void*) rep_objects_pool;
     rep_objects.buffers_avail_cb = 0;
+    oc_memb_init(&rep_objects);
 
     oc_rep_set_pool(&rep_objects);
 }
@@ -913,6 +914,81 @@ void test_link_manager__security_data_from_nxid__data_present__returns_correct_d
                              sizeof(struct nx_common_check_key));
 }
 
+void test_link_manager__security_handle_from_nxid__no_data_present__returns_false(
+    void)
+{
+    // initializes with no links present
+    struct nx_id linked_id = {0};
+    linked_id.authority_id = 5921;
+    linked_id.device_id = 123456;
+
+    struct nexus_channel_link_security_handle handle;
+    memset(&handle, 0xDE, sizeof(handle));
+    bool result =
+        nexus_channel_link_manager_security_handle_from_nxid(&linked_id,
+                                                             &handle);
+    TEST_ASSERT_FALSE(result);
+
+    // handle unmodified if no data is found
+    TEST_ASSERT_EACH_EQUAL_UINT8(0xDE, (uint8_t*) &handle, sizeof(handle));
+}
+
+void test_link_manager__security_handle_from_nxid__data_present__key_state_matches_key(
+    void)
+{
+    struct nx_id linked_id = {0};
+    linked_id.authority_id = 5921;
+    linked_id.device_id = 123456;
+
+    union nexus_channel_link_security_data sec_data;
+    memset(&sec_data, 0xBB, sizeof(sec_data)); // arbitrary
+    sec_data.mode0.nonce = 5;
+    memset(&sec_data.mode0.sym_key, 0xFA, sizeof(sec_data.mode0.sym_key));
+
+    nxp_common_request_processing_Expect();
+    nexus_channel_link_manager_create_link(
+        &linked_id,
+        CHANNEL_LINK_OPERATING_MODE_CONTROLLER,
+        NEXUS_CHANNEL_LINK_SECURITY_MODE_KEY128SYM_COSE_MAC0_AUTH_SIPHASH24,
+        &sec_data);
+    nxp_channel_notify_event_Expect(
+        NXP_CHANNEL_EVENT_LINK_ESTABLISHED_AS_CONTROLLER);
+    nexus_channel_link_manager_process(0);
+
+    struct nexus_channel_link_security_handle handle;
+    bool result =
+        nexus_channel_link_manager_security_handle_from_nxid(&linked_id,
+                                                             &handle);
+    TEST_ASSERT_TRUE(result);
+    TEST_ASSERT_EQUAL(5, handle.nonce);
+
+    // MACs computed with the link key state match MACs using the key
+    const uint8_t data[] = {0x01, 0x02, 0x03, 0x04, 0x05};
+    const struct nexus_check_value expected =
+        nexus_check_compute(&sec_data.mode0.sym_key, data, sizeof(data));
+    const struct nexus_check_value actual =
+        nexus_check_compute_keyed(handle.key_state, data, sizeof(data));
+    TEST_ASSERT_EQUAL_MEMORY(&expected, &actual, sizeof(expected));
+
+    // nonce changes are reflected in new handles
+    TEST_ASSERT_TRUE(
+        nexus_channel_link_manager_set_security_data_auth_nonce(&linked_id, 9));
+    TEST_ASSERT_TRUE(nexus_channel_link_manager_security_handle_from_nxid(
+        &linked_id, &handle));
+    TEST_ASSERT_EQUAL(9, handle.nonce);
+
+    // key state is cleared when the link is deleted
+    const struct nexus_check_keyed_state* key_state = handle.key_state;
+    nxp_common_request_processing_Expect();
+    nexus_channel_link_manager_clear_all_links();
+    nxp_channel_notify_event_Expect(NXP_CHANNEL_EVENT_LINK_DELETED);
+    nexus_channel_link_manager_process(0);
+    TEST_ASSERT_FALSE(nexus_channel_link_manager_security_handle_from_nxid(
+        &linked_id, &handle));
+    TEST_ASSERT_EACH_EQUAL_UINT8(
+        0, (const uint8_t*) key_state, sizeof(struct nexus_check_keyed_state));
+}
+
 void test_link_manager__increment_security_data_mode0__nonce_updated(void)
 {
     // initializes with no links present
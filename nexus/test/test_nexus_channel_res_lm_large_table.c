@@ -0,0 +1,279 @@
+#include "include/nx_channel.h"
+#include "messaging/coap/coap.h"
+#include "messaging/coap/engine.h"
+#include "oc/api/oc_main.h"
+#include "oc/include/oc_api.h"
+#include "oc/include/oc_buffer.h"
+#include "oc/include/oc_core_res.h"
+#include "oc/include/oc_endpoint.h"
+#include "oc/include/oc_helpers.h"
+#include "oc/include/oc_rep.h"
+#include "oc/include/oc_ri.h"
+#include "oc/util/oc_etimer.h"
+#include "oc/util/oc_mmem.h"
+#include "oc/util/oc_process.h"
+#include "oc/util/oc_timer.h"
+
+#include "util/oc_memb.h"
+#include "utils/oc_list.h"
+#include "utils/oc_uuid.h"
+
+#include "src/internal_channel_config.h"
+#include "src/nexus_channel_core.h"
+#include "src/nexus_channel_om.h"
+#include "src/nexus_channel_res_link_hs.h"
+#include "src/nexus_channel_res_lm.h"
+#include "src/nexus_channel_res_payg_credit.h"
+#include "src/nexus_channel_sm.h"
+#include "src/nexus_common_internal.h"
+#include "src/nexus_cose_mac0_common.h"
+#include "src/nexus_cose_mac0_sign.h"
+#include "src/nexus_cose_mac0_verify.h"
+#include "src/nexus_keycode_core.h"
+#include "src/nexus_keycode_mas.h"
+#include "src/nexus_keycode_pro.h"
+#include "src/nexus_keycode_pro_extended.h"
+#include "src/nexus_nv.h"
+#include "src/nexus_oc_wrapper.h"
+#include "src/nexus_security.h"
+#include "src/nexus_util.h"
+#include "unity.h"
+#include "utils/crc_ccitt.h"
+#include "utils/siphash_24.h"
+
+// Other support libraries
+#include <mock_nxp_channel.h>
+#include <mock_nxp_common.h>
+#include <mock_nxp_keycode.h>
+#include <string.h>
+
+/********************************************************
+ * DEFINITIONS
+ *******************************************************/
+#define LINK_PAGE_LAST_BLOCK_ID                                                \
+    (NX_COMMON_NV_LINK_PAGE_FIRST_BLOCK_ID + NX_COMMON_NV_LINK_PAGE_COUNT - 1)
+
+/********************************************************
+ * PRIVATE DATA
+ *******************************************************/
+// NV blocks storing link pages, as last written
+static uint8_t _nv_pages[NX_COMMON_NV_LINK_PAGE_COUNT]
+                        [NX_COMMON_NV_LINK_PAGE_BLOCK_LENGTH];
+static uint32_t _page_write_count;
+static uint32_t _other_link_block_write_count;
+
+/********************************************************
+ * PRIVATE FUNCTIONS
+ *******************************************************/
+// pull in source file from IoTivity without changing its name
+// https://github.com/ThrowTheSwitch/Ceedling/issues/113
+TEST_FILE("oc/api/oc_server_api.c")
+TEST_FILE("oc/api/oc_client_api.c")
+TEST_FILE("oc/deps/tinycbor/cborencoder.c")
+TEST_FILE("oc/deps/tinycbor/cborparser.c")
+
+bool CALLBACK_nxp_common_nv_write(
+    const struct nx_common_nv_block_meta block_meta,
+    void* write_buffer,
+    int NumCalls)
+{
+    (void) NumCalls;
+    if (block_meta.block_id >= NX_COMMON_NV_LINK_PAGE_FIRST_BLOCK_ID &&
+        block_meta.block_id <= LINK_PAGE_LAST_BLOCK_ID)
+    {
+        TEST_ASSERT_EQUAL_UINT(NX_COMMON_NV_LINK_PAGE_BLOCK_LENGTH,
+                               block_meta.length);
+        memcpy(_nv_pages[block_meta.block_id -
+                         NX_COMMON_NV_LINK_PAGE_FIRST_BLOCK_ID],
+               write_buffer,
+               NX_COMMON_NV_LINK_PAGE_BLOCK_LENGTH);
+        _page_write_count++;
+    }
+    else if (block_meta.block_id >= NX_NV_BLOCK_CHANNEL_LM_LINK_1.block_id)
+    {
+        _other_link_block_write_count++;
+    }
+    return true;
+}
+
+bool CALLBACK_nxp_common_nv_read(
+    const struct nx_common_nv_block_meta block_meta,
+    void* read_buffer,
+    int NumCalls)
+{
+    (void) NumCalls;
+    if (block_meta.block_id >= NX_COMMON_NV_LINK_PAGE_FIRST_BLOCK_ID &&
+        block_meta.block_id <= LINK_PAGE_LAST_BLOCK_ID)
+    {
+        memcpy(read_buffer,
+               _nv_pages[block_meta.block_id -
+                         NX_COMMON_NV_LINK_PAGE_FIRST_BLOCK_ID],
+               NX_COMMON_NV_LINK_PAGE_BLOCK_LENGTH);
+        return true;
+    }
+    return false;
+}
+
+// Setup (called before any 'test_*' function is called, automatically)
+void setUp(void)
+{
+    memset(_nv_pages, 0x00, sizeof(_nv_pages));
+    _page_write_count = 0;
+    _other_link_block_write_count = 0;
+    nxp_common_nv_read_StubWithCallback(CALLBACK_nxp_common_nv_read);
+    nxp_common_nv_write_StubWithCallback(CALLBACK_nxp_common_nv_write);
+    nxp_channel_random_value_IgnoreAndReturn(123456);
+    nxp_channel_notify_event_Ignore();
+    nxp_common_request_processing_Ignore();
+    nexus_channel_core_init();
+
+    // In tests, `nexus_channel_core_init` does not initialize channel
+    // submodules, so we can enable just this submodule manually
+    nexus_channel_link_manager_init();
+}
+
+// Teardown (called after any 'test_*' function is called, automatically)
+void tearDown(void)
+{
+    nexus_channel_core_shutdown();
+}
+
+// Simulate a reset, loading links from NV
+static void _reinit(void)
+{
+    nexus_channel_core_shutdown();
+    nexus_channel_core_init();
+    nexus_channel_link_manager_init();
+}
+
+// Arbitrary, distinct IDs which share authority IDs and have nearby device IDs
+static struct nx_id _linked_id(uint8_t index)
+{
+    const struct nx_id id = {(uint16_t)(0x1000 + index % 2),
+                             (uint32_t)(5000 + index / 2)};
+    return id;
+}
+
+static void _create_link(const struct nx_id* id, uint32_t nonce)
+{
+    union nexus_channel_link_security_data sec_data;
+    memset(&sec_data, 0xBB, sizeof(sec_data)); // arbitrary
+    sec_data.mode0.nonce = nonce;
+
+    TEST_ASSERT_TRUE(nexus_channel_link_manager_create_link(
+        id,
+        CHANNEL_LINK_OPERATING_MODE_CONTROLLER,
+        NEXUS_CHANNEL_LINK_SECURITY_MODE_KEY128SYM_COSE_MAC0_AUTH_SIPHASH24,
+        &sec_data));
+    nexus_channel_link_manager_process(0);
+}
+
+static void _create_all_links(void)
+{
+    for (uint8_t i = 0; i < NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS; i++)
+    {
+        const struct nx_id id = _linked_id(i);
+        _create_link(&id, i);
+    }
+    TEST_ASSERT_EQUAL_UINT(NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS,
+                           nx_channel_link_count());
+}
+
+static void _assert_all_links_found(void)
+{
+    nexus_channel_link_t link;
+    for (uint8_t i = 0; i < NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS; i++)
+    {
+        const struct nx_id id = _linked_id(i);
+        TEST_ASSERT_TRUE(nexus_channel_link_manager_link_from_nxid(&id, &link));
+        TEST_ASSERT_EQUAL_UINT(id.authority_id,
+                               link.linked_device_id.authority_id);
+        TEST_ASSERT_EQUAL_UINT(id.device_id, link.linked_device_id.device_id);
+    }
+}
+
+void test_large_table__create_links__all_found_and_stored_in_pages(void)
+{
+    _create_all_links();
+    _assert_all_links_found();
+
+    // one page write per new link, and no per-link block writes
+    TEST_ASSERT_EQUAL_UINT(NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS,
+                           _page_write_count);
+    TEST_ASSERT_EQUAL_UINT(0, _other_link_block_write_count);
+
+    nexus_channel_link_t link;
+    const struct nx_id unknown_ids[] = {
+        {0x1000, 4999},
+        {0x1002, 5000},
+        {0x1001, 5000 + NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS},
+    };
+    for (uint8_t i = 0; i < sizeof(unknown_ids) / sizeof(unknown_ids[0]); i++)
+    {
+        TEST_ASSERT_FALSE(
+            nexus_channel_link_manager_link_from_nxid(&unknown_ids[i], &link));
+    }
+}
+
+void test_large_table__relink_each_link__other_links_still_found(void)
+{
+    _create_all_links();
+
+    // Relinking deletes the existing link and creates a new one; every
+    // other link must remain reachable after each deletion
+    for (uint8_t i = 0; i < NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS; i++)
+    {
+        const struct nx_id id = _linked_id(i);
+        _create_link(&id, 100);
+        TEST_ASSERT_EQUAL_UINT(NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS,
+                               nx_channel_link_count());
+        _assert_all_links_found();
+    }
+}
+
+void test_large_table__clear_all_links__no_links_found(void)
+{
+    _create_all_links();
+
+    nexus_channel_link_manager_clear_all_links();
+    nexus_channel_link_manager_process(0);
+    TEST_ASSERT_EQUAL_UINT(0, nx_channel_link_count());
+
+    nexus_channel_link_t link;
+    for (uint8_t i = 0; i < NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS; i++)
+    {
+        const struct nx_id id = _linked_id(i);
+        TEST_ASSERT_FALSE(
+            nexus_channel_link_manager_link_from_nxid(&id, &link));
+    }
+
+    // links are cleared in NV as well
+    _reinit();
+    TEST_ASSERT_EQUAL_UINT(0, nx_channel_link_count());
+}
+
+void test_large_table__reinit__links_restored_from_pages(void)
+{
+    _create_all_links();
+
+    _reinit();
+    TEST_ASSERT_EQUAL_UINT(NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS,
+                           nx_channel_link_count());
+    _assert_all_links_found();
+
+    struct nexus_channel_link_security_mode0_data sec_data;
+    for (uint8_t i = 0; i < NEXUS_CHANNEL_MAX_SIMULTANEOUS_LINKS; i++)
+    {
+        const struct nx_id id = _linked_id(i);
+        TEST_ASSERT_TRUE(
+            nexus_channel_link_manager_security_data_from_nxid(&id, &sec_data));
+        TEST_ASSERT_EQUAL_UINT(
+            i + NEXUS_CHANNEL_LINK_SECURITY_NONCE_NV_STORAGE_INTERVAL_COUNT,
+            sec_data.nonce);
+    }
+
+    // Updated nonces of all links are persisted, one write per page
+    _page_write_count = 0;
+    nexus_channel_link_manager_process(0);
+    TEST_ASSERT_EQUAL_UINT(NX_COMMON_NV_LINK_PAGE_COUNT, _page_write_count);
+}
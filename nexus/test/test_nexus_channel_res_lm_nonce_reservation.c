@@ -0,0 +1,217 @@
+#include "include/nx_channel.h"
+#include "messaging/coap/coap.h"
+#include "messaging/coap/engine.h"
+#include "oc/api/oc_main.h"
+#include "oc/include/oc_api.h"
+#include "oc/include/oc_buffer.h"
+#include "oc/include/oc_core_res.h"
+#include "oc/include/oc_endpoint.h"
+#include "oc/include/oc_helpers.h"
+#include "oc/include/oc_rep.h"
+#include "oc/include/oc_ri.h"
+#include "oc/util/oc_etimer.h"
+#include "oc/util/oc_mmem.h"
+#include "oc/util/oc_process.h"
+#include "oc/util/oc_timer.h"
+
+#include "util/oc_memb.h"
+#include "utils/oc_list.h"
+#include "utils/oc_uuid.h"
+
+#include "src/internal_channel_config.h"
+#include "src/nexus_channel_core.h"
+#include "src/nexus_channel_om.h"
+#include "src/nexus_channel_res_link_hs.h"
+#include "src/nexus_channel_res_lm.h"
+#include "src/nexus_channel_res_payg_credit.h"
+#include "src/nexus_channel_sm.h"
+#include "src/nexus_common_internal.h"
+#include "src/nexus_cose_mac0_common.h"
+#include "src/nexus_cose_mac0_sign.h"
+#include "src/nexus_cose_mac0_verify.h"
+#include "src/nexus_keycode_core.h"
+#include "src/nexus_keycode_mas.h"
+#include "src/nexus_keycode_pro.h"
+#include "src/nexus_keycode_pro_extended.h"
+#include "src/nexus_nv.h"
+#include "src/nexus_oc_wrapper.h"
+#include "src/nexus_security.h"
+#include "src/nexus_util.h"
+#include "unity.h"
+#include "utils/crc_ccitt.h"
+#include "utils/siphash_24.h"
+
+// Other support libraries
+#include <mock_nxp_channel.h>
+#include <mock_nxp_common.h>
+#include <mock_nxp_keycode.h>
+#include <string.h>
+
+/********************************************************
+ * DEFINITIONS
+ *******************************************************/
+// Offset of the nonce in a persisted link NV block
+#define LINK_BLOCK_NONCE_OFFSET                                                \
+    (NEXUS_NV_BLOCK_ID_WIDTH + sizeof(nexus_channel_link_t) - sizeof(uint32_t))
+
+/********************************************************
+ * PRIVATE DATA
+ *******************************************************/
+static const struct nx_id LINKED_ID = {5921, 123456};
+
+static uint32_t _link_write_count;
+static uint32_t _last_persisted_nonce;
+
+/********************************************************
+ * PRIVATE FUNCTIONS
+ *******************************************************/
+// pull in source file from IoTivity without changing its name
+// https://github.com/ThrowTheSwitch/Ceedling/issues/113
+TEST_FILE("oc/api/oc_server_api.c")
+TEST_FILE("oc/api/oc_client_api.c")
+TEST_FILE("oc/deps/tinycbor/cborencoder.c")
+TEST_FILE("oc/deps/tinycbor/cborparser.c")
+
+bool CALLBACK_nxp_common_nv_write(
+    const struct nx_common_nv_block_meta block_meta,
+    void* write_buffer,
+    int NumCalls)
+{
+    (void) NumCalls;
+    // the only link is stored in the first link block
+    if (block_meta.block_id == NX_NV_BLOCK_CHANNEL_LM_LINK_1.block_id)
+    {
+        _link_write_count++;
+        memcpy(&_last_persisted_nonce,
+               (uint8_t*) write_buffer + LINK_BLOCK_NONCE_OFFSET,
+               sizeof(uint32_t));
+    }
+    return true;
+}
+
+// Setup (called before any 'test_*' function is called, automatically)
+void setUp(void)
+{
+    _link_write_count = 0;
+    nxp_common_nv_read_IgnoreAndReturn(false);
+    nxp_common_nv_write_StubWithCallback(CALLBACK_nxp_common_nv_write);
+    nxp_channel_random_value_IgnoreAndReturn(123456);
+    nexus_channel_core_init();
+
+    // In tests, `nexus_channel_core_init` does not initialize channel
+    // submodules, so we can enable just this submodule manually
+    nexus_channel_link_manager_init();
+
+    union nexus_channel_link_security_data sec_data;
+    memset(&sec_data, 0xBB, sizeof(sec_data)); // arbitrary
+    sec_data.mode0.nonce = 5;
+
+    nxp_common_request_processing_Expect();
+    nexus_channel_link_manager_create_link(
+        &LINKED_ID,
+        CHANNEL_LINK_OPERATING_MODE_CONTROLLER,
+        NEXUS_CHANNEL_LINK_SECURITY_MODE_KEY128SYM_COSE_MAC0_AUTH_SIPHASH24,
+        &sec_data);
+    nxp_channel_notify_event_Expect(
+        NXP_CHANNEL_EVENT_LINK_ESTABLISHED_AS_CONTROLLER);
+    nexus_channel_link_manager_process(0);
+
+    TEST_ASSERT_EQUAL_UINT(1, _link_write_count);
+    TEST_ASSERT_EQUAL_UINT(5, _last_persisted_nonce);
+    _link_write_count = 0;
+}
+
+// Teardown (called after any 'test_*' function is called, automatically)
+void tearDown(void)
+{
+    nexus_channel_core_shutdown();
+}
+
+// Use nonces up to `last_nonce`, calling process every `seconds_per_message`
+static void _send_messages(uint32_t first_nonce,
+                           uint32_t last_nonce,
+                           uint32_t seconds_per_message)
+{
+    for (uint32_t nonce = first_nonce; nonce <= last_nonce; nonce++)
+    {
+        TEST_ASSERT_TRUE(
+            nexus_channel_link_manager_set_security_data_auth_nonce(&LINKED_ID,
+                                                                    nonce));
+        (void) nexus_channel_link_manager_reset_link_secs_since_active(
+            &LINKED_ID);
+        nexus_channel_link_manager_process(seconds_per_message);
+    }
+}
+
+void test_nonce_reservation__first_message__reserves_interval_count(void)
+{
+    _send_messages(6, 6, 1);
+    TEST_ASSERT_EQUAL_UINT(1, _link_write_count);
+    TEST_ASSERT_EQUAL_UINT(
+        6 + NEXUS_CHANNEL_LINK_SECURITY_NONCE_NV_STORAGE_INTERVAL_COUNT,
+        _last_persisted_nonce);
+
+    // no further writes until the reservation is used up
+    _send_messages(
+        7, 6 + NEXUS_CHANNEL_LINK_SECURITY_NONCE_NV_STORAGE_INTERVAL_COUNT, 1);
+    TEST_ASSERT_EQUAL_UINT(1, _link_write_count);
+}
+
+void test_nonce_reservation__busy_link__reservation_grows(void)
+{
+    const uint32_t interval =
+        NEXUS_CHANNEL_LINK_SECURITY_NONCE_NV_STORAGE_INTERVAL_COUNT;
+
+    // first reservation is used up quickly, so the next one is larger
+    _send_messages(6, 6 + interval + 1, 1);
+    TEST_ASSERT_EQUAL_UINT(2, _link_write_count);
+    TEST_ASSERT_EQUAL_UINT(6 + interval + 1 + 2 * interval,
+                           _last_persisted_nonce);
+
+    // continue until the reservation reaches its maximum size
+    uint32_t nonce = 6 + interval + 1;
+    uint32_t expected_size = 2 * interval;
+    while (expected_size <
+           NEXUS_CHANNEL_LINK_SECURITY_NONCE_RESERVATION_MAX_COUNT)
+    {
+        expected_size *= 2;
+        _send_messages(nonce + 1, _last_persisted_nonce + 1, 1);
+        nonce = _last_persisted_nonce - expected_size;
+    }
+    const uint32_t write_count = _link_write_count;
+    const uint32_t reserved = _last_persisted_nonce;
+
+    // reservation stays at its maximum size
+    _send_messages(nonce + 1, reserved + 1, 1);
+    TEST_ASSERT_EQUAL_UINT(write_count + 1, _link_write_count);
+    TEST_ASSERT_EQUAL_UINT(
+        reserved + 1 + NEXUS_CHANNEL_LINK_SECURITY_NONCE_RESERVATION_MAX_COUNT,
+        _last_persisted_nonce);
+}
+
+void test_nonce_reservation__quiet_link__reservation_does_not_grow(void)
+{
+    const uint32_t interval =
+        NEXUS_CHANNEL_LINK_SECURITY_NONCE_NV_STORAGE_INTERVAL_COUNT;
+    const uint32_t slow_seconds =
+        NEXUS_CHANNEL_LINK_SECURITY_NONCE_RESERVATION_SECONDS / interval + 1;
+
+    _send_messages(6, 6, slow_seconds);
+    _send_messages(7, 6 + interval + 1, slow_seconds);
+    TEST_ASSERT_EQUAL_UINT(2, _link_write_count);
+    TEST_ASSERT_EQUAL_UINT(6 + interval + 1 + interval, _last_persisted_nonce);
+}
+
+void test_nonce_reservation__nonce_reset__persisted_immediately(void)
+{
+    _send_messages(6, 6, 1);
+    TEST_ASSERT_EQUAL_UINT(1, _link_write_count);
+
+    TEST_ASSERT_TRUE(
+        nexus_channel_link_manager_set_security_data_auth_nonce(&LINKED_ID, 0));
+    nexus_channel_link_manager_process(0);
+    TEST_ASSERT_EQUAL_UINT(2, _link_write_count);
+    TEST_ASSERT_EQUAL_UINT(
+        NEXUS_CHANNEL_LINK_SECURITY_NONCE_NV_STORAGE_INTERVAL_COUNT,
+        _last_persisted_nonce);
+}
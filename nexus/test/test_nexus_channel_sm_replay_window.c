@@ -0,0 +1,415 @@
+#include "include/nx_channel.h"
+#include "messaging/coap/coap.h"
+#include "messaging/coap/engine.h"
+#include "oc/api/oc_main.h"
+#include "oc/include/oc_api.h"
+#include "oc/include/oc_buffer.h"
+#include "oc/include/oc_core_res.h"
+#include "oc/include/oc_endpoint.h"
+#include "oc/include/oc_helpers.h"
+#include "oc/include/oc_rep.h"
+#include "oc/include/oc_ri.h"
+#include "oc/util/oc_etimer.h"
+#include "oc/util/oc_mmem.h"
+#include "oc/util/oc_process.h"
+#include "oc/util/oc_timer.h"
+
+#include "util/oc_memb.h"
+#include "utils/oc_list.h"
+#include "utils/oc_uuid.h"
+
+#include "src/internal_channel_config.h"
+#include "src/nexus_channel_core.h"
+#include "src/nexus_channel_om.h"
+#include "src/nexus_channel_res_link_hs.h"
+#include "src/nexus_channel_res_lm.h"
+#include "src/nexus_channel_res_payg_credit.h"
+#include "src/nexus_channel_sm.h"
+#include "src/nexus_common_internal.h"
+#include "src/nexus_cose_mac0_common.h"
+#include "src/nexus_cose_mac0_sign.h"
+#include "src/nexus_cose_mac0_verify.h"
+#include "src/nexus_keycode_core.h"
+#include "src/nexus_keycode_mas.h"
+#include "src/nexus_keycode_pro.h"
+#include "src/nexus_keycode_pro_extended.h"
+#include "src/nexus_nv.h"
+#include "src/nexus_oc_wrapper.h"
+#include "src/nexus_security.h"
+#include "src/nexus_util.h"
+#include "unity.h"
+#include "utils/crc_ccitt.h"
+#include "utils/siphash_24.h"
+
+// Other support libraries
+#include <mock_nxp_channel.h>
+#include <mock_nxp_common.h>
+#include <mock_nxp_keycode.h>
+#include <string.h>
+
+/********************************************************
+ * DEFINITIONS
+ *******************************************************/
+
+// Secured requests in flight at once (`OC_MAX_NUM_CONCURRENT_REQUESTS`)
+#define SENT_REQUEST_MAX_COUNT 2
+
+/********************************************************
+ * PRIVATE DATA
+ *******************************************************/
+// Nexus ID {53932, 4244308258}, represented by `FAKE_ACCESSORY_ENDPOINT`
+static const struct nx_id LINKED_ID = {53932, 4244308258};
+
+oc_endpoint_t FAKE_ACCESSORY_ENDPOINT = {
+    NULL, // 'next'
+    0, // device
+    IPV6, // flags
+    {{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}}, // di
+    {(oc_ipv6_addr_t){
+        5683, // port
+        {// arbitrary link local address that represents a Nexus ID
+         0xFE,
+         0x80,
+         0,
+         0,
+         0,
+         0,
+         0,
+         0,
+         0xD0,
+         0xAC,
+         0xFC,
+         0xFF,
+         0xFE,
+         0xFB,
+         0x01,
+         0x22},
+        2 // scope
+    }},
+    {{0}}, // addr_local (unused)
+    0, // interface index (not used)
+    0, // priority (not used)
+    0, // ocf_version_t (unused)
+};
+
+static struct nx_common_check_key LINK_KEY;
+
+// Secured requests sent by this device
+static uint8_t _sent_requests[SENT_REQUEST_MAX_COUNT]
+                             [NEXUS_CHANNEL_MAX_COAP_TOTAL_MESSAGE_SIZE];
+static uint32_t _sent_request_lengths[SENT_REQUEST_MAX_COUNT];
+static uint8_t _sent_request_count;
+
+/********************************************************
+ * PRIVATE FUNCTIONS
+ *******************************************************/
+// pull in source file from IoTivity without changing its name
+// https://github.com/ThrowTheSwitch/Ceedling/issues/113
+TEST_FILE("oc/api/oc_server_api.c")
+TEST_FILE("oc/api/oc_client_api.c")
+TEST_FILE("oc/deps/tinycbor/cborencoder.c")
+TEST_FILE("oc/deps/tinycbor/cborparser.c")
+
+// Setup (called before any 'test_*' function is called, automatically)
+void setUp(void)
+{
+    nxp_channel_notify_event_Ignore();
+    nxp_common_nv_read_IgnoreAndReturn(false);
+    nxp_common_nv_write_IgnoreAndReturn(true);
+    nxp_channel_random_value_IgnoreAndReturn(123456);
+    nexus_channel_core_init();
+
+    // In tests, `nexus_channel_core_init` does not initialize channel
+    // submodules, so we can enable just this submodule manually
+    nexus_channel_link_manager_init();
+
+    memset(&LINK_KEY, 0xFA, sizeof(LINK_KEY)); // arbitrary
+
+    union nexus_channel_link_security_data sec_data;
+    memset(&sec_data, 0xBB, sizeof(sec_data)); // arbitrary
+    sec_data.mode0.nonce = 5;
+    memcpy(&sec_data.mode0.sym_key, &LINK_KEY, sizeof(LINK_KEY));
+
+    nxp_common_request_processing_Expect();
+    nexus_channel_link_manager_create_link(
+        &LINKED_ID,
+        CHANNEL_LINK_OPERATING_MODE_CONTROLLER,
+        NEXUS_CHANNEL_LINK_SECURITY_MODE_KEY128SYM_COSE_MAC0_AUTH_SIPHASH24,
+        &sec_data);
+    nexus_channel_link_manager_process(0);
+}
+
+// Teardown (called after any 'test_*' function is called, automatically)
+void tearDown(void)
+{
+    nexus_channel_core_shutdown();
+}
+
+// Authenticate a secured message with code `code` and nonce `nonce`
+static nexus_channel_sm_auth_error_t _authenticate(uint8_t code,
+                                                   uint32_t nonce)
+{
+    coap_packet_t packet;
+    // arbitrary message ID
+    coap_udp_init_message(&packet, COAP_TYPE_CON, code, 123);
+    coap_set_header_uri_path(&packet, "/nx/pc", strlen("/nx/pc"));
+    coap_set_header_content_format(&packet, APPLICATION_COSE_MAC0);
+
+    // HELLO WORLD
+    uint8_t payload_to_secure[11] = {
+        0x48, 0x45, 0x4C, 0x4C, 0x4F, 0x20, 0x57, 0x4F, 0x52, 0x4C, 0x44};
+    const nexus_cose_mac0_common_macparams_t mac_params = {
+        &LINK_KEY,
+        nonce,
+        // aad
+        {
+            packet.code,
+            (uint8_t*) packet.uri_path,
+            (uint8_t) packet.uri_path_len,
+        },
+        payload_to_secure,
+        sizeof(payload_to_secure),
+    };
+
+    uint8_t enc_data[NEXUS_CHANNEL_MAX_CBOR_PAYLOAD_SIZE];
+    size_t enc_size;
+    nexus_cose_error encode_result = nexus_cose_mac0_sign_encode_message(
+        &mac_params, enc_data, sizeof(enc_data), &enc_size);
+    TEST_ASSERT_EQUAL(NEXUS_COSE_ERROR_NONE, encode_result);
+    coap_set_payload(&packet, enc_data, enc_size);
+
+    return nexus_channel_authenticate_message(&FAKE_ACCESSORY_ENDPOINT,
+                                              &packet);
+}
+
+static uint32_t _link_nonce(void)
+{
+    struct nexus_channel_link_security_mode0_data sec_data;
+    TEST_ASSERT_TRUE(
+        nexus_channel_link_manager_security_data_from_nxid(&LINKED_ID,
+                                                           &sec_data));
+    return sec_data.nonce;
+}
+
+nx_channel_error
+CALLBACK_nxp_channel_network_send(const void* const bytes_to_send,
+                                  uint32_t bytes_count,
+                                  const struct nx_id* const source,
+                                  const struct nx_id* const dest,
+                                  bool is_multicast,
+                                  int NumCalls)
+{
+    (void) source;
+    (void) is_multicast;
+    (void) NumCalls;
+    TEST_ASSERT_EQUAL_MEMORY(&LINKED_ID, dest, sizeof(struct nx_id));
+    TEST_ASSERT_TRUE(_sent_request_count < SENT_REQUEST_MAX_COUNT);
+    TEST_ASSERT_TRUE(bytes_count <= NEXUS_CHANNEL_MAX_COAP_TOTAL_MESSAGE_SIZE);
+    memcpy(_sent_requests[_sent_request_count], bytes_to_send, bytes_count);
+    _sent_request_lengths[_sent_request_count] = bytes_count;
+    _sent_request_count++;
+    return NX_CHANNEL_ERROR_NONE;
+}
+
+static void _dummy_response_handler(nx_channel_client_response_t* response)
+{
+    (void) response;
+}
+
+// Authenticate the request sent with index `index`, as the linked device
+static nexus_channel_sm_auth_error_t _authenticate_sent_request(uint8_t index)
+{
+    // authentication unpacks the payload in place, so keep the sent request
+    uint8_t received[NEXUS_CHANNEL_MAX_COAP_TOTAL_MESSAGE_SIZE];
+    memcpy(received, _sent_requests[index], _sent_request_lengths[index]);
+
+    coap_packet_t packet;
+    TEST_ASSERT_EQUAL(
+        COAP_NO_ERROR,
+        coap_udp_parse_message(
+            &packet, received, (uint16_t) _sent_request_lengths[index]));
+    return nexus_channel_authenticate_message(&FAKE_ACCESSORY_ENDPOINT,
+                                              &packet);
+}
+
+void test_replay_window__in_order_requests__accepted_once(void)
+{
+    TEST_ASSERT_EQUAL(NEXUS_CHANNEL_SM_AUTH_MESSAGE_ERROR_NONE,
+                      _authenticate(COAP_PUT, 6));
+    TEST_ASSERT_EQUAL(NEXUS_CHANNEL_SM_AUTH_MESSAGE_ERROR_NONE,
+                      _authenticate(COAP_PUT, 7));
+    TEST_ASSERT_EQUAL_UINT(7, _link_nonce());
+
+    TEST_ASSERT_EQUAL(
+        NEXUS_CHANNEL_SM_AUTH_MESSAGE_ERROR_REQUEST_RECEIVED_WITH_INVALID_NONCE,
+        _authenticate(COAP_PUT, 6));
+    TEST_ASSERT_EQUAL(
+        NEXUS_CHANNEL_SM_AUTH_MESSAGE_ERROR_REQUEST_RECEIVED_WITH_INVALID_NONCE,
+        _authenticate(COAP_PUT, 7));
+    // nonces used before the link was created are never accepted
+    TEST_ASSERT_EQUAL(
+        NEXUS_CHANNEL_SM_AUTH_MESSAGE_ERROR_REQUEST_RECEIVED_WITH_INVALID_NONCE,
+        _authenticate(COAP_PUT, 5));
+    TEST_ASSERT_EQUAL_UINT(7, _link_nonce());
+}
+
+void test_replay_window__out_of_order_requests__accepted_once(void)
+{
+    TEST_ASSERT_EQUAL(NEXUS_CHANNEL_SM_AUTH_MESSAGE_ERROR_NONE,
+                      _authenticate(COAP_PUT, 9));
+    TEST_ASSERT_EQUAL(NEXUS_CHANNEL_SM_AUTH_MESSAGE_ERROR_NONE,
+                      _authenticate(COAP_POST, 7));
+    TEST_ASSERT_EQUAL(NEXUS_CHANNEL_SM_AUTH_MESSAGE_ERROR_NONE,
+                      _authenticate(COAP_GET, 6));
+    // out-of-order requests do not move the link nonce backwards
+    TEST_ASSERT_EQUAL_UINT(9, _link_nonce());
+
+    // replays are rejected
+    TEST_ASSERT_EQUAL(
+        NEXUS_CHANNEL_SM_AUTH_MESSAGE_ERROR_REQUEST_RECEIVED_WITH_INVALID_NONCE,
+        _authenticate(COAP_POST, 7));
+    TEST_ASSERT_EQUAL(
+        NEXUS_CHANNEL_SM_AUTH_MESSAGE_ERROR_REQUEST_RECEIVED_WITH_INVALID_NONCE,
+        _authenticate(COAP_PUT, 9));
+
+    // a late request with an unused nonce is still accepted
+    TEST_ASSERT_EQUAL(NEXUS_CHANNEL_SM_AUTH_MESSAGE_ERROR_NONE,
+                      _authenticate(COAP_PUT, 8));
+    TEST_ASSERT_EQUAL_UINT(9, _link_nonce());
+}
+
+void test_replay_window__request_below_window__rejected(void)
+{
+    const uint32_t newest = 100;
+    TEST_ASSERT_EQUAL(NEXUS_CHANNEL_SM_AUTH_MESSAGE_ERROR_NONE,
+                      _authenticate(COAP_PUT, newest));
+
+    // only the `SIZE` nonces up to the newest are tracked
+    TEST_ASSERT_EQUAL(
+        NEXUS_CHANNEL_SM_AUTH_MESSAGE_ERROR_REQUEST_RECEIVED_WITH_INVALID_NONCE,
+        _authenticate(COAP_PUT,
+                      newest - NEXUS_CHANNEL_LINK_SECURITY_REPLAY_WINDOW_SIZE));
+    TEST_ASSERT_EQUAL(
+        NEXUS_CHANNEL_SM_AUTH_MESSAGE_ERROR_NONE,
+        _authenticate(
+            COAP_PUT,
+            newest - NEXUS_CHANNEL_LINK_SECURITY_REPLAY_WINDOW_SIZE + 1));
+    TEST_ASSERT_EQUAL_UINT(newest, _link_nonce());
+}
+
+void test_replay_window__nonce_reset__window_reset(void)
+{
+    TEST_ASSERT_EQUAL(NEXUS_CHANNEL_SM_AUTH_MESSAGE_ERROR_NONE,
+                      _authenticate(COAP_PUT, 6));
+    TEST_ASSERT_EQUAL(
+        NEXUS_CHANNEL_SM_AUTH_MESSAGE_ERROR_NONCE_APPROACHING_MAX_FORCED_RESET_REQUIRED,
+        _authenticate(COAP_PUT, UINT32_MAX - 1));
+    TEST_ASSERT_EQUAL_UINT(0, _link_nonce());
+
+    // nonces below the reset value are not accepted
+    TEST_ASSERT_EQUAL(
+        NEXUS_CHANNEL_SM_AUTH_MESSAGE_ERROR_REQUEST_RECEIVED_WITH_INVALID_NONCE,
+        _authenticate(COAP_PUT, 0));
+    TEST_ASSERT_EQUAL(NEXUS_CHANNEL_SM_AUTH_MESSAGE_ERROR_NONE,
+                      _authenticate(COAP_PUT, 2));
+    TEST_ASSERT_EQUAL(NEXUS_CHANNEL_SM_AUTH_MESSAGE_ERROR_NONE,
+                      _authenticate(COAP_PUT, 1));
+    TEST_ASSERT_EQUAL(
+        NEXUS_CHANNEL_SM_AUTH_MESSAGE_ERROR_REQUEST_RECEIVED_WITH_INVALID_NONCE,
+        _authenticate(COAP_PUT, 1));
+}
+
+void test_replay_window__response_within_window__accepted(void)
+{
+    // two requests in flight, sent with nonces 6 and 7
+    TEST_ASSERT_TRUE(
+        nexus_channel_link_manager_set_security_data_auth_nonce(&LINKED_ID, 7));
+
+    TEST_ASSERT_EQUAL(NEXUS_CHANNEL_SM_AUTH_MESSAGE_ERROR_NONE,
+                      _authenticate(CONTENT_2_05, 6));
+    TEST_ASSERT_EQUAL_UINT(7, _link_nonce());
+    TEST_ASSERT_EQUAL(NEXUS_CHANNEL_SM_AUTH_MESSAGE_ERROR_NONE,
+                      _authenticate(CONTENT_2_05, 7));
+    TEST_ASSERT_EQUAL_UINT(7, _link_nonce());
+
+    TEST_ASSERT_TRUE(
+        nexus_channel_link_manager_set_security_data_auth_nonce(&LINKED_ID,
+                                                                100));
+    const uint32_t below_window =
+        100 - NEXUS_CHANNEL_LINK_SECURITY_REPLAY_WINDOW_SIZE - 1;
+    TEST_ASSERT_EQUAL(
+        NEXUS_CHANNEL_SM_AUTH_MESSAGE_ERROR_REQUEST_RECEIVED_WITH_INVALID_NONCE,
+        _authenticate(CONTENT_2_05, below_window));
+}
+
+void test_replay_window__late_nonce_sync__nonce_not_lowered(void)
+{
+    TEST_ASSERT_TRUE(
+        nexus_channel_link_manager_set_security_data_auth_nonce(&LINKED_ID,
+                                                                20));
+
+    TEST_ASSERT_EQUAL(
+        NEXUS_CHANNEL_SM_AUTH_MESSAGE_ERROR_VALID_NONCE_SYNC_RECEIVED,
+        _authenticate(NOT_ACCEPTABLE_4_06, 15));
+    TEST_ASSERT_EQUAL_UINT(20, _link_nonce());
+
+    TEST_ASSERT_EQUAL(
+        NEXUS_CHANNEL_SM_AUTH_MESSAGE_ERROR_VALID_NONCE_SYNC_RECEIVED,
+        _authenticate(NOT_ACCEPTABLE_4_06, 25));
+    TEST_ASSERT_EQUAL_UINT(25, _link_nonce());
+
+    // nonce reset signal still resets the nonce
+    TEST_ASSERT_EQUAL(
+        NEXUS_CHANNEL_SM_AUTH_MESSAGE_ERROR_VALID_NONCE_SYNC_RECEIVED,
+        _authenticate(NOT_ACCEPTABLE_4_06,
+                      NEXUS_CHANNEL_LINK_SECURITY_RESET_NONCE_SIGNAL_VALUE));
+    TEST_ASSERT_EQUAL_UINT(0, _link_nonce());
+}
+
+void test_replay_window__two_requests_in_flight__accepted_in_any_order(void)
+{
+    _sent_request_count = 0;
+    nxp_common_request_processing_Ignore();
+    nxp_channel_get_nexus_id_IgnoreAndReturn(LINKED_ID);
+    nxp_channel_network_send_StubWithCallback(
+        CALLBACK_nxp_channel_network_send);
+
+    // two secured requests are in flight on the link at once
+    for (uint8_t i = 0; i < 2; i++)
+    {
+        TEST_ASSERT_EQUAL(NX_CHANNEL_ERROR_NONE,
+                          nx_channel_do_get_request_secured(
+                              "nx/pc",
+                              &LINKED_ID,
+                              NULL,
+                              _dummy_response_handler,
+                              NULL));
+        // process OUTBOUND_NETWORK_EVENT in message_buffer_handler
+        oc_process_run();
+    }
+    TEST_ASSERT_EQUAL_UINT(2, _sent_request_count);
+
+    // each request used its own nonce (6 and 7)
+    TEST_ASSERT_EQUAL_UINT(7, _link_nonce());
+    // a response to the first request may arrive after the second is sent
+    TEST_ASSERT_EQUAL(NEXUS_CHANNEL_SM_AUTH_MESSAGE_ERROR_NONE,
+                      _authenticate(CONTENT_2_05, 6));
+
+    // the linked device (with the same link nonce, 5, before the requests
+    // were sent) receives the requests in the opposite order
+    TEST_ASSERT_TRUE(
+        nexus_channel_link_manager_set_security_data_auth_nonce(&LINKED_ID, 5));
+    TEST_ASSERT_EQUAL(NEXUS_CHANNEL_SM_AUTH_MESSAGE_ERROR_NONE,
+                      _authenticate_sent_request(1));
+    TEST_ASSERT_EQUAL(NEXUS_CHANNEL_SM_AUTH_MESSAGE_ERROR_NONE,
+                      _authenticate_sent_request(0));
+    TEST_ASSERT_EQUAL_UINT(7, _link_nonce());
+
+    // each is only accepted once
+    TEST_ASSERT_EQUAL(
+        NEXUS_CHANNEL_SM_AUTH_MESSAGE_ERROR_REQUEST_RECEIVED_WITH_INVALID_NONCE,
+        _authenticate_sent_request(0));
+    TEST_ASSERT_EQUAL(
+        NEXUS_CHANNEL_SM_AUTH_MESSAGE_ERROR_REQUEST_RECEIVED_WITH_INVALID_NONCE,
+        _authenticate_sent_request(1));
+}
@@ -378,6 +378,108 @@ void test_nexus_cose_mac0____nexus_cose_mac0_payload_ctx_to_mac_structure__valid
     }
 }
 
+void test_nexus_cose_mac0__nexus_cose_mac0_common_mac_params_compute_tag__various_inputs__matches_mac_structure_tag(
+    void)
+{
+    struct test_scenario
+    {
+        const nexus_cose_mac0_common_macparams_t input;
+        const nexus_cose_error expect_result;
+    };
+
+    uint8_t small_payload[6] = {0x98, 0x76, 0x54, 0xFF, 0x00, 0xAB};
+    // requires a 2-byte CBOR bytestring header
+    uint8_t large_payload[30];
+    uint8_t too_big_payload[200] = {0};
+    for (uint8_t i = 0; i < sizeof(large_payload); ++i)
+    {
+        large_payload[i] = (uint8_t) (i * 7);
+    }
+
+    const struct test_scenario scenarios[] = {
+        {
+            // ["MAC0", h'A10500', h'022F746573742F757269', h'987654FF00AB']
+            {&NEXUS_INTEGRITY_CHECK_FIXED_FF_KEY,
+             0,
+             {2, (uint8_t*) "/test/uri", 9},
+             &small_payload[0],
+             sizeof(small_payload)},
+            NEXUS_COSE_ERROR_NONE,
+        },
+        {
+            // no payload, no URI
+            {&NEXUS_INTEGRITY_CHECK_FIXED_00_KEY,
+             0xFAFB,
+             {1, (uint8_t*) "", 0},
+             &small_payload[0],
+             0},
+            NEXUS_COSE_ERROR_NONE,
+        },
+        {
+            {&NEXUS_INTEGRITY_CHECK_FIXED_FF_KEY,
+             0xFFFFFFFF,
+             {3, (uint8_t*) "/nx/pc", 6},
+             &large_payload[0],
+             sizeof(large_payload)},
+            NEXUS_COSE_ERROR_NONE,
+        },
+        {
+            {&NEXUS_INTEGRITY_CHECK_FIXED_FF_KEY,
+             0,
+             {1,
+              (uint8_t*) "/this/uri/too/long/wont/x",
+              NEXUS_CHANNEL_MAX_HUMAN_READABLE_URI_LENGTH + 1},
+             &small_payload[0],
+             0},
+            NEXUS_COSE_ERROR_INPUT_DATA_INVALID,
+        },
+        {
+            {&NEXUS_INTEGRITY_CHECK_FIXED_FF_KEY,
+             0,
+             {2, (uint8_t*) "/test/uri", 9},
+             &too_big_payload[0],
+             sizeof(too_big_payload)},
+            NEXUS_COSE_ERROR_INPUT_DATA_INVALID,
+        },
+    };
+
+    struct nexus_cose_mac0_cbor_data_t mac_struct;
+    struct nexus_check_value result_tag;
+
+    for (uint8_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); ++i)
+    {
+        const struct test_scenario scenario = scenarios[i];
+
+        const nexus_cose_error result =
+            nexus_cose_mac0_common_mac_params_compute_tag(&scenario.input,
+                                                          &result_tag);
+        TEST_ASSERT_EQUAL(scenario.expect_result, result);
+        if (result != NEXUS_COSE_ERROR_NONE)
+        {
+            continue;
+        }
+
+        // same tag as computed over the full `MAC_structure`
+        TEST_ASSERT_EQUAL(NEXUS_COSE_ERROR_NONE,
+                          nexus_cose_mac0_common_mac_params_to_mac_structure(
+                              &scenario.input, &mac_struct));
+        const struct nexus_check_value expect_tag =
+            nexus_cose_mac0_common_compute_tag(&mac_struct,
+                                               scenario.input.key);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(expect_tag.bytes,
+                                      result_tag.bytes,
+                                      sizeof(struct nexus_check_value));
+    }
+
+    // matches known tag from `compute_tag` test
+    const struct nexus_check_value known_tag = {
+        {0xd1, 0x3c, 0x8b, 0x4e, 0xe7, 0x39, 0x78, 0x72}};
+    nexus_cose_mac0_common_mac_params_compute_tag(&scenarios[0].input,
+                                                  &result_tag);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(
+        known_tag.bytes, result_tag.bytes, sizeof(struct nexus_check_value));
+}
+
 void test_nexus_cose_mac0__nexus_cose_mac0_verify_deserialize_protected_message__various_scenarios_expected_results(
     void)
 {
@@ -1,5 +1,6 @@
 #include "include/nx_keycode.h"
 #include "src/nexus_nv.h"
+#include "src/nexus_security.h"
 #include "src/nexus_util.h"
 #include "unity.h"
 #include "utils/crc_ccitt.h"
@@ -5,6 +5,7 @@
 #include "src/nexus_keycode_pro.h"
 #include "src/nexus_keycode_pro_extended.h"
 #include "src/nexus_nv.h"
+#include "src/nexus_security.h"
 #include "src/nexus_util.h"
 #include "unity.h"
 #include "utils/crc_ccitt.h"
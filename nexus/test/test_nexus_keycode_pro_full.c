@@ -4,6 +4,7 @@
 #include "src/nexus_keycode_pro.h"
 #include "src/nexus_keycode_pro_extended.h"
 #include "src/nexus_nv.h"
+#include "src/nexus_security.h"
 #include "src/nexus_util.h"
 #include "unity.h"
 #include "utils/crc_ccitt.h"
@@ -1620,3 +1621,424 @@ void test_nexus_keycode_pro_full_apply_activation__add_credit_to_unlocked__no_cr
     TEST_ASSERT_EQUAL_UINT(NEXUS_KEYCODE_PRO_RESPONSE_VALID_DUPLICATE,
                            response);
 }
+
+void test_nexus_keycode_verifier_verify__various_valid_inputs__expected_results_returned(
+    void)
+{
+    // same keycodes as
+    // `nexus_keycode_pro_full_apply__various_valid_inputs`, but verified
+    // against a verifier chained through each result. No `nxp_*` calls are
+    // expected.
+    struct test_scenario
+    {
+        const char* interleaved;
+        enum nexus_keycode_pro_response expected_response;
+        enum nexus_keycode_verifier_credit_action expected_action;
+        uint32_t expected_seconds;
+        uint32_t expected_pd_index;
+    };
+
+    const struct test_scenario scenarios[] = {
+        // universal short test
+        {"4064983",
+         NEXUS_KEYCODE_PRO_RESPONSE_VALID_APPLIED,
+         NEXUS_KEYCODE_VERIFIER_CREDIT_ACTION_ADD,
+         NEXUS_KEYCODE_PRO_UNIVERSAL_SHORT_TEST_SECONDS,
+         23},
+        // add, id = 16, hours=168
+        {"13777794160692",
+         NEXUS_KEYCODE_PRO_RESPONSE_VALID_APPLIED,
+         NEXUS_KEYCODE_VERIFIER_CREDIT_ACTION_ADD,
+         168 * 3600,
+         23},
+        // set, id = 63, hours=168
+        {"63530515961148",
+         NEXUS_KEYCODE_PRO_RESPONSE_VALID_APPLIED,
+         NEXUS_KEYCODE_VERIFIER_CREDIT_ACTION_SET,
+         168 * 3600,
+         63},
+        // same add as above first valid msg (now below window)
+        {"13777794160692",
+         NEXUS_KEYCODE_PRO_RESPONSE_INVALID,
+         NEXUS_KEYCODE_VERIFIER_CREDIT_ACTION_NONE,
+         0,
+         63},
+        // same set as above
+        {"63530515961148",
+         NEXUS_KEYCODE_PRO_RESPONSE_VALID_DUPLICATE,
+         NEXUS_KEYCODE_VERIFIER_CREDIT_ACTION_NONE,
+         0,
+         63},
+        // valid demo code, but generated for different key, so invalid
+        {"33579266365784",
+         NEXUS_KEYCODE_PRO_RESPONSE_INVALID,
+         NEXUS_KEYCODE_VERIFIER_CREDIT_ACTION_NONE,
+         0,
+         63},
+        // display device ID
+        {"6347765",
+         NEXUS_KEYCODE_PRO_RESPONSE_DISPLAY_DEVICE_ID,
+         NEXUS_KEYCODE_VERIFIER_CREDIT_ACTION_NONE,
+         0,
+         63},
+        // confirm device ID 12345678
+        {"712345678",
+         NEXUS_KEYCODE_PRO_RESPONSE_VALID_APPLIED,
+         NEXUS_KEYCODE_VERIFIER_CREDIT_ACTION_NONE,
+         0,
+         63},
+        // confirm device ID 123456789 (mismatched)
+        {"7123456789",
+         NEXUS_KEYCODE_PRO_RESPONSE_VALID_DUPLICATE,
+         NEXUS_KEYCODE_VERIFIER_CREDIT_ACTION_NONE,
+         0,
+         63},
+        // passthrough commands are not verified
+        {"8412345678902",
+         NEXUS_KEYCODE_PRO_RESPONSE_NONE,
+         NEXUS_KEYCODE_VERIFIER_CREDIT_ACTION_NONE,
+         0,
+         63},
+    };
+
+    _full_fixture_reinit(
+        '*', '#', "0123456789", NEXUS_INTEGRITY_CHECK_FIXED_00_KEY);
+
+    const uint8_t no_flags[NEXUS_KEYCODE_PRO_MAX_MESSAGE_ID_BYTE] = {0};
+    nexus_keycode_verifier_t verifier;
+    nexus_keycode_verifier_init(&verifier,
+                                &NEXUS_INTEGRITY_CHECK_FIXED_00_KEY,
+                                12345678,
+                                NEXUS_KEYCODE_PRO_RECEIVE_WINDOW_BEFORE_PD,
+                                no_flags);
+
+    for (uint8_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); ++i)
+    {
+        const struct test_scenario scenario = scenarios[i];
+        const struct nexus_keycode_frame frame =
+            nexus_keycode_frame_filled(scenario.interleaved);
+        nexus_keycode_verifier_result_t result;
+
+        const enum nexus_keycode_pro_response response =
+            nexus_keycode_verifier_verify(&verifier, &frame, &result);
+
+        TEST_ASSERT_EQUAL_UINT(scenario.expected_response, response);
+        TEST_ASSERT_EQUAL_UINT(scenario.expected_response, result.response);
+        TEST_ASSERT_EQUAL_UINT(scenario.expected_action, result.credit_action);
+        TEST_ASSERT_EQUAL_UINT(scenario.expected_seconds,
+                               result.credit_seconds);
+        TEST_ASSERT_EQUAL_UINT(scenario.expected_pd_index, result.pd_index);
+
+        // carry the resulting state into the next keycode
+        nexus_keycode_verifier_init(&verifier,
+                                    &verifier.secret_key,
+                                    verifier.user_facing_id,
+                                    result.pd_index,
+                                    result.received_flags);
+    }
+
+    // set credit at ID 63 masks every ID in the window
+    const uint8_t all_flags[NEXUS_KEYCODE_PRO_MAX_MESSAGE_ID_BYTE] = {
+        0xff, 0xff, 0xff};
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(
+        all_flags, verifier.received_flags, sizeof(all_flags));
+
+    // stored keycode state is untouched
+    TEST_ASSERT_EQUAL_UINT(nexus_keycode_pro_get_current_pd_index(), 23);
+    TEST_ASSERT_FALSE(nexus_keycode_pro_get_full_message_id_flag(16));
+}
+
+void test_nexus_keycode_verifier_verify__wipe_state_messages__window_updated(
+    void)
+{
+    _full_fixture_reinit(
+        '*', '#', "0123456789", NEXUS_INTEGRITY_CHECK_FIXED_FF_KEY);
+
+    const uint8_t no_flags[NEXUS_KEYCODE_PRO_MAX_MESSAGE_ID_BYTE] = {0};
+    const uint8_t all_flags[NEXUS_KEYCODE_PRO_MAX_MESSAGE_ID_BYTE] = {
+        0xff, 0xff, 0xff};
+    nexus_keycode_verifier_t verifier;
+    nexus_keycode_verifier_result_t result;
+
+    // wipe credit only, ID = 0 (generated for an all-zeros key)
+    nexus_keycode_verifier_init(&verifier,
+                                &NEXUS_INTEGRITY_CHECK_FIXED_00_KEY,
+                                0,
+                                NEXUS_KEYCODE_PRO_RECEIVE_WINDOW_BEFORE_PD,
+                                no_flags);
+    struct nexus_keycode_frame frame =
+        nexus_keycode_frame_filled("27854061048455");
+    nexus_keycode_verifier_verify(&verifier, &frame, &result);
+
+    TEST_ASSERT_EQUAL_UINT(NEXUS_KEYCODE_PRO_RESPONSE_VALID_APPLIED,
+                           result.response);
+    TEST_ASSERT_EQUAL_UINT(NEXUS_KEYCODE_VERIFIER_CREDIT_ACTION_SET,
+                           result.credit_action);
+    TEST_ASSERT_EQUAL_UINT(0, result.credit_seconds);
+    TEST_ASSERT_EQUAL_UINT(23, result.pd_index);
+    TEST_ASSERT_EQUAL_UINT8(0x01, result.received_flags[0]);
+    TEST_ASSERT_EQUAL_UINT8(0x00, result.received_flags[1]);
+    TEST_ASSERT_EQUAL_UINT8(0x00, result.received_flags[2]);
+    // the verifier itself is unchanged
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(
+        no_flags, verifier.received_flags, sizeof(no_flags));
+
+    // wipe credit and IDs, ID = 303
+    nexus_keycode_verifier_init(
+        &verifier, &NEXUS_INTEGRITY_CHECK_FIXED_FF_KEY, 0, 301, all_flags);
+    frame = nexus_keycode_frame_filled("19469685968779");
+    nexus_keycode_verifier_verify(&verifier, &frame, &result);
+
+    TEST_ASSERT_EQUAL_UINT(NEXUS_KEYCODE_PRO_RESPONSE_VALID_APPLIED,
+                           result.response);
+    TEST_ASSERT_EQUAL_UINT(NEXUS_KEYCODE_VERIFIER_CREDIT_ACTION_SET,
+                           result.credit_action);
+    TEST_ASSERT_EQUAL_UINT(23, result.pd_index);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(
+        no_flags, result.received_flags, sizeof(no_flags));
+
+    // wipe IDs only, ID = 303
+    frame = nexus_keycode_frame_filled("45299993090378");
+    nexus_keycode_verifier_verify(&verifier, &frame, &result);
+
+    TEST_ASSERT_EQUAL_UINT(NEXUS_KEYCODE_PRO_RESPONSE_VALID_APPLIED,
+                           result.response);
+    TEST_ASSERT_EQUAL_UINT(NEXUS_KEYCODE_VERIFIER_CREDIT_ACTION_NONE,
+                           result.credit_action);
+    TEST_ASSERT_EQUAL_UINT(23, result.pd_index);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(
+        no_flags, result.received_flags, sizeof(no_flags));
+}
+
+void test_nexus_keycode_verifier_verify__malformed_frames__invalid_returned(
+    void)
+{
+    _full_fixture_reinit(
+        '*', '#', "0123456789", NEXUS_INTEGRITY_CHECK_FIXED_00_KEY);
+
+    const uint8_t no_flags[NEXUS_KEYCODE_PRO_MAX_MESSAGE_ID_BYTE] = {0};
+    nexus_keycode_verifier_t verifier;
+    nexus_keycode_verifier_init(&verifier,
+                                &NEXUS_INTEGRITY_CHECK_FIXED_00_KEY,
+                                0,
+                                NEXUS_KEYCODE_PRO_RECEIVE_WINDOW_BEFORE_PD,
+                                no_flags);
+
+    const char* scenarios[] = {
+        "", // empty
+        "1377779416069*", // non-digit key
+        "9123456", // reserved type ID
+        "4064984", // wrong check
+    };
+
+    for (uint8_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); ++i)
+    {
+        const struct nexus_keycode_frame frame =
+            nexus_keycode_frame_filled(scenarios[i]);
+        nexus_keycode_verifier_result_t result;
+
+        TEST_ASSERT_EQUAL_UINT(
+            NEXUS_KEYCODE_PRO_RESPONSE_INVALID,
+            nexus_keycode_verifier_verify(&verifier, &frame, &result));
+        TEST_ASSERT_EQUAL_UINT(NEXUS_KEYCODE_VERIFIER_CREDIT_ACTION_NONE,
+                               result.credit_action);
+        TEST_ASSERT_EQUAL_UINT(23, result.pd_index);
+    }
+}
+
+void test_nexus_keycode_verifier_verify__unsupported_activation_type__invalid_returned(
+    void)
+{
+    _full_fixture_reinit(
+        '*', '#', "0123456789", NEXUS_INTEGRITY_CHECK_FIXED_00_KEY);
+
+    const uint8_t no_flags[NEXUS_KEYCODE_PRO_MAX_MESSAGE_ID_BYTE] = {0};
+    nexus_keycode_verifier_t verifier;
+    nexus_keycode_verifier_init(&verifier,
+                                &NEXUS_INTEGRITY_CHECK_FIXED_00_KEY,
+                                0,
+                                NEXUS_KEYCODE_PRO_RECEIVE_WINDOW_BEFORE_PD,
+                                no_flags);
+
+    // deinterleaves to "41256938123456"; type 4 is not an activation type,
+    // and must be rejected without asserting
+    const struct nexus_keycode_frame frame =
+        nexus_keycode_frame_filled("10001697123456");
+    nexus_keycode_verifier_result_t result;
+
+    TEST_ASSERT_EQUAL_UINT(
+        NEXUS_KEYCODE_PRO_RESPONSE_INVALID,
+        nexus_keycode_verifier_verify(&verifier, &frame, &result));
+    TEST_ASSERT_EQUAL_UINT(NEXUS_KEYCODE_VERIFIER_CREDIT_ACTION_NONE,
+                           result.credit_action);
+    TEST_ASSERT_EQUAL_UINT(23, result.pd_index);
+}
+
+void test_nexus_keycode_encoder_full_encode_batch__known_messages__keycodes_match_expected(
+    void)
+{
+    struct test_scenario
+    {
+        struct nexus_keycode_pro_full_message message;
+        const char* expected_keys;
+    };
+
+    // check fields are ignored by the encoder
+    const struct test_scenario scenarios[] = {
+        // universal short test
+        {{0, NEXUS_KEYCODE_PRO_FULL_FACTORY_ALLOW_TEST, {{0}}, 0}, "4064983"},
+        // add, id = 16, hours=168
+        {{16, NEXUS_KEYCODE_PRO_FULL_ACTIVATION_ADD_CREDIT, {{168}}, 0},
+         "13777794160692"},
+        // set, id = 63, hours=168
+        {{63, NEXUS_KEYCODE_PRO_FULL_ACTIVATION_SET_CREDIT, {{168}}, 0},
+         "63530515961148"},
+        // wipe restricted flag, id = 45
+        {{45,
+          NEXUS_KEYCODE_PRO_FULL_ACTIVATION_WIPE_STATE,
+          {{NEXUS_KEYCODE_PRO_FULL_WIPE_CUSTOM_FLAG_RESTRICTED}},
+          0},
+         "92312722802585"},
+        // display device ID
+        {{0, NEXUS_KEYCODE_PRO_FULL_FACTORY_DEVICE_ID_DISPLAY, {{0}}, 0},
+         "6347765"},
+        // confirm device IDs, at least 8 digits
+        {{0,
+          NEXUS_KEYCODE_PRO_FULL_FACTORY_NOMAC_DEVICE_ID_CONFIRMATION,
+          {{12345678}},
+          0},
+         "712345678"},
+        {{0,
+          NEXUS_KEYCODE_PRO_FULL_FACTORY_NOMAC_DEVICE_ID_CONFIRMATION,
+          {{1234}},
+          0},
+         "700001234"},
+        {{0,
+          NEXUS_KEYCODE_PRO_FULL_FACTORY_NOMAC_DEVICE_ID_CONFIRMATION,
+          {{1234567890}},
+          0},
+         "71234567890"},
+        // not encodable
+        {{0, NEXUS_KEYCODE_PRO_FULL_PASSTHROUGH_COMMAND, {{0}}, 0}, ""},
+        {{0, NEXUS_KEYCODE_PRO_FULL_ACTIVATION_ADD_CREDIT, {{100000}}, 0}, ""},
+    };
+    const uint8_t scenario_count = sizeof(scenarios) / sizeof(scenarios[0]);
+
+    struct nexus_keycode_pro_full_message
+        messages[sizeof(scenarios) / sizeof(scenarios[0])];
+    struct nexus_keycode_frame frames[sizeof(scenarios) / sizeof(scenarios[0])];
+    for (uint8_t i = 0; i < scenario_count; ++i)
+    {
+        messages[i] = scenarios[i].message;
+    }
+
+    nexus_keycode_encoder_t encoder;
+    nexus_keycode_encoder_init(&encoder, &NEXUS_INTEGRITY_CHECK_FIXED_00_KEY);
+
+    const uint32_t encoded_count = nexus_keycode_encoder_full_encode_batch(
+        &encoder, messages, scenario_count, frames);
+    TEST_ASSERT_EQUAL_UINT(scenario_count - 2, encoded_count);
+
+    for (uint8_t i = 0; i < scenario_count; ++i)
+    {
+        const char* expected_keys = scenarios[i].expected_keys;
+        TEST_ASSERT_EQUAL_UINT(strlen(expected_keys), frames[i].length);
+        if (frames[i].length > 0)
+        {
+            TEST_ASSERT_EQUAL_MEMORY(
+                expected_keys, frames[i].keys, frames[i].length);
+        }
+    }
+}
+
+void test_nexus_keycode_encoder_full_encode_batch__many_messages__parsed_messages_match(
+    void)
+{
+    _full_fixture_reinit(
+        '*', '#', "0123456789", NEXUS_INTEGRITY_CHECK_FIXED_FF_KEY);
+
+    const uint8_t type_codes[] = {
+        NEXUS_KEYCODE_PRO_FULL_ACTIVATION_ADD_CREDIT,
+        NEXUS_KEYCODE_PRO_FULL_ACTIVATION_SET_CREDIT,
+        NEXUS_KEYCODE_PRO_FULL_ACTIVATION_WIPE_STATE,
+        NEXUS_KEYCODE_PRO_FULL_ACTIVATION_DEMO_CODE,
+        NEXUS_KEYCODE_PRO_FULL_FACTORY_ALLOW_TEST,
+        NEXUS_KEYCODE_PRO_FULL_FACTORY_QC_TEST,
+        NEXUS_KEYCODE_PRO_FULL_FACTORY_DEVICE_ID_DISPLAY,
+    };
+    struct nexus_keycode_pro_full_message messages[150];
+    struct nexus_keycode_frame frames[150];
+    uint32_t seed = 12345;
+
+    for (uint8_t i = 0; i < sizeof(messages) / sizeof(messages[0]); ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        const uint8_t type_code =
+            type_codes[i % (sizeof(type_codes) / sizeof(type_codes[0]))];
+        messages[i].type_code = type_code;
+        // IDs within the receipt window of a new device
+        messages[i].full_message_id = (seed >> 8) % 64;
+        messages[i].check = 0;
+        if (type_code == NEXUS_KEYCODE_PRO_FULL_ACTIVATION_WIPE_STATE)
+        {
+            messages[i].body.wipe_state.target = (seed >> 16) % 4;
+        }
+        else if (type_code == NEXUS_KEYCODE_PRO_FULL_FACTORY_QC_TEST)
+        {
+            messages[i].body.qc_variant.minutes = (seed >> 16) % 100;
+        }
+        else
+        {
+            messages[i].body.add_set_credit.hours = (seed >> 12) % 100000;
+        }
+    }
+
+    nexus_keycode_encoder_t encoder;
+    nexus_keycode_encoder_init(&encoder, &NEXUS_INTEGRITY_CHECK_FIXED_FF_KEY);
+    TEST_ASSERT_EQUAL_UINT(
+        sizeof(messages) / sizeof(messages[0]),
+        nexus_keycode_encoder_full_encode_batch(
+            &encoder,
+            messages,
+            sizeof(messages) / sizeof(messages[0]),
+            frames));
+
+    const uint8_t no_flags[NEXUS_KEYCODE_PRO_MAX_MESSAGE_ID_BYTE] = {0};
+    nexus_keycode_verifier_t verifier;
+    nexus_keycode_verifier_init(&verifier,
+                                &NEXUS_INTEGRITY_CHECK_FIXED_FF_KEY,
+                                0,
+                                NEXUS_KEYCODE_PRO_RECEIVE_WINDOW_BEFORE_PD,
+                                no_flags);
+
+    for (uint8_t i = 0; i < sizeof(messages) / sizeof(messages[0]); ++i)
+    {
+        // parsed by the firmware parser
+        struct nexus_keycode_frame frame = frames[i];
+        struct nexus_keycode_pro_full_message parsed;
+        TEST_ASSERT_TRUE(nexus_keycode_pro_full_parse(&frame, &parsed));
+        TEST_ASSERT_EQUAL_UINT(messages[i].type_code, parsed.type_code);
+
+        if (parsed.type_code <
+            (uint8_t) NEXUS_KEYCODE_PRO_FULL_FACTORY_ALLOW_TEST)
+        {
+            TEST_ASSERT_EQUAL_UINT(messages[i].full_message_id,
+                                   parsed.full_message_id);
+            TEST_ASSERT_EQUAL_UINT(messages[i].body.add_set_credit.hours,
+                                   parsed.body.add_set_credit.hours);
+        }
+        else if (parsed.type_code ==
+                 (uint8_t) NEXUS_KEYCODE_PRO_FULL_FACTORY_QC_TEST)
+        {
+            TEST_ASSERT_EQUAL_UINT(messages[i].body.qc_variant.minutes,
+                                   parsed.body.qc_variant.minutes);
+        }
+
+        // and authenticated
+        nexus_keycode_verifier_result_t result;
+        TEST_ASSERT_NOT_EQUAL(
+            NEXUS_KEYCODE_PRO_RESPONSE_INVALID,
+            nexus_keycode_verifier_verify(&verifier, &frames[i], &result));
+        TEST_ASSERT_EQUAL_UINT(parsed.check, result.message.check);
+    }
+}
@@ -0,0 +1,135 @@
+#include "include/nx_common.h"
+#include "src/nexus_common_internal.h"
+#include "src/nexus_keycode_core.h"
+#include "src/nexus_keycode_pro.h"
+#include "src/nexus_nv.h"
+#include "src/nexus_security.h"
+#include "src/nexus_util.h"
+#include "unity.h"
+#include "utils/crc_ccitt.h"
+#include "utils/siphash_24.h"
+
+// Other support libraries
+#include <mock_nexus_channel_core.h>
+#include <mock_nxp_common.h>
+#include <mock_nxp_keycode.h>
+#include <string.h>
+
+/********************************************************
+ * DEFINITIONS
+ *******************************************************/
+
+// Blocks 0 and 1 are the only NV blocks used by the keycode modules
+#define FAKE_NV_BLOCK_COUNT 2
+
+/********************************************************
+ * PRIVATE TYPES
+ *******************************************************/
+
+/********************************************************
+ * PRIVATE DATA
+ *******************************************************/
+
+// Fake product NV, which keeps its contents across simulated power loss
+static uint8_t _fake_nv[FAKE_NV_BLOCK_COUNT][NX_COMMON_NV_MAX_BLOCK_LENGTH];
+static bool _fake_nv_valid[FAKE_NV_BLOCK_COUNT];
+
+/********************************************************
+ * PRIVATE FUNCTIONS
+ *******************************************************/
+
+bool CALLBACK_nxp_common_nv_read(
+    const struct nx_common_nv_block_meta block_meta,
+    void* read_buffer,
+    int NumCalls)
+{
+    (void) NumCalls;
+    if (block_meta.block_id >= FAKE_NV_BLOCK_COUNT ||
+        !_fake_nv_valid[block_meta.block_id])
+    {
+        return false;
+    }
+    memcpy(read_buffer, _fake_nv[block_meta.block_id], block_meta.length);
+    return true;
+}
+
+bool CALLBACK_nxp_common_nv_write(
+    const struct nx_common_nv_block_meta block_meta,
+    void* write_buffer,
+    int NumCalls)
+{
+    (void) NumCalls;
+    TEST_ASSERT_TRUE(block_meta.block_id < FAKE_NV_BLOCK_COUNT);
+    memcpy(_fake_nv[block_meta.block_id], write_buffer, block_meta.length);
+    _fake_nv_valid[block_meta.block_id] = true;
+    return true;
+}
+
+// Power up: all RAM state is lost, and is restored from the fake NV
+static void _fixture_power_up(void)
+{
+    nexus_nv_init();
+    nexus_keycode_pro_init(nexus_keycode_pro_full_parse_and_apply,
+                           nexus_keycode_pro_full_init,
+                           "0123456789");
+}
+
+static enum nexus_keycode_pro_response _fixture_apply(const char* keys)
+{
+    struct nexus_keycode_frame frame = {0};
+    for (uint8_t i = 0; keys[i] != '\0'; ++i)
+    {
+        frame.keys[i] = keys[i];
+        ++frame.length;
+    }
+
+    struct nexus_keycode_pro_full_message message = {0};
+    TEST_ASSERT_TRUE(nexus_keycode_pro_full_parse(&frame, &message));
+    return nexus_keycode_pro_full_apply(&message);
+}
+
+// Setup (called before any 'test_*' function is called, automatically)
+void setUp(void)
+{
+    memset(_fake_nv, 0x00, sizeof(_fake_nv));
+    memset(_fake_nv_valid, 0x00, sizeof(_fake_nv_valid));
+
+    nxp_common_nv_read_StubWithCallback(CALLBACK_nxp_common_nv_read);
+    nxp_common_nv_write_StubWithCallback(CALLBACK_nxp_common_nv_write);
+    nxp_common_request_processing_Ignore();
+    nxp_common_payg_state_get_current_IgnoreAndReturn(
+        NXP_COMMON_PAYG_STATE_ENABLED);
+    nxp_keycode_get_secret_key_IgnoreAndReturn(
+        NEXUS_INTEGRITY_CHECK_FIXED_00_KEY);
+
+    _fixture_power_up();
+}
+
+// Teardown (called after any 'test_*' function is called, automatically)
+void tearDown(void)
+{
+    nexus_keycode_pro_deinit();
+}
+
+void test_keycode_pro_nv_cache__power_loss_after_apply__replayed_keycode_rejected(
+    void)
+{
+    // add, id = 16, hours = 168
+    const char* keycode = "13777794160692";
+
+    TEST_ASSERT_EQUAL_UINT(23, nexus_keycode_pro_get_current_pd_index());
+
+    // credit is only added once
+    nxp_keycode_payg_credit_add_ExpectAndReturn(168 * 3600, true);
+    TEST_ASSERT_EQUAL_UINT(NEXUS_KEYCODE_PRO_RESPONSE_VALID_APPLIED,
+                           _fixture_apply(keycode));
+    TEST_ASSERT_TRUE(_fake_nv_valid[NX_NV_BLOCK_KEYCODE_PRO.block_id]);
+
+    // power is lost before the NV cache flush delay passes, and without
+    // `nx_common_shutdown`
+    _fixture_power_up();
+
+    TEST_ASSERT_TRUE(nexus_keycode_pro_get_full_message_id_flag(16));
+    TEST_ASSERT_EQUAL_UINT(NEXUS_KEYCODE_PRO_RESPONSE_VALID_DUPLICATE,
+                           _fixture_apply(keycode));
+}
@@ -0,0 +1,220 @@
+#include "include/nx_common.h"
+#include "src/nexus_common_internal.h"
+#include "src/nexus_keycode_core.h"
+#include "src/nexus_keycode_mas.h"
+#include "src/nexus_keycode_pro.h"
+#include "src/nexus_nv.h"
+#include "src/nexus_security.h"
+#include "src/nexus_util.h"
+#include "unity.h"
+#include "utils/crc_ccitt.h"
+#include "utils/siphash_24.h"
+
+// Other support libraries
+#include <mock_nexus_channel_core.h>
+#include <mock_nxp_common.h>
+#include <mock_nxp_keycode.h>
+#include <string.h>
+
+/********************************************************
+ * DEFINITIONS
+ *******************************************************/
+
+// Includes copy B of each block, and the commit blocks
+#define FAKE_NV_BLOCK_COUNT 64
+
+/********************************************************
+ * PRIVATE TYPES
+ *******************************************************/
+
+/********************************************************
+ * PRIVATE DATA
+ *******************************************************/
+
+// Fake product NV, which keeps its contents across simulated power loss
+static uint8_t _fake_nv[FAKE_NV_BLOCK_COUNT][NX_COMMON_NV_MAX_BLOCK_LENGTH];
+static bool _fake_nv_valid[FAKE_NV_BLOCK_COUNT];
+
+// Fake NV contents at the moment the product was asked to change credit
+static uint8_t _power_loss_nv[FAKE_NV_BLOCK_COUNT]
+                             [NX_COMMON_NV_MAX_BLOCK_LENGTH];
+static bool _power_loss_nv_valid[FAKE_NV_BLOCK_COUNT];
+
+/********************************************************
+ * PRIVATE FUNCTIONS
+ *******************************************************/
+
+bool CALLBACK_nxp_common_nv_read(
+    const struct nx_common_nv_block_meta block_meta,
+    void* read_buffer,
+    int NumCalls)
+{
+    (void) NumCalls;
+    if (block_meta.block_id >= FAKE_NV_BLOCK_COUNT ||
+        !_fake_nv_valid[block_meta.block_id])
+    {
+        return false;
+    }
+    memcpy(read_buffer, _fake_nv[block_meta.block_id], block_meta.length);
+    return true;
+}
+
+bool CALLBACK_nxp_common_nv_write(
+    const struct nx_common_nv_block_meta block_meta,
+    void* write_buffer,
+    int NumCalls)
+{
+    (void) NumCalls;
+    TEST_ASSERT_TRUE(block_meta.block_id < FAKE_NV_BLOCK_COUNT);
+    memcpy(_fake_nv[block_meta.block_id], write_buffer, block_meta.length);
+    _fake_nv_valid[block_meta.block_id] = true;
+    return true;
+}
+
+// Power is lost as soon as credit is changed, before anything else is
+// written to NV
+static void _snapshot_power_loss_nv(void)
+{
+    memcpy(_power_loss_nv, _fake_nv, sizeof(_fake_nv));
+    memcpy(_power_loss_nv_valid, _fake_nv_valid, sizeof(_fake_nv_valid));
+}
+
+bool CALLBACK_nxp_keycode_payg_credit_add(uint32_t credit, int NumCalls)
+{
+    (void) credit;
+    (void) NumCalls;
+    _snapshot_power_loss_nv();
+    return true;
+}
+
+bool CALLBACK_nxp_keycode_payg_credit_set(uint32_t credit, int NumCalls)
+{
+    (void) credit;
+    (void) NumCalls;
+    _snapshot_power_loss_nv();
+    return true;
+}
+
+// Applies each keycode as soon as it is entered, instead of enqueueing it
+static void _apply_handler(const struct nexus_keycode_frame* frame)
+{
+    (void) nexus_keycode_pro_full_parse_and_apply(frame);
+}
+
+static nexus_keycode_mas_message_handler _handler;
+
+// Power up: all RAM state is lost, and is restored from the fake NV
+static void _fixture_power_up(void)
+{
+    nexus_nv_init();
+    nexus_keycode_pro_init(nexus_keycode_pro_full_parse_and_apply,
+                           nexus_keycode_pro_full_init,
+                           "0123456789");
+    nexus_keycode_mas_init(_handler);
+}
+
+static void _fixture_power_loss(void)
+{
+    memcpy(_fake_nv, _power_loss_nv, sizeof(_fake_nv));
+    memcpy(_fake_nv_valid, _power_loss_nv_valid, sizeof(_fake_nv_valid));
+    _fixture_power_up();
+}
+
+// Enter and process a keycode (without start or end keys)
+static void _fixture_enter(const char* keys)
+{
+    for (uint8_t i = 0; keys[i] != '\0'; ++i)
+    {
+        nexus_keycode_mas_push(keys[i]);
+    }
+    nexus_keycode_mas_finish();
+    (void) nexus_keycode_pro_process();
+}
+
+// Setup (called before any 'test_*' function is called, automatically)
+void setUp(void)
+{
+    memset(_fake_nv, 0x00, sizeof(_fake_nv));
+    memset(_fake_nv_valid, 0x00, sizeof(_fake_nv_valid));
+    memset(_power_loss_nv, 0x00, sizeof(_power_loss_nv));
+    memset(_power_loss_nv_valid, 0x00, sizeof(_power_loss_nv_valid));
+
+    nxp_common_nv_read_StubWithCallback(CALLBACK_nxp_common_nv_read);
+    nxp_common_nv_write_StubWithCallback(CALLBACK_nxp_common_nv_write);
+    nxp_common_request_processing_Ignore();
+    nxp_common_payg_state_get_current_IgnoreAndReturn(
+        NXP_COMMON_PAYG_STATE_ENABLED);
+    nxp_keycode_get_secret_key_IgnoreAndReturn(
+        NEXUS_INTEGRITY_CHECK_FIXED_00_KEY);
+    nxp_keycode_feedback_start_IgnoreAndReturn(true);
+
+    _handler = nexus_keycode_pro_enqueue;
+    _fixture_power_up();
+}
+
+// Teardown (called after any 'test_*' function is called, automatically)
+void tearDown(void)
+{
+    nexus_keycode_mas_deinit();
+    nexus_keycode_pro_deinit();
+}
+
+void test_keycode_pro_nv_transaction__power_loss_at_credit_add__replayed_keycode_rejected(
+    void)
+{
+    // add, id = 16, hours = 168
+    const char* keycode = "13777794160692";
+
+    nxp_keycode_payg_credit_add_StubWithCallback(
+        CALLBACK_nxp_keycode_payg_credit_add);
+    _fixture_enter(keycode);
+    TEST_ASSERT_TRUE(nexus_keycode_pro_get_full_message_id_flag(16));
+
+    // the receipt was already stored when credit was added
+    _fixture_power_loss();
+    TEST_ASSERT_TRUE(nexus_keycode_pro_get_full_message_id_flag(16));
+
+    // credit is only added once
+    nxp_keycode_payg_credit_add_StubWithCallback(NULL);
+    _fixture_enter(keycode);
+}
+
+void test_keycode_pro_nv_transaction__power_loss_at_credit_set__replayed_keycode_rejected(
+    void)
+{
+    // set, id = 63, hours = 168
+    const char* keycode = "63530515961148";
+
+    nxp_keycode_payg_credit_set_StubWithCallback(
+        CALLBACK_nxp_keycode_payg_credit_set);
+    _fixture_enter(keycode);
+
+    _fixture_power_loss();
+    TEST_ASSERT_TRUE(nexus_keycode_pro_get_full_message_id_flag(63));
+    TEST_ASSERT_EQUAL_UINT(63, nexus_keycode_pro_get_current_pd_index());
+
+    // credit is only set once
+    nxp_keycode_payg_credit_set_StubWithCallback(NULL);
+    _fixture_enter(keycode);
+}
+
+void test_keycode_pro_nv_transaction__applied_while_entered__replayed_keycode_rejected(
+    void)
+{
+    _handler = _apply_handler;
+    _fixture_power_up();
+
+    // add, id = 16, hours = 168
+    const char* keycode = "13777794160692";
+
+    nxp_keycode_payg_credit_add_StubWithCallback(
+        CALLBACK_nxp_keycode_payg_credit_add);
+    _fixture_enter(keycode);
+
+    _fixture_power_loss();
+    TEST_ASSERT_TRUE(nexus_keycode_pro_get_full_message_id_flag(16));
+
+    // credit is only added once
+    nxp_keycode_payg_credit_add_StubWithCallback(NULL);
+    _fixture_enter(keycode);
+}
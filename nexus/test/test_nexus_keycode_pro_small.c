@@ -4,6 +4,7 @@
 #include "src/nexus_keycode_pro.h"
 #include "src/nexus_keycode_pro_extended.h"
 #include "src/nexus_nv.h"
+#include "src/nexus_security.h"
 #include "src/nexus_util.h"
 #include "unity.h"
 #include "utils/crc_ccitt.h"
@@ -1876,3 +1877,148 @@ void test_nexus_keycode_pro_small_compute_check__fixed_inputs__outputs_are_expec
         TEST_ASSERT_EQUAL_UINT(expected_checks[i], check);
     }
 }
+
+void test_nexus_keycode_encoder_small_encode_batch__known_messages__keycodes_match_expected(
+    void)
+{
+    struct test_scenario
+    {
+        struct nx_common_check_key key;
+        const char* alphabet;
+        struct nexus_keycode_pro_small_message message;
+        const char* expected_keys;
+    };
+
+    const struct nx_common_check_key key_fe = {{0xFE,
+                                                0xFE,
+                                                0xFE,
+                                                0xFE,
+                                                0xFE,
+                                                0xFE,
+                                                0xFE,
+                                                0xFE,
+                                                0xFE,
+                                                0xFE,
+                                                0xFE,
+                                                0xFE,
+                                                0xFE,
+                                                0xFE,
+                                                0xFE,
+                                                0xFE}};
+
+    // check fields are ignored by the encoder
+    const struct test_scenario scenarios[] = {
+        {NEXUS_INTEGRITY_CHECK_FIXED_FF_KEY,
+         "0123",
+         {30, NEXUS_KEYCODE_PRO_SMALL_ACTIVATION_ADD_CREDIT_TYPE, {{1}}, 0},
+         "32110323221113"},
+        {NEXUS_INTEGRITY_CHECK_FIXED_00_KEY,
+         "0123",
+         {17, NEXUS_KEYCODE_PRO_SMALL_ACTIVATION_ADD_CREDIT_TYPE, {{4}}, 0},
+         "02022022213121"},
+        {NEXUS_INTEGRITY_CHECK_FIXED_00_KEY,
+         "1234",
+         {17, NEXUS_KEYCODE_PRO_SMALL_ACTIVATION_ADD_CREDIT_TYPE, {{4}}, 0},
+         "13133133324232"},
+        // maintenance, "WIPE_IDS_ALL"
+        {key_fe,
+         "0123",
+         {0,
+          NEXUS_KEYCODE_PRO_SMALL_MAINTENANCE_OR_TEST_TYPE,
+          {{NEXUS_KEYCODE_PRO_SMALL_WIPE_STATE_TARGET_MASK | 0x80}},
+          0},
+         "32023320110033"},
+        // test messages always use the fixed 0xFF key
+        {key_fe,
+         "0123",
+         {0,
+          NEXUS_KEYCODE_PRO_SMALL_MAINTENANCE_OR_TEST_TYPE,
+          {{NEXUS_KEYCODE_PRO_SMALL_ENABLE_SHORT_TEST}},
+          0},
+         "21031000211022"},
+        // passthrough messages are not encodable
+        {key_fe,
+         "0123",
+         {0, NEXUS_KEYCODE_PRO_SMALL_TYPE_PASSTHROUGH, {{0}}, 0},
+         ""},
+    };
+
+    for (uint8_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); ++i)
+    {
+        const struct test_scenario scenario = scenarios[i];
+        nexus_keycode_encoder_t encoder;
+        nexus_keycode_encoder_init(&encoder, &scenario.key);
+
+        struct nexus_keycode_frame frame;
+        const uint32_t encoded_count = nexus_keycode_encoder_small_encode_batch(
+            &encoder, scenario.alphabet, &scenario.message, 1, &frame);
+
+        TEST_ASSERT_EQUAL_UINT(strlen(scenario.expected_keys) > 0,
+                               encoded_count);
+        TEST_ASSERT_EQUAL_UINT(strlen(scenario.expected_keys), frame.length);
+        if (frame.length > 0)
+        {
+            TEST_ASSERT_EQUAL_MEMORY(
+                scenario.expected_keys, frame.keys, frame.length);
+        }
+    }
+}
+
+void test_nexus_keycode_encoder_small_encode_batch__many_messages__parsed_messages_match(
+    void)
+{
+    const uint8_t type_codes[] = {
+        NEXUS_KEYCODE_PRO_SMALL_ACTIVATION_ADD_CREDIT_TYPE,
+        NEXUS_KEYCODE_PRO_SMALL_ACTIVATION_SET_CREDIT_TYPE,
+        NEXUS_KEYCODE_PRO_SMALL_MAINTENANCE_OR_TEST_TYPE,
+    };
+    struct nexus_keycode_pro_small_message messages[150];
+    struct nexus_keycode_frame frames[150];
+    uint32_t seed = 54321;
+
+    for (uint8_t i = 0; i < sizeof(messages) / sizeof(messages[0]); ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        messages[i].type_code =
+            type_codes[i % (sizeof(type_codes) / sizeof(type_codes[0]))];
+        // IDs within the receipt window of a new device
+        messages[i].full_message_id = (seed >> 8) % 64;
+        messages[i].body.activation.increment_id = (uint8_t)(seed >> 16);
+        messages[i].check = 0;
+    }
+
+    // setUp uses alphabet "0123" and an all-zeros secret key
+    nexus_keycode_encoder_t encoder;
+    nexus_keycode_encoder_init(&encoder, &NEXUS_INTEGRITY_CHECK_FIXED_00_KEY);
+    TEST_ASSERT_EQUAL_UINT(
+        sizeof(messages) / sizeof(messages[0]),
+        nexus_keycode_encoder_small_encode_batch(
+            &encoder,
+            "0123",
+            messages,
+            sizeof(messages) / sizeof(messages[0]),
+            frames));
+
+    for (uint8_t i = 0; i < sizeof(messages) / sizeof(messages[0]); ++i)
+    {
+        struct nexus_keycode_pro_small_message parsed;
+        TEST_ASSERT_TRUE(nexus_keycode_pro_small_parse(&frames[i], &parsed));
+        TEST_ASSERT_EQUAL_UINT(messages[i].type_code, parsed.type_code);
+        TEST_ASSERT_EQUAL_UINT(messages[i].full_message_id,
+                               parsed.full_message_id);
+        TEST_ASSERT_EQUAL_UINT(messages[i].body.activation.increment_id,
+                               parsed.body.activation.increment_id);
+
+        const bool is_test =
+            parsed.type_code ==
+                (uint8_t) NEXUS_KEYCODE_PRO_SMALL_MAINTENANCE_OR_TEST_TYPE &&
+            parsed.body.maintenance_test.function_id <=
+                NEXUS_KEYCODE_PRO_SMALL_MAX_TEST_FUNCTION_ID;
+        TEST_ASSERT_EQUAL_UINT(
+            nexus_keycode_pro_small_compute_check(
+                &parsed,
+                is_test ? &NEXUS_INTEGRITY_CHECK_FIXED_FF_KEY :
+                          &NEXUS_INTEGRITY_CHECK_FIXED_00_KEY),
+            parsed.check);
+    }
+}
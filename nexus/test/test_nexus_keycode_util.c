@@ -1,5 +1,7 @@
+#include "src/nexus_security.h"
 #include "src/nexus_util.h"
 #include "unity.h"
+#include "utils/crc_ccitt.h"
 #include "utils/siphash_24.h"
 
 // Other support libraries
@@ -156,6 +158,77 @@ void test_nexus_bitstream_pull_uint16_be__input_provided__pulled_matches_input(
     }
 }
 
+void test_nexus_bitstream_push_bits__various_offsets__matches_push_bit(void)
+{
+    const uint32_t pushed = 0xA5C3961E;
+
+    for (uint8_t offset = 0; offset < 16; ++offset)
+    {
+        for (uint8_t bits = 0; bits <= 32; ++bits)
+        {
+            uint8_t expected_bytes[7];
+            uint8_t actual_bytes[7];
+            memset(expected_bytes, 0xFF, sizeof(expected_bytes));
+            memset(actual_bytes, 0xFF, sizeof(actual_bytes));
+
+            struct nexus_bitstream expected;
+            nexus_bitstream_init(&expected,
+                                 expected_bytes,
+                                 sizeof(expected_bytes) * 8,
+                                 offset);
+            nexus_bitstream_set_bit_position(&expected, offset);
+            for (uint8_t i = 0; i < bits; ++i)
+            {
+                nexus_bitstream_push_bit(&expected,
+                                         (pushed >> (bits - 1 - i)) & 0x01);
+            }
+
+            nexus_bitstream_init(
+                &_this.stream, actual_bytes, sizeof(actual_bytes) * 8, offset);
+            nexus_bitstream_set_bit_position(&_this.stream, offset);
+            nexus_bitstream_push_bits(&_this.stream, pushed, bits);
+
+            TEST_ASSERT_EQUAL_UINT(expected.position, _this.stream.position);
+            TEST_ASSERT_EQUAL_UINT(expected.length, _this.stream.length);
+            TEST_ASSERT_EQUAL_HEX8_ARRAY(
+                expected_bytes, actual_bytes, sizeof(actual_bytes));
+        }
+    }
+}
+
+void test_nexus_bitstream_pull_bits__various_offsets__matches_pull_bit(void)
+{
+    const uint8_t bytes[] = {0x5a, 0x81, 0xed, 0x3c, 0x96, 0x0f, 0xe1};
+
+    for (uint8_t offset = 0; offset < 16; ++offset)
+    {
+        for (uint8_t bits = 0; bits <= 32; ++bits)
+        {
+            struct nexus_bitstream expected;
+            nexus_bitstream_init(
+                &expected, (void*) bytes, sizeof(bytes) * 8, sizeof(bytes) * 8);
+            nexus_bitstream_set_bit_position(&expected, offset);
+            uint32_t expected_pulled = 0;
+            for (uint8_t i = 0; i < bits; ++i)
+            {
+                const bool bit = nexus_bitstream_pull_bit(&expected);
+                expected_pulled = (expected_pulled << 1) | (uint32_t) bit;
+            }
+
+            nexus_bitstream_init(&_this.stream,
+                                 (void*) bytes,
+                                 sizeof(bytes) * 8,
+                                 sizeof(bytes) * 8);
+            nexus_bitstream_set_bit_position(&_this.stream, offset);
+
+            const uint32_t pulled =
+                nexus_bitstream_pull_bits(&_this.stream, bits);
+            TEST_ASSERT_EQUAL_HEX32(expected_pulled, pulled);
+            TEST_ASSERT_EQUAL_UINT(expected.position, _this.stream.position);
+        }
+    }
+}
+
 void test_nexus_check_compute__fixed_inputs__outputs_are_expected(void)
 {
     const struct nx_common_check_key input_keys[] = {
@@ -277,6 +350,175 @@ void test_nexus_check_compute__fixed_inputs__outputs_are_expected(void)
     }
 }
 
+void test_siphash24_update__input_split_at_every_offset__matches_one_shot(void)
+{
+    const uint8_t key[16] = {0x12,
+                             0x34,
+                             0x56,
+                             0x78,
+                             0x9a,
+                             0xbc,
+                             0xde,
+                             0xfe,
+                             0x01,
+                             0x23,
+                             0x45,
+                             0x67,
+                             0x89,
+                             0xdd,
+                             0xcc,
+                             0xfe};
+    uint8_t input[41];
+    for (uint8_t i = 0; i < sizeof(input); i++)
+    {
+        input[i] = (uint8_t)(i * 7 + 3);
+    }
+
+    struct siphash24_keyed_state state;
+    siphash24_keyed_state_init(&state, key);
+
+    for (uint8_t len = 0; len <= sizeof(input); len++)
+    {
+        uint8_t expected[8];
+        siphash24_compute(expected, input, len, key);
+
+        uint8_t keyed[8];
+        siphash24_compute_keyed(keyed, input, len, &state);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, keyed, 8);
+
+        // split the same input into two and three updates
+        for (uint8_t split = 0; split <= len; split++)
+        {
+            struct siphash24_ctx ctx;
+            uint8_t incremental[8];
+
+            siphash24_init(&ctx, &state);
+            siphash24_update(&ctx, input, split);
+            siphash24_update(&ctx, &input[split], (uint32_t)(len - split) / 2);
+            siphash24_update(&ctx,
+                             &input[split + (len - split) / 2],
+                             (uint32_t)(len - split) - (len - split) / 2);
+            siphash24_final(&ctx, incremental);
+            TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, incremental, 8);
+        }
+    }
+}
+
+void test_nexus_check_compute_keyed__fixed_inputs__matches_check_compute(void)
+{
+    const char* inputs[] = {"", "q", "qwerty", "qwertyui", "qwertyuiopasdfg"};
+
+    struct nexus_check_keyed_state state;
+    nexus_check_keyed_state_init(&state, &NEXUS_INTEGRITY_CHECK_FIXED_FF_KEY);
+
+    for (uint8_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); ++i)
+    {
+        const uint16_t input_size = (uint16_t) strlen(inputs[i]);
+        const struct nexus_check_value expected = nexus_check_compute(
+            &NEXUS_INTEGRITY_CHECK_FIXED_FF_KEY, inputs[i], input_size);
+        const struct nexus_check_value keyed =
+            nexus_check_compute_keyed(&state, inputs[i], input_size);
+
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(
+            expected.bytes, keyed.bytes, sizeof(expected.bytes));
+    }
+}
+
+void test_nexus_check_compute_batch__various_counts__matches_single_computation(
+    void)
+{
+    struct nexus_check_keyed_state states[9];
+    uint8_t data[9][20];
+    struct nexus_check_value results[9];
+
+    for (uint8_t i = 0; i < 9; ++i)
+    {
+        struct nx_common_check_key key;
+        memset(key.bytes, (int) (0x11 * i), sizeof(key.bytes));
+        nexus_check_keyed_state_init(&states[i], &key);
+        for (uint8_t j = 0; j < sizeof(data[i]); ++j)
+        {
+            data[i][j] = (uint8_t) (i * 31 + j);
+        }
+    }
+
+    for (uint16_t data_size = 0; data_size <= sizeof(data[0]); ++data_size)
+    {
+        // messages in a batch are packed `data_size` bytes apart
+        uint8_t packed[sizeof(data)];
+        for (uint8_t i = 0; i < 9; ++i)
+        {
+            memcpy(&packed[i * data_size], data[i], data_size);
+        }
+
+        for (uint8_t count = 1; count <= 9; ++count)
+        {
+            // all messages under the first key, then each under its own key
+            nexus_check_compute_batch(
+                states, true, packed, data_size, count, results);
+            for (uint8_t i = 0; i < count; ++i)
+            {
+                const struct nexus_check_value expected =
+                    nexus_check_compute_keyed(&states[0], data[i], data_size);
+                TEST_ASSERT_EQUAL_UINT8_ARRAY(
+                    expected.bytes, results[i].bytes, sizeof(expected.bytes));
+            }
+
+            nexus_check_compute_batch(
+                states, false, packed, data_size, count, results);
+            for (uint8_t i = 0; i < count; ++i)
+            {
+                const struct nexus_check_value expected =
+                    nexus_check_compute_keyed(&states[i], data[i], data_size);
+                TEST_ASSERT_EQUAL_UINT8_ARRAY(
+                    expected.bytes, results[i].bytes, sizeof(expected.bytes));
+            }
+        }
+    }
+}
+
+void test_compute_crc_ccitt__fixed_inputs__outputs_are_expected(void)
+{
+    TEST_ASSERT_EQUAL_HEX16(0x29B1, compute_crc_ccitt("123456789", 9));
+    TEST_ASSERT_EQUAL_HEX16(0xFFFF, compute_crc_ccitt("", 0));
+    TEST_ASSERT_EQUAL_HEX16(0xB915, compute_crc_ccitt("A", 1));
+}
+
+void test_crc_ccitt_update__input_split_at_every_offset__matches_bitwise(void)
+{
+    // longer than 255 bytes, not a multiple of 4 bytes
+    uint8_t input[301];
+    for (uint16_t i = 0; i < sizeof(input); ++i)
+    {
+        input[i] = (uint8_t) (i * 13 + 7);
+    }
+
+    // reference bit-at-a-time computation
+    uint16_t expected = 0xffff;
+    for (uint16_t i = 0; i < sizeof(input); ++i)
+    {
+        expected ^= (uint16_t) (input[i] << 8);
+        for (uint8_t bit = 0; bit < 8; ++bit)
+        {
+            const bool msb_set = (expected & 0x8000) != 0;
+            expected = (uint16_t) (expected << 1);
+            if (msb_set)
+            {
+                expected ^= 0x1021;
+            }
+        }
+    }
+    TEST_ASSERT_EQUAL_HEX16(expected, compute_crc_ccitt(input, sizeof(input)));
+
+    for (uint16_t split = 0; split <= sizeof(input); ++split)
+    {
+        uint16_t crc = crc_ccitt_begin();
+        crc = crc_ccitt_update(crc, input, split);
+        crc = crc_ccitt_update(crc, &input[split], sizeof(input) - split);
+        TEST_ASSERT_EQUAL_HEX16(expected, crc_ccitt_finish(crc));
+    }
+}
+
 void test_nexus_check_compute_pseudorandom_bytes__fixed_inputs__outputs_are_expected(
     void)
 {
@@ -473,6 +715,36 @@ void test_nexus_digits_try_pull_uint32__too_few_remaining_digits__sets_underrun_
                                  digits.length - digits.position);
 }
 
+void test_nexus_digits_chars_to_uint32__various_counts__matches_digit_at_a_time(
+    void)
+{
+    // long enough for several 8-digit chunks
+    const char* chars = "90283884449992271350476128";
+
+    for (uint8_t offset = 0; offset < 4; ++offset)
+    {
+        for (uint8_t count = 0; count <= 22; ++count)
+        {
+            // reference conversion, wraps modulo 2^32 for over 9 digits
+            uint32_t expected = 0;
+            for (uint8_t i = 0; i < count; ++i)
+            {
+                expected = expected * 10 + (uint32_t)(chars[offset + i] - '0');
+            }
+
+            TEST_ASSERT_EQUAL_UINT32(
+                expected, nexus_digits_chars_to_uint32(&chars[offset], count));
+        }
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(0, nexus_digits_chars_to_uint32("00000000", 8));
+    TEST_ASSERT_EQUAL_UINT32(99999999,
+                             nexus_digits_chars_to_uint32("99999999", 8));
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX,
+                             nexus_digits_chars_to_uint32("4294967295", 10));
+    TEST_ASSERT_EQUAL_UINT32(0, nexus_digits_chars_to_uint32("4294967296", 10));
+}
+
 void test_nexus_digits_pull_uint8__too_many_digits_pulled__returns_uint8_max(
     void)
 {
@@ -635,6 +907,90 @@ void test_nexus_bitset_contains_bitset__fixed_sets__contains_expected_result(
     }
 }
 
+void test_nexus_bitset_shift_down__various_counts__matches_bit_by_bit(void)
+{
+    const uint8_t initial[] = {0x5a, 0x81, 0xed, 0x3c, 0x96, 0x0f, 0xe1};
+
+    for (uint8_t bytes_count = 1; bytes_count <= sizeof(initial); ++bytes_count)
+    {
+        for (uint16_t count = 0; count <= bytes_count * 8 + 1; ++count)
+        {
+            uint8_t expected_bytes[sizeof(initial)] = {0};
+            struct nexus_bitset expected;
+            nexus_bitset_init(&expected, expected_bytes, bytes_count);
+
+            uint8_t bytes[sizeof(initial)];
+            memcpy(bytes, initial, sizeof(bytes));
+            struct nexus_bitset bitset;
+            nexus_bitset_init(&bitset, bytes, bytes_count);
+
+            for (uint16_t i = count; i < bytes_count * 8; ++i)
+            {
+                if (nexus_bitset_contains(&bitset, i))
+                {
+                    nexus_bitset_add(&expected, (uint16_t)(i - count));
+                }
+            }
+
+            nexus_bitset_shift_down(&bitset, count);
+
+            TEST_ASSERT_EQUAL_HEX8_ARRAY(expected_bytes, bytes, bytes_count);
+            // bytes past the end of the bitset are untouched
+            TEST_ASSERT_EQUAL_HEX8_ARRAY(&initial[bytes_count],
+                                         &bytes[bytes_count],
+                                         sizeof(initial) - bytes_count);
+        }
+    }
+}
+
+void test_nexus_bitset_find_next_unset__various_starts__matches_bit_by_bit(
+    void)
+{
+    uint8_t bytes[] = {0xff, 0xef, 0xff, 0xff, 0xff, 0xff, 0x7f};
+
+    for (uint8_t bytes_count = 1; bytes_count <= sizeof(bytes); ++bytes_count)
+    {
+        struct nexus_bitset bitset;
+        nexus_bitset_init(&bitset, bytes, bytes_count);
+
+        for (uint16_t start = 0; start <= bytes_count * 8 + 1; ++start)
+        {
+            uint16_t expected = start;
+            while (expected < bytes_count * 8 &&
+                   nexus_bitset_contains(&bitset, expected))
+            {
+                ++expected;
+            }
+            if (expected > bytes_count * 8)
+            {
+                expected = (uint16_t)(bytes_count * 8);
+            }
+
+            const uint16_t unset = nexus_bitset_find_next_unset(&bitset, start);
+            TEST_ASSERT_EQUAL_UINT(expected, unset);
+        }
+    }
+}
+
+void test_nexus_bitset_count__various_bytes__matches_contained_elements(void)
+{
+    uint8_t bytes[] = {0x00, 0x81, 0xed, 0xff, 0x96, 0x0f, 0xe1};
+
+    for (uint8_t bytes_count = 1; bytes_count <= sizeof(bytes); ++bytes_count)
+    {
+        struct nexus_bitset bitset;
+        nexus_bitset_init(&bitset, bytes, bytes_count);
+
+        uint16_t expected = 0;
+        for (uint16_t i = 0; i < bytes_count * 8; ++i)
+        {
+            expected = (uint16_t)(expected + nexus_bitset_contains(&bitset, i));
+        }
+
+        TEST_ASSERT_EQUAL_UINT(expected, nexus_bitset_count(&bitset));
+    }
+}
+
 void test_nexus_window__init_valid_window_various_values__window_created_as_expected(
     void)
 {
@@ -761,6 +1117,58 @@ void test_nexus_window__set_flags__move_window_far__clear_all_flags(void)
     TEST_ASSERT_TRUE(nexus_util_window_id_flag_already_set(&window, 60));
 }
 
+void test_nexus_window_next_unset_id__runs_of_set_flags__skips_to_unset(void)
+{
+    struct nexus_window window;
+    uint8_t flag_array[4] = {0};
+
+    nexus_util_window_init(&window, flag_array, 4, 131, 31, 8);
+
+    // IDs 100-110 and 112-131 (center) set; 111 unset
+    for (uint32_t id = 100; id <= 131; ++id)
+    {
+        if (id != 111)
+        {
+            TEST_ASSERT_TRUE(nexus_util_window_set_id_flag(&window, id));
+        }
+    }
+
+    TEST_ASSERT_EQUAL_UINT(111, nexus_util_window_next_unset_id(&window, 100));
+    TEST_ASSERT_EQUAL_UINT(111, nexus_util_window_next_unset_id(&window, 111));
+    TEST_ASSERT_EQUAL_UINT(132, nexus_util_window_next_unset_id(&window, 112));
+    // above center, and outside the window, are never set
+    TEST_ASSERT_EQUAL_UINT(135, nexus_util_window_next_unset_id(&window, 135));
+    TEST_ASSERT_EQUAL_UINT(99, nexus_util_window_next_unset_id(&window, 99));
+    TEST_ASSERT_EQUAL_UINT(150, nexus_util_window_next_unset_id(&window, 150));
+}
+
+void test_nexus_window__largest_window__flags_kept_when_moved(void)
+{
+    struct nexus_window window;
+    uint8_t flag_array[NEXUS_UTIL_MAX_WINDOW_BITSET_SIZE_BYTES] = {0};
+
+    nexus_util_window_init(&window,
+                           flag_array,
+                           NEXUS_UTIL_MAX_WINDOW_BITSET_SIZE_BYTES,
+                           255,
+                           255,
+                           100);
+
+    TEST_ASSERT_TRUE(nexus_util_window_set_id_flag(&window, 0));
+    TEST_ASSERT_TRUE(nexus_util_window_set_id_flag(&window, 40));
+    TEST_ASSERT_TRUE(nexus_util_window_set_id_flag(&window, 200));
+
+    // move the window up by 37; ID 0 drops out, others move down
+    TEST_ASSERT_TRUE(nexus_util_window_set_id_flag(&window, 292));
+    TEST_ASSERT_EQUAL_UINT(292, window.center_index);
+    TEST_ASSERT_FALSE(nexus_util_window_id_flag_already_set(&window, 0));
+    TEST_ASSERT_TRUE(nexus_util_window_id_flag_already_set(&window, 40));
+    TEST_ASSERT_TRUE(nexus_util_window_id_flag_already_set(&window, 200));
+    TEST_ASSERT_TRUE(nexus_util_window_id_flag_already_set(&window, 292));
+    TEST_ASSERT_FALSE(nexus_util_window_id_flag_already_set(&window, 255));
+    TEST_ASSERT_EQUAL_UINT(3, nexus_bitset_count(&window.flags));
+}
+
 void test_endianness_htobe32__various_scenarios__result_matches_htonl(void)
 {
     struct test_scenario
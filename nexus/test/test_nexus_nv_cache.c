@@ -0,0 +1,275 @@
+#include "include/nx_common.h"
+#include "src/nexus_nv.h"
+#include "src/nexus_security.h"
+#include "src/nexus_util.h"
+#include "unity.h"
+#include "utils/crc_ccitt.h"
+
+// Other support libraries
+#include <mock_nexus_common_internal.h>
+#include <mock_nxp_common.h>
+#include <string.h>
+
+/********************************************************
+ * DEFINITIONS
+ *******************************************************/
+
+#define BLOCK_0_INNER_LENGTH                                                   \
+    (NX_COMMON_NV_BLOCK_0_LENGTH - NEXUS_NV_BLOCK_WRAPPER_SIZE_BYTES)
+#define BLOCK_1_INNER_LENGTH                                                   \
+    (NX_COMMON_NV_BLOCK_1_LENGTH - NEXUS_NV_BLOCK_WRAPPER_SIZE_BYTES)
+
+/********************************************************
+ * PRIVATE TYPES
+ *******************************************************/
+
+/********************************************************
+ * PRIVATE DATA
+ *******************************************************/
+
+// valid block 0, with inner data {0x06, 0x00, 0x00, 0x00}
+static const uint8_t BLOCK_0_VALID[NX_COMMON_NV_BLOCK_0_LENGTH] = {
+    0x00, 0x00, 0x06, 0x00, 0x00, 0x00, 0x89, 0x29};
+
+// Fake product NV, holding full blocks 0 and 1
+static uint8_t _fake_nv[2][NX_COMMON_NV_MAX_BLOCK_LENGTH];
+static uint32_t _fake_nv_reads;
+static uint32_t _fake_nv_writes;
+static bool _fake_nv_write_fails;
+static uint32_t _fake_processing_requests;
+static uint32_t _fake_uptime;
+
+/********************************************************
+ * PRIVATE FUNCTIONS
+ *******************************************************/
+
+bool CALLBACK_nxp_common_nv_read(
+    const struct nx_common_nv_block_meta block_meta,
+    void* read_buffer,
+    int NumCalls)
+{
+    (void) NumCalls;
+    TEST_ASSERT_TRUE(block_meta.block_id < 2);
+    _fake_nv_reads++;
+    memcpy(read_buffer, _fake_nv[block_meta.block_id], block_meta.length);
+    return true;
+}
+
+bool CALLBACK_nxp_common_nv_write(
+    const struct nx_common_nv_block_meta block_meta,
+    void* write_buffer,
+    int NumCalls)
+{
+    (void) NumCalls;
+    TEST_ASSERT_TRUE(block_meta.block_id < 2);
+    TEST_ASSERT_TRUE(nx_common_nv_block_valid(block_meta, write_buffer));
+    if (_fake_nv_write_fails)
+    {
+        return false;
+    }
+    _fake_nv_writes++;
+    memcpy(_fake_nv[block_meta.block_id], write_buffer, block_meta.length);
+    return true;
+}
+
+void CALLBACK_nxp_common_request_processing(int NumCalls)
+{
+    (void) NumCalls;
+    _fake_processing_requests++;
+}
+
+uint32_t CALLBACK_nexus_common_uptime(int NumCalls)
+{
+    (void) NumCalls;
+    return _fake_uptime;
+}
+
+// Setup (called before any 'test_*' function is called, automatically)
+void setUp(void)
+{
+    memset(_fake_nv, 0x00, sizeof(_fake_nv));
+    memcpy(_fake_nv[0], BLOCK_0_VALID, sizeof(BLOCK_0_VALID));
+    _fake_nv_reads = 0;
+    _fake_nv_writes = 0;
+    _fake_nv_write_fails = false;
+    _fake_processing_requests = 0;
+    _fake_uptime = 1000;
+
+    nxp_common_nv_read_StubWithCallback(CALLBACK_nxp_common_nv_read);
+    nxp_common_nv_write_StubWithCallback(CALLBACK_nxp_common_nv_write);
+    nxp_common_request_processing_StubWithCallback(
+        CALLBACK_nxp_common_request_processing);
+    nexus_common_uptime_StubWithCallback(CALLBACK_nexus_common_uptime);
+
+    nexus_nv_init();
+}
+
+// Teardown (called after any 'test_*' function is called, automatically)
+void tearDown(void)
+{
+}
+
+void test_nv_cache__read_twice__nv_read_once(void)
+{
+    uint8_t inner_data[BLOCK_0_INNER_LENGTH] = {0};
+
+    TEST_ASSERT_TRUE(nexus_nv_read(NX_NV_BLOCK_KEYCODE_MAS, inner_data));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(
+        &BLOCK_0_VALID[NEXUS_NV_BLOCK_ID_WIDTH], inner_data, sizeof(inner_data));
+    TEST_ASSERT_EQUAL_UINT(1, _fake_nv_reads);
+
+    memset(inner_data, 0x00, sizeof(inner_data));
+    TEST_ASSERT_TRUE(nexus_nv_read(NX_NV_BLOCK_KEYCODE_MAS, inner_data));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(
+        &BLOCK_0_VALID[NEXUS_NV_BLOCK_ID_WIDTH], inner_data, sizeof(inner_data));
+    TEST_ASSERT_EQUAL_UINT(1, _fake_nv_reads);
+}
+
+void test_nv_cache__read_invalid_block__fails_without_rereading(void)
+{
+    uint8_t inner_data[BLOCK_1_INNER_LENGTH] = {0};
+
+    // block 1 is all zeroes in NV, which is not a valid block
+    TEST_ASSERT_FALSE(nexus_nv_read(NX_NV_BLOCK_KEYCODE_PRO, inner_data));
+    TEST_ASSERT_FALSE(nexus_nv_read(NX_NV_BLOCK_KEYCODE_PRO, inner_data));
+    TEST_ASSERT_EQUAL_UINT(1, _fake_nv_reads);
+}
+
+void test_nv_cache__update_identical__no_nv_write(void)
+{
+    uint8_t inner_data[BLOCK_0_INNER_LENGTH] = {0x06, 0x00, 0x00, 0x00};
+
+    TEST_ASSERT_TRUE(nexus_nv_update(NX_NV_BLOCK_KEYCODE_MAS, inner_data));
+    TEST_ASSERT_TRUE(nexus_nv_update(NX_NV_BLOCK_KEYCODE_MAS, inner_data));
+    TEST_ASSERT_EQUAL_UINT(1, _fake_nv_reads);
+    TEST_ASSERT_EQUAL_UINT(0, _fake_processing_requests);
+
+    TEST_ASSERT_EQUAL_UINT(UINT32_MAX, nexus_nv_cache_process());
+    TEST_ASSERT_EQUAL_UINT(0, _fake_nv_writes);
+}
+
+void test_nv_cache__update_changed__written_after_flush_delay(void)
+{
+    uint8_t inner_data[BLOCK_0_INNER_LENGTH] = {0x07, 0x00, 0x00, 0x00};
+
+    TEST_ASSERT_TRUE(nexus_nv_update(NX_NV_BLOCK_KEYCODE_MAS, inner_data));
+    TEST_ASSERT_EQUAL_UINT(1, _fake_processing_requests);
+    TEST_ASSERT_EQUAL_UINT(0, _fake_nv_writes);
+
+    // updated data is read back before it is written
+    uint8_t read_data[BLOCK_0_INNER_LENGTH] = {0};
+    TEST_ASSERT_TRUE(nexus_nv_read(NX_NV_BLOCK_KEYCODE_MAS, read_data));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(inner_data, read_data, sizeof(read_data));
+
+    TEST_ASSERT_EQUAL_UINT(NEXUS_NV_CACHE_FLUSH_DELAY_SECONDS,
+                           nexus_nv_cache_process());
+    _fake_uptime += NEXUS_NV_CACHE_FLUSH_DELAY_SECONDS - 1;
+    TEST_ASSERT_EQUAL_UINT(1, nexus_nv_cache_process());
+    TEST_ASSERT_EQUAL_UINT(0, _fake_nv_writes);
+
+    _fake_uptime += 1;
+    TEST_ASSERT_EQUAL_UINT(UINT32_MAX, nexus_nv_cache_process());
+    TEST_ASSERT_EQUAL_UINT(1, _fake_nv_writes);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(inner_data,
+                                  &_fake_nv[0][NEXUS_NV_BLOCK_ID_WIDTH],
+                                  sizeof(inner_data));
+    TEST_ASSERT_EQUAL_UINT(1, _fake_nv_reads);
+}
+
+void test_nv_cache__several_updates_within_delay__single_nv_write(void)
+{
+    uint8_t inner_data[BLOCK_0_INNER_LENGTH] = {0};
+
+    for (uint8_t i = 1; i <= 10; i++)
+    {
+        memset(inner_data, i, sizeof(inner_data));
+        TEST_ASSERT_TRUE(nexus_nv_update(NX_NV_BLOCK_KEYCODE_MAS, inner_data));
+    }
+    TEST_ASSERT_EQUAL_UINT(1, _fake_processing_requests);
+
+    _fake_uptime += NEXUS_NV_CACHE_FLUSH_DELAY_SECONDS;
+    TEST_ASSERT_EQUAL_UINT(UINT32_MAX, nexus_nv_cache_process());
+    TEST_ASSERT_EQUAL_UINT(1, _fake_nv_writes);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(inner_data,
+                                  &_fake_nv[0][NEXUS_NV_BLOCK_ID_WIDTH],
+                                  sizeof(inner_data));
+}
+
+void test_nv_cache__update_keycode_receipts__written_immediately(void)
+{
+    uint8_t inner_data[BLOCK_1_INNER_LENGTH] = {0};
+
+    for (uint8_t i = 1; i <= 3; i++)
+    {
+        memset(inner_data, i, sizeof(inner_data));
+        TEST_ASSERT_TRUE(nexus_nv_update(NX_NV_BLOCK_KEYCODE_PRO, inner_data));
+        TEST_ASSERT_EQUAL_UINT(i, _fake_nv_writes);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(inner_data,
+                                      &_fake_nv[1][NEXUS_NV_BLOCK_ID_WIDTH],
+                                      sizeof(inner_data));
+    }
+
+    // identical updates are still not written
+    TEST_ASSERT_TRUE(nexus_nv_update(NX_NV_BLOCK_KEYCODE_PRO, inner_data));
+    TEST_ASSERT_EQUAL_UINT(3, _fake_nv_writes);
+    TEST_ASSERT_EQUAL_UINT(UINT32_MAX, nexus_nv_cache_process());
+}
+
+void test_nv_cache__update_keycode_receipts_write_fails__retried_after_delay(
+    void)
+{
+    uint8_t inner_data[BLOCK_1_INNER_LENGTH] = {0};
+    memset(inner_data, 0x5A, sizeof(inner_data));
+
+    _fake_nv_write_fails = true;
+    TEST_ASSERT_FALSE(nexus_nv_update(NX_NV_BLOCK_KEYCODE_PRO, inner_data));
+    TEST_ASSERT_EQUAL_UINT(0, _fake_nv_writes);
+
+    _fake_nv_write_fails = false;
+    TEST_ASSERT_EQUAL_UINT(NEXUS_NV_CACHE_FLUSH_DELAY_SECONDS,
+                           nexus_nv_cache_process());
+    _fake_uptime += NEXUS_NV_CACHE_FLUSH_DELAY_SECONDS;
+    TEST_ASSERT_EQUAL_UINT(UINT32_MAX, nexus_nv_cache_process());
+    TEST_ASSERT_EQUAL_UINT(1, _fake_nv_writes);
+}
+
+void test_nv_cache__nv_write_fails__retried_after_delay(void)
+{
+    uint8_t inner_data[BLOCK_0_INNER_LENGTH] = {0x08, 0x00, 0x00, 0x00};
+
+    TEST_ASSERT_TRUE(nexus_nv_update(NX_NV_BLOCK_KEYCODE_MAS, inner_data));
+
+    _fake_nv_write_fails = true;
+    _fake_uptime += NEXUS_NV_CACHE_FLUSH_DELAY_SECONDS;
+    TEST_ASSERT_EQUAL_UINT(NEXUS_NV_CACHE_FLUSH_DELAY_SECONDS,
+                           nexus_nv_cache_process());
+    TEST_ASSERT_EQUAL_UINT(0, _fake_nv_writes);
+
+    _fake_nv_write_fails = false;
+    _fake_uptime += NEXUS_NV_CACHE_FLUSH_DELAY_SECONDS;
+    TEST_ASSERT_EQUAL_UINT(UINT32_MAX, nexus_nv_cache_process());
+    TEST_ASSERT_EQUAL_UINT(1, _fake_nv_writes);
+}
+
+void test_nv_cache__flush__writes_all_updated_blocks_immediately(void)
+{
+    uint8_t inner_data[BLOCK_0_INNER_LENGTH] = {0x09, 0x00, 0x00, 0x00};
+
+    TEST_ASSERT_TRUE(nexus_nv_update(NX_NV_BLOCK_KEYCODE_MAS, inner_data));
+    TEST_ASSERT_EQUAL_UINT(0, _fake_nv_writes);
+
+    TEST_ASSERT_TRUE(nexus_nv_cache_flush());
+    TEST_ASSERT_EQUAL_UINT(1, _fake_nv_writes);
+
+    // nothing left to write
+    TEST_ASSERT_TRUE(nexus_nv_cache_flush());
+    _fake_uptime += NEXUS_NV_CACHE_FLUSH_DELAY_SECONDS;
+    TEST_ASSERT_EQUAL_UINT(UINT32_MAX, nexus_nv_cache_process());
+    TEST_ASSERT_EQUAL_UINT(1, _fake_nv_writes);
+
+    // data persisted in NV is read after the cache is reset
+    nexus_nv_init();
+    uint8_t read_data[BLOCK_0_INNER_LENGTH] = {0};
+    TEST_ASSERT_TRUE(nexus_nv_read(NX_NV_BLOCK_KEYCODE_MAS, read_data));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(inner_data, read_data, sizeof(read_data));
+}
@@ -0,0 +1,302 @@
+#include "include/nx_common.h"
+#include "src/nexus_nv.h"
+#include "test/support/nv_flash_file.h"
+#include "unity.h"
+#include "utils/crc_ccitt.h"
+#include "utils/nv_log.h"
+
+// Other support libraries
+#include <mock_nxp_common.h>
+#include <stdio.h>
+#include <string.h>
+
+/********************************************************
+ * DEFINITIONS
+ *******************************************************/
+
+#define TEST_FLASH_PATH "test_nexus_nv_log_flash.bin"
+#define TEST_PAGE_SIZE 256
+#define TEST_PAGE_COUNT 4
+
+/********************************************************
+ * PRIVATE TYPES
+ *******************************************************/
+
+/********************************************************
+ * PRIVATE DATA
+ *******************************************************/
+
+static struct nv_flash_file _flash;
+static struct nv_log _log;
+
+/********************************************************
+ * PRIVATE FUNCTIONS
+ *******************************************************/
+
+// Fill `block` with a valid NV block, with every data byte set to `value`
+static void _make_block(const struct nx_common_nv_block_meta block_meta,
+                        uint8_t value,
+                        uint8_t* block)
+{
+    memcpy(block, &block_meta.block_id, NEXUS_NV_BLOCK_ID_WIDTH);
+    memset(block + NEXUS_NV_BLOCK_ID_WIDTH,
+           value,
+           block_meta.length - NEXUS_NV_BLOCK_WRAPPER_SIZE_BYTES);
+    const uint16_t crc = compute_crc_ccitt(
+        block, (size_t)(block_meta.length - NEXUS_NV_BLOCK_CRC_WIDTH));
+    memcpy(block + block_meta.length - NEXUS_NV_BLOCK_CRC_WIDTH,
+           &crc,
+           NEXUS_NV_BLOCK_CRC_WIDTH);
+}
+
+static bool _write_value(const struct nx_common_nv_block_meta block_meta,
+                         uint8_t value)
+{
+    uint8_t block[NX_COMMON_NV_MAX_BLOCK_LENGTH];
+    _make_block(block_meta, value, block);
+    return nv_log_write(&_log, block_meta, block);
+}
+
+static void _assert_value(const struct nx_common_nv_block_meta block_meta,
+                          uint8_t value)
+{
+    uint8_t expected[NX_COMMON_NV_MAX_BLOCK_LENGTH];
+    uint8_t block[NX_COMMON_NV_MAX_BLOCK_LENGTH];
+    _make_block(block_meta, value, expected);
+    TEST_ASSERT_TRUE(nv_log_read(&_log, block_meta, block));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, block, block_meta.length);
+}
+
+// Read the data value of a block, which must be present and valid
+static uint8_t _read_value(const struct nx_common_nv_block_meta block_meta)
+{
+    uint8_t block[NX_COMMON_NV_MAX_BLOCK_LENGTH];
+    TEST_ASSERT_TRUE(nv_log_read(&_log, block_meta, block));
+    TEST_ASSERT_TRUE(nx_common_nv_block_valid(block_meta, block));
+    return block[NEXUS_NV_BLOCK_ID_WIDTH];
+}
+
+// Setup (called before any 'test_*' function is called, automatically)
+void setUp(void)
+{
+    (void) remove(TEST_FLASH_PATH);
+    TEST_ASSERT_TRUE(nv_flash_file_open(
+        &_flash, TEST_FLASH_PATH, TEST_PAGE_SIZE, TEST_PAGE_COUNT));
+    TEST_ASSERT_TRUE(nv_log_init(&_log, &_flash.flash));
+}
+
+// Teardown (called after any 'test_*' function is called, automatically)
+void tearDown(void)
+{
+    nv_flash_file_close(&_flash);
+    (void) remove(TEST_FLASH_PATH);
+}
+
+void test_nv_log__invalid_flash__init_fails(void)
+{
+    struct nv_log_flash flash = _flash.flash;
+    flash.page_count = 1;
+    TEST_ASSERT_FALSE(nv_log_init(&_log, &flash));
+
+    flash.page_count = NV_LOG_MAX_PAGES + 1;
+    TEST_ASSERT_FALSE(nv_log_init(&_log, &flash));
+
+    flash.page_count = TEST_PAGE_COUNT;
+    flash.page_size = NV_LOG_PAGE_HEADER_SIZE + NX_COMMON_NV_MAX_BLOCK_LENGTH;
+    TEST_ASSERT_FALSE(nv_log_init(&_log, &flash));
+}
+
+void test_nv_log__blank_flash__no_blocks_read(void)
+{
+    uint8_t block[NX_COMMON_NV_MAX_BLOCK_LENGTH];
+    TEST_ASSERT_FALSE(nv_log_read(&_log, NX_NV_BLOCK_KEYCODE_MAS, block));
+    TEST_ASSERT_FALSE(nv_log_read(&_log, NX_NV_BLOCK_KEYCODE_PRO, block));
+
+    // nothing is written to flash until a block is written
+    TEST_ASSERT_EQUAL_UINT(0, _flash.bytes_programmed);
+}
+
+void test_nv_log__write_then_read__latest_block_returned(void)
+{
+    TEST_ASSERT_TRUE(_write_value(NX_NV_BLOCK_KEYCODE_MAS, 0x11));
+    TEST_ASSERT_TRUE(_write_value(NX_NV_BLOCK_KEYCODE_PRO, 0x22));
+    _assert_value(NX_NV_BLOCK_KEYCODE_MAS, 0x11);
+    _assert_value(NX_NV_BLOCK_KEYCODE_PRO, 0x22);
+
+    TEST_ASSERT_TRUE(_write_value(NX_NV_BLOCK_KEYCODE_MAS, 0x33));
+    _assert_value(NX_NV_BLOCK_KEYCODE_MAS, 0x33);
+    _assert_value(NX_NV_BLOCK_KEYCODE_PRO, 0x22);
+
+    // No erases while the first page has space
+    for (uint8_t page = 0; page < TEST_PAGE_COUNT; page++)
+    {
+        TEST_ASSERT_EQUAL_UINT(0, _flash.erase_count[page]);
+    }
+}
+
+void test_nv_log__read_with_wrong_length__fails(void)
+{
+    TEST_ASSERT_TRUE(_write_value(NX_NV_BLOCK_KEYCODE_MAS, 0x11));
+
+    struct nx_common_nv_block_meta wrong_meta = NX_NV_BLOCK_KEYCODE_MAS;
+    wrong_meta.length = NX_COMMON_NV_BLOCK_1_LENGTH;
+    uint8_t block[NX_COMMON_NV_MAX_BLOCK_LENGTH];
+    TEST_ASSERT_FALSE(nv_log_read(&_log, wrong_meta, block));
+}
+
+void test_nv_log__invalid_block__not_written(void)
+{
+    uint8_t block[NX_COMMON_NV_MAX_BLOCK_LENGTH];
+    _make_block(NX_NV_BLOCK_KEYCODE_MAS, 0x44, block);
+    block[NEXUS_NV_BLOCK_ID_WIDTH] ^= 0x01;
+    TEST_ASSERT_FALSE(nv_log_write(&_log, NX_NV_BLOCK_KEYCODE_MAS, block));
+
+    // block ID does not match metadata
+    _make_block(NX_NV_BLOCK_KEYCODE_MAS, 0x44, block);
+    TEST_ASSERT_FALSE(nv_log_write(&_log, NX_NV_BLOCK_KEYCODE_PRO, block));
+
+    TEST_ASSERT_FALSE(nv_log_read(&_log, NX_NV_BLOCK_KEYCODE_MAS, block));
+    TEST_ASSERT_EQUAL_UINT(0, _flash.bytes_programmed);
+}
+
+void test_nv_log__write_segments__same_as_full_block(void)
+{
+    const struct nx_common_nv_block_meta meta = NX_NV_BLOCK_KEYCODE_PRO;
+    const uint8_t inner_length =
+        (uint8_t)(meta.length - NEXUS_NV_BLOCK_WRAPPER_SIZE_BYTES);
+    uint8_t block[NX_COMMON_NV_MAX_BLOCK_LENGTH];
+    _make_block(meta, 0x55, block);
+
+    // block ID, inner data, and CRC, as written by Nexus
+    struct nx_common_nv_write_segment segments[3] = {
+        {.data = block, .length = NEXUS_NV_BLOCK_ID_WIDTH},
+        {.data = block + NEXUS_NV_BLOCK_ID_WIDTH, .length = inner_length},
+        {.data = block + NEXUS_NV_BLOCK_ID_WIDTH + inner_length,
+         .length = NEXUS_NV_BLOCK_CRC_WIDTH},
+    };
+    TEST_ASSERT_TRUE(nv_log_write_v(&_log, meta, segments, 3));
+    _assert_value(meta, 0x55);
+
+    // segments which do not add up to the block length are rejected
+    TEST_ASSERT_FALSE(nv_log_write_v(&_log, meta, segments, 2));
+    segments[1].length++;
+    TEST_ASSERT_FALSE(nv_log_write_v(&_log, meta, segments, 3));
+
+    // segments forming an invalid block are rejected
+    segments[1].length--;
+    uint8_t other_data[NX_COMMON_NV_MAX_BLOCK_LENGTH];
+    memset(other_data, 0x66, sizeof(other_data));
+    segments[1].data = other_data;
+    TEST_ASSERT_FALSE(nv_log_write_v(&_log, meta, segments, 3));
+    _assert_value(meta, 0x55);
+}
+
+void test_nv_log__reinit__latest_blocks_restored(void)
+{
+    for (uint8_t i = 0; i < 20; i++)
+    {
+        TEST_ASSERT_TRUE(_write_value(NX_NV_BLOCK_KEYCODE_MAS, i));
+        TEST_ASSERT_TRUE(_write_value(NX_NV_BLOCK_KEYCODE_PRO, (uint8_t)(~i)));
+    }
+
+    memset(&_log, 0x00, sizeof(_log));
+    TEST_ASSERT_TRUE(nv_log_init(&_log, &_flash.flash));
+    _assert_value(NX_NV_BLOCK_KEYCODE_MAS, 19);
+    _assert_value(NX_NV_BLOCK_KEYCODE_PRO, (uint8_t)(~19));
+
+    // writes continue after the restored records
+    TEST_ASSERT_TRUE(_write_value(NX_NV_BLOCK_KEYCODE_MAS, 0xA0));
+    _assert_value(NX_NV_BLOCK_KEYCODE_MAS, 0xA0);
+    _assert_value(NX_NV_BLOCK_KEYCODE_PRO, (uint8_t)(~19));
+}
+
+void test_nv_log__many_updates__pages_collected_and_wear_levelled(void)
+{
+    // block 1 is written once, and must survive collection of its page
+    TEST_ASSERT_TRUE(_write_value(NX_NV_BLOCK_KEYCODE_PRO, 0x5A));
+
+    for (uint16_t i = 0; i < 2000; i++)
+    {
+        TEST_ASSERT_TRUE(_write_value(NX_NV_BLOCK_KEYCODE_MAS, (uint8_t) i));
+    }
+    _assert_value(NX_NV_BLOCK_KEYCODE_MAS, (uint8_t) 1999);
+    _assert_value(NX_NV_BLOCK_KEYCODE_PRO, 0x5A);
+
+    // 2000 updates at 12 bytes per record, with far fewer page erases
+    uint32_t min_erases = UINT32_MAX;
+    uint32_t max_erases = 0;
+    for (uint8_t page = 0; page < TEST_PAGE_COUNT; page++)
+    {
+        min_erases = _flash.erase_count[page] < min_erases ?
+                         _flash.erase_count[page] :
+                         min_erases;
+        max_erases = _flash.erase_count[page] > max_erases ?
+                         _flash.erase_count[page] :
+                         max_erases;
+    }
+    TEST_ASSERT_TRUE(min_erases > 0);
+    TEST_ASSERT_TRUE(max_erases - min_erases <= 1);
+    TEST_ASSERT_TRUE(max_erases * TEST_PAGE_COUNT < 2000 / 10);
+
+    memset(&_log, 0x00, sizeof(_log));
+    TEST_ASSERT_TRUE(nv_log_init(&_log, &_flash.flash));
+    _assert_value(NX_NV_BLOCK_KEYCODE_MAS, (uint8_t) 1999);
+    _assert_value(NX_NV_BLOCK_KEYCODE_PRO, 0x5A);
+}
+
+void test_nv_log__power_loss_at_any_point__acknowledged_blocks_kept(void)
+{
+    // Repeat the same sequence of writes, with power lost after a different
+    // number of programmed bytes each time (including during page headers,
+    // page collection, and page erases)
+    for (int32_t power_loss_bytes = 0; power_loss_bytes < 2000;
+         power_loss_bytes += 3)
+    {
+        tearDown();
+        setUp();
+
+        uint8_t acknowledged[2] = {0, 0};
+        uint8_t attempted[2] = {0, 0};
+        const struct nx_common_nv_block_meta metas[2] = {
+            NX_NV_BLOCK_KEYCODE_MAS, NX_NV_BLOCK_KEYCODE_PRO};
+
+        nv_flash_file_power_loss_after(&_flash, power_loss_bytes);
+        for (uint16_t i = 1; i < 200; i++)
+        {
+            const uint8_t which = (uint8_t)(i % 3 == 0);
+            attempted[which] = (uint8_t) i;
+            if (!_write_value(metas[which], (uint8_t) i))
+            {
+                break;
+            }
+            acknowledged[which] = (uint8_t) i;
+        }
+
+        nv_flash_file_power_on(&_flash);
+        TEST_ASSERT_TRUE(nv_log_init(&_log, &_flash.flash));
+        for (uint8_t which = 0; which < 2; which++)
+        {
+            if (acknowledged[which] == 0 && attempted[which] == 0)
+            {
+                continue;
+            }
+            uint8_t block[NX_COMMON_NV_MAX_BLOCK_LENGTH];
+            if (acknowledged[which] == 0 &&
+                !nv_log_read(&_log, metas[which], block))
+            {
+                // first write of the block was interrupted
+                continue;
+            }
+            const uint8_t value = _read_value(metas[which]);
+            TEST_ASSERT_TRUE(value == acknowledged[which] ||
+                             value == attempted[which]);
+        }
+
+        // log remains usable, through further page changes
+        for (uint16_t i = 0; i < 100; i++)
+        {
+            TEST_ASSERT_TRUE(_write_value(NX_NV_BLOCK_KEYCODE_MAS, 0xEE));
+        }
+        _assert_value(NX_NV_BLOCK_KEYCODE_MAS, 0xEE);
+    }
+}
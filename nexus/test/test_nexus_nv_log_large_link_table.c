@@ -0,0 +1,138 @@
+#include "include/nx_common.h"
+#include "src/nexus_nv.h"
+#include "test/support/nv_flash_file.h"
+#include "unity.h"
+#include "utils/crc_ccitt.h"
+#include "utils/nv_log.h"
+
+// Other support libraries
+#include <mock_nxp_common.h>
+#include <stdio.h>
+#include <string.h>
+
+/********************************************************
+ * DEFINITIONS
+ *******************************************************/
+
+#define TEST_FLASH_PATH "test_nexus_nv_log_large_link_table_flash.bin"
+#define TEST_PAGE_SIZE 512
+#define TEST_PAGE_COUNT 4
+
+/********************************************************
+ * PRIVATE TYPES
+ *******************************************************/
+
+/********************************************************
+ * PRIVATE DATA
+ *******************************************************/
+
+static struct nv_flash_file _flash;
+static struct nv_log _log;
+
+// first and last link page blocks
+static const struct nx_common_nv_block_meta FIRST_LINK_PAGE = {
+    .block_id = NX_COMMON_NV_LINK_PAGE_FIRST_BLOCK_ID,
+    .length = NX_COMMON_NV_LINK_PAGE_BLOCK_LENGTH};
+static const struct nx_common_nv_block_meta LAST_LINK_PAGE = {
+    .block_id = NX_COMMON_NV_LINK_PAGE_FIRST_BLOCK_ID +
+                NX_COMMON_NV_LINK_PAGE_COUNT - 1,
+    .length = NX_COMMON_NV_LINK_PAGE_BLOCK_LENGTH};
+
+/********************************************************
+ * PRIVATE FUNCTIONS
+ *******************************************************/
+
+// Fill `block` with a valid NV block, with every data byte set to `value`
+static void _make_block(const struct nx_common_nv_block_meta block_meta,
+                        uint8_t value,
+                        uint8_t* block)
+{
+    memcpy(block, &block_meta.block_id, NEXUS_NV_BLOCK_ID_WIDTH);
+    memset(block + NEXUS_NV_BLOCK_ID_WIDTH,
+           value,
+           block_meta.length - NEXUS_NV_BLOCK_WRAPPER_SIZE_BYTES);
+    const uint16_t crc = compute_crc_ccitt(
+        block, (size_t)(block_meta.length - NEXUS_NV_BLOCK_CRC_WIDTH));
+    memcpy(block + block_meta.length - NEXUS_NV_BLOCK_CRC_WIDTH,
+           &crc,
+           NEXUS_NV_BLOCK_CRC_WIDTH);
+}
+
+static bool _write_value(const struct nx_common_nv_block_meta block_meta,
+                         uint8_t value)
+{
+    uint8_t block[NX_COMMON_NV_MAX_BLOCK_LENGTH];
+    _make_block(block_meta, value, block);
+    return nv_log_write(&_log, block_meta, block);
+}
+
+static void _assert_value(const struct nx_common_nv_block_meta block_meta,
+                          uint8_t value)
+{
+    uint8_t expected[NX_COMMON_NV_MAX_BLOCK_LENGTH];
+    uint8_t block[NX_COMMON_NV_MAX_BLOCK_LENGTH];
+    _make_block(block_meta, value, expected);
+    TEST_ASSERT_TRUE(nv_log_read(&_log, block_meta, block));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, block, block_meta.length);
+}
+
+// Setup (called before any 'test_*' function is called, automatically)
+void setUp(void)
+{
+    (void) remove(TEST_FLASH_PATH);
+    TEST_ASSERT_TRUE(nv_flash_file_open(
+        &_flash, TEST_FLASH_PATH, TEST_PAGE_SIZE, TEST_PAGE_COUNT));
+    TEST_ASSERT_TRUE(nv_log_init(&_log, &_flash.flash));
+}
+
+// Teardown (called after any 'test_*' function is called, automatically)
+void tearDown(void)
+{
+    nv_flash_file_close(&_flash);
+    (void) remove(TEST_FLASH_PATH);
+}
+
+void test_nv_log_large_link_table__link_pages__stored_and_restored(void)
+{
+    TEST_ASSERT_TRUE(_write_value(FIRST_LINK_PAGE, 0x11));
+    TEST_ASSERT_TRUE(_write_value(LAST_LINK_PAGE, 0x22));
+    TEST_ASSERT_TRUE(_write_value(NX_NV_BLOCK_KEYCODE_PRO, 0x33));
+    _assert_value(FIRST_LINK_PAGE, 0x11);
+    _assert_value(LAST_LINK_PAGE, 0x22);
+
+    memset(&_log, 0x00, sizeof(_log));
+    TEST_ASSERT_TRUE(nv_log_init(&_log, &_flash.flash));
+    _assert_value(FIRST_LINK_PAGE, 0x11);
+    _assert_value(LAST_LINK_PAGE, 0x22);
+    _assert_value(NX_NV_BLOCK_KEYCODE_PRO, 0x33);
+}
+
+void test_nv_log_large_link_table__many_updates__link_page_survives_collection(
+    void)
+{
+    // written once, and must be copied forward when its page is collected
+    TEST_ASSERT_TRUE(_write_value(LAST_LINK_PAGE, 0x5A));
+
+    for (uint16_t i = 0; i < 500; i++)
+    {
+        TEST_ASSERT_TRUE(_write_value(FIRST_LINK_PAGE, (uint8_t) i));
+    }
+    TEST_ASSERT_TRUE(_flash.erase_count[0] > 0);
+    _assert_value(FIRST_LINK_PAGE, (uint8_t) 499);
+    _assert_value(LAST_LINK_PAGE, 0x5A);
+
+    memset(&_log, 0x00, sizeof(_log));
+    TEST_ASSERT_TRUE(nv_log_init(&_log, &_flash.flash));
+    _assert_value(FIRST_LINK_PAGE, (uint8_t) 499);
+    _assert_value(LAST_LINK_PAGE, 0x5A);
+}
+
+void test_nv_log_large_link_table__block_above_link_pages__not_written(void)
+{
+    const struct nx_common_nv_block_meta past_last_page = {
+        .block_id = NX_COMMON_NV_LINK_PAGE_FIRST_BLOCK_ID +
+                    NX_COMMON_NV_LINK_PAGE_COUNT,
+        .length = NX_COMMON_NV_LINK_PAGE_BLOCK_LENGTH};
+    TEST_ASSERT_FALSE(_write_value(past_last_page, 0x11));
+    TEST_ASSERT_EQUAL_UINT(0, _flash.bytes_programmed);
+}
@@ -0,0 +1,298 @@
+#include "include/nx_common.h"
+#include "src/nexus_nv.h"
+#include "unity.h"
+#include "utils/crc_ccitt.h"
+
+// Other support libraries
+#include <mock_nxp_common.h>
+#include <string.h>
+
+/********************************************************
+ * DEFINITIONS
+ *******************************************************/
+
+#define BLOCK_0_INNER_LENGTH                                                   \
+    (NX_COMMON_NV_BLOCK_0_LENGTH - NEXUS_NV_BLOCK_WRAPPER_SIZE_BYTES)
+#define BLOCK_1_INNER_LENGTH                                                   \
+    (NX_COMMON_NV_BLOCK_1_LENGTH - NEXUS_NV_BLOCK_WRAPPER_SIZE_BYTES)
+
+// Block IDs of copy B, and of the commit blocks
+#define BLOCK_0_COPY_B_ID (NX_COMMON_NV_BLOCK_COPY_B_ID_OFFSET + 0)
+#define BLOCK_1_COPY_B_ID (NX_COMMON_NV_BLOCK_COPY_B_ID_OFFSET + 1)
+#define COMMIT_BLOCK_A_ID 21
+#define COMMIT_BLOCK_B_ID 22
+
+#define FAKE_NV_BLOCK_COUNT 64
+#define FAKE_NV_MAX_WRITES 16
+
+/********************************************************
+ * PRIVATE TYPES
+ *******************************************************/
+
+/********************************************************
+ * PRIVATE DATA
+ *******************************************************/
+
+// Fake product NV, holding full blocks by block ID
+static uint8_t _fake_nv[FAKE_NV_BLOCK_COUNT][NX_COMMON_NV_MAX_BLOCK_LENGTH];
+static uint16_t _fake_nv_written_ids[FAKE_NV_MAX_WRITES];
+static uint32_t _fake_nv_writes;
+// writes which complete before power is lost, or -1 if power is not lost
+static int32_t _fake_nv_writes_until_power_loss;
+
+/********************************************************
+ * PRIVATE FUNCTIONS
+ *******************************************************/
+
+bool CALLBACK_nxp_common_nv_read(
+    const struct nx_common_nv_block_meta block_meta,
+    void* read_buffer,
+    int NumCalls)
+{
+    (void) NumCalls;
+    TEST_ASSERT_TRUE(block_meta.block_id < FAKE_NV_BLOCK_COUNT);
+    memcpy(read_buffer, _fake_nv[block_meta.block_id], block_meta.length);
+    return true;
+}
+
+bool CALLBACK_nxp_common_nv_write(
+    const struct nx_common_nv_block_meta block_meta,
+    void* write_buffer,
+    int NumCalls)
+{
+    (void) NumCalls;
+    TEST_ASSERT_TRUE(block_meta.block_id < FAKE_NV_BLOCK_COUNT);
+    TEST_ASSERT_TRUE(nx_common_nv_block_valid(block_meta, write_buffer));
+    if (_fake_nv_writes_until_power_loss == 0)
+    {
+        // interrupted write, leaving an invalid block
+        memset(_fake_nv[block_meta.block_id], 0xA5, block_meta.length);
+        return false;
+    }
+    if (_fake_nv_writes_until_power_loss > 0)
+    {
+        _fake_nv_writes_until_power_loss--;
+    }
+
+    TEST_ASSERT_TRUE(_fake_nv_writes < FAKE_NV_MAX_WRITES);
+    _fake_nv_written_ids[_fake_nv_writes++] = block_meta.block_id;
+    memcpy(_fake_nv[block_meta.block_id], write_buffer, block_meta.length);
+    return true;
+}
+
+// Store a valid block in fake NV, with every inner data byte set to `value`
+static void _fake_nv_store(const struct nx_common_nv_block_meta block_meta,
+                           uint8_t value)
+{
+    uint8_t* block = _fake_nv[block_meta.block_id];
+    memcpy(block, &block_meta.block_id, NEXUS_NV_BLOCK_ID_WIDTH);
+    memset(block + NEXUS_NV_BLOCK_ID_WIDTH,
+           value,
+           block_meta.length - NEXUS_NV_BLOCK_WRAPPER_SIZE_BYTES);
+    const uint16_t crc = compute_crc_ccitt(
+        block, (size_t)(block_meta.length - NEXUS_NV_BLOCK_CRC_WIDTH));
+    memcpy(block + block_meta.length - NEXUS_NV_BLOCK_CRC_WIDTH,
+           &crc,
+           NEXUS_NV_BLOCK_CRC_WIDTH);
+}
+
+// Update a block, with every inner data byte set to `value`
+static bool _update_value(const struct nx_common_nv_block_meta block_meta,
+                          uint8_t value)
+{
+    uint8_t inner_data[NX_COMMON_NV_MAX_BLOCK_LENGTH];
+    memset(inner_data, value, sizeof(inner_data));
+    return nexus_nv_update(block_meta, inner_data);
+}
+
+// Read a block, which must be valid with every inner data byte identical
+static uint8_t _read_value(const struct nx_common_nv_block_meta block_meta)
+{
+    const uint8_t inner_length =
+        (uint8_t)(block_meta.length - NEXUS_NV_BLOCK_WRAPPER_SIZE_BYTES);
+    uint8_t inner_data[NX_COMMON_NV_MAX_BLOCK_LENGTH];
+    TEST_ASSERT_TRUE(nexus_nv_read(block_meta, inner_data));
+    for (uint8_t i = 1; i < inner_length; i++)
+    {
+        TEST_ASSERT_EQUAL_UINT8(inner_data[0], inner_data[i]);
+    }
+    return inner_data[0];
+}
+
+// Discard all NV state in RAM, as after a reset
+static void _reset(void)
+{
+    _fake_nv_writes_until_power_loss = -1;
+    _fake_nv_writes = 0;
+    nexus_nv_init();
+}
+
+// Setup (called before any 'test_*' function is called, automatically)
+void setUp(void)
+{
+    memset(_fake_nv, 0x00, sizeof(_fake_nv));
+    memset(_fake_nv_written_ids, 0x00, sizeof(_fake_nv_written_ids));
+
+    nxp_common_nv_read_StubWithCallback(CALLBACK_nxp_common_nv_read);
+    nxp_common_nv_write_StubWithCallback(CALLBACK_nxp_common_nv_write);
+
+    // blocks written before transactions were enabled
+    _fake_nv_store(NX_NV_BLOCK_KEYCODE_MAS, 0x10);
+    _fake_nv_store(NX_NV_BLOCK_KEYCODE_PRO, 0x20);
+    _reset();
+}
+
+// Teardown (called after any 'test_*' function is called, automatically)
+void tearDown(void)
+{
+}
+
+void test_nv_transaction__no_commit_blocks__copy_a_is_current(void)
+{
+    TEST_ASSERT_EQUAL_UINT8(0x10, _read_value(NX_NV_BLOCK_KEYCODE_MAS));
+    TEST_ASSERT_EQUAL_UINT8(0x20, _read_value(NX_NV_BLOCK_KEYCODE_PRO));
+
+    // updates outside of a transaction are written in place
+    TEST_ASSERT_TRUE(_update_value(NX_NV_BLOCK_KEYCODE_MAS, 0x11));
+    TEST_ASSERT_EQUAL_UINT(1, _fake_nv_writes);
+    TEST_ASSERT_EQUAL_UINT(0, _fake_nv_written_ids[0]);
+    TEST_ASSERT_EQUAL_UINT8(0x11, _read_value(NX_NV_BLOCK_KEYCODE_MAS));
+}
+
+void test_nv_transaction__two_blocks_updated__written_then_committed(void)
+{
+    nexus_nv_transaction_begin();
+    TEST_ASSERT_TRUE(_update_value(NX_NV_BLOCK_KEYCODE_MAS, 0x11));
+    TEST_ASSERT_TRUE(_update_value(NX_NV_BLOCK_KEYCODE_PRO, 0x21));
+
+    // staged data is read back before the commit, without any NV writes
+    TEST_ASSERT_EQUAL_UINT8(0x11, _read_value(NX_NV_BLOCK_KEYCODE_MAS));
+    TEST_ASSERT_EQUAL_UINT8(0x21, _read_value(NX_NV_BLOCK_KEYCODE_PRO));
+    TEST_ASSERT_EQUAL_UINT(0, _fake_nv_writes);
+
+    TEST_ASSERT_TRUE(nexus_nv_transaction_commit());
+    TEST_ASSERT_EQUAL_UINT(3, _fake_nv_writes);
+    TEST_ASSERT_EQUAL_UINT(BLOCK_0_COPY_B_ID, _fake_nv_written_ids[0]);
+    TEST_ASSERT_EQUAL_UINT(BLOCK_1_COPY_B_ID, _fake_nv_written_ids[1]);
+    TEST_ASSERT_EQUAL_UINT(COMMIT_BLOCK_B_ID, _fake_nv_written_ids[2]);
+
+    _reset();
+    TEST_ASSERT_EQUAL_UINT8(0x11, _read_value(NX_NV_BLOCK_KEYCODE_MAS));
+    TEST_ASSERT_EQUAL_UINT8(0x21, _read_value(NX_NV_BLOCK_KEYCODE_PRO));
+
+    // later updates outside of a transaction are written to copy B in place
+    TEST_ASSERT_TRUE(_update_value(NX_NV_BLOCK_KEYCODE_MAS, 0x12));
+    TEST_ASSERT_EQUAL_UINT(1, _fake_nv_writes);
+    TEST_ASSERT_EQUAL_UINT(BLOCK_0_COPY_B_ID, _fake_nv_written_ids[0]);
+    _reset();
+    TEST_ASSERT_EQUAL_UINT8(0x12, _read_value(NX_NV_BLOCK_KEYCODE_MAS));
+}
+
+void test_nv_transaction__repeated_updates__each_block_written_once(void)
+{
+    nexus_nv_transaction_begin();
+    for (uint8_t i = 0; i < 10; i++)
+    {
+        TEST_ASSERT_TRUE(_update_value(NX_NV_BLOCK_KEYCODE_MAS, i));
+        TEST_ASSERT_TRUE(_update_value(NX_NV_BLOCK_KEYCODE_PRO, i));
+    }
+    TEST_ASSERT_TRUE(nexus_nv_transaction_commit());
+    TEST_ASSERT_EQUAL_UINT(3, _fake_nv_writes);
+
+    _reset();
+    TEST_ASSERT_EQUAL_UINT8(9, _read_value(NX_NV_BLOCK_KEYCODE_MAS));
+    TEST_ASSERT_EQUAL_UINT8(9, _read_value(NX_NV_BLOCK_KEYCODE_PRO));
+}
+
+void test_nv_transaction__unchanged_blocks__not_written(void)
+{
+    nexus_nv_transaction_begin();
+    TEST_ASSERT_TRUE(_update_value(NX_NV_BLOCK_KEYCODE_MAS, 0x10));
+    TEST_ASSERT_TRUE(_update_value(NX_NV_BLOCK_KEYCODE_PRO, 0x20));
+    TEST_ASSERT_TRUE(nexus_nv_transaction_commit());
+    TEST_ASSERT_EQUAL_UINT(0, _fake_nv_writes);
+
+    // only one block changed, which is written in place without a commit
+    nexus_nv_transaction_begin();
+    TEST_ASSERT_TRUE(_update_value(NX_NV_BLOCK_KEYCODE_MAS, 0x10));
+    TEST_ASSERT_TRUE(_update_value(NX_NV_BLOCK_KEYCODE_PRO, 0x22));
+    TEST_ASSERT_TRUE(nexus_nv_transaction_commit());
+    TEST_ASSERT_EQUAL_UINT(1, _fake_nv_writes);
+    TEST_ASSERT_EQUAL_UINT(1, _fake_nv_written_ids[0]);
+
+    _reset();
+    TEST_ASSERT_EQUAL_UINT8(0x10, _read_value(NX_NV_BLOCK_KEYCODE_MAS));
+    TEST_ASSERT_EQUAL_UINT8(0x22, _read_value(NX_NV_BLOCK_KEYCODE_PRO));
+}
+
+void test_nv_transaction__nested__written_by_outermost_commit(void)
+{
+    nexus_nv_transaction_begin();
+    TEST_ASSERT_TRUE(_update_value(NX_NV_BLOCK_KEYCODE_MAS, 0x11));
+
+    nexus_nv_transaction_begin();
+    TEST_ASSERT_TRUE(_update_value(NX_NV_BLOCK_KEYCODE_PRO, 0x21));
+    TEST_ASSERT_TRUE(nexus_nv_transaction_commit());
+    TEST_ASSERT_EQUAL_UINT(0, _fake_nv_writes);
+
+    TEST_ASSERT_TRUE(nexus_nv_transaction_commit());
+    TEST_ASSERT_EQUAL_UINT(3, _fake_nv_writes);
+}
+
+void test_nv_transaction__power_lost_during_commit__no_blocks_updated(void)
+{
+    // Power is lost during each of the 3 writes of the commit in turn
+    for (int32_t writes = 0; writes < 3; writes++)
+    {
+        setUp();
+        _fake_nv_writes_until_power_loss = writes;
+
+        nexus_nv_transaction_begin();
+        TEST_ASSERT_TRUE(_update_value(NX_NV_BLOCK_KEYCODE_MAS, 0x11));
+        TEST_ASSERT_TRUE(_update_value(NX_NV_BLOCK_KEYCODE_PRO, 0x21));
+        TEST_ASSERT_FALSE(nexus_nv_transaction_commit());
+
+        _reset();
+        TEST_ASSERT_EQUAL_UINT8(0x10, _read_value(NX_NV_BLOCK_KEYCODE_MAS));
+        TEST_ASSERT_EQUAL_UINT8(0x20, _read_value(NX_NV_BLOCK_KEYCODE_PRO));
+
+        // the same transaction succeeds once power is restored
+        nexus_nv_transaction_begin();
+        TEST_ASSERT_TRUE(_update_value(NX_NV_BLOCK_KEYCODE_MAS, 0x11));
+        TEST_ASSERT_TRUE(_update_value(NX_NV_BLOCK_KEYCODE_PRO, 0x21));
+        TEST_ASSERT_TRUE(nexus_nv_transaction_commit());
+
+        _reset();
+        TEST_ASSERT_EQUAL_UINT8(0x11, _read_value(NX_NV_BLOCK_KEYCODE_MAS));
+        TEST_ASSERT_EQUAL_UINT8(0x21, _read_value(NX_NV_BLOCK_KEYCODE_PRO));
+    }
+}
+
+void test_nv_transaction__commits_alternate__previous_commit_kept(void)
+{
+    nexus_nv_transaction_begin();
+    TEST_ASSERT_TRUE(_update_value(NX_NV_BLOCK_KEYCODE_MAS, 0x11));
+    TEST_ASSERT_TRUE(_update_value(NX_NV_BLOCK_KEYCODE_PRO, 0x21));
+    TEST_ASSERT_TRUE(nexus_nv_transaction_commit());
+
+    // second commit writes copy A of each block, and the other commit block
+    _fake_nv_writes = 0;
+    nexus_nv_transaction_begin();
+    TEST_ASSERT_TRUE(_update_value(NX_NV_BLOCK_KEYCODE_MAS, 0x12));
+    TEST_ASSERT_TRUE(_update_value(NX_NV_BLOCK_KEYCODE_PRO, 0x22));
+    TEST_ASSERT_TRUE(nexus_nv_transaction_commit());
+    TEST_ASSERT_EQUAL_UINT(3, _fake_nv_writes);
+    TEST_ASSERT_EQUAL_UINT(0, _fake_nv_written_ids[0]);
+    TEST_ASSERT_EQUAL_UINT(1, _fake_nv_written_ids[1]);
+    TEST_ASSERT_EQUAL_UINT(COMMIT_BLOCK_A_ID, _fake_nv_written_ids[2]);
+
+    _reset();
+    TEST_ASSERT_EQUAL_UINT8(0x12, _read_value(NX_NV_BLOCK_KEYCODE_MAS));
+    TEST_ASSERT_EQUAL_UINT8(0x22, _read_value(NX_NV_BLOCK_KEYCODE_PRO));
+
+    // if the latest commit block is lost, the previous commit is current
+    memset(_fake_nv[COMMIT_BLOCK_A_ID], 0xA5, NX_COMMON_NV_BLOCK_21_LENGTH);
+    _reset();
+    TEST_ASSERT_EQUAL_UINT8(0x11, _read_value(NX_NV_BLOCK_KEYCODE_MAS));
+    TEST_ASSERT_EQUAL_UINT8(0x21, _read_value(NX_NV_BLOCK_KEYCODE_PRO));
+}
@@ -0,0 +1,154 @@
+#include "include/nx_common.h"
+#include "src/nexus_nv.h"
+#include "unity.h"
+#include "utils/crc_ccitt.h"
+
+// Other support libraries
+#include <mock_nxp_common.h>
+#include <string.h>
+
+/********************************************************
+ * DEFINITIONS
+ *******************************************************/
+
+#define BLOCK_1_INNER_LENGTH                                                   \
+    (NX_COMMON_NV_BLOCK_1_LENGTH - NEXUS_NV_BLOCK_WRAPPER_SIZE_BYTES)
+
+#define FAKE_NV_BLOCK_COUNT 2
+
+/********************************************************
+ * PRIVATE TYPES
+ *******************************************************/
+
+/********************************************************
+ * PRIVATE DATA
+ *******************************************************/
+
+// Fake product NV, holding full blocks by block ID
+static uint8_t _fake_nv[FAKE_NV_BLOCK_COUNT][NX_COMMON_NV_MAX_BLOCK_LENGTH];
+static uint32_t _fake_nv_writes;
+static bool _fake_nv_write_fails;
+// segments passed to the latest write
+static struct nx_common_nv_write_segment _fake_nv_segments[3];
+static uint8_t _fake_nv_segment_count;
+
+/********************************************************
+ * PRIVATE FUNCTIONS
+ *******************************************************/
+
+bool CALLBACK_nxp_common_nv_read(
+    const struct nx_common_nv_block_meta block_meta,
+    void* read_buffer,
+    int NumCalls)
+{
+    (void) NumCalls;
+    TEST_ASSERT_TRUE(block_meta.block_id < FAKE_NV_BLOCK_COUNT);
+    memcpy(read_buffer, _fake_nv[block_meta.block_id], block_meta.length);
+    return true;
+}
+
+bool CALLBACK_nxp_common_nv_write_v(
+    const struct nx_common_nv_block_meta block_meta,
+    const struct nx_common_nv_write_segment* segments,
+    uint8_t segment_count,
+    int NumCalls)
+{
+    (void) NumCalls;
+    TEST_ASSERT_TRUE(block_meta.block_id < FAKE_NV_BLOCK_COUNT);
+    TEST_ASSERT_TRUE(segment_count <= 3);
+    memcpy(_fake_nv_segments,
+           segments,
+           segment_count * sizeof(struct nx_common_nv_write_segment));
+    _fake_nv_segment_count = segment_count;
+    _fake_nv_writes++;
+    if (_fake_nv_write_fails)
+    {
+        return false;
+    }
+
+    // gather the segments, which must form a valid block
+    uint8_t block[NX_COMMON_NV_MAX_BLOCK_LENGTH];
+    uint8_t length = 0;
+    for (uint8_t i = 0; i < segment_count; i++)
+    {
+        TEST_ASSERT_TRUE(length + segments[i].length <= block_meta.length);
+        memcpy(block + length, segments[i].data, segments[i].length);
+        length = (uint8_t)(length + segments[i].length);
+    }
+    TEST_ASSERT_EQUAL_UINT8(block_meta.length, length);
+    TEST_ASSERT_TRUE(nx_common_nv_block_valid(block_meta, block));
+
+    memcpy(_fake_nv[block_meta.block_id], block, block_meta.length);
+    return true;
+}
+
+// Setup (called before any 'test_*' function is called, automatically)
+void setUp(void)
+{
+    memset(_fake_nv, 0x00, sizeof(_fake_nv));
+    memset(_fake_nv_segments, 0x00, sizeof(_fake_nv_segments));
+    _fake_nv_segment_count = 0;
+    _fake_nv_writes = 0;
+    _fake_nv_write_fails = false;
+
+    nxp_common_nv_read_StubWithCallback(CALLBACK_nxp_common_nv_read);
+    nxp_common_nv_write_v_StubWithCallback(CALLBACK_nxp_common_nv_write_v);
+}
+
+// Teardown (called after any 'test_*' function is called, automatically)
+void tearDown(void)
+{
+}
+
+void test_nv_write_v__update__block_written_in_segments(void)
+{
+    uint8_t inner_data[BLOCK_1_INNER_LENGTH];
+    memset(inner_data, 0x5A, sizeof(inner_data));
+    TEST_ASSERT_TRUE(nexus_nv_update(NX_NV_BLOCK_KEYCODE_PRO, inner_data));
+    TEST_ASSERT_EQUAL_UINT(1, _fake_nv_writes);
+
+    // block ID, then the inner data (not copied), then the CRC
+    TEST_ASSERT_EQUAL_UINT8(3, _fake_nv_segment_count);
+    TEST_ASSERT_EQUAL_UINT8(NEXUS_NV_BLOCK_ID_WIDTH,
+                            _fake_nv_segments[0].length);
+    TEST_ASSERT_EQUAL_PTR(inner_data, _fake_nv_segments[1].data);
+    TEST_ASSERT_EQUAL_UINT8(BLOCK_1_INNER_LENGTH, _fake_nv_segments[1].length);
+    TEST_ASSERT_EQUAL_UINT8(NEXUS_NV_BLOCK_CRC_WIDTH,
+                            _fake_nv_segments[2].length);
+
+    // CRC is identical to that computed over the complete block
+    const uint16_t expected_crc = compute_crc_ccitt(
+        _fake_nv[1], NX_COMMON_NV_BLOCK_1_LENGTH - NEXUS_NV_BLOCK_CRC_WIDTH);
+    TEST_ASSERT_EQUAL_MEMORY(
+        &expected_crc,
+        _fake_nv[1] + NEXUS_NV_BLOCK_ID_WIDTH + BLOCK_1_INNER_LENGTH,
+        NEXUS_NV_BLOCK_CRC_WIDTH);
+
+    uint8_t read_data[BLOCK_1_INNER_LENGTH];
+    TEST_ASSERT_TRUE(nexus_nv_read(NX_NV_BLOCK_KEYCODE_PRO, read_data));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(inner_data, read_data, BLOCK_1_INNER_LENGTH);
+}
+
+void test_nv_write_v__identical_update__not_written(void)
+{
+    uint8_t inner_data[BLOCK_1_INNER_LENGTH];
+    memset(inner_data, 0x33, sizeof(inner_data));
+    TEST_ASSERT_TRUE(nexus_nv_update(NX_NV_BLOCK_KEYCODE_PRO, inner_data));
+    TEST_ASSERT_TRUE(nexus_nv_update(NX_NV_BLOCK_KEYCODE_PRO, inner_data));
+    TEST_ASSERT_EQUAL_UINT(1, _fake_nv_writes);
+
+    inner_data[0] = 0x34;
+    TEST_ASSERT_TRUE(nexus_nv_update(NX_NV_BLOCK_KEYCODE_PRO, inner_data));
+    TEST_ASSERT_EQUAL_UINT(2, _fake_nv_writes);
+}
+
+void test_nv_write_v__write_fails__update_fails(void)
+{
+    uint8_t inner_data[BLOCK_1_INNER_LENGTH];
+    memset(inner_data, 0x77, sizeof(inner_data));
+    _fake_nv_write_fails = true;
+    TEST_ASSERT_FALSE(nexus_nv_update(NX_NV_BLOCK_KEYCODE_PRO, inner_data));
+
+    uint8_t read_data[BLOCK_1_INNER_LENGTH];
+    TEST_ASSERT_FALSE(nexus_nv_read(NX_NV_BLOCK_KEYCODE_PRO, read_data));
+}
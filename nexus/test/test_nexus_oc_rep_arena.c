@@ -0,0 +1,109 @@
+#include "oc/include/oc_helpers.h"
+#include "oc/include/oc_rep.h"
+#include "oc/util/oc_memb.h"
+#include "oc/util/oc_mmem.h"
+#include "utils/oc_list.h"
+#include "unity.h"
+
+#include <stdint.h>
+#include <string.h>
+
+// pull in source file from IoTivity without changing its name
+// https://github.com/ThrowTheSwitch/Ceedling/issues/113
+TEST_FILE("oc/deps/tinycbor/cborencoder.c")
+TEST_FILE("oc/deps/tinycbor/cborparser.c")
+
+/********************************************************
+ * PRIVATE DATA
+ *******************************************************/
+// {"a": 5, "bb": "hi", "c": [1, 2, 3]}
+static const uint8_t PAYLOAD[] = {0xA3, 0x61, 0x61, 0x05, 0x62, 0x62,
+                                  0x62, 0x62, 0x68, 0x69, 0x61, 0x63,
+                                  0x83, 0x01, 0x02, 0x03};
+
+/********************************************************
+ * PRIVATE FUNCTIONS
+ *******************************************************/
+
+// Setup (called before any 'test_*' function is called, automatically)
+void setUp(void)
+{
+    oc_rep_arena_reset();
+}
+
+// Teardown (called after any 'test_*' function is called, automatically)
+void tearDown(void)
+{
+}
+
+void test_oc_rep_arena__parse_payload__values_parsed(void)
+{
+    oc_rep_t* rep = NULL;
+    const int result = oc_parse_rep(PAYLOAD, sizeof(PAYLOAD), &rep);
+    TEST_ASSERT_EQUAL_INT(CborNoError, result);
+
+    TEST_ASSERT_NOT_NULL(rep);
+    TEST_ASSERT_EQUAL_STRING("a", oc_string(rep->name));
+    TEST_ASSERT_EQUAL_INT(OC_REP_INT, rep->type);
+    TEST_ASSERT_EQUAL_INT(5, rep->value.integer);
+
+    rep = rep->next;
+    TEST_ASSERT_NOT_NULL(rep);
+    TEST_ASSERT_EQUAL_STRING("bb", oc_string(rep->name));
+    TEST_ASSERT_EQUAL_INT(OC_REP_STRING, rep->type);
+    TEST_ASSERT_EQUAL_STRING("hi", oc_string(rep->value.string));
+
+    rep = rep->next;
+    TEST_ASSERT_NOT_NULL(rep);
+    TEST_ASSERT_EQUAL_STRING("c", oc_string(rep->name));
+    TEST_ASSERT_EQUAL_INT(OC_REP_INT_ARRAY, rep->type);
+    TEST_ASSERT_EQUAL_UINT(3, oc_int_array_size(rep->value.array));
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        TEST_ASSERT_EQUAL_INT(i + 1, oc_int_array(rep->value.array)[i]);
+    }
+    TEST_ASSERT_NULL(rep->next);
+}
+
+void test_oc_rep_arena__reset__memory_reused(void)
+{
+    oc_rep_t* first = NULL;
+    TEST_ASSERT_EQUAL_INT(CborNoError,
+                          oc_parse_rep(PAYLOAD, sizeof(PAYLOAD), &first));
+    const size_t high_water = oc_rep_arena_high_water();
+    TEST_ASSERT_TRUE(high_water > 0);
+    // does not free individual reps
+    oc_free_rep(first);
+
+    oc_rep_arena_reset();
+    oc_rep_t* second = NULL;
+    TEST_ASSERT_EQUAL_INT(CborNoError,
+                          oc_parse_rep(PAYLOAD, sizeof(PAYLOAD), &second));
+    TEST_ASSERT_EQUAL_PTR(first, second);
+    TEST_ASSERT_EQUAL_UINT(high_water, oc_rep_arena_high_water());
+}
+
+void test_oc_rep_arena__payload_larger_than_arena__out_of_memory(void)
+{
+    // map of 40 single character keys, each with an integer value
+    uint8_t payload[2 + 40 * 3];
+    payload[0] = 0xB8; // map, count in following byte
+    payload[1] = 40;
+    for (uint8_t i = 0; i < 40; i++)
+    {
+        payload[2 + i * 3] = 0x61;
+        payload[3 + i * 3] = (uint8_t)('A' + i);
+        payload[4 + i * 3] = 0x00;
+    }
+
+    oc_rep_t* rep = NULL;
+    const int result = oc_parse_rep(payload, sizeof(payload), &rep);
+    TEST_ASSERT_EQUAL_INT(CborErrorOutOfMemory, result);
+    TEST_ASSERT_TRUE(oc_rep_arena_high_water() <=
+                     NEXUS_CHANNEL_OC_REP_ARENA_SIZE);
+
+    // arena is usable again after reset
+    oc_rep_arena_reset();
+    TEST_ASSERT_EQUAL_INT(CborNoError,
+                          oc_parse_rep(PAYLOAD, sizeof(PAYLOAD), &rep));
+}
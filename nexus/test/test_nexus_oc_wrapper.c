@@ -268,6 +268,82 @@ void test_nexus_oc_wrapper__nx_channel_network_receive__valid_message__no_error(
     nexus_channel_core_process(1);
 }
 
+void test_nexus_oc_wrapper__nx_channel_network_receive_batch__invalid_frames__rejected(
+    void)
+{
+    uint8_t dummy_data[10];
+    memset(&dummy_data, 0xAB, sizeof(dummy_data));
+    const struct nx_channel_network_frame frames[2] = {
+        {dummy_data, 0, {0, 12345678}},
+        {dummy_data, NEXUS_CHANNEL_MAX_COAP_TOTAL_MESSAGE_SIZE + 1, {0, 1}},
+    };
+    uint32_t accepted_count = 0xFFFFFFFF;
+    uint32_t free_count = 0xFFFFFFFF;
+
+    nx_channel_error result = nx_channel_network_receive_batch(
+        NULL, 1, &accepted_count, &free_count);
+    TEST_ASSERT_EQUAL_UINT(NX_CHANNEL_ERROR_UNSPECIFIED, result);
+    TEST_ASSERT_EQUAL_UINT(0, accepted_count);
+    TEST_ASSERT_EQUAL_UINT(oc_buffer_incoming_free_count(), free_count);
+
+    // stops at the first frame, which is empty
+    result = nx_channel_network_receive_batch(
+        frames, 2, &accepted_count, &free_count);
+    TEST_ASSERT_EQUAL_UINT(NX_CHANNEL_ERROR_UNSPECIFIED, result);
+    TEST_ASSERT_EQUAL_UINT(0, accepted_count);
+
+    result = nx_channel_network_receive_batch(
+        &frames[1], 1, &accepted_count, &free_count);
+    TEST_ASSERT_EQUAL_UINT(NX_CHANNEL_ERROR_MESSAGE_TOO_LARGE, result);
+    TEST_ASSERT_EQUAL_UINT(0, accepted_count);
+
+    // no frames is not an error
+    result = nx_channel_network_receive_batch(
+        frames, 0, &accepted_count, &free_count);
+    TEST_ASSERT_EQUAL_UINT(NX_CHANNEL_ERROR_NONE, result);
+    TEST_ASSERT_EQUAL_UINT(0, accepted_count);
+}
+
+void test_nexus_oc_wrapper__nx_channel_network_receive_batch__more_frames_than_buffers__accepts_until_full(
+    void)
+{
+    uint8_t dummy_data[10];
+    memset(&dummy_data, 0xAB, sizeof(dummy_data));
+    struct nx_id fake_id = {0, 12345678};
+    const struct nx_channel_network_frame frames[3] = {
+        {dummy_data, sizeof(dummy_data), {0, 12345678}},
+        {dummy_data, sizeof(dummy_data), {0, 12345679}},
+        {dummy_data, sizeof(dummy_data), {0, 12345680}},
+    };
+
+    nxp_common_nv_read_IgnoreAndReturn(true);
+    nxp_common_nv_write_IgnoreAndReturn(true);
+    nxp_channel_random_value_IgnoreAndReturn(123456);
+    nexus_channel_core_init();
+
+    nxp_common_request_processing_Expect();
+    nexus_channel_core_process(0);
+
+    const uint32_t initial_free_count =
+        (uint32_t) oc_buffer_incoming_free_count();
+    TEST_ASSERT_LESS_THAN_UINT(3, initial_free_count);
+
+    uint32_t accepted_count;
+    uint32_t free_count;
+    nxp_common_request_processing_Expect(); // due to messages being rcvd
+    const nx_channel_error result = nx_channel_network_receive_batch(
+        frames, 3, &accepted_count, &free_count);
+    TEST_ASSERT_EQUAL_UINT(NX_CHANNEL_ERROR_UNSPECIFIED, result);
+    TEST_ASSERT_EQUAL_UINT(initial_free_count, accepted_count);
+    TEST_ASSERT_EQUAL_UINT(0, free_count);
+
+    // clear buffers for next tests. We'll expect to send back an error
+    // message, but aren't testing contents here
+    nxp_channel_get_nexus_id_ExpectAndReturn(fake_id);
+    nxp_channel_network_send_ExpectAnyArgsAndReturn(NX_CHANNEL_ERROR_NONE);
+    nexus_channel_core_process(1);
+}
+
 void test_nexus_oc_wrapper__oc_send_buffer__expected_calls_to_nxp_channel_network_send(
     void)
 {
@@ -0,0 +1,189 @@
+#include "include/nx_channel.h"
+#include "include/nxp_common.h"
+
+#include "messaging/coap/coap.h"
+#include "messaging/coap/engine.h"
+#include "messaging/coap/transactions.h"
+#include "oc/api/oc_main.h"
+#include "oc/include/oc_api.h"
+#include "oc/include/oc_buffer.h"
+#include "oc/include/oc_core_res.h"
+#include "oc/include/oc_endpoint.h"
+#include "oc/include/oc_helpers.h"
+#include "oc/include/oc_network_events.h"
+#include "oc/include/oc_rep.h"
+#include "oc/include/oc_ri.h"
+#include "oc/port/oc_connectivity.h"
+#include "oc/util/oc_etimer.h"
+#include "oc/util/oc_memb.h"
+#include "oc/util/oc_mmem.h"
+#include "oc/util/oc_process.h"
+#include "oc/util/oc_timer.h"
+#include "utils/oc_list.h"
+#include "utils/oc_uuid.h"
+
+#include "src/internal_channel_config.h"
+#include "src/nexus_channel_core.h"
+#include "src/nexus_channel_om.h"
+#include "src/nexus_channel_res_link_hs.h"
+#include "src/nexus_channel_res_lm.h"
+#include "src/nexus_channel_sm.h"
+#include "src/nexus_common_internal.h"
+#include "src/nexus_cose_mac0_common.h"
+#include "src/nexus_cose_mac0_sign.h"
+#include "src/nexus_cose_mac0_verify.h"
+#include "src/nexus_keycode_core.h"
+#include "src/nexus_keycode_mas.h"
+#include "src/nexus_keycode_pro.h"
+#include "src/nexus_keycode_pro_extended.h"
+#include "src/nexus_nv.h"
+#include "src/nexus_oc_wrapper.h"
+#include "src/nexus_security.h"
+#include "src/nexus_util.h"
+#include "utils/crc_ccitt.h"
+#include "utils/siphash_24.h"
+
+#include "unity.h"
+
+// Other support libraries
+#include <mock_nexus_channel_res_payg_credit.h>
+#include <mock_nxp_channel.h>
+#include <mock_nxp_common.h>
+#include <mock_nxp_keycode.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+// pull in source file from IoTivity without changing its name
+// https://github.com/ThrowTheSwitch/Ceedling/issues/113
+TEST_FILE("oc/api/oc_server_api.c")
+TEST_FILE("oc/api/oc_client_api.c")
+TEST_FILE("oc/deps/tinycbor/cborencoder.c")
+TEST_FILE("oc/deps/tinycbor/cborparser.c")
+
+/********************************************************
+ * PRIVATE DATA
+ *******************************************************/
+static uint8_t _dummy_data[10];
+static struct nx_channel_network_frame
+    _frames[NEXUS_CHANNEL_INGRESS_RING_MESSAGE_COUNT + 1];
+static uint32_t _sent_count;
+
+/********************************************************
+ * PRIVATE FUNCTIONS
+ *******************************************************/
+nx_channel_error
+CALLBACK_nxp_channel_network_send(const void* const bytes_to_send,
+                                  uint32_t bytes_count,
+                                  const struct nx_id* const source,
+                                  const struct nx_id* const dest,
+                                  bool is_multicast,
+                                  int NumCalls)
+{
+    (void) bytes_to_send;
+    (void) bytes_count;
+    (void) source;
+    (void) dest;
+    (void) is_multicast;
+    (void) NumCalls;
+    _sent_count++;
+    return NX_CHANNEL_ERROR_NONE;
+}
+
+// Setup (called before any 'test_*' function is called, automatically)
+void setUp(void)
+{
+    nexus_channel_res_payg_credit_process_IgnoreAndReturn(UINT32_MAX);
+    nxp_channel_notify_event_Ignore();
+    nxp_common_nv_read_IgnoreAndReturn(true);
+    nxp_common_nv_write_IgnoreAndReturn(true);
+    nxp_channel_random_value_IgnoreAndReturn(123456);
+    nxp_common_request_processing_Ignore();
+    nexus_channel_core_init();
+    nexus_channel_core_process(0);
+
+    // Not valid CoAP, each message is answered with an error response
+    memset(_dummy_data, 0xAB, sizeof(_dummy_data));
+    for (uint8_t i = 0; i < NEXUS_CHANNEL_INGRESS_RING_MESSAGE_COUNT + 1; i++)
+    {
+        _frames[i].bytes_received = _dummy_data;
+        _frames[i].bytes_count = sizeof(_dummy_data);
+        _frames[i].source.authority_id = 0;
+        _frames[i].source.device_id = 12345678 + i;
+    }
+
+    const struct nx_id fake_id = {0, 12345678};
+    nxp_channel_get_nexus_id_IgnoreAndReturn(fake_id);
+    _sent_count = 0;
+    nxp_channel_network_send_StubWithCallback(
+        CALLBACK_nxp_channel_network_send);
+}
+
+// Teardown (called after any 'test_*' function is called, automatically)
+void tearDown(void)
+{
+    nexus_channel_core_shutdown();
+}
+
+void test_ingress_ring__burst_larger_than_oc_buffers__all_messages_processed(
+    void)
+{
+    TEST_ASSERT_LESS_THAN_INT(NEXUS_CHANNEL_INGRESS_RING_MESSAGE_COUNT,
+                              oc_buffer_incoming_free_count());
+
+    uint32_t accepted_count;
+    uint32_t free_count;
+    nx_channel_error result = nx_channel_network_receive_batch(
+        _frames,
+        NEXUS_CHANNEL_INGRESS_RING_MESSAGE_COUNT,
+        &accepted_count,
+        &free_count);
+    TEST_ASSERT_EQUAL_UINT(NX_CHANNEL_ERROR_NONE, result);
+    TEST_ASSERT_EQUAL_UINT(NEXUS_CHANNEL_INGRESS_RING_MESSAGE_COUNT,
+                           accepted_count);
+    TEST_ASSERT_EQUAL_UINT(0, free_count);
+    TEST_ASSERT_EQUAL_UINT(NEXUS_CHANNEL_INGRESS_RING_MESSAGE_COUNT,
+                           nexus_oc_wrapper_ingress_ring_count());
+
+    // ring is full
+    result = nx_channel_network_receive(
+        _dummy_data,
+        sizeof(_dummy_data),
+        &_frames[NEXUS_CHANNEL_INGRESS_RING_MESSAGE_COUNT].source);
+    TEST_ASSERT_EQUAL_UINT(NX_CHANNEL_ERROR_UNSPECIFIED, result);
+
+    nexus_channel_core_process(1);
+    TEST_ASSERT_EQUAL_UINT(0, nexus_oc_wrapper_ingress_ring_count());
+    TEST_ASSERT_EQUAL_UINT(NEXUS_CHANNEL_INGRESS_RING_MESSAGE_COUNT,
+                           _sent_count);
+}
+
+void test_ingress_ring__invalid_frame__stops_batch(void)
+{
+    _frames[1].bytes_count = NEXUS_CHANNEL_MAX_COAP_TOTAL_MESSAGE_SIZE + 1;
+
+    uint32_t accepted_count;
+    uint32_t free_count;
+    const nx_channel_error result = nx_channel_network_receive_batch(
+        _frames, 3, &accepted_count, &free_count);
+    TEST_ASSERT_EQUAL_UINT(NX_CHANNEL_ERROR_MESSAGE_TOO_LARGE, result);
+    TEST_ASSERT_EQUAL_UINT(1, accepted_count);
+    TEST_ASSERT_EQUAL_UINT(NEXUS_CHANNEL_INGRESS_RING_MESSAGE_COUNT - 1,
+                           free_count);
+
+    nexus_channel_core_process(1);
+    TEST_ASSERT_EQUAL_UINT(1, _sent_count);
+}
+
+void test_ingress_ring__single_receive__queued_until_processed(void)
+{
+    const nx_channel_error result = nx_channel_network_receive(
+        _dummy_data, sizeof(_dummy_data), &_frames[0].source);
+    TEST_ASSERT_EQUAL_UINT(NX_CHANNEL_ERROR_NONE, result);
+    TEST_ASSERT_EQUAL_UINT(1, nexus_oc_wrapper_ingress_ring_count());
+    TEST_ASSERT_EQUAL_UINT(0, _sent_count);
+
+    nexus_channel_core_process(1);
+    TEST_ASSERT_EQUAL_UINT(0, nexus_oc_wrapper_ingress_ring_count());
+    TEST_ASSERT_EQUAL_UINT(1, _sent_count);
+}
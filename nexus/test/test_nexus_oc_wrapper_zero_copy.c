@@ -0,0 +1,193 @@
+#include "include/nx_channel.h"
+#include "include/nxp_common.h"
+
+#include "messaging/coap/coap.h"
+#include "messaging/coap/engine.h"
+#include "messaging/coap/transactions.h"
+#include "oc/api/oc_main.h"
+#include "oc/include/oc_api.h"
+#include "oc/include/oc_buffer.h"
+#include "oc/include/oc_core_res.h"
+#include "oc/include/oc_endpoint.h"
+#include "oc/include/oc_helpers.h"
+#include "oc/include/oc_network_events.h"
+#include "oc/include/oc_rep.h"
+#include "oc/include/oc_ri.h"
+#include "oc/port/oc_connectivity.h"
+#include "oc/util/oc_etimer.h"
+#include "oc/util/oc_memb.h"
+#include "oc/util/oc_mmem.h"
+#include "oc/util/oc_process.h"
+#include "oc/util/oc_timer.h"
+#include "utils/oc_list.h"
+#include "utils/oc_uuid.h"
+
+#include "src/internal_channel_config.h"
+#include "src/nexus_channel_core.h"
+#include "src/nexus_channel_om.h"
+#include "src/nexus_channel_res_link_hs.h"
+#include "src/nexus_channel_res_lm.h"
+#include "src/nexus_channel_sm.h"
+#include "src/nexus_common_internal.h"
+#include "src/nexus_cose_mac0_common.h"
+#include "src/nexus_cose_mac0_sign.h"
+#include "src/nexus_cose_mac0_verify.h"
+#include "src/nexus_keycode_core.h"
+#include "src/nexus_keycode_mas.h"
+#include "src/nexus_keycode_pro.h"
+#include "src/nexus_keycode_pro_extended.h"
+#include "src/nexus_nv.h"
+#include "src/nexus_oc_wrapper.h"
+#include "src/nexus_security.h"
+#include "src/nexus_util.h"
+#include "utils/crc_ccitt.h"
+#include "utils/siphash_24.h"
+
+#include "unity.h"
+
+// Other support libraries
+#include <mock_nexus_channel_res_payg_credit.h>
+#include <mock_nxp_channel.h>
+#include <mock_nxp_common.h>
+#include <mock_nxp_keycode.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+// pull in source file from IoTivity without changing its name
+// https://github.com/ThrowTheSwitch/Ceedling/issues/113
+TEST_FILE("oc/api/oc_server_api.c")
+TEST_FILE("oc/api/oc_client_api.c")
+TEST_FILE("oc/deps/tinycbor/cborencoder.c")
+TEST_FILE("oc/deps/tinycbor/cborparser.c")
+
+/********************************************************
+ * PRIVATE DATA
+ *******************************************************/
+static uint8_t _lent_data[2][10];
+static const struct nx_id SOURCE_ID = {0, 12345678};
+static uint32_t _sent_count;
+static uint32_t _release_count;
+static void* _last_released;
+
+/********************************************************
+ * PRIVATE FUNCTIONS
+ *******************************************************/
+nx_channel_error
+CALLBACK_nxp_channel_network_send(const void* const bytes_to_send,
+                                  uint32_t bytes_count,
+                                  const struct nx_id* const source,
+                                  const struct nx_id* const dest,
+                                  bool is_multicast,
+                                  int NumCalls)
+{
+    (void) bytes_to_send;
+    (void) bytes_count;
+    (void) source;
+    (void) dest;
+    (void) is_multicast;
+    (void) NumCalls;
+    _sent_count++;
+    return NX_CHANNEL_ERROR_NONE;
+}
+
+static void _release(void* bytes_received)
+{
+    _release_count++;
+    _last_released = bytes_received;
+}
+
+// Setup (called before any 'test_*' function is called, automatically)
+void setUp(void)
+{
+    nexus_channel_res_payg_credit_process_IgnoreAndReturn(UINT32_MAX);
+    nxp_channel_notify_event_Ignore();
+    nxp_common_nv_read_IgnoreAndReturn(true);
+    nxp_common_nv_write_IgnoreAndReturn(true);
+    nxp_channel_random_value_IgnoreAndReturn(123456);
+    nxp_common_request_processing_Ignore();
+    nexus_channel_core_init();
+    nexus_channel_core_process(0);
+
+    // Not valid CoAP, each message is answered with an error response
+    memset(_lent_data, 0xAB, sizeof(_lent_data));
+
+    const struct nx_id fake_id = {0, 12345678};
+    nxp_channel_get_nexus_id_IgnoreAndReturn(fake_id);
+    _sent_count = 0;
+    _release_count = 0;
+    _last_released = NULL;
+    nxp_channel_network_send_StubWithCallback(
+        CALLBACK_nxp_channel_network_send);
+}
+
+// Teardown (called after any 'test_*' function is called, automatically)
+void tearDown(void)
+{
+    nexus_channel_core_shutdown();
+}
+
+void test_zero_copy__receive_lent__released_once_after_processing(void)
+{
+    const nx_channel_error result = nx_channel_network_receive_lent(
+        _lent_data[0], sizeof(_lent_data[0]), &SOURCE_ID, _release);
+    TEST_ASSERT_EQUAL_UINT(NX_CHANNEL_ERROR_NONE, result);
+    TEST_ASSERT_EQUAL_UINT(0, _release_count);
+
+    nexus_channel_core_process(1);
+    TEST_ASSERT_EQUAL_UINT(1, _sent_count);
+    TEST_ASSERT_EQUAL_UINT(1, _release_count);
+    TEST_ASSERT_EQUAL_PTR(_lent_data[0], _last_released);
+
+    nexus_channel_core_process(1);
+    TEST_ASSERT_EQUAL_UINT(1, _release_count);
+}
+
+void test_zero_copy__invalid_receive_lent__not_released(void)
+{
+    nx_channel_error result = nx_channel_network_receive_lent(
+        _lent_data[0], 0, &SOURCE_ID, _release);
+    TEST_ASSERT_EQUAL_UINT(NX_CHANNEL_ERROR_UNSPECIFIED, result);
+
+    result = nx_channel_network_receive_lent(
+        _lent_data[0],
+        NEXUS_CHANNEL_MAX_COAP_TOTAL_MESSAGE_SIZE + 1,
+        &SOURCE_ID,
+        _release);
+    TEST_ASSERT_EQUAL_UINT(NX_CHANNEL_ERROR_MESSAGE_TOO_LARGE, result);
+
+    result = nx_channel_network_receive_lent(
+        _lent_data[0], sizeof(_lent_data[0]), &SOURCE_ID, NULL);
+    TEST_ASSERT_EQUAL_UINT(NX_CHANNEL_ERROR_UNSPECIFIED, result);
+
+    nexus_channel_core_process(1);
+    TEST_ASSERT_EQUAL_UINT(0, _sent_count);
+    TEST_ASSERT_EQUAL_UINT(0, _release_count);
+}
+
+void test_zero_copy__lent_and_copied_receive__both_processed(void)
+{
+    nx_channel_error result = nx_channel_network_receive_lent(
+        _lent_data[0], sizeof(_lent_data[0]), &SOURCE_ID, _release);
+    TEST_ASSERT_EQUAL_UINT(NX_CHANNEL_ERROR_NONE, result);
+    result = nx_channel_network_receive(
+        _lent_data[1], sizeof(_lent_data[1]), &SOURCE_ID);
+    TEST_ASSERT_EQUAL_UINT(NX_CHANNEL_ERROR_NONE, result);
+
+    nexus_channel_core_process(1);
+    TEST_ASSERT_EQUAL_UINT(2, _sent_count);
+    TEST_ASSERT_EQUAL_UINT(1, _release_count);
+    TEST_ASSERT_EQUAL_PTR(_lent_data[0], _last_released);
+}
+
+void test_zero_copy__shutdown_before_processing__released(void)
+{
+    const nx_channel_error result = nx_channel_network_receive_lent(
+        _lent_data[0], sizeof(_lent_data[0]), &SOURCE_ID, _release);
+    TEST_ASSERT_EQUAL_UINT(NX_CHANNEL_ERROR_NONE, result);
+
+    nexus_channel_core_shutdown();
+    TEST_ASSERT_EQUAL_UINT(1, _release_count);
+    TEST_ASSERT_EQUAL_PTR(_lent_data[0], _last_released);
+    nexus_channel_core_init();
+}
@@ -0,0 +1,192 @@
+#include "oc/util/oc_etimer.h"
+#include "oc/util/oc_process.h"
+#include "oc/util/oc_timer.h"
+#include "unity.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/********************************************************
+ * DEFINITIONS
+ *******************************************************/
+#define TEST_TIMER_COUNT 24
+
+/********************************************************
+ * PRIVATE DATA
+ *******************************************************/
+static oc_clock_time_t _now;
+static struct oc_etimer _timers[TEST_TIMER_COUNT];
+static struct oc_etimer* _expired[TEST_TIMER_COUNT];
+static uint8_t _expired_count;
+
+OC_PROCESS(test_receiver_process, "Test timer receiver");
+OC_PROCESS(test_other_process, "Test other timer receiver");
+
+/********************************************************
+ * PRIVATE FUNCTIONS
+ *******************************************************/
+// replaces the platform clock for these tests
+oc_clock_time_t oc_clock_time(void)
+{
+    return _now;
+}
+
+OC_PROCESS_THREAD(test_receiver_process, ev, data)
+{
+    OC_PROCESS_BEGIN();
+    while (1)
+    {
+        OC_PROCESS_YIELD();
+        if (ev == OC_PROCESS_EVENT_TIMER &&
+            _expired_count < TEST_TIMER_COUNT)
+        {
+            _expired[_expired_count++] = (struct oc_etimer*) data;
+        }
+    }
+    OC_PROCESS_END();
+}
+
+OC_PROCESS_THREAD(test_other_process, ev, data)
+{
+    (void) ev;
+    (void) data;
+    OC_PROCESS_BEGIN();
+    while (1)
+    {
+        OC_PROCESS_YIELD();
+    }
+    OC_PROCESS_END();
+}
+
+// Set a timer owned by `process`
+static void _set_timer(struct oc_process* process,
+                       struct oc_etimer* timer,
+                       oc_clock_time_t interval)
+{
+    OC_PROCESS_CONTEXT_BEGIN(process);
+    oc_etimer_set(timer, interval);
+    OC_PROCESS_CONTEXT_END(process);
+}
+
+static void _advance_time(oc_clock_time_t seconds)
+{
+    _now += seconds;
+    (void) oc_etimer_request_poll();
+    while (oc_process_run() > 0)
+    {
+    }
+}
+
+// Setup (called before any 'test_*' function is called, automatically)
+void setUp(void)
+{
+    _now = 1000;
+    memset(_timers, 0x00, sizeof(_timers));
+    memset(_expired, 0x00, sizeof(_expired));
+    _expired_count = 0;
+    oc_process_init();
+    oc_process_start(&oc_etimer_process, NULL);
+    oc_process_start(&test_receiver_process, NULL);
+}
+
+// Teardown (called after any 'test_*' function is called, automatically)
+void tearDown(void)
+{
+}
+
+void test_oc_etimer_heap__many_timers__expire_in_order(void)
+{
+    for (uint8_t i = 0; i < TEST_TIMER_COUNT; i++)
+    {
+        // distinct intervals, not set in order
+        _set_timer(&test_receiver_process,
+                   &_timers[i],
+                   (oc_clock_time_t)(1 + (i * 7) % TEST_TIMER_COUNT));
+    }
+    TEST_ASSERT_TRUE(oc_etimer_pending());
+    TEST_ASSERT_EQUAL_UINT(_now + 1, oc_etimer_next_expiration_time());
+
+    for (uint8_t second = 1; second <= TEST_TIMER_COUNT; second++)
+    {
+        _advance_time(1);
+        TEST_ASSERT_EQUAL_UINT(second, _expired_count);
+        TEST_ASSERT_EQUAL_UINT(_now,
+                               oc_etimer_expiration_time(_expired[second - 1]));
+        TEST_ASSERT_TRUE(oc_etimer_expired(_expired[second - 1]));
+    }
+    TEST_ASSERT_FALSE(oc_etimer_pending());
+    TEST_ASSERT_EQUAL_UINT(0, oc_etimer_next_expiration_time());
+}
+
+void test_oc_etimer_heap__stop_timers__stopped_timers_do_not_expire(void)
+{
+    for (uint8_t i = 0; i < TEST_TIMER_COUNT; i++)
+    {
+        _set_timer(&test_receiver_process,
+                   &_timers[i],
+                   (oc_clock_time_t)(1 + (i * 5) % TEST_TIMER_COUNT));
+    }
+    // stop the earliest timer, and every third timer
+    oc_etimer_stop(&_timers[0]);
+    for (uint8_t i = 3; i < TEST_TIMER_COUNT; i += 3)
+    {
+        oc_etimer_stop(&_timers[i]);
+    }
+    // stopping a stopped timer has no effect
+    oc_etimer_stop(&_timers[0]);
+    TEST_ASSERT_TRUE(oc_etimer_expired(&_timers[0]));
+    TEST_ASSERT_EQUAL_UINT(_now + 2, oc_etimer_next_expiration_time());
+
+    _advance_time(TEST_TIMER_COUNT);
+    TEST_ASSERT_EQUAL_UINT(TEST_TIMER_COUNT - TEST_TIMER_COUNT / 3,
+                           _expired_count);
+    for (uint8_t i = 0; i < _expired_count; i++)
+    {
+        const uint8_t index = (uint8_t)(_expired[i] - _timers);
+        TEST_ASSERT_NOT_EQUAL(0, index % 3);
+    }
+    TEST_ASSERT_FALSE(oc_etimer_pending());
+}
+
+void test_oc_etimer_heap__pending_timer_set_again__repositioned(void)
+{
+    _set_timer(&test_receiver_process, &_timers[0], 10);
+    _set_timer(&test_receiver_process, &_timers[1], 20);
+    TEST_ASSERT_EQUAL_UINT(_now + 10, oc_etimer_next_expiration_time());
+
+    // later than the other pending timer
+    OC_PROCESS_CONTEXT_BEGIN(&test_receiver_process);
+    oc_etimer_reset_with_new_interval(&_timers[0], 30);
+    OC_PROCESS_CONTEXT_END(&test_receiver_process);
+    TEST_ASSERT_EQUAL_UINT(_now + 20, oc_etimer_next_expiration_time());
+
+    // earlier than the other pending timer
+    oc_etimer_adjust(&_timers[0], -25);
+    TEST_ASSERT_EQUAL_UINT(_now + 15, oc_etimer_next_expiration_time());
+
+    _advance_time(15);
+    TEST_ASSERT_EQUAL_UINT(1, _expired_count);
+    TEST_ASSERT_EQUAL_PTR(&_timers[0], _expired[0]);
+    _advance_time(5);
+    TEST_ASSERT_EQUAL_UINT(2, _expired_count);
+    TEST_ASSERT_EQUAL_PTR(&_timers[1], _expired[1]);
+}
+
+void test_oc_etimer_heap__process_exits__timers_of_process_removed(void)
+{
+    oc_process_start(&test_other_process, NULL);
+    for (uint8_t i = 0; i < TEST_TIMER_COUNT; i++)
+    {
+        _set_timer((i % 2 == 0) ? &test_receiver_process : &test_other_process,
+                   &_timers[i],
+                   (oc_clock_time_t)(TEST_TIMER_COUNT - i));
+    }
+    TEST_ASSERT_EQUAL_UINT(_now + 1, oc_etimer_next_expiration_time());
+
+    oc_process_exit(&test_other_process);
+    TEST_ASSERT_EQUAL_UINT(_now + 2, oc_etimer_next_expiration_time());
+
+    _advance_time(TEST_TIMER_COUNT);
+    TEST_ASSERT_EQUAL_UINT(TEST_TIMER_COUNT / 2, _expired_count);
+    TEST_ASSERT_FALSE(oc_etimer_pending());
+}
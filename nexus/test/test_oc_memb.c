@@ -0,0 +1,134 @@
+#include "oc/util/oc_memb.h"
+#include "unity.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/********************************************************
+ * DEFINITIONS
+ *******************************************************/
+#define TEST_MEMB_COUNT 4
+
+struct test_memb_chunk
+{
+    void* link;
+    uint8_t bytes[8];
+};
+
+/********************************************************
+ * PRIVATE DATA
+ *******************************************************/
+OC_MEMB(test_memb, struct test_memb_chunk, TEST_MEMB_COUNT);
+
+/********************************************************
+ * PRIVATE FUNCTIONS
+ *******************************************************/
+
+// Setup (called before any 'test_*' function is called, automatically)
+void setUp(void)
+{
+    oc_memb_init(&test_memb);
+}
+
+// Teardown (called after any 'test_*' function is called, automatically)
+void tearDown(void)
+{
+}
+
+void test_oc_memb__alloc_all__distinct_chunks_then_fails(void)
+{
+    struct test_memb_chunk* chunks[TEST_MEMB_COUNT];
+    for (uint8_t i = 0; i < TEST_MEMB_COUNT; i++)
+    {
+        chunks[i] = (struct test_memb_chunk*) oc_memb_alloc(&test_memb);
+        TEST_ASSERT_NOT_NULL(chunks[i]);
+        for (uint8_t j = 0; j < i; j++)
+        {
+            TEST_ASSERT_NOT_EQUAL(chunks[j], chunks[i]);
+        }
+    }
+    TEST_ASSERT_EQUAL_INT(0, oc_memb_numfree(&test_memb));
+    TEST_ASSERT_NULL(oc_memb_alloc(&test_memb));
+    TEST_ASSERT_NULL(oc_memb_alloc_uninit(&test_memb));
+
+    struct oc_memb_stats stats;
+    oc_memb_get_stats(&test_memb, &stats);
+    TEST_ASSERT_EQUAL_UINT(TEST_MEMB_COUNT, stats.num);
+    TEST_ASSERT_EQUAL_UINT(TEST_MEMB_COUNT, stats.used);
+    TEST_ASSERT_EQUAL_UINT(TEST_MEMB_COUNT, stats.high_water);
+    TEST_ASSERT_EQUAL_UINT(2, stats.alloc_failures);
+}
+
+void test_oc_memb__free_then_alloc__chunk_reused_and_zeroed(void)
+{
+    struct test_memb_chunk* first =
+        (struct test_memb_chunk*) oc_memb_alloc(&test_memb);
+    struct test_memb_chunk* second =
+        (struct test_memb_chunk*) oc_memb_alloc(&test_memb);
+    memset(first, 0xAB, sizeof(struct test_memb_chunk));
+    memset(second, 0xCD, sizeof(struct test_memb_chunk));
+
+    TEST_ASSERT_EQUAL_INT(0, oc_memb_free(&test_memb, first));
+    TEST_ASSERT_EQUAL_INT(0, oc_memb_free(&test_memb, second));
+    TEST_ASSERT_EQUAL_INT(TEST_MEMB_COUNT, oc_memb_numfree(&test_memb));
+
+    // most recently freed chunk is reused first
+    struct test_memb_chunk* chunk =
+        (struct test_memb_chunk*) oc_memb_alloc(&test_memb);
+    TEST_ASSERT_EQUAL_PTR(second, chunk);
+    const struct test_memb_chunk zeroed = {0};
+    TEST_ASSERT_EQUAL_MEMORY(&zeroed, chunk, sizeof(struct test_memb_chunk));
+
+    // uninitialized allocation leaves contents unchanged
+    chunk = (struct test_memb_chunk*) oc_memb_alloc_uninit(&test_memb);
+    TEST_ASSERT_EQUAL_PTR(first, chunk);
+    TEST_ASSERT_EQUAL_UINT8(0xAB, chunk->bytes[0]);
+
+    struct oc_memb_stats stats;
+    oc_memb_get_stats(&test_memb, &stats);
+    TEST_ASSERT_EQUAL_UINT(2, stats.used);
+    TEST_ASSERT_EQUAL_UINT(2, stats.high_water);
+    TEST_ASSERT_EQUAL_UINT(0, stats.alloc_failures);
+}
+
+void test_oc_memb__invalid_free__pool_unchanged(void)
+{
+    struct test_memb_chunk* chunk =
+        (struct test_memb_chunk*) oc_memb_alloc(&test_memb);
+    struct test_memb_chunk other;
+
+    TEST_ASSERT_EQUAL_INT(-1, oc_memb_free(&test_memb, &other));
+    TEST_ASSERT_EQUAL_INT(-1,
+                          oc_memb_free(&test_memb, (uint8_t*) chunk + 1));
+    TEST_ASSERT_EQUAL_INT(TEST_MEMB_COUNT - 1, oc_memb_numfree(&test_memb));
+
+    // freeing a chunk twice does not add it to the free chunks twice
+    TEST_ASSERT_EQUAL_INT(0, oc_memb_free(&test_memb, chunk));
+    TEST_ASSERT_EQUAL_INT(0, oc_memb_free(&test_memb, chunk));
+    TEST_ASSERT_EQUAL_INT(TEST_MEMB_COUNT, oc_memb_numfree(&test_memb));
+
+    void* chunks[TEST_MEMB_COUNT];
+    for (uint8_t i = 0; i < TEST_MEMB_COUNT; i++)
+    {
+        chunks[i] = oc_memb_alloc(&test_memb);
+        TEST_ASSERT_NOT_NULL(chunks[i]);
+    }
+    TEST_ASSERT_NOT_EQUAL(chunks[0], chunks[1]);
+    TEST_ASSERT_NULL(oc_memb_alloc(&test_memb));
+}
+
+void test_oc_memb__init__stats_reset(void)
+{
+    for (uint8_t i = 0; i < TEST_MEMB_COUNT + 1; i++)
+    {
+        (void) oc_memb_alloc(&test_memb);
+    }
+    oc_memb_init(&test_memb);
+
+    struct oc_memb_stats stats;
+    oc_memb_get_stats(&test_memb, &stats);
+    TEST_ASSERT_EQUAL_UINT(0, stats.used);
+    TEST_ASSERT_EQUAL_UINT(0, stats.high_water);
+    TEST_ASSERT_EQUAL_UINT(0, stats.alloc_failures);
+    TEST_ASSERT_EQUAL_INT(TEST_MEMB_COUNT, oc_memb_numfree(&test_memb));
+}
@@ -17,6 +17,7 @@
 #ifndef __NEXUS__COMMON__INC__CRC_CCITT_H_
 #define __NEXUS__COMMON__INC__CRC_CCITT_H_
 
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -33,8 +34,40 @@ extern "C" {
  * Sample Input Data:
  * {0x31,0x32,0x33,0x34,0x35,0x36,0x37,0x38,0x39} (1-9 in ASCII)
  * Sample Output CRC: 0x29B1
+ *
+ * By default, a table-driven implementation (processing four bytes per
+ * step, using 2 KiB of constant tables) is used. Enable
+ * `CONFIG_NEXUS_COMMON_CRC_CCITT_SMALL_ROM_ENABLED` (or define
+ * `CRC_CCITT_SMALL_ROM`) to use a slower bitwise implementation without
+ * lookup tables instead, for flash-constrained targets. Both produce
+ * identical results.
+ */
+uint16_t compute_crc_ccitt(const void* bytes, size_t bytes_length);
+
+/* Incremental CRC CCITT computation, for data which is not contiguous or
+ * not available all at once.
+ *
+ * The result of `crc_ccitt_finish` is identical to `compute_crc_ccitt` over
+ * all bytes passed to `crc_ccitt_update`, in order:
+ *
+ *     uint16_t crc = crc_ccitt_begin();
+ *     crc = crc_ccitt_update(crc, header, header_length);
+ *     crc = crc_ccitt_update(crc, body, body_length);
+ *     crc = crc_ccitt_finish(crc);
+ */
+
+/* Returns the initial running CRC value.
+ */
+uint16_t crc_ccitt_begin(void);
+
+/* Returns the running CRC value `crc` updated with `bytes_length` bytes.
+ */
+uint16_t
+crc_ccitt_update(uint16_t crc, const void* bytes, size_t bytes_length);
+
+/* Returns the final CRC CCITT value for a running CRC value `crc`.
  */
-uint16_t compute_crc_ccitt(void* bytes, uint8_t bytes_length);
+uint16_t crc_ccitt_finish(uint16_t crc);
 
 #ifdef __cplusplus
 }
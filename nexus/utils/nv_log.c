@@ -0,0 +1,452 @@
+/* \file nv_log.c
+ * \brief Log-structured flash storage for Nexus NV blocks
+ * \author Angaza
+ * \copyright 2021 Angaza, Inc.
+ * \license This file is released under the MIT license
+ */
+
+#include "nv_log.h"
+
+#include <string.h>
+
+// "NVLG", identifies a page written by this module
+#define NV_LOG_PAGE_MAGIC 0x474C564EUL
+#define NV_LOG_SEQUENCE_ERASED UINT32_MAX
+#define NV_LOG_NO_RECORD UINT32_MAX
+
+// Value of erased flash. A record length equal to this value marks the end
+// of the records in a page.
+#define NV_LOG_ERASED_BYTE 0xFF
+
+// Block ID, CRC, and at least one byte of data
+#define NV_LOG_MIN_BLOCK_LENGTH 5
+
+// Records are a length byte, followed by the block, followed by padding
+#define NV_LOG_RECORD_SIZE(block_length)                                       \
+    ((uint16_t)(((uint32_t)(block_length) + NV_LOG_RECORD_ALIGN) &             \
+                ~(uint32_t)(NV_LOG_RECORD_ALIGN - 1)))
+#define NV_LOG_MAX_RECORD_SIZE                                                 \
+    NV_LOG_RECORD_SIZE(NX_COMMON_NV_MAX_BLOCK_LENGTH)
+
+// Attempts to write a record before giving up, if writes fail to verify
+#define NV_LOG_WRITE_ATTEMPTS 3
+
+static uint32_t _nv_log_page_address(const struct nv_log* log, uint8_t page)
+{
+    return (uint32_t) page * log->flash->page_size;
+}
+
+static bool _nv_log_read(const struct nv_log* log,
+                         uint32_t address,
+                         void* data,
+                         uint16_t length)
+{
+    return log->flash->read(log->flash->context, address, data, length);
+}
+
+// Program `data` and confirm that it reads back correctly
+static bool _nv_log_program(const struct nv_log* log,
+                            uint32_t address,
+                            const uint8_t* data,
+                            uint16_t length)
+{
+    uint8_t readback[NV_LOG_MAX_RECORD_SIZE];
+
+    if (length > sizeof(readback) ||
+        !log->flash->program(log->flash->context, address, data, length) ||
+        !_nv_log_read(log, address, readback, length))
+    {
+        return false;
+    }
+    return memcmp(readback, data, length) == 0;
+}
+
+static bool _nv_log_page_blank(const struct nv_log* log, uint8_t page)
+{
+    const uint32_t page_address = _nv_log_page_address(log, page);
+    uint8_t chunk[16];
+
+    for (uint16_t offset = 0; offset < log->flash->page_size;
+         offset = (uint16_t)(offset + sizeof(chunk)))
+    {
+        uint16_t length = (uint16_t)(log->flash->page_size - offset);
+        if (length > sizeof(chunk))
+        {
+            length = sizeof(chunk);
+        }
+        if (!_nv_log_read(log, page_address + offset, chunk, length))
+        {
+            return false;
+        }
+        for (uint16_t i = 0; i < length; i++)
+        {
+            if (chunk[i] != NV_LOG_ERASED_BYTE)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/* Add the valid records of `page` to the index, replacing any records
+ * already indexed. Returns the offset following the last record, where
+ * the next record may be written.
+ */
+static uint16_t _nv_log_scan_page(struct nv_log* log, uint8_t page)
+{
+    const uint16_t page_size = log->flash->page_size;
+    const uint32_t page_address = _nv_log_page_address(log, page);
+    uint8_t block[NX_COMMON_NV_MAX_BLOCK_LENGTH];
+    uint16_t offset = NV_LOG_PAGE_HEADER_SIZE;
+
+    while (offset < page_size)
+    {
+        uint8_t length;
+        if (!_nv_log_read(log, page_address + offset, &length, 1) ||
+            length == NV_LOG_ERASED_BYTE)
+        {
+            break;
+        }
+
+        const uint16_t record_size = NV_LOG_RECORD_SIZE(length);
+        if (length < NV_LOG_MIN_BLOCK_LENGTH ||
+            length > NX_COMMON_NV_MAX_BLOCK_LENGTH ||
+            record_size > page_size - offset)
+        {
+            // Corrupted length, later records cannot be located
+            return page_size;
+        }
+
+        // Records interrupted by power loss fail validation, and are skipped
+        const uint32_t block_address = page_address + offset + 1;
+        if (_nv_log_read(log, block_address, block, length))
+        {
+            struct nx_common_nv_block_meta block_meta;
+            memcpy(&block_meta.block_id, block, sizeof(block_meta.block_id));
+            block_meta.length = length;
+            if (block_meta.block_id < NV_LOG_MAX_BLOCKS &&
+                nx_common_nv_block_valid(block_meta, block))
+            {
+                log->index[block_meta.block_id] = block_address;
+            }
+        }
+        offset = (uint16_t)(offset + record_size);
+    }
+    return offset;
+}
+
+static uint8_t _nv_log_erased_page_count(const struct nv_log* log)
+{
+    uint8_t count = 0;
+    for (uint8_t page = 0; page < log->flash->page_count; page++)
+    {
+        if (log->page_sequence[page] == NV_LOG_SEQUENCE_ERASED)
+        {
+            count++;
+        }
+    }
+    return count;
+}
+
+// Returns the page with the lowest sequence number, other than the active
+// page. Assumes that at least one such page exists.
+static uint8_t _nv_log_oldest_page(const struct nv_log* log)
+{
+    uint8_t oldest = log->active_page;
+    for (uint8_t page = 0; page < log->flash->page_count; page++)
+    {
+        const uint32_t sequence = log->page_sequence[page];
+        if (page == log->active_page || sequence == NV_LOG_SEQUENCE_ERASED)
+        {
+            continue;
+        }
+        if (oldest == log->active_page ||
+            sequence < log->page_sequence[oldest])
+        {
+            oldest = page;
+        }
+    }
+    return oldest;
+}
+
+// Append a record to the active page, and index it if written successfully
+static bool _nv_log_append(struct nv_log* log,
+                           const uint8_t* record,
+                           uint16_t record_size,
+                           uint16_t block_id)
+{
+    if (record_size > log->flash->page_size - log->write_offset)
+    {
+        return false;
+    }
+
+    const uint32_t address =
+        _nv_log_page_address(log, log->active_page) + log->write_offset;
+    // A failed write may still have programmed part of the record, so its
+    // space is not reused
+    log->write_offset = (uint16_t)(log->write_offset + record_size);
+    if (!_nv_log_program(log, address, record, record_size))
+    {
+        return false;
+    }
+    log->index[block_id] = address + 1;
+    return true;
+}
+
+// Copy the latest records stored in `page` to the active page, then erase it
+static bool _nv_log_collect_page(struct nv_log* log, uint8_t page)
+{
+    const uint32_t page_start = _nv_log_page_address(log, page);
+    const uint32_t page_end = page_start + log->flash->page_size;
+    uint8_t record[NV_LOG_MAX_RECORD_SIZE];
+
+    for (uint16_t block_id = 0; block_id < NV_LOG_MAX_BLOCKS; block_id++)
+    {
+        // Records begin with their length, immediately before the block
+        const uint32_t block_address = log->index[block_id];
+        if (block_address == NV_LOG_NO_RECORD || block_address < page_start ||
+            block_address >= page_end)
+        {
+            continue;
+        }
+        if (!_nv_log_read(log, block_address - 1, record, 1) ||
+            record[0] > NX_COMMON_NV_MAX_BLOCK_LENGTH)
+        {
+            return false;
+        }
+        const uint16_t record_size = NV_LOG_RECORD_SIZE(record[0]);
+        if (!_nv_log_read(log, block_address - 1, record, record_size) ||
+            !_nv_log_append(log, record, record_size, block_id))
+        {
+            return false;
+        }
+    }
+
+    if (!log->flash->erase_page(log->flash->context, page))
+    {
+        return false;
+    }
+    log->page_sequence[page] = NV_LOG_SEQUENCE_ERASED;
+    return true;
+}
+
+// Start writing to the next erased page after the active page
+static bool _nv_log_open_next_page(struct nv_log* log)
+{
+    const uint8_t page_count = log->flash->page_count;
+    for (uint8_t i = 1; i < page_count; i++)
+    {
+        const uint8_t page = (uint8_t)((log->active_page + i) % page_count);
+        if (log->page_sequence[page] != NV_LOG_SEQUENCE_ERASED)
+        {
+            continue;
+        }
+
+        uint8_t header[NV_LOG_PAGE_HEADER_SIZE];
+        const uint32_t magic = NV_LOG_PAGE_MAGIC;
+        memcpy(header, &magic, sizeof(magic));
+        memcpy(header + sizeof(magic),
+               &log->next_sequence,
+               sizeof(log->next_sequence));
+        if (!_nv_log_program(
+                log, _nv_log_page_address(log, page), header, sizeof(header)))
+        {
+            return false;
+        }
+
+        log->page_sequence[page] = log->next_sequence;
+        log->next_sequence++;
+        log->active_page = page;
+        log->write_offset = NV_LOG_PAGE_HEADER_SIZE;
+        return true;
+    }
+    return false;
+}
+
+/* Continue the log on the next page. If no erased pages remain afterwards,
+ * the oldest page is collected so that the following page change is also
+ * possible.
+ */
+static bool _nv_log_next_page(struct nv_log* log)
+{
+    if (!_nv_log_open_next_page(log))
+    {
+        return false;
+    }
+    if (_nv_log_erased_page_count(log) == 0)
+    {
+        return _nv_log_collect_page(log, _nv_log_oldest_page(log));
+    }
+    return true;
+}
+
+bool nv_log_init(struct nv_log* log, const struct nv_log_flash* flash)
+{
+    if (flash == NULL || flash->page_count < 2 ||
+        flash->page_count > NV_LOG_MAX_PAGES ||
+        flash->page_size % NV_LOG_RECORD_ALIGN != 0 ||
+        flash->page_size < NV_LOG_PAGE_HEADER_SIZE + NV_LOG_MAX_RECORD_SIZE)
+    {
+        return false;
+    }
+
+    log->flash = flash;
+    memset(log->index, 0xFF, sizeof(log->index));
+    log->next_sequence = 0;
+    // If the flash is blank, the first write opens page 0
+    log->active_page = (uint8_t)(flash->page_count - 1);
+    log->write_offset = flash->page_size;
+
+    uint8_t valid_pages = 0;
+    for (uint8_t page = 0; page < flash->page_count; page++)
+    {
+        uint8_t header[NV_LOG_PAGE_HEADER_SIZE];
+        if (!_nv_log_read(
+                log, _nv_log_page_address(log, page), header, sizeof(header)))
+        {
+            return false;
+        }
+
+        uint32_t magic;
+        uint32_t sequence;
+        memcpy(&magic, header, sizeof(magic));
+        memcpy(&sequence, header + sizeof(magic), sizeof(sequence));
+        if (magic == NV_LOG_PAGE_MAGIC && sequence != NV_LOG_SEQUENCE_ERASED)
+        {
+            log->page_sequence[page] = sequence;
+            valid_pages++;
+            if (sequence >= log->next_sequence)
+            {
+                log->next_sequence = sequence + 1;
+                log->active_page = page;
+            }
+            continue;
+        }
+
+        // Page header or erase interrupted by power loss
+        log->page_sequence[page] = NV_LOG_SEQUENCE_ERASED;
+        if (!_nv_log_page_blank(log, page) &&
+            !flash->erase_page(flash->context, page))
+        {
+            return false;
+        }
+    }
+
+    // Scan pages from oldest to newest, so that the index refers to the
+    // latest record of each block
+    uint32_t min_sequence = 0;
+    for (uint8_t i = 0; i < valid_pages; i++)
+    {
+        uint8_t next = flash->page_count;
+        for (uint8_t page = 0; page < flash->page_count; page++)
+        {
+            const uint32_t sequence = log->page_sequence[page];
+            if (sequence != NV_LOG_SEQUENCE_ERASED &&
+                sequence >= min_sequence &&
+                (next == flash->page_count ||
+                 sequence < log->page_sequence[next]))
+            {
+                next = page;
+            }
+        }
+
+        const uint16_t end = _nv_log_scan_page(log, next);
+        if (next == log->active_page)
+        {
+            log->write_offset = end;
+        }
+        min_sequence = log->page_sequence[next] + 1;
+    }
+
+    // Power was lost after the last erased page was opened, but before the
+    // oldest page was collected
+    if (valid_pages == flash->page_count)
+    {
+        return _nv_log_collect_page(log, _nv_log_oldest_page(log));
+    }
+    return true;
+}
+
+bool nv_log_read(const struct nv_log* log,
+                 const struct nx_common_nv_block_meta block_meta,
+                 void* block)
+{
+    if (block_meta.block_id >= NV_LOG_MAX_BLOCKS ||
+        log->index[block_meta.block_id] == NV_LOG_NO_RECORD)
+    {
+        return false;
+    }
+
+    const uint32_t block_address = log->index[block_meta.block_id];
+    uint8_t length;
+    if (!_nv_log_read(log, block_address - 1, &length, 1) ||
+        length != block_meta.length)
+    {
+        return false;
+    }
+    return _nv_log_read(log, block_address, block, block_meta.length);
+}
+
+bool nv_log_write(struct nv_log* log,
+                  const struct nx_common_nv_block_meta block_meta,
+                  const void* block)
+{
+    const struct nx_common_nv_write_segment segment = {
+        .data = block, .length = block_meta.length};
+    return nv_log_write_v(log, block_meta, &segment, 1);
+}
+
+bool nv_log_write_v(struct nv_log* log,
+                    const struct nx_common_nv_block_meta block_meta,
+                    const struct nx_common_nv_write_segment* segments,
+                    uint8_t segment_count)
+{
+    if (block_meta.block_id >= NV_LOG_MAX_BLOCKS ||
+        block_meta.length < NV_LOG_MIN_BLOCK_LENGTH ||
+        block_meta.length > NX_COMMON_NV_MAX_BLOCK_LENGTH)
+    {
+        return false;
+    }
+
+    uint8_t record[NV_LOG_MAX_RECORD_SIZE];
+    const uint16_t record_size = NV_LOG_RECORD_SIZE(block_meta.length);
+    memset(record, NV_LOG_ERASED_BYTE, sizeof(record));
+    record[0] = block_meta.length;
+    // segments are gathered directly into the record
+    uint16_t offset = 1;
+    for (uint8_t i = 0; i < segment_count; i++)
+    {
+        if (offset + segments[i].length > 1 + block_meta.length)
+        {
+            return false;
+        }
+        memcpy(&record[offset], segments[i].data, segments[i].length);
+        offset = (uint16_t)(offset + segments[i].length);
+    }
+    if (offset != 1 + block_meta.length)
+    {
+        return false;
+    }
+
+    // Only complete blocks are written, so that `nv_log_init` can reject
+    // records interrupted by power loss
+    if (!nx_common_nv_block_valid(block_meta, &record[1]))
+    {
+        return false;
+    }
+
+    for (uint8_t attempt = 0; attempt < NV_LOG_WRITE_ATTEMPTS; attempt++)
+    {
+        if (record_size > log->flash->page_size - log->write_offset &&
+            !_nv_log_next_page(log))
+        {
+            return false;
+        }
+        if (_nv_log_append(log, record, record_size, block_meta.block_id))
+        {
+            return true;
+        }
+    }
+    return false;
+}
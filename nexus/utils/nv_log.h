@@ -0,0 +1,197 @@
+/** \file nv_log.h
+ * \brief Log-structured flash storage for Nexus NV blocks.
+ * \author Angaza
+ * \copyright 2021 Angaza, Inc.
+ * \license This file is released under the MIT license
+ *
+ * The above copyright notice and license shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * Reference implementation of the storage behind `nxp_common_nv_read` and
+ * `nxp_common_nv_write`, for products which store Nexus NV blocks in
+ * page-erasable flash (NOR flash, or internal MCU flash).
+ *
+ * Instead of erasing a page for every block update, each written block is
+ * appended as a record to the current page, and a RAM index tracks the
+ * location of the latest record for each block ID. When a page is full,
+ * the next page (in ring order, so that all pages wear evenly) is used.
+ * Before the last erased page is used, the latest records of the oldest
+ * page are copied forward and the oldest page is erased.
+ *
+ * Records are the Nexus NV blocks themselves (block ID, data, CRC), so
+ * a record interrupted by power loss fails validation and is ignored by
+ * `nv_log_init`; the previous record of that block is used instead.
+ *
+ * Example:
+ *
+ *     static struct nv_log product_nv_log;
+ *
+ *     // at startup, before `nx_common_init`
+ *     nv_log_init(&product_nv_log, &product_flash);
+ *
+ *     bool nxp_common_nv_write(const struct nx_common_nv_block_meta meta,
+ *                              void* write_buffer)
+ *     {
+ *         return nv_log_write(&product_nv_log, meta, write_buffer);
+ *     }
+ *
+ *     // or, with `CONFIG_NEXUS_COMMON_NV_WRITE_V_ENABLED`
+ *     bool nxp_common_nv_write_v(
+ *         const struct nx_common_nv_block_meta meta,
+ *         const struct nx_common_nv_write_segment* segments,
+ *         uint8_t segment_count)
+ *     {
+ *         return nv_log_write_v(
+ *             &product_nv_log, meta, segments, segment_count);
+ *     }
+ *
+ *     bool nxp_common_nv_read(const struct nx_common_nv_block_meta meta,
+ *                             void* read_buffer)
+ *     {
+ *         return nv_log_read(&product_nv_log, meta, read_buffer);
+ *     }
+ */
+
+#ifndef __NEXUS__UTILS__NV_LOG_H_
+#define __NEXUS__UTILS__NV_LOG_H_
+
+#include "include/nx_common.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Block IDs 0 to `NV_LOG_MAX_BLOCKS - 1` may be stored
+#ifndef NV_LOG_MAX_BLOCKS
+    #if defined(CONFIG_NEXUS_CHANNEL_LINK_SECURITY_ENABLED) &&                 \
+        defined(CONFIG_NEXUS_CHANNEL_LARGE_LINK_TABLE_ENABLED)
+        // link pages have the highest block IDs (above any copy B)
+        #define NV_LOG_MAX_BLOCKS                                              \
+            (NX_COMMON_NV_LINK_PAGE_FIRST_BLOCK_ID +                           \
+             NX_COMMON_NV_LINK_PAGE_COUNT)
+    #elif defined(CONFIG_NEXUS_COMMON_NV_TRANSACTIONS_ENABLED)
+        // includes copy B of each block
+        #define NV_LOG_MAX_BLOCKS (NX_COMMON_NV_BLOCK_COPY_B_ID_OFFSET + 16)
+    #else
+        #define NV_LOG_MAX_BLOCKS 21
+    #endif
+#endif
+
+// Maximum number of flash pages used by one log
+#ifndef NV_LOG_MAX_PAGES
+    #define NV_LOG_MAX_PAGES 8
+#endif
+
+// Records are padded to a multiple of this many bytes, for flash which
+// can only be programmed in aligned units. Must be a power of two.
+#ifndef NV_LOG_RECORD_ALIGN
+    #define NV_LOG_RECORD_ALIGN 4
+#endif
+
+// Bytes at the start of each page used to identify and order pages
+#define NV_LOG_PAGE_HEADER_SIZE 8
+
+/** Flash device used by a log.
+ *
+ * Erased flash reads as 0xFF, and programming may only change bits from 1
+ * to 0. Addresses are relative to the start of the first page used by the
+ * log; page `n` begins at address `n * page_size`.
+ *
+ * Each page must be large enough to hold one record of every block
+ * stored in the log (`NX_COMMON_NV_MAX_BLOCK_LENGTH + 1` bytes, rounded
+ * up to `NV_LOG_RECORD_ALIGN`, per block), in addition to its header.
+ */
+struct nv_log_flash
+{
+    void* context; // passed to each function below
+    uint16_t page_size; // bytes, multiple of `NV_LOG_RECORD_ALIGN`
+    uint8_t page_count; // at least 2, at most `NV_LOG_MAX_PAGES`
+    bool (*read)(void* context, uint32_t address, void* data, uint16_t length);
+    bool (*program)(void* context,
+                    uint32_t address,
+                    const void* data,
+                    uint16_t length);
+    bool (*erase_page)(void* context, uint8_t page);
+};
+
+/** State of a log, kept in RAM.
+ *
+ * Initialized by `nv_log_init`; fields are not intended to be accessed
+ * directly.
+ */
+struct nv_log
+{
+    const struct nv_log_flash* flash;
+    // address of the latest record of each block ID
+    uint32_t index[NV_LOG_MAX_BLOCKS];
+    // sequence number of each page, or `NV_LOG_SEQUENCE_ERASED`
+    uint32_t page_sequence[NV_LOG_MAX_PAGES];
+    uint32_t next_sequence;
+    uint16_t write_offset; // next free offset within `active_page`
+    uint8_t active_page;
+};
+
+/** Load a log from flash.
+ *
+ * Scans all pages to build the RAM index, erasing pages which were left
+ * incompletely written or erased by a power loss. Blank flash results in
+ * an empty log.
+ *
+ * \param log log state to initialize
+ * \param flash flash device storing the log; must remain valid while the
+ * log is used
+ * \return true if the log is ready to use, false if `flash` is invalid or
+ * could not be read
+ */
+bool nv_log_init(struct nv_log* log, const struct nv_log_flash* flash);
+
+/** Read the latest record of a block.
+ *
+ * \param log log to read from
+ * \param block_meta metadata of block to read
+ * \param block where the full block (block ID, data, and CRC) is copied
+ * \return true if the block was found and read, false otherwise
+ */
+bool nv_log_read(const struct nv_log* log,
+                 const struct nx_common_nv_block_meta block_meta,
+                 void* block);
+
+/** Append a new record of a block.
+ *
+ * \param log log to write to
+ * \param block_meta metadata of block to write
+ * \param block full block (block ID, data, and CRC) to write
+ * \return true if the block was written, false if the block is invalid or
+ * could not be written
+ */
+bool nv_log_write(struct nv_log* log,
+                  const struct nx_common_nv_block_meta block_meta,
+                  const void* block);
+
+/** Append a new record of a block, given in segments.
+ *
+ * As `nv_log_write`, for products which implement `nxp_common_nv_write_v`
+ * (`CONFIG_NEXUS_COMMON_NV_WRITE_V_ENABLED`). Segments are copied directly
+ * into the new record.
+ *
+ * \param log log to write to
+ * \param block_meta metadata of block to write
+ * \param segments parts of the full block (block ID, data, and CRC) to
+ * write, in order; lengths must add up to `block_meta.length`
+ * \param segment_count number of entries in `segments`
+ * \return true if the block was written, false if the block is invalid or
+ * could not be written
+ */
+bool nv_log_write_v(struct nv_log* log,
+                    const struct nx_common_nv_block_meta block_meta,
+                    const struct nx_common_nv_write_segment* segments,
+                    uint8_t segment_count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -26,15 +26,29 @@
 #include <stdio.h>
 #include <string.h>
 
+// Select SIMD kernels for batched computation. SSE2 is part of the x86-64
+// baseline and NEON is part of the AArch64 baseline, so both are selected at
+// compile time. AVX2 is compiled in on x86-64 GCC/Clang but only used if the
+// CPU reports support at runtime. All other targets (including Cortex-M)
+// use the portable scalar path.
+#ifndef SIPHASH24_BATCH_NO_SIMD
+    #if defined(__x86_64__) && defined(__SSE2__)
+        #define SIPHASH24_BATCH_SSE2 1
+        #include <emmintrin.h>
+        #if defined(__GNUC__) || defined(__clang__)
+            #define SIPHASH24_BATCH_AVX2 1
+            #include <immintrin.h>
+        #endif
+    #elif defined(__aarch64__) && defined(__ARM_NEON)
+        #define SIPHASH24_BATCH_NEON 1
+        #include <arm_neon.h>
+    #endif
+#endif
+
 typedef uint64_t u64;
 typedef uint32_t u32;
 typedef uint8_t u8;
 
-static u64 v0;
-static u64 v1;
-static u64 v2;
-static u64 v3;
-
 #define ROTL(x, b) (u64)(((x) << (b)) | ((x) >> (64 - (b))))
 
 #define U32TO8_LE(p, v)                                                        \
@@ -52,58 +66,31 @@ static u64 v3;
      ((u64)((p)[3]) << 24) | ((u64)((p)[4]) << 32) | ((u64)((p)[5]) << 40) |   \
      ((u64)((p)[6]) << 48) | ((u64)((p)[7]) << 56))
 
-static void SIPROUND(void)
-{
-    do
-    {
-        v0 += v1;
-        v1 = ROTL(v1, 13);
-        v1 ^= v0;
-        v0 = ROTL(v0, 32);
-        v2 += v3;
-        v3 = ROTL(v3, 16);
-        v3 ^= v2;
-        v0 += v3;
-        v3 = ROTL(v3, 21);
-        v3 ^= v0;
-        v2 += v1;
-        v1 = ROTL(v1, 17);
-        v1 ^= v2;
-        v2 = ROTL(v2, 32);
-    } while (0);
-}
+// Operates on local state variables (not globals) so that every computation
+// is reentrant and the state may be kept in registers.
+#define SIPROUND(v0, v1, v2, v3)                                               \
+    do                                                                         \
+    {                                                                          \
+        (v0) += (v1);                                                          \
+        (v1) = ROTL((v1), 13);                                                 \
+        (v1) ^= (v0);                                                          \
+        (v0) = ROTL((v0), 32);                                                 \
+        (v2) += (v3);                                                          \
+        (v3) = ROTL((v3), 16);                                                 \
+        (v3) ^= (v2);                                                          \
+        (v0) += (v3);                                                          \
+        (v3) = ROTL((v3), 21);                                                 \
+        (v3) ^= (v0);                                                          \
+        (v2) += (v1);                                                          \
+        (v1) = ROTL((v1), 17);                                                 \
+        (v1) ^= (v2);                                                          \
+        (v2) = ROTL((v2), 32);                                                 \
+    } while (0)
 
-/* SipHash-2-4 */
-void siphash24_compute(uint8_t* out,
-                       const uint8_t* in,
-                       const uint32_t inlen,
-                       const uint8_t* k)
+// Load the final 0-7 bytes of a message into the low bytes of a word
+static u64 _siphash24_load_tail(const u8* in, const uint32_t left)
 {
-    const u8* end = in + inlen - (inlen % sizeof(u64));
-    const int left = inlen & 7;
-    u64 b = ((u64) inlen) << 56;
-
-    /* "somepseudorandomlygeneratedbytes" */
-    v0 = 0x736f6d6570736575ULL;
-    v1 = 0x646f72616e646f6dULL;
-    v2 = 0x6c7967656e657261ULL;
-    v3 = 0x7465646279746573ULL;
-    const u64 k0 = U8TO64_LE(k);
-    const u64 k1 = U8TO64_LE(k + 8);
-
-    v3 ^= k1;
-    v2 ^= k0;
-    v1 ^= k1;
-    v0 ^= k0;
-
-    for (; in != end; in += 8)
-    {
-        const u64 m = U8TO64_LE(in);
-        v3 ^= m;
-        SIPROUND();
-        SIPROUND();
-        v0 ^= m;
-    }
+    u64 b = 0;
 
     switch (left)
     {
@@ -142,15 +129,454 @@ void siphash24_compute(uint8_t* out,
             // should never arrive here, invalid check calculation result
             assert(false);
     }
+    return b;
+}
+
+void siphash24_keyed_state_init(struct siphash24_keyed_state* state,
+                                const uint8_t* k)
+{
+    const u64 k0 = U8TO64_LE(k);
+    const u64 k1 = U8TO64_LE(k + 8);
+
+    /* "somepseudorandomlygeneratedbytes" */
+    state->v0 = 0x736f6d6570736575ULL ^ k0;
+    state->v1 = 0x646f72616e646f6dULL ^ k1;
+    state->v2 = 0x6c7967656e657261ULL ^ k0;
+    state->v3 = 0x7465646279746573ULL ^ k1;
+}
+
+void siphash24_init(struct siphash24_ctx* ctx,
+                    const struct siphash24_keyed_state* state)
+{
+    ctx->v0 = state->v0;
+    ctx->v1 = state->v1;
+    ctx->v2 = state->v2;
+    ctx->v3 = state->v3;
+    ctx->tail = 0;
+    ctx->total_len = 0;
+    ctx->tail_len = 0;
+}
+
+void siphash24_update(struct siphash24_ctx* ctx,
+                      const uint8_t* in,
+                      uint32_t inlen)
+{
+    u64 v0 = ctx->v0;
+    u64 v1 = ctx->v1;
+    u64 v2 = ctx->v2;
+    u64 v3 = ctx->v3;
+
+    ctx->total_len += inlen;
+
+    // complete a partially filled word from a previous update first
+    while (ctx->tail_len > 0 && inlen > 0)
+    {
+        ctx->tail |= ((u64) *in++) << (8 * ctx->tail_len);
+        --inlen;
+        if (++ctx->tail_len == sizeof(u64))
+        {
+            const u64 m = ctx->tail;
+            v3 ^= m;
+            SIPROUND(v0, v1, v2, v3);
+            SIPROUND(v0, v1, v2, v3);
+            v0 ^= m;
+            ctx->tail = 0;
+            ctx->tail_len = 0;
+        }
+    }
+
+    const u8* end = in + inlen - (inlen % sizeof(u64));
+    for (; in != end; in += 8)
+    {
+        const u64 m = U8TO64_LE(in);
+        v3 ^= m;
+        SIPROUND(v0, v1, v2, v3);
+        SIPROUND(v0, v1, v2, v3);
+        v0 ^= m;
+    }
+
+    // stash any remaining bytes until more input (or finalization) arrives
+    const uint32_t left = inlen & 7;
+    if (left > 0)
+    {
+        ctx->tail = _siphash24_load_tail(in, left);
+        ctx->tail_len = (uint8_t) left;
+    }
+
+    ctx->v0 = v0;
+    ctx->v1 = v1;
+    ctx->v2 = v2;
+    ctx->v3 = v3;
+}
+
+void siphash24_final(struct siphash24_ctx* ctx, uint8_t* out)
+{
+    u64 v0 = ctx->v0;
+    u64 v1 = ctx->v1;
+    u64 v2 = ctx->v2;
+    u64 v3 = ctx->v3;
+    u64 b = (((u64) ctx->total_len) << 56) | ctx->tail;
+
+    v3 ^= b;
+    SIPROUND(v0, v1, v2, v3);
+    SIPROUND(v0, v1, v2, v3);
+    v0 ^= b;
+    v2 ^= 0xff;
+    SIPROUND(v0, v1, v2, v3);
+    SIPROUND(v0, v1, v2, v3);
+    SIPROUND(v0, v1, v2, v3);
+    SIPROUND(v0, v1, v2, v3);
+    b = v0 ^ v1 ^ v2 ^ v3;
+    U64TO8_LE(out, b);
+
+    // do not leave intermediate state derived from the key behind
+    memset(ctx, 0x00, sizeof(struct siphash24_ctx));
+}
+
+/* SipHash-2-4, using a precomputed keyed initial state */
+void siphash24_compute_keyed(uint8_t* out,
+                             const uint8_t* in,
+                             const uint32_t inlen,
+                             const struct siphash24_keyed_state* state)
+{
+    const u8* end = in + inlen - (inlen % sizeof(u64));
+    const uint32_t left = inlen & 7;
+    u64 b = ((u64) inlen) << 56;
+
+    u64 v0 = state->v0;
+    u64 v1 = state->v1;
+    u64 v2 = state->v2;
+    u64 v3 = state->v3;
+
+    for (; in != end; in += 8)
+    {
+        const u64 m = U8TO64_LE(in);
+        v3 ^= m;
+        SIPROUND(v0, v1, v2, v3);
+        SIPROUND(v0, v1, v2, v3);
+        v0 ^= m;
+    }
+
+    b |= _siphash24_load_tail(in, left);
+
     v3 ^= b;
-    SIPROUND();
-    SIPROUND();
+    SIPROUND(v0, v1, v2, v3);
+    SIPROUND(v0, v1, v2, v3);
     v0 ^= b;
     v2 ^= 0xff;
-    SIPROUND();
-    SIPROUND();
-    SIPROUND();
-    SIPROUND();
+    SIPROUND(v0, v1, v2, v3);
+    SIPROUND(v0, v1, v2, v3);
+    SIPROUND(v0, v1, v2, v3);
+    SIPROUND(v0, v1, v2, v3);
     b = v0 ^ v1 ^ v2 ^ v3;
     U64TO8_LE(out, b);
 }
+
+/* SipHash-2-4 */
+void siphash24_compute(uint8_t* out,
+                       const uint8_t* in,
+                       const uint32_t inlen,
+                       const uint8_t* k)
+{
+    struct siphash24_keyed_state state;
+
+    siphash24_keyed_state_init(&state, k);
+    siphash24_compute_keyed(out, in, inlen, &state);
+}
+
+//
+// BATCHED COMPUTATION
+//
+
+// Keyed state used for message `i` of a batch
+#define BATCH_STATE(states, shared, i) ((shared) ? &(states)[0] : &(states)[i])
+
+#ifdef SIPHASH24_BATCH_SSE2
+    #define SSE2_ROTL(x, b)                                                    \
+        _mm_or_si128(_mm_slli_epi64((x), (b)), _mm_srli_epi64((x), 64 - (b)))
+    // rotating each 64-bit lane by 32 is a swap of its 32-bit halves
+    #define SSE2_ROTL32(x) _mm_shuffle_epi32((x), _MM_SHUFFLE(2, 3, 0, 1))
+    #define SSE2_SIPROUND(v0, v1, v2, v3)                                      \
+        do                                                                     \
+        {                                                                      \
+            (v0) = _mm_add_epi64((v0), (v1));                                  \
+            (v1) = SSE2_ROTL((v1), 13);                                        \
+            (v1) = _mm_xor_si128((v1), (v0));                                  \
+            (v0) = SSE2_ROTL32(v0);                                            \
+            (v2) = _mm_add_epi64((v2), (v3));                                  \
+            (v3) = SSE2_ROTL((v3), 16);                                        \
+            (v3) = _mm_xor_si128((v3), (v2));                                  \
+            (v0) = _mm_add_epi64((v0), (v3));                                  \
+            (v3) = SSE2_ROTL((v3), 21);                                        \
+            (v3) = _mm_xor_si128((v3), (v0));                                  \
+            (v2) = _mm_add_epi64((v2), (v1));                                  \
+            (v1) = SSE2_ROTL((v1), 17);                                        \
+            (v1) = _mm_xor_si128((v1), (v2));                                  \
+            (v2) = SSE2_ROTL32(v2);                                            \
+        } while (0)
+
+// Two messages of `inlen` bytes each, one per 64-bit lane
+static void _siphash24_batch_sse2_x2(uint8_t* out,
+                                     const uint8_t* in,
+                                     const uint32_t inlen,
+                                     const struct siphash24_keyed_state* s0,
+                                     const struct siphash24_keyed_state* s1)
+{
+    const u8* in0 = in;
+    const u8* in1 = in + inlen;
+    const uint32_t blocks = inlen / sizeof(u64);
+
+    __m128i v0 = _mm_set_epi64x((long long) s1->v0, (long long) s0->v0);
+    __m128i v1 = _mm_set_epi64x((long long) s1->v1, (long long) s0->v1);
+    __m128i v2 = _mm_set_epi64x((long long) s1->v2, (long long) s0->v2);
+    __m128i v3 = _mm_set_epi64x((long long) s1->v3, (long long) s0->v3);
+
+    for (uint32_t i = 0; i < blocks; i++)
+    {
+        const __m128i m = _mm_set_epi64x((long long) U8TO64_LE(in1 + 8 * i),
+                                         (long long) U8TO64_LE(in0 + 8 * i));
+        v3 = _mm_xor_si128(v3, m);
+        SSE2_SIPROUND(v0, v1, v2, v3);
+        SSE2_SIPROUND(v0, v1, v2, v3);
+        v0 = _mm_xor_si128(v0, m);
+    }
+
+    const u64 len_word = ((u64) inlen) << 56;
+    const uint32_t left = inlen & 7;
+    const __m128i b = _mm_set_epi64x(
+        (long long) (len_word | _siphash24_load_tail(in1 + 8 * blocks, left)),
+        (long long) (len_word | _siphash24_load_tail(in0 + 8 * blocks, left)));
+
+    v3 = _mm_xor_si128(v3, b);
+    SSE2_SIPROUND(v0, v1, v2, v3);
+    SSE2_SIPROUND(v0, v1, v2, v3);
+    v0 = _mm_xor_si128(v0, b);
+    v2 = _mm_xor_si128(v2, _mm_set_epi64x(0xff, 0xff));
+    SSE2_SIPROUND(v0, v1, v2, v3);
+    SSE2_SIPROUND(v0, v1, v2, v3);
+    SSE2_SIPROUND(v0, v1, v2, v3);
+    SSE2_SIPROUND(v0, v1, v2, v3);
+
+    u64 result[2];
+    _mm_storeu_si128(
+        (__m128i*) result,
+        _mm_xor_si128(_mm_xor_si128(v0, v1), _mm_xor_si128(v2, v3)));
+    U64TO8_LE(out, result[0]);
+    U64TO8_LE(out + 8, result[1]);
+}
+#endif /* SIPHASH24_BATCH_SSE2 */
+
+#ifdef SIPHASH24_BATCH_AVX2
+    #define AVX2_ROTL(x, b)                                                    \
+        _mm256_or_si256(_mm256_slli_epi64((x), (b)),                          \
+                        _mm256_srli_epi64((x), 64 - (b)))
+    #define AVX2_ROTL32(x) _mm256_shuffle_epi32((x), _MM_SHUFFLE(2, 3, 0, 1))
+    #define AVX2_SIPROUND(v0, v1, v2, v3)                                      \
+        do                                                                     \
+        {                                                                      \
+            (v0) = _mm256_add_epi64((v0), (v1));                               \
+            (v1) = AVX2_ROTL((v1), 13);                                        \
+            (v1) = _mm256_xor_si256((v1), (v0));                               \
+            (v0) = AVX2_ROTL32(v0);                                            \
+            (v2) = _mm256_add_epi64((v2), (v3));                               \
+            (v3) = AVX2_ROTL((v3), 16);                                        \
+            (v3) = _mm256_xor_si256((v3), (v2));                               \
+            (v0) = _mm256_add_epi64((v0), (v3));                               \
+            (v3) = AVX2_ROTL((v3), 21);                                        \
+            (v3) = _mm256_xor_si256((v3), (v0));                               \
+            (v2) = _mm256_add_epi64((v2), (v1));                               \
+            (v1) = AVX2_ROTL((v1), 17);                                        \
+            (v1) = _mm256_xor_si256((v1), (v2));                               \
+            (v2) = AVX2_ROTL32(v2);                                            \
+        } while (0)
+
+    #define AVX2_SET_LANES(a, b, c, d)                                         \
+        _mm256_set_epi64x(                                                     \
+            (long long) (d), (long long) (c), (long long) (b), (long long) (a))
+
+// Four messages of `inlen` bytes each, one per 64-bit lane
+__attribute__((target("avx2"))) static void
+_siphash24_batch_avx2_x4(uint8_t* out,
+                         const uint8_t* in,
+                         const uint32_t inlen,
+                         const struct siphash24_keyed_state* const* s)
+{
+    const uint32_t blocks = inlen / sizeof(u64);
+
+    __m256i v0 = AVX2_SET_LANES(s[0]->v0, s[1]->v0, s[2]->v0, s[3]->v0);
+    __m256i v1 = AVX2_SET_LANES(s[0]->v1, s[1]->v1, s[2]->v1, s[3]->v1);
+    __m256i v2 = AVX2_SET_LANES(s[0]->v2, s[1]->v2, s[2]->v2, s[3]->v2);
+    __m256i v3 = AVX2_SET_LANES(s[0]->v3, s[1]->v3, s[2]->v3, s[3]->v3);
+
+    for (uint32_t i = 0; i < blocks; i++)
+    {
+        const u8* block = in + 8 * i;
+        const __m256i m = AVX2_SET_LANES(U8TO64_LE(block),
+                                         U8TO64_LE(block + inlen),
+                                         U8TO64_LE(block + 2 * inlen),
+                                         U8TO64_LE(block + 3 * inlen));
+        v3 = _mm256_xor_si256(v3, m);
+        AVX2_SIPROUND(v0, v1, v2, v3);
+        AVX2_SIPROUND(v0, v1, v2, v3);
+        v0 = _mm256_xor_si256(v0, m);
+    }
+
+    const u64 len_word = ((u64) inlen) << 56;
+    const uint32_t left = inlen & 7;
+    const u8* tail = in + 8 * blocks;
+    const __m256i b = AVX2_SET_LANES(
+        len_word | _siphash24_load_tail(tail, left),
+        len_word | _siphash24_load_tail(tail + inlen, left),
+        len_word | _siphash24_load_tail(tail + 2 * inlen, left),
+        len_word | _siphash24_load_tail(tail + 3 * inlen, left));
+
+    v3 = _mm256_xor_si256(v3, b);
+    AVX2_SIPROUND(v0, v1, v2, v3);
+    AVX2_SIPROUND(v0, v1, v2, v3);
+    v0 = _mm256_xor_si256(v0, b);
+    v2 = _mm256_xor_si256(v2, _mm256_set1_epi64x(0xff));
+    AVX2_SIPROUND(v0, v1, v2, v3);
+    AVX2_SIPROUND(v0, v1, v2, v3);
+    AVX2_SIPROUND(v0, v1, v2, v3);
+    AVX2_SIPROUND(v0, v1, v2, v3);
+
+    u64 result[4];
+    _mm256_storeu_si256(
+        (__m256i*) result,
+        _mm256_xor_si256(_mm256_xor_si256(v0, v1), _mm256_xor_si256(v2, v3)));
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        U64TO8_LE(out + 8 * i, result[i]);
+    }
+}
+#endif /* SIPHASH24_BATCH_AVX2 */
+
+#ifdef SIPHASH24_BATCH_NEON
+    #define NEON_ROTL(x, b)                                                    \
+        vorrq_u64(vshlq_n_u64((x), (b)), vshrq_n_u64((x), 64 - (b)))
+    #define NEON_ROTL32(x)                                                     \
+        vreinterpretq_u64_u32(vrev64q_u32(vreinterpretq_u32_u64(x)))
+    #define NEON_SIPROUND(v0, v1, v2, v3)                                      \
+        do                                                                     \
+        {                                                                      \
+            (v0) = vaddq_u64((v0), (v1));                                      \
+            (v1) = NEON_ROTL((v1), 13);                                        \
+            (v1) = veorq_u64((v1), (v0));                                      \
+            (v0) = NEON_ROTL32(v0);                                            \
+            (v2) = vaddq_u64((v2), (v3));                                      \
+            (v3) = NEON_ROTL((v3), 16);                                        \
+            (v3) = veorq_u64((v3), (v2));                                      \
+            (v0) = vaddq_u64((v0), (v3));                                      \
+            (v3) = NEON_ROTL((v3), 21);                                        \
+            (v3) = veorq_u64((v3), (v0));                                      \
+            (v2) = vaddq_u64((v2), (v1));                                      \
+            (v1) = NEON_ROTL((v1), 17);                                        \
+            (v1) = veorq_u64((v1), (v2));                                      \
+            (v2) = NEON_ROTL32(v2);                                            \
+        } while (0)
+
+static uint64x2_t _neon_lanes(const u64 lo, const u64 hi)
+{
+    const u64 lanes[2] = {lo, hi};
+    return vld1q_u64(lanes);
+}
+
+// Two messages of `inlen` bytes each, one per 64-bit lane
+static void _siphash24_batch_neon_x2(uint8_t* out,
+                                     const uint8_t* in,
+                                     const uint32_t inlen,
+                                     const struct siphash24_keyed_state* s0,
+                                     const struct siphash24_keyed_state* s1)
+{
+    const u8* in0 = in;
+    const u8* in1 = in + inlen;
+    const uint32_t blocks = inlen / sizeof(u64);
+
+    uint64x2_t v0 = _neon_lanes(s0->v0, s1->v0);
+    uint64x2_t v1 = _neon_lanes(s0->v1, s1->v1);
+    uint64x2_t v2 = _neon_lanes(s0->v2, s1->v2);
+    uint64x2_t v3 = _neon_lanes(s0->v3, s1->v3);
+
+    for (uint32_t i = 0; i < blocks; i++)
+    {
+        const uint64x2_t m =
+            _neon_lanes(U8TO64_LE(in0 + 8 * i), U8TO64_LE(in1 + 8 * i));
+        v3 = veorq_u64(v3, m);
+        NEON_SIPROUND(v0, v1, v2, v3);
+        NEON_SIPROUND(v0, v1, v2, v3);
+        v0 = veorq_u64(v0, m);
+    }
+
+    const u64 len_word = ((u64) inlen) << 56;
+    const uint32_t left = inlen & 7;
+    const uint64x2_t b =
+        _neon_lanes(len_word | _siphash24_load_tail(in0 + 8 * blocks, left),
+                    len_word | _siphash24_load_tail(in1 + 8 * blocks, left));
+
+    v3 = veorq_u64(v3, b);
+    NEON_SIPROUND(v0, v1, v2, v3);
+    NEON_SIPROUND(v0, v1, v2, v3);
+    v0 = veorq_u64(v0, b);
+    v2 = veorq_u64(v2, vdupq_n_u64(0xff));
+    NEON_SIPROUND(v0, v1, v2, v3);
+    NEON_SIPROUND(v0, v1, v2, v3);
+    NEON_SIPROUND(v0, v1, v2, v3);
+    NEON_SIPROUND(v0, v1, v2, v3);
+
+    u64 result[2];
+    vst1q_u64(result, veorq_u64(veorq_u64(v0, v1), veorq_u64(v2, v3)));
+    U64TO8_LE(out, result[0]);
+    U64TO8_LE(out + 8, result[1]);
+}
+#endif /* SIPHASH24_BATCH_NEON */
+
+void siphash24_compute_batch(uint8_t* out,
+                             const uint8_t* in,
+                             const uint32_t inlen,
+                             const uint32_t count,
+                             const struct siphash24_keyed_state* states,
+                             const bool shared_state)
+{
+    uint32_t i = 0;
+
+#ifdef SIPHASH24_BATCH_AVX2
+    if (count - i >= 4 && __builtin_cpu_supports("avx2"))
+    {
+        for (; count - i >= 4; i += 4)
+        {
+            const struct siphash24_keyed_state* lane_states[4] = {
+                BATCH_STATE(states, shared_state, i),
+                BATCH_STATE(states, shared_state, i + 1),
+                BATCH_STATE(states, shared_state, i + 2),
+                BATCH_STATE(states, shared_state, i + 3)};
+            _siphash24_batch_avx2_x4(
+                out + 8 * i, in + inlen * i, inlen, lane_states);
+        }
+    }
+#endif
+
+#if defined(SIPHASH24_BATCH_SSE2) || defined(SIPHASH24_BATCH_NEON)
+    for (; count - i >= 2; i += 2)
+    {
+    #ifdef SIPHASH24_BATCH_SSE2
+        _siphash24_batch_sse2_x2(
+    #else
+        _siphash24_batch_neon_x2(
+    #endif
+            out + 8 * i,
+            in + inlen * i,
+            inlen,
+            BATCH_STATE(states, shared_state, i),
+            BATCH_STATE(states, shared_state, i + 1));
+    }
+#endif
+
+    // portable path, and any remainder not handled by a SIMD kernel
+    for (; i < count; i++)
+    {
+        siphash24_compute_keyed(out + 8 * i,
+                                in + inlen * i,
+                                inlen,
+                                BATCH_STATE(states, shared_state, i));
+    }
+}
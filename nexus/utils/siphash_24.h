@@ -17,6 +17,7 @@
 #ifndef __NEXUS__COMMON__INC__SIPHASH_24_H_
 #define __NEXUS__COMMON__INC__SIPHASH_24_H_
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -41,6 +42,122 @@ void siphash24_compute(uint8_t* out,
                        const uint32_t inlen,
                        const uint8_t* key);
 
+/** Siphash 2-4 state after key setup, before any input is compressed.
+ *
+ * Computing this state once per key (for example, once per link key or
+ * once per origin key) allows repeated hash computations under the same
+ * key to skip key setup. The state is read-only after initialization, so
+ * a single keyed state may be shared by several threads.
+ *
+ * This state is derived from the secret key and should be treated (and
+ * cleared) with the same care as the key itself.
+ */
+struct siphash24_keyed_state
+{
+    uint64_t v0;
+    uint64_t v1;
+    uint64_t v2;
+    uint64_t v3;
+};
+
+/** Incremental Siphash 2-4 computation context.
+ *
+ * Holds all intermediate state of a single hash computation; no global
+ * state is used, so independent contexts may be used concurrently.
+ */
+struct siphash24_ctx
+{
+    uint64_t v0;
+    uint64_t v1;
+    uint64_t v2;
+    uint64_t v3;
+    uint64_t tail; // input bytes not yet compressed (little endian)
+    uint32_t total_len; // total bytes of input seen so far
+    uint8_t tail_len; // number of valid bytes in `tail`
+};
+
+/** Precompute the keyed initial Siphash 2-4 state for `key`.
+ *
+ * \param state pointer to keyed state to initialize
+ * \param key 128-bit (16 byte) secret key
+ */
+void siphash24_keyed_state_init(struct siphash24_keyed_state* state,
+                                const uint8_t* key);
+
+/** Begin an incremental Siphash 2-4 computation.
+ *
+ * \param ctx context to initialize
+ * \param state keyed state (see `siphash24_keyed_state_init`)
+ */
+void siphash24_init(struct siphash24_ctx* ctx,
+                    const struct siphash24_keyed_state* state);
+
+/** Feed more input bytes into an incremental Siphash 2-4 computation.
+ *
+ * Input may be split across any number of calls at any byte boundary; the
+ * result is identical to a single `siphash24_compute` over all bytes.
+ *
+ * \param ctx context previously initialized with `siphash24_init`
+ * \param in pointer to input bytes
+ * \param inlen number of input bytes at `in`
+ */
+void siphash24_update(struct siphash24_ctx* ctx,
+                      const uint8_t* in,
+                      uint32_t inlen);
+
+/** Complete an incremental Siphash 2-4 computation.
+ *
+ * `out` must be able to contain at least 8 bytes. `ctx` is cleared and
+ * must be reinitialized before reuse.
+ *
+ * \param ctx context previously initialized with `siphash24_init`
+ * \param out pointer to output where the Siphash 2-4 result will be placed
+ */
+void siphash24_final(struct siphash24_ctx* ctx, uint8_t* out);
+
+/** Compute a Siphash 2-4 result using a precomputed keyed state.
+ *
+ * Identical to `siphash24_compute`, but skips key setup.
+ *
+ * \param out pointer to output where the Siphash 2-4 result will be placed.
+ * \param in pointer to input bytes to compute hash over
+ * \param inlen length of input bytes to compute from `in`
+ * \param state keyed state (see `siphash24_keyed_state_init`)
+ */
+void siphash24_compute_keyed(uint8_t* out,
+                             const uint8_t* in,
+                             const uint32_t inlen,
+                             const struct siphash24_keyed_state* state);
+
+/** Compute several independent Siphash 2-4 results at once.
+ *
+ * Computes `count` results, each over one of `count` equal-length messages
+ * stored back-to-back at `in` (message `i` begins at `in + i * inlen`).
+ * Result `i` is written to `out + 8 * i`, and is identical to
+ * `siphash24_compute_keyed` over message `i`.
+ *
+ * Each message may use its own keyed state (`states[i]`), or all messages
+ * may share `states[0]` if `shared_state` is true.
+ *
+ * Where available, multiple messages are computed in parallel across SIMD
+ * lanes (SSE2/AVX2 on x86-64, with AVX2 detected at runtime, and NEON on
+ * AArch64). Other targets use a portable scalar implementation. Define
+ * `SIPHASH24_BATCH_NO_SIMD` to always use the scalar implementation.
+ *
+ * \param out pointer to output, at least `8 * count` bytes
+ * \param in pointer to `count` messages of `inlen` bytes each
+ * \param inlen length of each message in bytes
+ * \param count number of messages (and results)
+ * \param states keyed states, one per message (or one if `shared_state`)
+ * \param shared_state if true, use `states[0]` for all messages
+ */
+void siphash24_compute_batch(uint8_t* out,
+                             const uint8_t* in,
+                             const uint32_t inlen,
+                             const uint32_t count,
+                             const struct siphash24_keyed_state* states,
+                             const bool shared_state);
+
 #ifdef __cplusplus
 }
 #endif